@@ -0,0 +1,257 @@
+#include "ActorSpatialHash.h"
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+
+USING_NS_CC;
+
+constexpr float ActorSpatialHash::kCellSize;
+constexpr float ActorSpatialHash::kQueryMargin;
+
+namespace {
+
+inline int cellCoord(float v) { return (int)std::floor(v / ActorSpatialHash::kCellSize); }
+
+} // namespace
+
+ActorSpatialHash::~ActorSpatialHash() {
+    clear();
+}
+
+void ActorSpatialHash::clear() {
+    for (auto& actor : _actors) {
+        actor.node->release();
+    }
+    _actors.clear();
+    _oversized.clear();
+    _lookup.clear();
+    _cellStart.assign(1, 0);
+    _cellMask = 0;
+    _focusValid = false;
+}
+
+void ActorSpatialHash::add(Node* actor, const CharacterCollider& collider, const Vec3& pos, uint32_t layers,
+                           CombatantRegistry::Handle combatant) {
+    if (!actor) return;
+    actor->retain();
+    _actors.push_back({actor, collider.worldAABB, pos, layers, combatant, FLT_MAX});
+}
+
+void ActorSpatialHash::setFocus(Node* focus, float range, uint32_t layers) {
+    _focus = focus;
+    _focusRange = range;
+    _focusLayers = layers;
+}
+
+uint32_t ActorSpatialHash::hashCell(int cx, int cz) const {
+    return (((uint32_t)cx * 73856093u) ^ ((uint32_t)cz * 19349663u)) & _cellMask;
+}
+
+/**
+ * 包围盒 XZ 投影覆盖的格子范围
+ * @return bool 某个轴上覆盖的格子数超过 kMaxCellSpan 时返回 false
+ */
+bool ActorSpatialHash::cellSpan(const AABB& box, int& x0, int& z0, int& x1, int& z1) const {
+    if ((box._max.x - box._min.x) > kCellSize * (kMaxCellSpan - 1) ||
+        (box._max.z - box._min.z) > kCellSize * (kMaxCellSpan - 1)) {
+        return false;
+    }
+    x0 = cellCoord(box._min.x);
+    z0 = cellCoord(box._min.z);
+    x1 = cellCoord(box._max.x);
+    z1 = cellCoord(box._max.z);
+    return true;
+}
+
+void ActorSpatialHash::nextStamp() {
+    if (++_stamp == 0) {
+        std::fill(_visitStamp.begin(), _visitStamp.end(), 0u);
+        _stamp = 1;
+    }
+}
+
+/**
+ * 计数排序建立哈希表：桶数取不小于两倍登记次数的 2 的幂
+ */
+void ActorSpatialHash::build() {
+    _lastQueries = _queries;
+    _lastCandidates = _candidates;
+    _queries = 0;
+    _candidates = 0;
+
+    const int count = (int)_actors.size();
+    _visitStamp.assign(count, 0);
+    _stamp = 0;
+    _oversized.clear();
+
+    // 1. 统计登记次数，确定桶数
+    uint32_t entries = 0;
+    int x0, z0, x1, z1;
+    for (int i = 0; i < count; ++i) {
+        if (cellSpan(_actors[i].box, x0, z0, x1, z1)) {
+            entries += (uint32_t)((x1 - x0 + 1) * (z1 - z0 + 1));
+        } else {
+            _oversized.push_back(i);
+        }
+    }
+    uint32_t buckets = 16;
+    while (buckets < entries * 2) buckets <<= 1;
+    _cellMask = buckets - 1;
+
+    // 2. 每个桶的登记数 -> 前缀和 -> 分发
+    _cellStart.assign(buckets + 1, 0);
+    for (int i = 0; i < count; ++i) {
+        if (!cellSpan(_actors[i].box, x0, z0, x1, z1)) continue;
+        for (int cz = z0; cz <= z1; ++cz) {
+            for (int cx = x0; cx <= x1; ++cx) ++_cellStart[hashCell(cx, cz) + 1];
+        }
+    }
+    for (uint32_t b = 1; b <= buckets; ++b) _cellStart[b] += _cellStart[b - 1];
+
+    _cellActors.resize(entries);
+    _cellCursor.assign(_cellStart.begin(), _cellStart.end() - 1);
+    for (int i = 0; i < count; ++i) {
+        if (!cellSpan(_actors[i].box, x0, z0, x1, z1)) continue;
+        for (int cz = z0; cz <= z1; ++cz) {
+            for (int cx = x0; cx <= x1; ++cx) _cellActors[_cellCursor[hashCell(cx, cz)]++] = i;
+        }
+    }
+
+    _lookup.resize(count);
+    for (int i = 0; i < count; ++i) _lookup[i] = std::make_pair((const Node*)_actors[i].node, (int32_t)i);
+    std::sort(_lookup.begin(), _lookup.end());
+
+    // 3. 焦点周围的角色缓存到焦点的距离
+    _focusValid = false;
+    if (!_focus) return;
+    auto it = std::lower_bound(_lookup.begin(), _lookup.end(), std::make_pair((const Node*)_focus, (int32_t)-1));
+    if (it == _lookup.end() || it->first != _focus) return;
+
+    const Vec3 focusPos = _actors[it->second].pos;
+    const float rangeSq = _focusRange * _focusRange;
+    forEachCandidate(focusPos.x - _focusRange, focusPos.z - _focusRange, focusPos.x + _focusRange,
+                     focusPos.z + _focusRange, _focusLayers, _focus, [&](int i) {
+                         const float d = _actors[i].pos.distanceSquared(focusPos);
+                         if (d <= rangeSq) _actors[i].focusDist = std::sqrt(d);
+                     });
+    _focusValid = true;
+}
+
+template <typename Visitor>
+void ActorSpatialHash::forEachCandidate(float minX, float minZ, float maxX, float maxZ, uint32_t layers,
+                                        const Node* exclude, Visitor visit) {
+    ++_queries;
+    const int count = (int)_actors.size();
+    if (count == 0) return;
+
+    auto accept = [&](int i) {
+        const Actor& actor = _actors[i];
+        if (!(actor.layers & layers) || actor.node == exclude) return;
+        ++_candidates;
+        visit(i);
+    };
+
+    // 查询范围覆盖的格子比桶还多时，直接扫描全部角色
+    const float spanX = std::floor(maxX / kCellSize) - std::floor(minX / kCellSize) + 1.0f;
+    const float spanZ = std::floor(maxZ / kCellSize) - std::floor(minZ / kCellSize) + 1.0f;
+    if (spanX * spanZ > (float)(_cellMask + 1)) {
+        for (int i = 0; i < count; ++i) accept(i);
+        return;
+    }
+
+    nextStamp();
+    const int x0 = cellCoord(minX), z0 = cellCoord(minZ);
+    const int x1 = cellCoord(maxX), z1 = cellCoord(maxZ);
+    for (int cz = z0; cz <= z1; ++cz) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            const uint32_t bucket = hashCell(cx, cz);
+            for (uint32_t k = _cellStart[bucket]; k < _cellStart[bucket + 1]; ++k) {
+                const int i = _cellActors[k];
+                if (_visitStamp[i] == _stamp) continue;
+                _visitStamp[i] = _stamp;
+                accept(i);
+            }
+        }
+    }
+    for (int i : _oversized) accept(i);
+}
+
+int ActorSpatialHash::queryAABB(const AABB& box, uint32_t layers, std::vector<Node*>& out, const Node* exclude) {
+    const int before = (int)out.size();
+    forEachCandidate(box._min.x, box._min.z, box._max.x, box._max.z, layers, exclude, [&](int i) {
+        if (_actors[i].box.intersects(box)) out.push_back(_actors[i].node);
+    });
+    return (int)out.size() - before;
+}
+
+int ActorSpatialHash::queryCombatants(const AABB& box, uint32_t layers, std::vector<CombatantRegistry::Handle>& out,
+                                      const Node* exclude) {
+    const int before = (int)out.size();
+    forEachCandidate(box._min.x, box._min.z, box._max.x, box._max.z, layers, exclude, [&](int i) {
+        if (_actors[i].combatant != CombatantRegistry::kInvalidHandle && _actors[i].box.intersects(box)) {
+            out.push_back(_actors[i].combatant);
+        }
+    });
+    return (int)out.size() - before;
+}
+
+int ActorSpatialHash::queryRadius(const Vec3& center, float radius, uint32_t layers, std::vector<Node*>& out,
+                                  const Node* exclude) {
+    const int before = (int)out.size();
+    const float radiusSq = radius * radius;
+    forEachCandidate(center.x - radius, center.z - radius, center.x + radius, center.z + radius, layers, exclude,
+                     [&](int i) {
+                         // 球心到包围盒的最近点
+                         const AABB& box = _actors[i].box;
+                         const Vec3 p(std::min(std::max(center.x, box._min.x), box._max.x),
+                                      std::min(std::max(center.y, box._min.y), box._max.y),
+                                      std::min(std::max(center.z, box._min.z), box._max.z));
+                         if (p.distanceSquared(center) <= radiusSq) out.push_back(_actors[i].node);
+                     });
+    return (int)out.size() - before;
+}
+
+int ActorSpatialHash::queryNearest(const Vec3& center, int k, float maxRadius, uint32_t layers,
+                                   std::vector<Node*>& out, const Node* exclude) {
+    if (k <= 0) return 0;
+    _nearest.clear();
+    const float radiusSq = maxRadius * maxRadius;
+    forEachCandidate(center.x - maxRadius, center.z - maxRadius, center.x + maxRadius, center.z + maxRadius, layers,
+                     exclude, [&](int i) {
+                         const float d = _actors[i].pos.distanceSquared(center);
+                         if (d <= radiusSq) _nearest.push_back(std::make_pair(d, (int32_t)i));
+                     });
+
+    const int found = std::min(k, (int)_nearest.size());
+    std::partial_sort(_nearest.begin(), _nearest.begin() + found, _nearest.end());
+    for (int n = 0; n < found; ++n) out.push_back(_actors[_nearest[n].second].node);
+    return found;
+}
+
+bool ActorSpatialHash::sweepAABB(const AABB& box, const Vec3& delta, uint32_t layers, SweepHit& outHit,
+                                 const Node* exclude) {
+    bool found = false;
+    outHit = SweepHit();
+    forEachCandidate(std::min(box._min.x, box._min.x + delta.x), std::min(box._min.z, box._min.z + delta.z),
+                     std::max(box._max.x, box._max.x + delta.x), std::max(box._max.z, box._max.z + delta.z), layers,
+                     exclude, [&](int i) {
+                         float toi;
+                         Vec3 normal;
+                         if (!CharacterCollider::sweepAABB(box, delta, _actors[i].box, toi, normal)) return;
+                         if (found && toi >= outHit.toi) return;
+                         found = true;
+                         outHit.toi = toi;
+                         outHit.normal = normal;
+                         outHit.node = _actors[i].node;
+                         outHit.combatant = _actors[i].combatant;
+                     });
+    return found;
+}
+
+bool ActorSpatialHash::getFocusDistance(const Node* actor, float& outDist) const {
+    if (!_focusValid) return false;
+    auto it = std::lower_bound(_lookup.begin(), _lookup.end(), std::make_pair(actor, (int32_t)-1));
+    if (it == _lookup.end() || it->first != actor) return false;
+    outDist = _actors[it->second].focusDist;
+    return true;
+}
@@ -0,0 +1,169 @@
+#ifndef __ACTOR_SPATIAL_HASH_H__
+#define __ACTOR_SPATIAL_HASH_H__
+
+#include "cocos2d.h"
+#include "CharacterCollider.h"
+#include "CombatantRegistry.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @class ActorSpatialHash
+ * @brief 角色（玩家与敌人）的动态宽相：按世界 AABB 的 XZ 投影建立的均匀空间哈希
+ *
+ * 场景在所有子节点更新之后调用 clear / add / build，每帧按各角色 CharacterCollider::worldAABB 重建一次，
+ * 之后的查询（玩家推挤、近战命中、敌人感知）只扫描附近格子里的角色，开销不随敌人总数增长。
+ * 包围盒覆盖多个格子的角色登记在每个格子中（偏移表 + 扁平索引，计数排序），查询时按序号去重；
+ * 覆盖格子过多的角色单独存放，每次查询都检查。
+ *
+ * 表中是上一帧结束时的包围盒，查询结果只作为候选，精确检测应使用角色当前的包围盒，
+ * 查询范围外扩 kQueryMargin 覆盖一帧内的位移。
+ *
+ * 焦点（玩家）：build 时对焦点周围 focusRange 内的角色求一次到焦点的距离并缓存，
+ * 敌人的感知判断直接读取，不再各自计算世界坐标与距离。
+ */
+class ActorSpatialHash {
+public:
+    enum Layer : uint32_t {
+        kLayerPlayer = 1u << 0,
+        kLayerEnemy = 1u << 1,
+        kLayerAll = 0xffffffffu
+    };
+
+    static constexpr float kCellSize = 100.0f;   ///< 格子边长，约为普通角色包围盒宽度的两倍
+    static constexpr float kQueryMargin = 20.0f; ///< 查询范围的外扩距离
+    static const int kMaxCellSpan = 8;           ///< 包围盒在单个轴上覆盖的格子数超过该值时单独存放
+
+    /**
+     * @brief 扫掠查询的首次接触
+     */
+    struct SweepHit {
+        float toi = 1.0f;                           ///< 接触时间，范围 [0, 1]
+        cocos2d::Vec3 normal = cocos2d::Vec3::ZERO; ///< 接触面法线，由被碰到的角色指向扫掠的包围盒
+        cocos2d::Node* node = nullptr;              ///< 被碰到的角色
+        CombatantRegistry::Handle combatant = CombatantRegistry::kInvalidHandle; ///< 被碰到角色的句柄
+    };
+
+    ~ActorSpatialHash();
+
+    /**
+     * @brief 清空上一帧的角色并释放引用
+     */
+    void clear();
+
+    /**
+     * @brief 登记一个角色，build 前保持引用
+     * @param actor 角色节点
+     * @param collider 角色的碰撞器，取其 worldAABB
+     * @param pos 角色的世界坐标（脚底）
+     * @param layers 角色所属的层（Layer 按位或）
+     * @param combatant 角色在 CombatantRegistry 中的句柄
+     */
+    void add(cocos2d::Node* actor, const CharacterCollider& collider, const cocos2d::Vec3& pos, uint32_t layers,
+             CombatantRegistry::Handle combatant = CombatantRegistry::kInvalidHandle);
+
+    /**
+     * @brief 设置焦点角色，在下一次 build 时生效
+     * @param focus 焦点角色（为空时不缓存距离）
+     * @param range 缓存距离的范围
+     * @param layers 缓存距离的角色层
+     */
+    void setFocus(cocos2d::Node* focus, float range, uint32_t layers);
+    cocos2d::Node* getFocus() const { return _focus; }
+
+    /**
+     * @brief 建立哈希表与焦点距离缓存
+     */
+    void build();
+
+    /**
+     * @brief 包围盒与 box 相交的角色
+     * @param exclude 跳过的角色（通常是查询者自己）
+     * @return int 追加到 out 的角色数
+     */
+    int queryAABB(const cocos2d::AABB& box, uint32_t layers, std::vector<cocos2d::Node*>& out,
+                  const cocos2d::Node* exclude = nullptr);
+
+    /**
+     * @brief 同 queryAABB，输出角色的 CombatantRegistry 句柄（跳过没有登记的角色）
+     */
+    int queryCombatants(const cocos2d::AABB& box, uint32_t layers, std::vector<CombatantRegistry::Handle>& out,
+                        const cocos2d::Node* exclude = nullptr);
+
+    /**
+     * @brief 包围盒与以 center 为球心、radius 为半径的球相交的角色
+     */
+    int queryRadius(const cocos2d::Vec3& center, float radius, uint32_t layers, std::vector<cocos2d::Node*>& out,
+                    const cocos2d::Node* exclude = nullptr);
+
+    /**
+     * @brief maxRadius 内离 center 最近的 k 个角色（按角色坐标的距离升序）
+     */
+    int queryNearest(const cocos2d::Vec3& center, int k, float maxRadius, uint32_t layers,
+                     std::vector<cocos2d::Node*>& out, const cocos2d::Node* exclude = nullptr);
+
+    /**
+     * @brief 包围盒沿 delta 平移时最先碰到的角色（CharacterCollider::sweepAABB）
+     * 起始时已与包围盒相交的角色不算接触；表中是上一帧结束时的包围盒，接触后仍应按角色当前的包围盒推出
+     * @return bool 是否碰到角色
+     */
+    bool sweepAABB(const cocos2d::AABB& box, const cocos2d::Vec3& delta, uint32_t layers, SweepHit& outHit,
+                   const cocos2d::Node* exclude = nullptr);
+
+    /**
+     * @brief 读取 build 时缓存的角色到焦点的距离
+     * @param outDist 输出：距离，角色在焦点范围外时为 FLT_MAX
+     * @return bool 角色不在表中或没有焦点时返回 false
+     */
+    bool getFocusDistance(const cocos2d::Node* actor, float& outDist) const;
+
+    int getActorCount() const { return (int)_actors.size(); }
+
+    /// 统计：上一帧查询次数与检查的候选数
+    int getLastQueryCount() const { return _lastQueries; }
+    int getLastCandidateCount() const { return _lastCandidates; }
+
+private:
+    struct Actor {
+        cocos2d::Node* node;
+        cocos2d::AABB box;
+        cocos2d::Vec3 pos;
+        uint32_t layers;
+        CombatantRegistry::Handle combatant;
+        float focusDist;
+    };
+
+    std::vector<Actor> _actors;
+    std::vector<uint32_t> _visitStamp; ///< 等于 _stamp 时角色在本次查询中已检查过
+    uint32_t _stamp = 0;
+
+    // 空间哈希：桶 b 的角色为 _cellActors[_cellStart[b], _cellStart[b + 1])
+    std::vector<uint32_t> _cellStart;
+    std::vector<uint32_t> _cellCursor;
+    std::vector<int32_t> _cellActors;
+    std::vector<int32_t> _oversized;
+    uint32_t _cellMask = 0;
+
+    std::vector<std::pair<const cocos2d::Node*, int32_t>> _lookup; ///< 按节点地址排序，用于读取焦点距离
+    std::vector<std::pair<float, int32_t>> _nearest;
+
+    cocos2d::Node* _focus = nullptr;
+    float _focusRange = 0.0f;
+    uint32_t _focusLayers = 0;
+    bool _focusValid = false;
+
+    int _queries = 0, _candidates = 0;
+    int _lastQueries = 0, _lastCandidates = 0;
+
+    uint32_t hashCell(int cx, int cz) const;
+    bool cellSpan(const cocos2d::AABB& box, int& x0, int& z0, int& x1, int& z1) const;
+    void nextStamp();
+
+    /// 对 XZ 范围内格子里的角色逐个调用 visit（每个角色最多一次）
+    template <typename Visitor>
+    void forEachCandidate(float minX, float minZ, float maxX, float maxZ, uint32_t layers,
+                          const cocos2d::Node* exclude, Visitor visit);
+};
+
+#endif // __ACTOR_SPATIAL_HASH_H__
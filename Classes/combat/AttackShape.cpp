@@ -0,0 +1,397 @@
+#include "AttackShape.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define ATTACK_SHAPE_SIMD 1
+#endif
+
+USING_NS_CC;
+
+namespace {
+
+const float kEpsilon = 1e-6f;
+const float kPadMin = 1e30f;  ///< 填充包围盒的下限（大于上限，永远不会命中）
+const float kPadMax = -1e30f;
+
+// 标量版本：一条通道，掩码为 bool
+inline float vSplat(float x, float) { return x; }
+inline float vLoad(const float* p) { return *p; }
+inline float vAdd(float a, float b) { return a + b; }
+inline float vSub(float a, float b) { return a - b; }
+inline float vMul(float a, float b) { return a * b; }
+inline float vMin(float a, float b) { return std::min(a, b); }
+inline float vMax(float a, float b) { return std::max(a, b); }
+inline float vAbs(float a) { return std::fabs(a); }
+inline bool vLe(float a, float b) { return a <= b; }
+inline bool vGe(float a, float b) { return a >= b; }
+inline bool vAnd(bool a, bool b) { return a && b; }
+inline bool vOr(bool a, bool b) { return a || b; }
+inline int vMoveMask(bool a) { return a ? 1 : 0; }
+
+#if defined(__AVX__)
+
+typedef __m256 VFloat;
+inline VFloat vSplat(float x, VFloat) { return _mm256_set1_ps(x); }
+inline VFloat vLoadV(const float* p) { return _mm256_loadu_ps(p); }
+inline VFloat vAdd(VFloat a, VFloat b) { return _mm256_add_ps(a, b); }
+inline VFloat vSub(VFloat a, VFloat b) { return _mm256_sub_ps(a, b); }
+inline VFloat vMul(VFloat a, VFloat b) { return _mm256_mul_ps(a, b); }
+inline VFloat vMin(VFloat a, VFloat b) { return _mm256_min_ps(a, b); }
+inline VFloat vMax(VFloat a, VFloat b) { return _mm256_max_ps(a, b); }
+inline VFloat vAbs(VFloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+inline VFloat vLe(VFloat a, VFloat b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+inline VFloat vGe(VFloat a, VFloat b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline VFloat vAnd(VFloat a, VFloat b) { return _mm256_and_ps(a, b); }
+inline VFloat vOr(VFloat a, VFloat b) { return _mm256_or_ps(a, b); }
+inline int vMoveMask(VFloat a) { return _mm256_movemask_ps(a); }
+
+#elif defined(ATTACK_SHAPE_SIMD)
+
+typedef __m128 VFloat;
+inline VFloat vSplat(float x, VFloat) { return _mm_set1_ps(x); }
+inline VFloat vLoadV(const float* p) { return _mm_loadu_ps(p); }
+inline VFloat vAdd(VFloat a, VFloat b) { return _mm_add_ps(a, b); }
+inline VFloat vSub(VFloat a, VFloat b) { return _mm_sub_ps(a, b); }
+inline VFloat vMul(VFloat a, VFloat b) { return _mm_mul_ps(a, b); }
+inline VFloat vMin(VFloat a, VFloat b) { return _mm_min_ps(a, b); }
+inline VFloat vMax(VFloat a, VFloat b) { return _mm_max_ps(a, b); }
+inline VFloat vAbs(VFloat a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline VFloat vLe(VFloat a, VFloat b) { return _mm_cmple_ps(a, b); }
+inline VFloat vGe(VFloat a, VFloat b) { return _mm_cmpge_ps(a, b); }
+inline VFloat vAnd(VFloat a, VFloat b) { return _mm_and_ps(a, b); }
+inline VFloat vOr(VFloat a, VFloat b) { return _mm_or_ps(a, b); }
+inline int vMoveMask(VFloat a) { return _mm_movemask_ps(a); }
+
+#endif
+
+/**
+ * 摆放到世界中的形状：判定需要的标量全部预先算好，对所有目标通道共用
+ */
+struct Placed {
+    AttackShape::Type type;
+    float ox, oz;       ///< Sector / Ring 的圆心，Capsule 的起点，OrientedBox 的中心
+    float fx, fz;       ///< 朝向（已归一化）
+    float sx, sz;       ///< 右侧方向
+    float yMin, yMax;   ///< 世界高度范围
+
+    float r2;           ///< Sector / Ring 外半径的平方，Capsule 半径的平方
+    float inner2;       ///< Ring 内半径的平方
+    float cosA, cos2;   ///< Sector 半角的余弦及其平方
+    bool fullCircle;    ///< Sector 半角达到 180 度
+    float elx, elz;     ///< Sector 左边界（长度为半径）
+    float erx, erz;     ///< Sector 右边界
+    float dx, dz;       ///< Capsule 轴线向量
+    float invDD;        ///< Capsule 轴线长度平方的倒数（长度为 0 时为 0）
+    float hl, hw;       ///< OrientedBox 的半长与半宽
+};
+
+Placed place(const AttackShape& shape, const Vec3& origin, const Vec3& forward) {
+    Placed p;
+    p.type = shape.type;
+
+    float fx = forward.x, fz = forward.z;
+    const float len = std::sqrt(fx * fx + fz * fz);
+    if (len > kEpsilon) {
+        fx /= len;
+        fz /= len;
+    } else {
+        fx = 0.0f;
+        fz = 1.0f;
+    }
+    p.fx = fx;
+    p.fz = fz;
+    p.sx = fz;
+    p.sz = -fx;
+    p.yMin = origin.y + shape.minY;
+    p.yMax = origin.y + shape.maxY;
+    p.ox = origin.x;
+    p.oz = origin.z;
+    p.r2 = shape.radius * shape.radius;
+    p.inner2 = shape.innerRadius * shape.innerRadius;
+    p.cosA = p.cos2 = 0.0f;
+    p.fullCircle = false;
+    p.elx = p.elz = p.erx = p.erz = 0.0f;
+    p.dx = p.dz = p.invDD = 0.0f;
+    p.hl = p.hw = 0.0f;
+
+    switch (shape.type) {
+    case AttackShape::Type::Sector: {
+        const float a = CC_DEGREES_TO_RADIANS(std::min(shape.halfAngle, 180.0f));
+        p.cosA = std::cos(a);
+        p.cos2 = p.cosA * p.cosA;
+        p.fullCircle = shape.halfAngle >= 180.0f;
+        const float sinA = std::sin(a);
+        // 朝向分别向两侧旋转半角
+        p.elx = (fx * p.cosA - fz * sinA) * shape.radius;
+        p.elz = (fz * p.cosA + fx * sinA) * shape.radius;
+        p.erx = (fx * p.cosA + fz * sinA) * shape.radius;
+        p.erz = (fz * p.cosA - fx * sinA) * shape.radius;
+        break;
+    }
+    case AttackShape::Type::Capsule: {
+        p.ox += fx * shape.offset;
+        p.oz += fz * shape.offset;
+        p.dx = fx * shape.length;
+        p.dz = fz * shape.length;
+        const float dd = p.dx * p.dx + p.dz * p.dz;
+        p.invDD = dd > kEpsilon ? 1.0f / dd : 0.0f;
+        break;
+    }
+    case AttackShape::Type::OrientedBox:
+        p.hl = shape.length * 0.5f;
+        p.hw = shape.halfWidth;
+        p.ox += fx * (shape.offset + p.hl);
+        p.oz += fz * (shape.offset + p.hl);
+        break;
+    case AttackShape::Type::Ring:
+        p.ox += fx * shape.offset;
+        p.oz += fz * shape.offset;
+        break;
+    }
+    return p;
+}
+
+/// 点 (cx, cz) 到矩形的距离平方
+template <typename V>
+V distPointRect2(float cx, float cz, V x0, V x1, V z0, V z1) {
+    const V px = vSub(vMin(vMax(vSplat(cx, x0), x0), x1), vSplat(cx, x0));
+    const V pz = vSub(vMin(vMax(vSplat(cz, x0), z0), z1), vSplat(cz, x0));
+    return vAdd(vMul(px, px), vMul(pz, pz));
+}
+
+/// 各通道的点 (cx, cz) 到线段 A + t * D（t ∈ [0, 1]）的距离平方
+template <typename V>
+V distPointSeg2(V cx, V cz, float ax, float az, float dx, float dz, float invDD) {
+    const V rx = vSub(cx, vSplat(ax, cx));
+    const V rz = vSub(cz, vSplat(az, cx));
+    V t = vMul(vAdd(vMul(rx, vSplat(dx, cx)), vMul(rz, vSplat(dz, cx))), vSplat(invDD, cx));
+    t = vMin(vMax(t, vSplat(0.0f, cx)), vSplat(1.0f, cx));
+    const V qx = vSub(rx, vMul(t, vSplat(dx, cx)));
+    const V qz = vSub(rz, vMul(t, vSplat(dz, cx)));
+    return vAdd(vMul(qx, qx), vMul(qz, qz));
+}
+
+/// 线段 P + t * D（t ∈ [0, 1]）是否穿过矩形（slab 法，线段方向对所有通道相同）
+template <typename V>
+auto segHitsRect(float px, float pz, float dx, float dz, V x0, V x1, V z0, V z1) -> decltype(vLe(x0, x1)) {
+    V tmin = vSplat(0.0f, x0);
+    V tmax = vSplat(1.0f, x0);
+    const bool flatX = std::fabs(dx) < kEpsilon;
+    const bool flatZ = std::fabs(dz) < kEpsilon;
+    if (!flatX) {
+        const V inv = vSplat(1.0f / dx, x0);
+        const V t1 = vMul(vSub(x0, vSplat(px, x0)), inv);
+        const V t2 = vMul(vSub(x1, vSplat(px, x0)), inv);
+        tmin = vMax(tmin, vMin(t1, t2));
+        tmax = vMin(tmax, vMax(t1, t2));
+    }
+    if (!flatZ) {
+        const V inv = vSplat(1.0f / dz, x0);
+        const V t1 = vMul(vSub(z0, vSplat(pz, x0)), inv);
+        const V t2 = vMul(vSub(z1, vSplat(pz, x0)), inv);
+        tmin = vMax(tmin, vMin(t1, t2));
+        tmax = vMin(tmax, vMax(t1, t2));
+    }
+    auto hit = vLe(tmin, tmax);
+    // 与坐标轴平行时，该轴上的起点必须落在矩形范围内
+    if (flatX) hit = vAnd(hit, vAnd(vGe(vSplat(px, x0), x0), vLe(vSplat(px, x0), x1)));
+    if (flatZ) hit = vAnd(hit, vAnd(vGe(vSplat(pz, x0), z0), vLe(vSplat(pz, x0), z1)));
+    return hit;
+}
+
+/**
+ * 判定核心：标量与 SIMD 共用，V 为 float 时掩码是 bool，否则是逐通道的全 1 / 全 0
+ */
+template <typename V>
+auto testLanes(const Placed& p, V x0, V y0, V z0, V x1, V y1, V z1) -> decltype(vLe(x0, x1)) {
+    const auto vertical = vAnd(vGe(y1, vSplat(p.yMin, x0)), vLe(y0, vSplat(p.yMax, x0)));
+
+    switch (p.type) {
+    case AttackShape::Type::Sector: {
+        // 矩形上离圆心最近的点在扇形内，或扇形的任一条边界穿过矩形
+        const V px = vSub(vMin(vMax(vSplat(p.ox, x0), x0), x1), vSplat(p.ox, x0));
+        const V pz = vSub(vMin(vMax(vSplat(p.oz, x0), z0), z1), vSplat(p.oz, x0));
+        const V d2 = vAdd(vMul(px, px), vMul(pz, pz));
+        const auto inDisc = vLe(d2, vSplat(p.r2, x0));
+        if (p.fullCircle) return vAnd(vertical, inDisc);
+
+        const V along = vAdd(vMul(px, vSplat(p.fx, x0)), vMul(pz, vSplat(p.fz, x0)));
+        const V along2 = vMul(along, along);
+        const V limit2 = vMul(d2, vSplat(p.cos2, x0));
+        const auto front = vGe(along, vSplat(0.0f, x0));
+        const auto inWedge = p.cosA >= 0.0f ? vAnd(front, vGe(along2, limit2)) : vOr(front, vLe(along2, limit2));
+        const auto edges = vOr(segHitsRect(p.ox, p.oz, p.elx, p.elz, x0, x1, z0, z1),
+                               segHitsRect(p.ox, p.oz, p.erx, p.erz, x0, x1, z0, z1));
+        return vAnd(vertical, vAnd(inDisc, vOr(inWedge, edges)));
+    }
+    case AttackShape::Type::Capsule: {
+        // 轴线穿过矩形，或轴线端点到矩形、矩形顶点到轴线的最近距离不超过半径
+        const V r2 = vSplat(p.r2, x0);
+        auto hit = segHitsRect(p.ox, p.oz, p.dx, p.dz, x0, x1, z0, z1);
+        hit = vOr(hit, vLe(distPointRect2(p.ox, p.oz, x0, x1, z0, z1), r2));
+        hit = vOr(hit, vLe(distPointRect2(p.ox + p.dx, p.oz + p.dz, x0, x1, z0, z1), r2));
+        V d = distPointSeg2(x0, z0, p.ox, p.oz, p.dx, p.dz, p.invDD);
+        d = vMin(d, distPointSeg2(x1, z0, p.ox, p.oz, p.dx, p.dz, p.invDD));
+        d = vMin(d, distPointSeg2(x0, z1, p.ox, p.oz, p.dx, p.dz, p.invDD));
+        d = vMin(d, distPointSeg2(x1, z1, p.ox, p.oz, p.dx, p.dz, p.invDD));
+        return vAnd(vertical, vOr(hit, vLe(d, r2)));
+    }
+    case AttackShape::Type::OrientedBox: {
+        // 分离轴：世界 X / Z 轴与矩形的朝向 / 侧向
+        const V half = vSplat(0.5f, x0);
+        const V hx = vMul(vSub(x1, x0), half);
+        const V hz = vMul(vSub(z1, z0), half);
+        const V dx = vSub(vSplat(p.ox, x0), vMul(vAdd(x0, x1), half));
+        const V dz = vSub(vSplat(p.oz, x0), vMul(vAdd(z0, z1), half));
+        const float afx = std::fabs(p.fx), afz = std::fabs(p.fz);
+        const float asx = std::fabs(p.sx), asz = std::fabs(p.sz);
+
+        auto hit = vLe(vAbs(dx), vAdd(hx, vSplat(afx * p.hl + asx * p.hw, x0)));
+        hit = vAnd(hit, vLe(vAbs(dz), vAdd(hz, vSplat(afz * p.hl + asz * p.hw, x0))));
+        const V projF = vAdd(vMul(dx, vSplat(p.fx, x0)), vMul(dz, vSplat(p.fz, x0)));
+        const V extF = vAdd(vSplat(p.hl, x0), vAdd(vMul(hx, vSplat(afx, x0)), vMul(hz, vSplat(afz, x0))));
+        hit = vAnd(hit, vLe(vAbs(projF), extF));
+        const V projS = vAdd(vMul(dx, vSplat(p.sx, x0)), vMul(dz, vSplat(p.sz, x0)));
+        const V extS = vAdd(vSplat(p.hw, x0), vAdd(vMul(hx, vSplat(asx, x0)), vMul(hz, vSplat(asz, x0))));
+        hit = vAnd(hit, vLe(vAbs(projS), extS));
+        return vAnd(vertical, hit);
+    }
+    case AttackShape::Type::Ring:
+    default: {
+        // 矩形到圆心的最近距离不超过外半径，最远距离不小于内半径
+        const V nearD2 = distPointRect2(p.ox, p.oz, x0, x1, z0, z1);
+        const V farX = vMax(vAbs(vSub(x0, vSplat(p.ox, x0))), vAbs(vSub(x1, vSplat(p.ox, x0))));
+        const V farZ = vMax(vAbs(vSub(z0, vSplat(p.oz, x0))), vAbs(vSub(z1, vSplat(p.oz, x0))));
+        const V farD2 = vAdd(vMul(farX, farX), vMul(farZ, farZ));
+        return vAnd(vertical, vAnd(vLe(nearD2, vSplat(p.r2, x0)), vGe(farD2, vSplat(p.inner2, x0))));
+    }
+    }
+}
+
+} // namespace
+
+AttackShape AttackShape::sector(float radius, float halfAngleDeg) {
+    AttackShape s;
+    s.type = Type::Sector;
+    s.radius = radius;
+    s.halfAngle = halfAngleDeg;
+    return s;
+}
+
+AttackShape AttackShape::capsule(float length, float radius, float offset) {
+    AttackShape s;
+    s.type = Type::Capsule;
+    s.length = length;
+    s.radius = radius;
+    s.offset = offset;
+    return s;
+}
+
+AttackShape AttackShape::orientedBox(float length, float halfWidth, float offset) {
+    AttackShape s;
+    s.type = Type::OrientedBox;
+    s.length = length;
+    s.halfWidth = halfWidth;
+    s.offset = offset;
+    return s;
+}
+
+AttackShape AttackShape::ring(float innerRadius, float outerRadius, float offset) {
+    AttackShape s;
+    s.type = Type::Ring;
+    s.innerRadius = innerRadius;
+    s.radius = outerRadius;
+    s.offset = offset;
+    return s;
+}
+
+Vec3 AttackShape::getActorForward(const Mat4& toWorld) {
+    Vec3 forward;
+    toWorld.transformVector(Vec3(0.0f, 0.0f, -1.0f), &forward);
+    return forward;
+}
+
+AABB AttackShape::getBounds(const Vec3& origin, const Vec3& forward) const {
+    const Placed p = place(*this, origin, forward);
+    float minX, maxX, minZ, maxZ;
+    switch (type) {
+    case Type::Capsule:
+        minX = std::min(p.ox, p.ox + p.dx) - radius;
+        maxX = std::max(p.ox, p.ox + p.dx) + radius;
+        minZ = std::min(p.oz, p.oz + p.dz) - radius;
+        maxZ = std::max(p.oz, p.oz + p.dz) + radius;
+        break;
+    case Type::OrientedBox: {
+        const float ex = std::fabs(p.fx) * p.hl + std::fabs(p.sx) * p.hw;
+        const float ez = std::fabs(p.fz) * p.hl + std::fabs(p.sz) * p.hw;
+        minX = p.ox - ex;
+        maxX = p.ox + ex;
+        minZ = p.oz - ez;
+        maxZ = p.oz + ez;
+        break;
+    }
+    case Type::Sector:
+    case Type::Ring:
+    default:
+        minX = p.ox - radius;
+        maxX = p.ox + radius;
+        minZ = p.oz - radius;
+        maxZ = p.oz + radius;
+        break;
+    }
+    return AABB(Vec3(minX, p.yMin, minZ), Vec3(maxX, p.yMax, maxZ));
+}
+
+bool AttackShape::test(const Vec3& origin, const Vec3& forward, const AABB& target) const {
+    const Placed p = place(*this, origin, forward);
+    return testLanes(p, target._min.x, target._min.y, target._min.z, target._max.x, target._max.y, target._max.z);
+}
+
+void AttackTargets::clear() {
+    _count = 0;
+    for (auto* arr : {&_minX, &_minY, &_minZ}) arr->assign(kLaneCount, kPadMin);
+    for (auto* arr : {&_maxX, &_maxY, &_maxZ}) arr->assign(kLaneCount, kPadMax);
+}
+
+void AttackTargets::add(const AABB& box) {
+    if (_minX.empty()) clear();
+    // 覆盖第一个填充位，再在末尾补一个
+    _minX[_count] = box._min.x;
+    _minY[_count] = box._min.y;
+    _minZ[_count] = box._min.z;
+    _maxX[_count] = box._max.x;
+    _maxY[_count] = box._max.y;
+    _maxZ[_count] = box._max.z;
+    ++_count;
+    for (auto* arr : {&_minX, &_minY, &_minZ}) arr->push_back(kPadMin);
+    for (auto* arr : {&_maxX, &_maxY, &_maxZ}) arr->push_back(kPadMax);
+}
+
+int AttackTargets::test(const AttackShape& shape, const Vec3& origin, const Vec3& forward,
+                        std::vector<uint32_t>& outMask) const {
+    outMask.assign((_count + 31) / 32, 0u);
+    if (_count == 0) return 0;
+
+    const Placed p = place(shape, origin, forward);
+    int hits = 0;
+    for (int i = 0; i < _count; i += kLaneCount) {
+#if defined(ATTACK_SHAPE_SIMD)
+        uint32_t bits = (uint32_t)vMoveMask(testLanes(p, vLoadV(&_minX[i]), vLoadV(&_minY[i]), vLoadV(&_minZ[i]),
+                                                      vLoadV(&_maxX[i]), vLoadV(&_maxY[i]), vLoadV(&_maxZ[i])));
+#else
+        uint32_t bits = (uint32_t)vMoveMask(testLanes(p, vLoad(&_minX[i]), vLoad(&_minY[i]), vLoad(&_minZ[i]),
+                                                      vLoad(&_maxX[i]), vLoad(&_maxY[i]), vLoad(&_maxZ[i])));
+#endif
+        // 越过末尾的通道是填充，不计入
+        if (_count - i < kLaneCount) bits &= (1u << (_count - i)) - 1u;
+        if (!bits) continue;
+        outMask[i >> 5] |= bits << (i & 31);
+        while (bits) {
+            bits &= bits - 1u;
+            ++hits;
+        }
+    }
+    return hits;
+}
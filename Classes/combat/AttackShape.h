@@ -0,0 +1,98 @@
+#ifndef __ATTACK_SHAPE_H__
+#define __ATTACK_SHAPE_H__
+
+#include "cocos2d.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct AttackShape
+ * @brief 攻击判定形状：在 XZ 平面上定义、沿竖直方向拉伸的区域，随攻击者的位置与朝向摆放
+ *
+ * - Sector：以攻击者为圆心、朝向两侧各 halfAngle 度的扇形（挥砍）；
+ * - Capsule：从攻击者前方 offset 处沿朝向延伸 length、半径 radius 的胶囊（突刺、棍扫）；
+ * - OrientedBox：从攻击者前方 offset 处沿朝向延伸 length、半宽 halfWidth 的矩形（冲刺斩）；
+ * - Ring：圆心在攻击者前方 offset 处、内外半径之间的圆环（震地波，内半径为 0 时是圆盘）。
+ * 高度范围 [minY, maxY] 相对攻击者脚底。
+ */
+struct AttackShape {
+    enum class Type : uint8_t {
+        Sector,
+        Capsule,
+        OrientedBox,
+        Ring
+    };
+
+    Type type = Type::Sector;
+    float radius = 0.0f;      ///< Sector / Ring 的外半径，Capsule 的半径
+    float innerRadius = 0.0f; ///< Ring 的内半径
+    float halfAngle = 0.0f;   ///< Sector 的半角（度，不超过 180）
+    float length = 0.0f;      ///< Capsule / OrientedBox 沿朝向的长度
+    float halfWidth = 0.0f;   ///< OrientedBox 的半宽
+    float offset = 0.0f;      ///< 形状起点沿朝向的偏移（Sector 不使用）
+    float minY = -50.0f;      ///< 高度范围下限（相对攻击者脚底）
+    float maxY = 200.0f;      ///< 高度范围上限（相对攻击者脚底）
+
+    static AttackShape sector(float radius, float halfAngleDeg);
+    static AttackShape capsule(float length, float radius, float offset = 0.0f);
+    static AttackShape orientedBox(float length, float halfWidth, float offset = 0.0f);
+    static AttackShape ring(float innerRadius, float outerRadius, float offset = 0.0f);
+
+    /**
+     * @brief 角色的攻击朝向：节点本地 -Z 变换到世界（模型在节点内转了 180 度，本地 +Z 朝向镜头一侧）
+     * @param toWorld 角色节点到世界的变换
+     */
+    static cocos2d::Vec3 getActorForward(const cocos2d::Mat4& toWorld);
+
+    /**
+     * @brief 摆放后的世界包围盒，供空间哈希筛选候选目标
+     * @param origin 攻击者脚底的世界坐标
+     * @param forward 攻击者朝向（只取 XZ，不要求归一化）
+     */
+    cocos2d::AABB getBounds(const cocos2d::Vec3& origin, const cocos2d::Vec3& forward) const;
+
+    /**
+     * @brief 单个目标包围盒的判定（与批量判定的结果一致）
+     */
+    bool test(const cocos2d::Vec3& origin, const cocos2d::Vec3& forward, const cocos2d::AABB& target) const;
+};
+
+/**
+ * @class AttackTargets
+ * @brief 一批目标包围盒（结构数组），供攻击形状一次性批量判定
+ *
+ * 按编译目标选择实现：定义 __AVX__ 时一次测试 8 个目标，支持 SSE2 时一次 4 个，其余平台逐个标量测试；
+ * 各实现共用同一份判定代码，结果完全相同。
+ * 数组末尾填充 kLaneCount 个上下颠倒的空包围盒，SIMD 读取越过末尾时安全且永远不会命中。
+ */
+class AttackTargets {
+public:
+#if defined(__AVX__)
+    static const int kLaneCount = 8;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    static const int kLaneCount = 4;
+#else
+    static const int kLaneCount = 1;
+#endif
+
+    void clear();
+    void add(const cocos2d::AABB& box);
+    int size() const { return _count; }
+
+    /**
+     * @brief 用摆放后的攻击形状测试全部目标
+     * @param outMask 输出：命中掩码，第 i 个目标对应 outMask[i / 32] 的第 i % 32 位
+     * @return int 命中的目标数
+     */
+    int test(const AttackShape& shape, const cocos2d::Vec3& origin, const cocos2d::Vec3& forward,
+             std::vector<uint32_t>& outMask) const;
+
+    static bool isHit(const std::vector<uint32_t>& mask, int i) { return (mask[i >> 5] >> (i & 31)) & 1u; }
+
+private:
+    int _count = 0;
+    std::vector<float> _minX, _minY, _minZ;
+    std::vector<float> _maxX, _maxY, _maxZ;
+};
+
+#endif // __ATTACK_SHAPE_H__
@@ -0,0 +1,283 @@
+#include "CapsuleSweep.h"
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+
+USING_NS_CC;
+
+namespace {
+
+const float kEpsilon = 1e-8f;
+
+inline Vec3 cross(const Vec3& a, const Vec3& b) {
+    Vec3 out;
+    Vec3::cross(a, b, &out);
+    return out;
+}
+
+/**
+ * 点到三角形的最近点（按 Voronoi 区域分类）
+ */
+Vec3 closestPointOnTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c) {
+    const Vec3 ab = b - a, ac = c - a, ap = p - a;
+    const float d1 = ab.dot(ap), d2 = ac.dot(ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+    const Vec3 bp = p - b;
+    const float d3 = ab.dot(bp), d4 = ac.dot(bp);
+    if (d3 >= 0.0f && d4 <= d3) return b;
+
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+    const Vec3 cp = p - c;
+    const float d5 = ab.dot(cp), d6 = ac.dot(cp);
+    if (d6 >= 0.0f && d5 <= d6) return c;
+
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+
+    const float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+/**
+ * 两条线段之间的最近点，返回距离平方
+ */
+float closestPointsSegmentSegment(const Vec3& p1, const Vec3& q1, const Vec3& p2, const Vec3& q2,
+                                  Vec3& c1, Vec3& c2) {
+    const Vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+    const float a = d1.dot(d1), e = d2.dot(d2), f = d2.dot(r);
+    float s, t;
+
+    if (a <= kEpsilon && e <= kEpsilon) {
+        s = t = 0.0f;
+    } else if (a <= kEpsilon) {
+        s = 0.0f;
+        t = clampf(f / e, 0.0f, 1.0f);
+    } else {
+        const float c = d1.dot(r);
+        if (e <= kEpsilon) {
+            t = 0.0f;
+            s = clampf(-c / a, 0.0f, 1.0f);
+        } else {
+            const float b = d1.dot(d2);
+            const float denom = a * e - b * b;
+            s = denom > kEpsilon ? clampf((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+            t = (b * s + f) / e;
+            if (t < 0.0f) {
+                t = 0.0f;
+                s = clampf(-c / a, 0.0f, 1.0f);
+            } else if (t > 1.0f) {
+                t = 1.0f;
+                s = clampf((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+    }
+
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+    return (c1 - c2).lengthSquared();
+}
+
+/**
+ * 射线 o + t * d 与球的首次接触时间（只取进入点）
+ */
+bool raySphere(const Vec3& o, const Vec3& d, const Vec3& center, float radius, float& t) {
+    const Vec3 m = o - center;
+    const float b = m.dot(d);
+    const float c = m.dot(m) - radius * radius;
+    if (c > 0.0f && b >= 0.0f) return false;
+    const float a = d.dot(d);
+    if (a <= kEpsilon) return false;
+    const float disc = b * b - a * c;
+    if (disc < 0.0f) return false;
+    t = (-b - std::sqrt(disc)) / a;
+    return t >= 0.0f;
+}
+
+/**
+ * 射线与有限圆柱侧面（轴线 p -> q）的首次接触时间，端面由端点球另行处理
+ */
+bool rayCylinder(const Vec3& o, const Vec3& d, const Vec3& p, const Vec3& q, float radius, float& t) {
+    const Vec3 axis = q - p;
+    const float axisLen2 = axis.dot(axis);
+    if (axisLen2 <= kEpsilon) return false;
+
+    const Vec3 m = o - p;
+    const float md = m.dot(axis);
+    const float dd = d.dot(axis);
+    // 去掉轴向分量后的二次方程 A t^2 + 2B t + C = 0
+    const float A = axisLen2 * d.dot(d) - dd * dd;
+    const float B = axisLen2 * m.dot(d) - md * dd;
+    const float C = axisLen2 * (m.dot(m) - radius * radius) - md * md;
+    // 平行于轴线，或已经在无限圆柱内部（只可能在端面之外，由端点球处理）
+    if (A <= kEpsilon * axisLen2 || C < 0.0f) return false;
+
+    const float disc = B * B - A * C;
+    if (disc < 0.0f) return false;
+    t = (-B - std::sqrt(disc)) / A;
+    if (t < 0.0f) return false;
+
+    const float s = (md + t * dd) / axisLen2;
+    return s >= 0.0f && s <= 1.0f;
+}
+
+bool pointInTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& n) {
+    return cross(b - a, p - a).dot(n) >= 0.0f &&
+           cross(c - b, p - b).dot(n) >= 0.0f &&
+           cross(a - c, p - c).dot(n) >= 0.0f;
+}
+
+} // namespace
+
+namespace CapsuleSweep {
+
+float closestPointsSegmentTriangle(const Vec3& a, const Vec3& b,
+                                   const Vec3& v0, const Vec3& v1, const Vec3& v2,
+                                   Vec3& outOnSegment, Vec3& outOnTriangle) {
+    // 线段穿过三角形时距离为 0
+    const Vec3 n = cross(v1 - v0, v2 - v0);
+    const float da = n.dot(a - v0);
+    const float db = n.dot(b - v0);
+    if ((da <= 0.0f && db >= 0.0f) || (da >= 0.0f && db <= 0.0f)) {
+        if (da != db) {
+            const Vec3 p = a + (b - a) * (da / (da - db));
+            if (pointInTriangle(p, v0, v1, v2, n)) {
+                outOnSegment = outOnTriangle = p;
+                return 0.0f;
+            }
+        }
+    }
+
+    // 否则最近点对必然包含线段端点或三角形的边
+    float best = FLT_MAX;
+    const Vec3 ends[2] = {a, b};
+    for (const Vec3& e : ends) {
+        const Vec3 q = closestPointOnTriangle(e, v0, v1, v2);
+        const float d2 = (e - q).lengthSquared();
+        if (d2 < best) {
+            best = d2;
+            outOnSegment = e;
+            outOnTriangle = q;
+        }
+    }
+
+    const Vec3 verts[3] = {v0, v1, v2};
+    for (int i = 0; i < 3; ++i) {
+        Vec3 c1, c2;
+        const float d2 = closestPointsSegmentSegment(a, b, verts[i], verts[(i + 1) % 3], c1, c2);
+        if (d2 < best) {
+            best = d2;
+            outOnSegment = c1;
+            outOnTriangle = c2;
+        }
+    }
+    return best;
+}
+
+Vec3 contactNormal(const Vec3& a, const Vec3& b, const Vec3& delta,
+                   const Vec3& v0, const Vec3& v1, const Vec3& v2, Vec3* outPoint) {
+    Vec3 onSegment, onTriangle;
+    closestPointsSegmentTriangle(a, b, v0, v1, v2, onSegment, onTriangle);
+    if (outPoint) *outPoint = onTriangle;
+
+    Vec3 n = onSegment - onTriangle;
+    if (n.lengthSquared() > 1e-10f) {
+        n.normalize();
+        return n;
+    }
+    n = cross(v1 - v0, v2 - v0);
+    if (n.lengthSquared() <= kEpsilon) return -delta.getNormalized();
+    n.normalize();
+    return n.dot(delta) > 0.0f ? -n : n;
+}
+
+bool sweepTriangle(const Vec3& a, const Vec3& b, float radius, const Vec3& delta,
+                   const Vec3& v0, const Vec3& v1, const Vec3& v2, float& outToi) {
+    const float r2 = radius * radius;
+
+    // 0. 起始时已相交：只在朝三角形移动时报告接触
+    Vec3 onSegment, onTriangle;
+    if (closestPointsSegmentTriangle(a, b, v0, v1, v2, onSegment, onTriangle) <= r2) {
+        if (contactNormal(a, b, delta, v0, v1, v2).dot(delta) < 0.0f) {
+            outToi = 0.0f;
+            return true;
+        }
+        return false;
+    }
+
+    float best = 1.0f;
+    bool hit = false;
+    auto consider = [&](float t) {
+        if (t >= 0.0f && t <= best) {
+            best = t;
+            hit = true;
+        }
+    };
+
+    const Vec3 verts[3] = {v0, v1, v2};
+    const Vec3 ends[2] = {a, b};
+    const Vec3 axis = b - a;
+    float t;
+
+    // 1. 端点球对三角形面
+    Vec3 n = cross(v1 - v0, v2 - v0);
+    const float nLen = n.length();
+    if (nLen > kEpsilon) {
+        n *= 1.0f / nLen;
+        const float nd = n.dot(delta);
+        for (const Vec3& e : ends) {
+            const float dist = n.dot(e - v0);
+            const float side = dist >= 0.0f ? 1.0f : -1.0f;
+            if (side * nd >= 0.0f) continue;
+            t = (side * radius - dist) / nd;
+            if (t < 0.0f || t > best) continue;
+            if (pointInTriangle(e + delta * t - n * (side * radius), v0, v1, v2, n)) consider(t);
+        }
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        const Vec3& p = verts[i];
+        const Vec3& q = verts[(i + 1) % 3];
+
+        // 2. 端点球对边（圆柱侧面）与顶点（球）
+        for (const Vec3& e : ends) {
+            if (rayCylinder(e, delta, p, q, radius, t)) consider(t);
+            if (raySphere(e, delta, p, radius, t)) consider(t);
+        }
+
+        // 3. 三角形顶点对胶囊轴线：在胶囊参考系下顶点沿 -delta 运动
+        if (rayCylinder(p, -delta, a, b, radius, t)) consider(t);
+
+        // 4. 三角形边对胶囊轴线：两直线距离达到半径，且最近点都落在线段内部
+        const Vec3 edge = q - p;
+        Vec3 m = cross(edge, axis);
+        const float mLen2 = m.lengthSquared();
+        if (mLen2 > kEpsilon * edge.lengthSquared() * axis.lengthSquared() && mLen2 > kEpsilon) {
+            m *= 1.0f / std::sqrt(mLen2);
+            const float md = m.dot(delta);
+            const float dist = m.dot(a - p);
+            const float side = dist >= 0.0f ? 1.0f : -1.0f;
+            if (side * md < 0.0f) {
+                t = (side * radius - dist) / md;
+                if (t >= 0.0f && t <= best) {
+                    Vec3 c1, c2;
+                    const Vec3 moved = a + delta * t;
+                    closestPointsSegmentSegment(moved, moved + axis, p, q, c1, c2);
+                    if (std::fabs((c1 - c2).length() - radius) <= radius * 1e-3f + 1e-4f) consider(t);
+                }
+            }
+        }
+    }
+
+    if (hit) outToi = best;
+    return hit;
+}
+
+} // namespace CapsuleSweep
@@ -0,0 +1,85 @@
+#ifndef __CAPSULE_SWEEP_H__
+#define __CAPSULE_SWEEP_H__
+
+#include "cocos2d.h"
+
+/**
+ * @brief 胶囊体扫掠与最近点计算（纯几何，不依赖加速结构）
+ *
+ * 胶囊体由轴线线段 (a, b) 与半径 radius 描述。平移扫掠与三角形的首次接触时间
+ * 按特征对逐一解析求解：端点球对三角形面 / 边 / 顶点、三角形顶点对轴线、三角形边对轴线，
+ * 取其中最早的一个。接触法线在接触时刻由线段与三角形的最近点求得，各特征共用。
+ */
+namespace CapsuleSweep {
+
+/**
+ * @brief 计算胶囊体沿 delta 平移时与三角形的首次接触时间
+ * @param a, b 胶囊轴线端点（起始位置）
+ * @param radius 胶囊半径
+ * @param delta 平移量，接触点为 a + delta * outToi
+ * @param v0, v1, v2 三角形顶点
+ * @param outToi 输出：接触时间，范围 [0, 1]
+ * @return bool 是否接触。起始时已相交：朝三角形移动返回 toi = 0，远离则忽略该三角形（便于从穿插中退出）
+ */
+bool sweepTriangle(const cocos2d::Vec3& a, const cocos2d::Vec3& b, float radius, const cocos2d::Vec3& delta,
+                   const cocos2d::Vec3& v0, const cocos2d::Vec3& v1, const cocos2d::Vec3& v2, float& outToi);
+
+/**
+ * @brief 线段与三角形之间的最近点
+ * @param outOnSegment 输出：线段上的最近点
+ * @param outOnTriangle 输出：三角形上的最近点
+ * @return float 最近距离的平方（线段穿过三角形时为 0）
+ */
+float closestPointsSegmentTriangle(const cocos2d::Vec3& a, const cocos2d::Vec3& b,
+                                   const cocos2d::Vec3& v0, const cocos2d::Vec3& v1, const cocos2d::Vec3& v2,
+                                   cocos2d::Vec3& outOnSegment, cocos2d::Vec3& outOnTriangle);
+
+/**
+ * @brief 接触法线：由三角形指向胶囊轴线的单位向量
+ * 最近点重合时（线段穿过三角形）退化为与 delta 相对的三角形面法线
+ */
+cocos2d::Vec3 contactNormal(const cocos2d::Vec3& a, const cocos2d::Vec3& b, const cocos2d::Vec3& delta,
+                            const cocos2d::Vec3& v0, const cocos2d::Vec3& v1, const cocos2d::Vec3& v2,
+                            cocos2d::Vec3* outPoint = nullptr);
+
+/// 滑动时与墙面保持的间隙，避免下一次扫掠从相交状态开始
+const float kSlideSkin = 0.5f;
+
+/**
+ * @brief 沿墙滑动的水平移动，与具体的碰撞几何无关
+ * 每次扫掠碰到障碍后停在接触点，去掉剩余位移中指向墙面的水平分量后继续，最多 maxIterations 次
+ * @param sweep 扫掠函数 bool(const Vec3& a, const Vec3& b, const Vec3& delta, float& outToi, Vec3& outNormal)
+ * @return Vec3 实际到达的位置（Y 与 from 相同）
+ */
+template <typename SweepFn>
+cocos2d::Vec3 slide(const cocos2d::Vec3& from, const cocos2d::Vec3& axisBottom, const cocos2d::Vec3& axisTop,
+                    const cocos2d::Vec3& delta, int maxIterations, SweepFn sweep) {
+    cocos2d::Vec3 pos = from;
+    cocos2d::Vec3 remaining(delta.x, 0.0f, delta.z);
+
+    for (int i = 0; i < maxIterations && remaining.lengthSquared() > 1e-6f; ++i) {
+        float toi;
+        cocos2d::Vec3 normal;
+        if (!sweep(pos + axisBottom, pos + axisTop, remaining, toi, normal)) {
+            return pos + remaining;
+        }
+
+        // 只考虑法线的水平分量：坡面交给贴地检测，顶部碰到悬空结构时水平法线接近 0，直接停下
+        cocos2d::Vec3 wallNormal(normal.x, 0.0f, normal.z);
+        const float wallLen = wallNormal.length();
+        pos += remaining * toi;
+        if (wallLen < 0.1f) break;
+        wallNormal *= 1.0f / wallLen;
+        pos += wallNormal * kSlideSkin;
+
+        // 去掉剩余位移中指向墙面的分量，沿墙滑动
+        remaining *= 1.0f - toi;
+        const float into = remaining.dot(wallNormal);
+        if (into < 0.0f) remaining -= wallNormal * into;
+    }
+    return pos;
+}
+
+} // namespace CapsuleSweep
+
+#endif // __CAPSULE_SWEEP_H__
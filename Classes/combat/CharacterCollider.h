@@ -4,6 +4,7 @@
 #include "cocos2d.h"
 #include "3d/CCMesh.h"
 #include <vector>
+#include <algorithm>
 #include <float.h>
 
 using namespace cocos2d;
@@ -85,6 +86,25 @@ public:
         worldAABB.transform(transform);
     }
 
+    /**
+     * @brief 由世界空间 AABB 推导竖直胶囊体，用于与地形的扫掠检测
+     * @param stepHeight 胶囊底部离脚底的高度，低于该高度的台阶与坡面交给贴地检测处理
+     * @param outBottom 输出：轴线下端相对脚底的偏移
+     * @param outTop 输出：轴线上端相对脚底的偏移
+     * @param outRadius 输出：半径（取 XZ 较窄一边的一半）
+     */
+    void getCapsule(float stepHeight, Vec3& outBottom, Vec3& outTop, float& outRadius) const {
+        const float width = worldAABB._max.x - worldAABB._min.x;
+        const float depth = worldAABB._max.z - worldAABB._min.z;
+        const float height = worldAABB._max.y - worldAABB._min.y;
+        outRadius = std::max(0.5f * std::min(width, depth), 1.0f);
+
+        const float bottom = stepHeight + outRadius;
+        const float top = std::max(height - outRadius, bottom);
+        outBottom = Vec3(0.0f, bottom, 0.0f);
+        outTop = Vec3(0.0f, top, 0.0f);
+    }
+
     /**
      * @brief 检测与其他 AABB 的碰撞
      */
@@ -119,6 +139,49 @@ public:
             return Vec3(0, 0, -minOverlapZ);
         }
     }
+
+    /**
+     * @brief 扫掠 AABB：moving 沿 delta 平移时与 other 的首次接触时间（按轴分段求进入与离开时间）
+     * @param outToi 输出：接触时间，范围 [0, 1]，接触位置为 moving 平移 delta * outToi
+     * @param outNormal 输出：接触面法线，由 other 指向 moving
+     * @return bool 是否接触。起始时已相交返回 false，交给 getCollisionOffset 推出
+     */
+    static bool sweepAABB(const AABB& moving, const Vec3& delta, const AABB& other, float& outToi, Vec3& outNormal) {
+        const float minA[3] = {moving._min.x, moving._min.y, moving._min.z};
+        const float maxA[3] = {moving._max.x, moving._max.y, moving._max.z};
+        const float minB[3] = {other._min.x, other._min.y, other._min.z};
+        const float maxB[3] = {other._max.x, other._max.y, other._max.z};
+        const float d[3] = {delta.x, delta.y, delta.z};
+
+        float enter = -FLT_MAX;
+        float exit = FLT_MAX;
+        int axis = -1;
+        for (int i = 0; i < 3; ++i) {
+            if (d[i] == 0.0f) {
+                // 该轴不动：必须一直重叠
+                if (maxA[i] <= minB[i] || minA[i] >= maxB[i]) return false;
+                continue;
+            }
+            const float inv = 1.0f / d[i];
+            float t0 = (d[i] > 0.0f ? minB[i] - maxA[i] : maxB[i] - minA[i]) * inv;
+            float t1 = (d[i] > 0.0f ? maxB[i] - minA[i] : minB[i] - maxA[i]) * inv;
+            if (t0 > enter) {
+                enter = t0;
+                axis = i;
+            }
+            exit = std::min(exit, t1);
+        }
+
+        if (axis < 0 || enter < 0.0f || enter > 1.0f || enter >= exit) return false;
+
+        outToi = enter;
+        outNormal = Vec3::ZERO;
+        const float n = d[axis] > 0.0f ? -1.0f : 1.0f;
+        if (axis == 0) outNormal.x = n;
+        else if (axis == 1) outNormal.y = n;
+        else outNormal.z = n;
+        return true;
+    }
 };
 
 #endif // __CHARACTER_COLLIDER_H__
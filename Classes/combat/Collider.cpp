@@ -1,21 +1,108 @@
 #include "Collider.h"
+#include "CapsuleSweep.h"
+#include "CollisionCache.h"
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "ObjParser.h"
 #include "3d/CCSprite3D.h"
 #include "3d/CCMesh.h"
-#include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 
 USING_NS_CC;
 
+constexpr float TerrainQuery::kNoHit;
+constexpr float TerrainQuery::kMaxStepHeight;
+constexpr float TerrainQuery::kMinWalkableNormalY;
+
+namespace {
+
+// 碰撞缓存中各段的标签
+const uint32_t kTagMeta = CollisionCache::makeTag('M', 'E', 'T', 'A');
+const uint32_t kTagMeshHeader = CollisionCache::makeTag('Q', 'H', 'D', 'R');
+const uint32_t kTagMeshPositions = CollisionCache::makeTag('Q', 'P', 'O', 'S');
+const uint32_t kTagMeshIndices = CollisionCache::makeTag('Q', 'I', 'D', 'X');
+const uint32_t kTagBVHNodes = CollisionCache::makeTag('B', 'V', 'H', 'N');
+const uint32_t kTagGridHeader = CollisionCache::makeTag('G', 'R', 'D', 'H');
+const uint32_t kTagGridOffsets = CollisionCache::makeTag('G', 'R', 'D', 'O');
+const uint32_t kTagGridIndices = CollisionCache::makeTag('G', 'R', 'D', 'I');
+const uint32_t kTagHeightfieldHeader = CollisionCache::makeTag('H', 'F', 'H', 'D');
+const uint32_t kTagHeightfieldCounts = CollisionCache::makeTag('H', 'F', 'C', 'T');
+const uint32_t kTagHeightfieldHeights = CollisionCache::makeTag('H', 'F', 'H', 'T');
+const uint32_t kTagHeightfieldFlags = CollisionCache::makeTag('H', 'F', 'F', 'L');
+
+/**
+ * 缓存元信息段
+ */
+struct CacheMeta {
+    uint32_t accelType;
+    uint32_t triangleCount;
+    uint32_t vertexCount;
+    float simplifyDeviation; ///< 简化代理相对原网格的最大偏差，未简化时为 0
+};
+
+/**
+ * 网格参数段，单元格内容以"偏移表 + 扁平索引"的形式另存两段
+ */
+struct CacheGridHeader {
+    float minX, minZ, cellSize;
+    int32_t cols, rows;
+};
+
+/// 竖直向下的射线（贴地探测）可以走高度场
+inline bool isDownRay(const Vec3& dir) {
+    return dir.x == 0.0f && dir.z == 0.0f && dir.y < 0.0f;
+}
+
+/// 将 10 位整数的各位间隔展开（用于拼接二维 Morton 码）
+inline uint32_t spreadBits10(uint32_t v) {
+    v &= 0x3FF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+} // namespace
+
+uint32_t TerrainCollider::allocateSerial() {
+    // 流式加载在后台线程创建分块碰撞器；从 1 开始，0 留给空缓存
+    static std::atomic<uint32_t> nextSerial(1);
+    return nextSerial.fetch_add(1, std::memory_order_relaxed);
+}
+
 /**
  * 创建地形碰撞器实例
  * @param terrainModel 关联的 3D 地形模型
  * @param objFilePath 可选的 .obj 模型文件路径，用于提取精确的碰撞网格
+ * @param accel 加速结构类型（网格或 BVH）
+ * @param simplifyTolerance 碰撞代理允许偏离 .obj 网格的最大距离，0 表示不简化
  * @return 碰撞器实例指针
  */
-TerrainCollider* TerrainCollider::create(Sprite3D* terrainModel, const std::string& objFilePath) {
+TerrainCollider* TerrainCollider::create(Sprite3D* terrainModel, const std::string& objFilePath, AccelType accel,
+                                         float simplifyTolerance) {
+    auto pRet = new (std::nothrow) TerrainCollider();
+    if (!pRet) return nullptr;
+    pRet->_simplifyTolerance = simplifyTolerance;
+    if (pRet->init(terrainModel, objFilePath, accel)) {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return nullptr;
+}
+
+TerrainCollider* TerrainCollider::createFromObj(const std::string& objFilePath, AccelType accel,
+                                                float scale, const Vec3& position, float simplifyTolerance) {
     auto pRet = new (std::nothrow) TerrainCollider();
-    if (pRet && pRet->init(terrainModel, objFilePath)) {
+    if (!pRet) return nullptr;
+    pRet->_scale = scale;
+    pRet->_position = position;
+    pRet->_simplifyTolerance = simplifyTolerance;
+    if (pRet->init(nullptr, objFilePath, accel)) {
         pRet->autorelease();
         return pRet;
     }
@@ -26,98 +113,336 @@ TerrainCollider* TerrainCollider::create(Sprite3D* terrainModel, const std::stri
 /**
  * 初始化碰撞器
  * 逻辑：优先尝试从 .obj 文件加载精确三角形，如果失败则回退到基于 AABB 的简单碰撞
+ * terrainModel 为空时按 _scale / _position 变换（默认为模型空间），且 .obj 必须能成功加载
  */
-bool TerrainCollider::init(Sprite3D* terrainModel, const std::string& objFilePath) {
-    if (!terrainModel) return false;
+bool TerrainCollider::init(Sprite3D* terrainModel, const std::string& objFilePath, AccelType accel) {
+    if (!terrainModel && objFilePath.empty()) return false;
     _terrain = terrainModel;
-    _terrain->retain(); // 增加引用计数，防止模型被提前释放
+    _accelType = accel;
+    if (_terrain) {
+        _terrain->retain(); // 增加引用计数，防止模型被提前释放
+        _scale = _terrain->getScale();
+        _position = _terrain->getPosition3D();
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point from) {
+        return std::chrono::duration<float, std::milli>(Clock::now() - from).count();
+    };
+    auto startTime = Clock::now();
+    _loadStats = LoadStats();
     
     bool loaded = false;
+    bool fromCache = false;
+    std::string cachePath;
+    uint64_t cacheKey = 0;
     if (!objFilePath.empty()) {
-        // 尝试从磁盘加载 .obj 文件
-        loaded = loadFromObj(objFilePath);
+        std::string fullPath = FileUtils::getInstance()->fullPathForFilename(objFilePath);
+        if (!fullPath.empty()) {
+            // 优先读取二进制缓存，缓存缺失或过期时再解析 .obj
+            auto cacheStart = Clock::now();
+            cachePath = getCachePath(objFilePath);
+            cacheKey = computeCacheKey(fullPath);
+            fromCache = loadFromCache(cachePath, cacheKey);
+            _loadStats.cacheMs = elapsedMs(cacheStart);
+        }
+        loaded = fromCache || loadFromObj(objFilePath);
     }
 
     // 如果没有路径或加载失败，生成一个基于 AABB 范围的平面作为碰撞体（保底逻辑）
-    if (!loaded || _triangles.empty()) {
+    if (!loaded || _mesh.empty()) {
+        if (!_terrain) return false;
         extractTriangles(_terrain);
     }
     
-    // 构建空间网格索引
-    buildGrid();
+    // 构建空间加速结构（缓存中已包含，无需重建）
+    if (!fromCache) {
+        auto buildStart = Clock::now();
+        if (_accelType == AccelType::BVH) {
+            buildBVH();
+        } else {
+            buildGrid();
+        }
+        buildHeightfield();
+        _loadStats.buildMs = elapsedMs(buildStart);
+
+        if (loaded && !cachePath.empty()) {
+            auto cacheStart = Clock::now();
+            saveToCache(cachePath, cacheKey);
+            _loadStats.cacheMs += elapsedMs(cacheStart);
+        }
+    }
+
+    buildSoA();
+
+    _loadStats.fromCache = fromCache;
+    _loadStats.triangleCount = _mesh.getTriangleCount();
+    _loadStats.heightfieldFastRatio = _heightfield.getFastCellRatio();
+    _loadStats.totalMs = elapsedMs(startTime);
+    CCLOG("TerrainCollider: %d triangles ready in %.2f ms (%s, parse %.2f ms on %d threads, build %.2f ms, cache %.2f ms)",
+          _loadStats.triangleCount, _loadStats.totalMs, fromCache ? "cache hit" : "cache miss",
+          _loadStats.parseMs, _loadStats.parseThreads, _loadStats.buildMs, _loadStats.cacheMs);
+    CCLOG("TerrainCollider: heightfield %dx%d, %d layers, %.1f%% cells on the fast path",
+          _heightfield.getHeader().cols, _heightfield.getHeader().rows, _heightfield.getHeader().layers,
+          _loadStats.heightfieldFastRatio * 100.0f);
+    CCLOG("TerrainCollider: %d vertices, mesh %.1f KB, query SoA %.1f KB, total %.1f KB (%.1f bytes per triangle)",
+          _mesh.getVertexCount(), _mesh.getMemoryBytes() / 1024.0f, _soa.getMemoryBytes() / 1024.0f,
+          getMemoryBytes() / 1024.0f, (float)getMemoryBytes() / std::max(1, _mesh.getTriangleCount()));
+
+    return true;
+}
+
+/**
+ * 缓存文件路径：可写目录下的 collision_cache/ 子目录，文件名由 .obj 路径与加速结构类型组成
+ */
+std::string TerrainCollider::getCachePath(const std::string& objFilePath) const {
+    std::string name = objFilePath;
+    for (auto& ch : name) {
+        if (ch == '/' || ch == '\\' || ch == ':' || ch == '.') ch = '_';
+    }
+    std::string suffix = (_accelType == AccelType::BVH) ? "_bvh" : "_grid";
+    if (_scale == 1.0f && _position == Vec3::ZERO) suffix += "_local";
+    return FileUtils::getInstance()->getWritablePath() + "collision_cache/" + name + suffix + ".wkcc";
+}
+
+/**
+ * 来源键：.obj 路径、大小、头尾采样内容，以及烘焙进三角形的缩放/位置、简化容差和加速结构类型
+ * 任何一项变化都会使旧缓存失效
+ */
+uint64_t TerrainCollider::computeCacheKey(const std::string& objFullPath) const {
+    uint64_t key = CollisionCache::hash(objFullPath.data(), objFullPath.size());
+    key = CollisionCache::hashFile(objFullPath, key);
+
+    const float transform[4] = {_scale, _position.x, _position.y, _position.z};
+    key = CollisionCache::hash(transform, sizeof(transform), key);
+    key = CollisionCache::hash(&_simplifyTolerance, sizeof(_simplifyTolerance), key);
+    uint32_t accel = (uint32_t)_accelType;
+    key = CollisionCache::hash(&accel, sizeof(accel), key);
+    return key;
+}
+
+/**
+ * 从二进制缓存加载三角形与加速结构
+ * 映射文件并校验后，每段数据只需一次 memcpy 即可就位
+ */
+bool TerrainCollider::loadFromCache(const std::string& cachePath, uint64_t key) {
+    CollisionCache::Reader reader;
+    if (!reader.open(cachePath, key) || !loadSections(reader)) return false;
+
+    CCLOG("TerrainCollider: Loaded %d triangles from cache %s.", _mesh.getTriangleCount(), cachePath.c_str());
+    return true;
+}
+
+bool TerrainCollider::loadSections(const CollisionCache::Reader& reader) {
+    size_t metaSize = 0, meshHeaderSize = 0, positionSize = 0, meshIndexSize = 0;
+    auto meta = static_cast<const CacheMeta*>(reader.getSection(kTagMeta, metaSize));
+    auto meshHeader = static_cast<const QuantizedMesh::Header*>(reader.getSection(kTagMeshHeader, meshHeaderSize));
+    auto positions = static_cast<const uint16_t*>(reader.getSection(kTagMeshPositions, positionSize));
+    auto meshIndices = static_cast<const uint32_t*>(reader.getSection(kTagMeshIndices, meshIndexSize));
+    if (!meta || metaSize != sizeof(CacheMeta) || !meshHeader || meshHeaderSize != sizeof(QuantizedMesh::Header) ||
+        !positions || !meshIndices ||
+        meta->accelType != (uint32_t)_accelType ||
+        meta->triangleCount == 0 ||
+        positionSize != (size_t)meta->vertexCount * 3 * sizeof(uint16_t) ||
+        meshIndexSize != (size_t)meta->triangleCount * 3 * sizeof(uint32_t)) {
+        return false;
+    }
+    _loadStats.simplifyDeviation = meta->simplifyDeviation;
+
+    if (_accelType == AccelType::BVH) {
+        size_t nodeSize = 0;
+        auto nodes = static_cast<const TerrainBVH::Node*>(reader.getSection(kTagBVHNodes, nodeSize));
+        if (!nodes || nodeSize == 0 || nodeSize % sizeof(TerrainBVH::Node) != 0) return false;
+        _bvh.assign(nodes, nodeSize / sizeof(TerrainBVH::Node));
+    } else {
+        size_t headerSize = 0, offsetSize = 0, indexSize = 0;
+        auto header = static_cast<const CacheGridHeader*>(reader.getSection(kTagGridHeader, headerSize));
+        auto offsets = static_cast<const uint32_t*>(reader.getSection(kTagGridOffsets, offsetSize));
+        auto indices = static_cast<const int32_t*>(reader.getSection(kTagGridIndices, indexSize));
+        if (!header || headerSize != sizeof(CacheGridHeader) || !offsets) return false;
+
+        size_t cellCount = (size_t)header->cols * header->rows;
+        if (header->cols <= 0 || header->rows <= 0 || offsetSize != (cellCount + 1) * sizeof(uint32_t) ||
+            offsets[cellCount] * sizeof(int32_t) != indexSize) {
+            return false;
+        }
 
+        if (offsets[0] != 0) return false;
+        for (size_t i = 0; i < cellCount; ++i) {
+            if (offsets[i] > offsets[i + 1]) return false;
+        }
+        const size_t indexCount = offsets[cellCount];
+        for (size_t i = 0; i < indexCount; ++i) {
+            if (indices[i] < 0 || (uint32_t)indices[i] >= meta->triangleCount) return false;
+        }
+
+        _grid.minX = header->minX;
+        _grid.minZ = header->minZ;
+        _grid.cellSize = header->cellSize;
+        _grid.cols = header->cols;
+        _grid.rows = header->rows;
+        _grid.offsets.assign(offsets, offsets + cellCount + 1);
+        _grid.indices.assign(indices, indices + indexCount);
+    }
+
+    size_t hfHeaderSize = 0, hfCountSize = 0, hfHeightSize = 0, hfFlagSize = 0;
+    auto hfHeader = static_cast<const TerrainHeightfield::Header*>(reader.getSection(kTagHeightfieldHeader, hfHeaderSize));
+    auto hfCounts = static_cast<const uint8_t*>(reader.getSection(kTagHeightfieldCounts, hfCountSize));
+    auto hfHeights = static_cast<const float*>(reader.getSection(kTagHeightfieldHeights, hfHeightSize));
+    auto hfFlags = static_cast<const uint8_t*>(reader.getSection(kTagHeightfieldFlags, hfFlagSize));
+    if (!hfHeader || hfHeaderSize != sizeof(TerrainHeightfield::Header) || !hfCounts || !hfFlags ||
+        hfHeightSize % sizeof(float) != 0 ||
+        !_heightfield.assign(*hfHeader, hfCounts, hfCountSize, hfHeights, hfHeightSize / sizeof(float),
+                             hfFlags, hfFlagSize)) {
+        return false;
+    }
+
+    if (!_mesh.assign(*meshHeader, positions, positionSize / sizeof(uint16_t),
+                      meshIndices, meshIndexSize / sizeof(uint32_t))) {
+        return false;
+    }
     return true;
 }
 
+/**
+ * 从烘焙文件初始化：段布局与碰撞缓存相同，读取后只需生成查询用的 SoA 副本
+ */
+bool TerrainCollider::initFromBake(Sprite3D* terrainModel, const CollisionCache::Reader& reader, AccelType accel) {
+    _terrain = terrainModel;
+    _accelType = accel;
+    if (_terrain) {
+        _terrain->retain();
+        _scale = _terrain->getScale();
+        _position = _terrain->getPosition3D();
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    _loadStats = LoadStats();
+    if (!loadSections(reader)) return false;
+    buildSoA();
+
+    _loadStats.fromCache = true;
+    _loadStats.triangleCount = _mesh.getTriangleCount();
+    _loadStats.heightfieldFastRatio = _heightfield.getFastCellRatio();
+    _loadStats.totalMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    CCLOG("TerrainCollider: %d triangles ready in %.2f ms (baked)", _loadStats.triangleCount, _loadStats.totalMs);
+    return true;
+}
+
+/**
+ * 将当前三角形与加速结构写入二进制缓存
+ */
+void TerrainCollider::saveToCache(const std::string& cachePath, uint64_t key) const {
+    FileUtils::getInstance()->createDirectory(FileUtils::getInstance()->getWritablePath() + "collision_cache/");
+    if (writeToFile(cachePath, key)) {
+        CCLOG("TerrainCollider: Collision cache written to %s", cachePath.c_str());
+    }
+}
+
+bool TerrainCollider::writeToFile(const std::string& fullPath, uint64_t key,
+                                  const std::function<void(CollisionCache::Writer&)>& extraSections) const {
+    CacheMeta meta;
+    meta.accelType = (uint32_t)_accelType;
+    meta.triangleCount = (uint32_t)_mesh.getTriangleCount();
+    meta.vertexCount = (uint32_t)_mesh.getVertexCount();
+    meta.simplifyDeviation = _loadStats.simplifyDeviation;
+
+    const auto& positions = _mesh.getPositions();
+    const auto& meshIndices = _mesh.getIndices();
+    CollisionCache::Writer writer;
+    writer.addSection(kTagMeta, &meta, sizeof(meta));
+    writer.addSection(kTagMeshHeader, &_mesh.getHeader(), sizeof(QuantizedMesh::Header));
+    writer.addSection(kTagMeshPositions, positions.data(), positions.size() * sizeof(uint16_t));
+    writer.addSection(kTagMeshIndices, meshIndices.data(), meshIndices.size() * sizeof(uint32_t));
+
+    // 网格参数段需要在 write 之前保持存活
+    CacheGridHeader gridHeader;
+
+    if (_accelType == AccelType::BVH) {
+        const auto& nodes = _bvh.getNodes();
+        writer.addSection(kTagBVHNodes, nodes.data(), nodes.size() * sizeof(TerrainBVH::Node));
+    } else {
+        gridHeader.minX = _grid.minX;
+        gridHeader.minZ = _grid.minZ;
+        gridHeader.cellSize = _grid.cellSize;
+        gridHeader.cols = _grid.cols;
+        gridHeader.rows = _grid.rows;
+        writer.addSection(kTagGridHeader, &gridHeader, sizeof(gridHeader));
+        writer.addSection(kTagGridOffsets, _grid.offsets.data(), _grid.offsets.size() * sizeof(uint32_t));
+        writer.addSection(kTagGridIndices, _grid.indices.data(), _grid.indices.size() * sizeof(int32_t));
+    }
+
+    // 高度场
+    const auto& hfCounts = _heightfield.getLayerCounts();
+    const auto& hfHeights = _heightfield.getHeights();
+    const auto& hfFlags = _heightfield.getCellFlags();
+    writer.addSection(kTagHeightfieldHeader, &_heightfield.getHeader(), sizeof(TerrainHeightfield::Header));
+    writer.addSection(kTagHeightfieldCounts, hfCounts.data(), hfCounts.size());
+    writer.addSection(kTagHeightfieldHeights, hfHeights.data(), hfHeights.size() * sizeof(float));
+    writer.addSection(kTagHeightfieldFlags, hfFlags.data(), hfFlags.size());
+
+    if (extraSections) extraSections(writer);
+    return writer.write(fullPath, key);
+}
+
 /**
  * 解析 .obj 文件以提取三角形面片
- * .obj 文件包含顶点 (v) 和面 (f) 信息
+ * 优先以内存映射方式读取文件，交给 ObjParser 并行解析，再烘焙缩放与位置得到世界空间三角形
  */
 bool TerrainCollider::loadFromObj(const std::string& objFilePath) {
     // 获取文件的完整路径（适配 Cocos2d-x 的资源管理）
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(objFilePath);
-    std::string content = FileUtils::getInstance()->getStringFromFile(fullPath);
-    if (content.empty()) return false;
 
-    std::vector<Vec3> vertices; // 临时存储原始顶点
-    std::stringstream ss(content);
-    std::string line;
-    
-    // 获取当前模型的缩放和位置，以便将局部坐标转换为世界坐标
-    float scale = _terrain->getScale();
-    Vec3 pos = _terrain->getPosition3D();
-
-    while (std::getline(ss, line)) {
-        if (line.size() < 2) continue;
-
-        // 解析顶点坐标：v x y z
-        if (line[0] == 'v' && line[1] == ' ') {
-            std::stringstream vss(line.substr(2));
-            float x, y, z;
-            if (vss >> x >> y >> z) {
-                // 转换到世界空间坐标系
-                vertices.push_back(Vec3(x * scale + pos.x, y * scale + pos.y, z * scale + pos.z));
-            }
-        } 
-        // 解析面索引：f v1/vt1/vn1 v2/vt2/vn2 v3/vt3/vn3
-        else if (line[0] == 'f' && line[1] == ' ') {
-            std::stringstream fss(line.substr(2));
-            std::string v1_s, v2_s, v3_s;
-            if (fss >> v1_s >> v2_s >> v3_s) {
-                try {
-                    // 处理可能带斜杠的索引（如 1/1/1 或 1//1）
-                    auto parseIdx = [](const std::string& s) {
-                        size_t p = s.find('/');
-                        return (p == std::string::npos) ? std::stoi(s) : std::stoi(s.substr(0, p));
-                    };
-
-                    // .obj 索引从 1 开始，需减 1 匹配 vector 索引
-                    int i1 = parseIdx(v1_s) - 1;
-                    int i2 = parseIdx(v2_s) - 1;
-                    int i3 = parseIdx(v3_s) - 1;
-
-                    // 索引合法性检查，防止数组越界导致崩溃
-                    if (i1 >= 0 && i1 < (int)vertices.size() &&
-                        i2 >= 0 && i2 < (int)vertices.size() &&
-                        i3 >= 0 && i3 < (int)vertices.size()) {
-                        // 存储生成的三角形面片数据，并预计算边界
-                        Triangle tri;
-                        tri.v0 = vertices[i1];
-                        tri.v1 = vertices[i2];
-                        tri.v2 = vertices[i3];
-                        tri.minX = std::min({tri.v0.x, tri.v1.x, tri.v2.x});
-                        tri.maxX = std::max({tri.v0.x, tri.v1.x, tri.v2.x});
-                        tri.minZ = std::min({tri.v0.z, tri.v1.z, tri.v2.z});
-                        tri.maxZ = std::max({tri.v0.z, tri.v1.z, tri.v2.z});
-                        _triangles.push_back(tri);
-                    }
-                } catch (...) {
-                    // 忽略格式错误的行
-                }
-            }
+    // 无法映射时（如 Android APK 内的资源）回退为整体读入内存
+    MappedFile mapped;
+    Data fileData;
+    const char* content = nullptr;
+    size_t contentSize = 0;
+    if (mapped.open(fullPath)) {
+        content = mapped.data();
+        contentSize = mapped.size();
+    } else {
+        fileData = FileUtils::getInstance()->getDataFromFile(fullPath);
+        content = reinterpret_cast<const char*>(fileData.getBytes());
+        contentSize = (size_t)fileData.getSize();
+    }
+    if (!content || contentSize == 0) return false;
+
+    std::vector<Vec3> vertices;
+    std::vector<int> indices;
+    ObjParser::Stats stats;
+    if (!ObjParser::parse(content, contentSize, vertices, indices, &stats)) return false;
+
+    _loadStats.parseMs = stats.parseMs;
+    _loadStats.parseThreads = stats.threadCount;
+    if (stats.skippedFaces > 0) {
+        CCLOG("TerrainCollider: %d malformed faces skipped in %s", stats.skippedFaces, objFilePath.c_str());
+    }
+
+    // 烘焙缩放和位置，将局部坐标转换为世界坐标（模型空间网格不做变换）
+    if (_scale != 1.0f || _position != Vec3::ZERO) {
+        for (auto& v : vertices) {
+            v = v * _scale + _position;
         }
     }
-    return !_triangles.empty();
+
+    // 在世界坐标下简化为碰撞代理，容差与场景单位一致
+    if (_simplifyTolerance > 0.0f) {
+        MeshSimplifier::Options options;
+        options.maxError = _simplifyTolerance;
+        MeshSimplifier::Stats simplifyStats;
+        if (MeshSimplifier::simplify(vertices, indices, options, &simplifyStats)) {
+            _loadStats.sourceTriangleCount = simplifyStats.inputTriangles;
+            _loadStats.simplifyDeviation = simplifyStats.maxDeviation;
+            _loadStats.simplifyMs = simplifyStats.simplifyMs;
+            CCLOG("TerrainCollider: simplified %d -> %d triangles in %.2f ms, max deviation %.3f (tolerance %.3f)",
+                  simplifyStats.inputTriangles, simplifyStats.outputTriangles, simplifyStats.simplifyMs,
+                  simplifyStats.maxDeviation, _simplifyTolerance);
+        }
+    }
+
+    // 量化为紧凑的索引网格（共享顶点只存一份）
+    return _mesh.build(vertices, indices);
 }
 
 /**
@@ -131,26 +456,32 @@ void TerrainCollider::extractTriangles(Sprite3D* model) {
     float groundY = min.y; // 取包围盒底部高度
     
     // 创建两个三角形组成一个矩形平面
-    Triangle tri1 = {Vec3(min.x, groundY, min.z), Vec3(max.x, groundY, min.z), Vec3(max.x, groundY, max.z)};
-    tri1.minX = min.x; tri1.maxX = max.x; tri1.minZ = min.z; tri1.maxZ = max.z;
-    _triangles.push_back(tri1);
-
-    Triangle tri2 = {Vec3(min.x, groundY, min.z), Vec3(max.x, groundY, max.z), Vec3(min.x, groundY, max.z)};
-    tri2.minX = min.x; tri2.maxX = max.x; tri2.minZ = min.z; tri2.maxZ = max.z;
-    _triangles.push_back(tri2);
+    std::vector<Vec3> vertices = {Vec3(min.x, groundY, min.z), Vec3(max.x, groundY, min.z),
+                                  Vec3(max.x, groundY, max.z), Vec3(min.x, groundY, max.z)};
+    std::vector<int> indices = {0, 1, 2, 0, 2, 3};
+    _mesh.build(vertices, indices);
 }
 
 void TerrainCollider::buildGrid() {
-    if (_triangles.empty()) return;
+    if (_mesh.empty()) return;
+    const int triangleCount = _mesh.getTriangleCount();
 
-    // 1. 计算地形总边界
+    // 1. 计算每个三角形的 XZ 边界与地形总边界
+    std::vector<float> bounds(triangleCount * 4); // minX, maxX, minZ, maxZ
     float minX = FLT_MAX, maxX = -FLT_MAX;
     float minZ = FLT_MAX, maxZ = -FLT_MAX;
-    for (const auto& tri : _triangles) {
-        minX = std::min({minX, tri.minX});
-        maxX = std::max({maxX, tri.maxX});
-        minZ = std::min({minZ, tri.minZ});
-        maxZ = std::max({maxZ, tri.maxZ});
+    for (int i = 0; i < triangleCount; ++i) {
+        Vec3 v0, v1, v2;
+        _mesh.getTriangle(i, v0, v1, v2);
+        float* b = &bounds[i * 4];
+        b[0] = std::min({v0.x, v1.x, v2.x});
+        b[1] = std::max({v0.x, v1.x, v2.x});
+        b[2] = std::min({v0.z, v1.z, v2.z});
+        b[3] = std::max({v0.z, v1.z, v2.z});
+        minX = std::min(minX, b[0]);
+        maxX = std::max(maxX, b[1]);
+        minZ = std::min(minZ, b[2]);
+        maxZ = std::max(maxZ, b[3]);
     }
 
     // 2. 初始化网格参数 (固定 32x32 网格)
@@ -159,98 +490,763 @@ void TerrainCollider::buildGrid() {
     _grid.cols = 32;
     _grid.rows = 32;
     _grid.cellSize = std::max((maxX - minX) / _grid.cols, (maxZ - minZ) / _grid.rows) + 0.1f;
-    _grid.cells.assign(_grid.cols * _grid.rows, std::vector<int>());
-
-    // 3. 将三角形分配到重叠的网格中
-    for (int i = 0; i < (int)_triangles.size(); ++i) {
-        const auto& tri = _triangles[i];
-        
-        int startCol = std::max(0, (int)((tri.minX - _grid.minX) / _grid.cellSize));
-        int endCol = std::min(_grid.cols - 1, (int)((tri.maxX - _grid.minX) / _grid.cellSize));
-        int startRow = std::max(0, (int)((tri.minZ - _grid.minZ) / _grid.cellSize));
-        int endRow = std::min(_grid.rows - 1, (int)((tri.maxZ - _grid.minZ) / _grid.cellSize));
 
+    // 3. 将三角形分配到重叠的网格中：先统计每格数量得到偏移表，再填入扁平索引
+    auto forEachCell = [this, &bounds](int i, auto&& fn) {
+        const float* b = &bounds[i * 4];
+        int startCol = std::max(0, (int)((b[0] - _grid.minX) / _grid.cellSize));
+        int endCol = std::min(_grid.cols - 1, (int)((b[1] - _grid.minX) / _grid.cellSize));
+        int startRow = std::max(0, (int)((b[2] - _grid.minZ) / _grid.cellSize));
+        int endRow = std::min(_grid.rows - 1, (int)((b[3] - _grid.minZ) / _grid.cellSize));
         for (int r = startRow; r <= endRow; ++r) {
             for (int c = startCol; c <= endCol; ++c) {
-                _grid.cells[r * _grid.cols + c].push_back(i);
+                fn(r * _grid.cols + c);
             }
         }
+    };
+
+    const int cellCount = _grid.cols * _grid.rows;
+    _grid.offsets.assign(cellCount + 1, 0);
+    for (int i = 0; i < triangleCount; ++i) {
+        forEachCell(i, [this](int cell) { ++_grid.offsets[cell + 1]; });
     }
-    CCLOG("TerrainCollider: Grid built. %d triangles distributed into %dx%d cells.", (int)_triangles.size(), _grid.cols, _grid.rows);
+    for (int c = 0; c < cellCount; ++c) {
+        _grid.offsets[c + 1] += _grid.offsets[c];
+    }
+
+    _grid.indices.resize(_grid.offsets[cellCount]);
+    std::vector<uint32_t> cursor(_grid.offsets.begin(), _grid.offsets.end() - 1);
+    for (int i = 0; i < triangleCount; ++i) {
+        forEachCell(i, [this, &cursor, i](int cell) { _grid.indices[cursor[cell]++] = i; });
+    }
+    CCLOG("TerrainCollider: Grid built. %d triangles distributed into %dx%d cells.", triangleCount, _grid.cols, _grid.rows);
+}
+
+/**
+ * 构建 SAH BVH
+ * 构建完成后按叶子顺序重排 _mesh 的三角形，使每个叶子引用一段连续的三角形
+ */
+void TerrainCollider::buildBVH() {
+    if (_mesh.empty()) return;
+
+    std::vector<TerrainBVH::Prim> prims(_mesh.getTriangleCount());
+    for (size_t i = 0; i < prims.size(); ++i) {
+        Vec3 v0, v1, v2;
+        _mesh.getTriangle((int)i, v0, v1, v2);
+        prims[i].bmin = Vec3(std::min({v0.x, v1.x, v2.x}), std::min({v0.y, v1.y, v2.y}), std::min({v0.z, v1.z, v2.z}));
+        prims[i].bmax = Vec3(std::max({v0.x, v1.x, v2.x}), std::max({v0.y, v1.y, v2.y}), std::max({v0.z, v1.z, v2.z}));
+    }
+
+    std::vector<int> order;
+    _bvh.build(prims, order, TriangleSoA::kLaneCount);
+    _mesh.reorderTriangles(order);
+
+    CCLOG("TerrainCollider: BVH built. %d triangles, %d nodes.", _mesh.getTriangleCount(), (int)_bvh.getNodes().size());
 }
 
 /**
- * 射线与地形所有三角形的求交检测
- * @param ray 射线（通常从角色脚部上方垂直向下发射）
+ * 由当前三角形烘焙竖直查询用的多层高度场
+ */
+void TerrainCollider::buildHeightfield() {
+    std::vector<Vec3> vertices;
+    vertices.resize(_mesh.getTriangleCount() * 3);
+    for (int i = 0; i < _mesh.getTriangleCount(); ++i) {
+        _mesh.getTriangle(i, vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+    }
+    _heightfield.bake(vertices, 0.0f, kMinWalkableNormalY);
+}
+
+/**
+ * 将解码后的三角形复制为 SoA 布局并预计算两条边，必须在 _mesh 最终排序确定后调用
+ */
+void TerrainCollider::buildSoA() {
+    _soa.resize(_mesh.getTriangleCount());
+    for (int i = 0; i < _mesh.getTriangleCount(); ++i) {
+        Vec3 v0, v1, v2;
+        _mesh.getTriangle(i, v0, v1, v2);
+        _soa.set(i, v0, v1, v2);
+    }
+}
+
+/**
+ * 射线与地形的求交检测，竖直射线先查高度场，其余按创建时选择的加速结构分派
+ * @param ray 射线（方向任意，无需归一化）
  * @param hitDist 输出：射线起点到最近碰撞点的距离
  * @return 是否发生碰撞
  */
 bool TerrainCollider::rayIntersects(const CustomRay& ray, float& hitDist) {
-    if (_triangles.empty()) return false;
+    if (_mesh.empty()) return false;
+
+    // 竖直向下的射线（贴地探测）直接查高度场
+    const Vec3& dir = ray.direction;
+    if (isDownRay(dir)) {
+        float groundY;
+        switch (probeHeightfield(ray.origin, groundY, nullptr)) {
+        case TerrainHeightfield::Probe::Hit:
+            hitDist = (ray.origin.y - groundY) / -dir.y;
+            return true;
+        case TerrainHeightfield::Probe::Miss:
+            return false;
+        case TerrainHeightfield::Probe::Exact:
+            break;
+        }
+    }
+
+    return raycast(ray.origin, ray.direction, FLT_MAX, false, hitDist);
+}
+
+bool TerrainCollider::rayIntersects(const CustomRay& ray, RayHit& outHit) {
+    if (_mesh.empty()) return false;
+
+    const Vec3& dir = ray.direction;
+    if (isDownRay(dir)) {
+        float groundY;
+        switch (probeHeightfield(ray.origin, groundY, &outHit.normal)) {
+        case TerrainHeightfield::Probe::Hit:
+            outHit.distance = (ray.origin.y - groundY) / -dir.y;
+            outHit.triangle = -1;
+            return true;
+        case TerrainHeightfield::Probe::Miss:
+            return false;
+        case TerrainHeightfield::Probe::Exact:
+            break;
+        }
+    }
+
+    float t;
+    int hitIndex = -1;
+    if (!raycast(ray.origin, ray.direction, FLT_MAX, false, t, &hitIndex)) return false;
+    fillRayHit(hitIndex, t, ray.direction, outHit);
+    return true;
+}
+
+TerrainHeightfield::Probe TerrainCollider::probeHeightfield(const Vec3& origin, float& outGroundY, Vec3* outNormal) const {
+    if (_heightfield.empty()) return TerrainHeightfield::Probe::Exact;
+
+    const TerrainHeightfield::Probe probe = _heightfield.probeDown(origin, outGroundY, outNormal);
+    if (probe == TerrainHeightfield::Probe::Hit && outNormal && outNormal->y < kMinWalkableNormalY) {
+        return TerrainHeightfield::Probe::Exact;
+    }
+    return probe;
+}
+
+/**
+ * 填充命中面信息，法线翻到与射线方向相对的一侧
+ * .obj 的环绕方向不可靠，getNormal 统一给出朝上的一侧，这里再按射线方向调整
+ */
+void TerrainCollider::fillRayHit(int triangle, float t, const Vec3& dir, RayHit& outHit) const {
+    const Vec3 n = _soa.getNormal(triangle);
+    outHit.distance = t;
+    outHit.normal = (n.dot(dir) > 0.0f) ? -n : n;
+    outHit.triangle = triangle;
+}
+
+size_t TerrainCollider::getMemoryBytes() const {
+    return _mesh.getMemoryBytes() + _soa.getMemoryBytes() +
+           _grid.offsets.capacity() * sizeof(uint32_t) + _grid.indices.capacity() * sizeof(int32_t) +
+           _bvh.getNodes().capacity() * sizeof(TerrainBVH::Node) +
+           _heightfield.getLayerCounts().capacity() + _heightfield.getHeights().capacity() * sizeof(float) +
+           _heightfield.getCellFlags().capacity() +
+           _vertexTriangleOffsets.capacity() * sizeof(uint32_t) + _vertexTriangles.capacity() * sizeof(int32_t);
+}
+
+bool TerrainCollider::getBounds(Vec3& outMin, Vec3& outMax) const {
+    if (_mesh.empty()) return false;
+    _mesh.getBounds(outMin, outMax);
+    return true;
+}
+
+bool TerrainCollider::segmentIntersects(const Vec3& from, const Vec3& to) {
+    if (_mesh.empty()) return false;
+    float t;
+    return raycast(from, to - from, 1.0f, true, t);
+}
 
-    // 1. 确定射线所在的网格单元
-    int c = (int)((ray.origin.x - _grid.minX) / _grid.cellSize);
-    int r = (int)((ray.origin.z - _grid.minZ) / _grid.cellSize);
+bool TerrainCollider::segmentIntersects(const Vec3& from, const Vec3& to, float& outFraction) {
+    if (_mesh.empty()) return false;
+    return raycast(from, to - from, 1.0f, false, outFraction);
+}
+
+bool TerrainCollider::raycast(const Vec3& origin, const Vec3& dir, float tMax, bool anyHit, float& hitT,
+                              int* hitIndex) {
+    if (_accelType == AccelType::BVH) {
+        return raycastBVH(origin, dir, tMax, anyHit, hitT, hitIndex);
+    }
+    return raycastGrid(origin, dir, tMax, anyHit, hitT, hitIndex);
+}
+
+template <typename Fn>
+void TerrainCollider::forEachCandidate(const Vec3& bmin, const Vec3& bmax, Fn fn) const {
+    if (_accelType == AccelType::BVH) {
+        _bvh.overlap(bmin, bmax, [&fn](int first, int count) {
+            for (int i = first; i < first + count; ++i) fn(i);
+        });
+        return;
+    }
+
+    int c0 = std::max(0, (int)((bmin.x - _grid.minX) / _grid.cellSize));
+    int c1 = std::min(_grid.cols - 1, (int)((bmax.x - _grid.minX) / _grid.cellSize));
+    int r0 = std::max(0, (int)((bmin.z - _grid.minZ) / _grid.cellSize));
+    int r1 = std::min(_grid.rows - 1, (int)((bmax.z - _grid.minZ) / _grid.cellSize));
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            const int cell = r * _grid.cols + c;
+            for (uint32_t k = _grid.offsets[cell]; k < _grid.offsets[cell + 1]; ++k) fn(_grid.indices[k]);
+        }
+    }
+}
+
+/**
+ * 胶囊体扫掠
+ * 1. 以起止位置胶囊的并集包围盒粗筛三角形
+ * 2. 逐个三角形解析求解接触时间，保留最早的一个
+ * 3. 在接触时刻由线段与三角形的最近点求接触法线
+ */
+bool TerrainCollider::sweepCapsule(const Vec3& a, const Vec3& b, float radius, const Vec3& delta, SweepHit& outHit) {
+    if (_mesh.empty()) return false;
+
+    Vec3 bmin(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+    Vec3 bmax(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+    bmin = Vec3(std::min(bmin.x, bmin.x + delta.x), std::min(bmin.y, bmin.y + delta.y), std::min(bmin.z, bmin.z + delta.z));
+    bmax = Vec3(std::max(bmax.x, bmax.x + delta.x), std::max(bmax.y, bmax.y + delta.y), std::max(bmax.z, bmax.z + delta.z));
+    bmin -= Vec3(radius, radius, radius);
+    bmax += Vec3(radius, radius, radius);
+
+    _sweepCandidates.clear();
+    forEachCandidate(bmin, bmax, [this](int idx) { _sweepCandidates.push_back(idx); });
+    // 网格模式下跨越多个单元格的三角形只检测一次（BVH 模式下没有建立网格）
+    if (_accelType == AccelType::Grid) {
+        const bool multiCell =
+            (int)((bmin.x - _grid.minX) / _grid.cellSize) != (int)((bmax.x - _grid.minX) / _grid.cellSize) ||
+            (int)((bmin.z - _grid.minZ) / _grid.cellSize) != (int)((bmax.z - _grid.minZ) / _grid.cellSize);
+        if (multiCell) {
+            std::sort(_sweepCandidates.begin(), _sweepCandidates.end());
+            _sweepCandidates.erase(std::unique(_sweepCandidates.begin(), _sweepCandidates.end()),
+                                   _sweepCandidates.end());
+        }
+    }
+
+    float bestToi = FLT_MAX;
+    int bestIndex = -1;
+    for (int idx : _sweepCandidates) {
+        Vec3 triMin, triMax;
+        _soa.getBounds(idx, triMin, triMax);
+        if (triMax.x < bmin.x || triMin.x > bmax.x || triMax.z < bmin.z || triMin.z > bmax.z ||
+            triMax.y < bmin.y || triMin.y > bmax.y) {
+            continue;
+        }
+
+        Vec3 v0, v1, v2;
+        _mesh.getTriangle(idx, v0, v1, v2);
+        float toi;
+        if (CapsuleSweep::sweepTriangle(a, b, radius, delta, v0, v1, v2, toi) && toi < bestToi) {
+            bestToi = toi;
+            bestIndex = idx;
+            if (toi == 0.0f) break;
+        }
+    }
+    if (bestIndex < 0) return false;
+
+    Vec3 v0, v1, v2;
+    _mesh.getTriangle(bestIndex, v0, v1, v2);
+    const Vec3 offset = delta * bestToi;
+    outHit.toi = bestToi;
+    outHit.normal = CapsuleSweep::contactNormal(a + offset, b + offset, delta, v0, v1, v2, &outHit.point);
+    return true;
+}
+
+bool TerrainCollider::sweepCapsule(const Vec3& a, const Vec3& b, float radius, const Vec3& delta,
+                                   float& toi, Vec3& normal) {
+    SweepHit hit;
+    if (!sweepCapsule(a, b, radius, delta, hit)) return false;
+    toi = hit.toi;
+    normal = hit.normal;
+    return true;
+}
+
+Vec3 TerrainCollider::slideCapsule(const Vec3& from, const Vec3& axisBottom, const Vec3& axisTop,
+                                   float radius, const Vec3& delta, int maxIterations) {
+    return CapsuleSweep::slide(from, axisBottom, axisTop, delta, maxIterations,
+                               [this, radius](const Vec3& a, const Vec3& b, const Vec3& d, float& toi, Vec3& normal) {
+        return sweepCapsule(a, b, radius, d, toi, normal);
+    });
+}
+
+/**
+ * 带缓存的贴地探测
+ * 1. 探测点严格位于缓存范围内时，只检测缓存中 XZ 包围盒覆盖探测点、且最高点高于当前命中的三角形
+ * 2. 命中高度不低于缓存的 floorY 时，范围内其它三角形都更低，结果即为全局最近命中
+ * 3. 否则做一次完整查询，并以命中的三角形为中心重建缓存
+ */
+bool TerrainCollider::probeGround(const Vec3& origin, GroundCache& cache, RayHit& outHit) {
+    if (_mesh.empty()) return false;
+
+    float groundY;
+    switch (probeHeightfield(origin, groundY, &outHit.normal)) {
+    case TerrainHeightfield::Probe::Hit:
+        outHit.distance = origin.y - groundY;
+        outHit.triangle = -1;
+        return true;
+    case TerrainHeightfield::Probe::Miss:
+        return false;
+    case TerrainHeightfield::Probe::Exact:
+        break;
+    }
+
+    const Vec3 down(0.0f, -1.0f, 0.0f);
+    if (cache.ownerSerial == _serial && cache.count > 0 &&
+        origin.x > cache.minX && origin.x < cache.maxX && origin.z > cache.minZ && origin.z < cache.maxZ) {
+        float best = FLT_MAX;
+        int bestSlot = -1;
+        for (int i = 0; i < cache.count; ++i) {
+            const float* b = cache.bounds[i];
+            if (origin.x < b[0] || origin.x > b[1] || origin.z < b[2] || origin.z > b[3]) continue;
+            if (bestSlot >= 0 && b[4] <= origin.y - best) continue;
+            float t;
+            if (_soa.intersect(cache.triangles[i], origin, down, t) && t < best) {
+                best = t;
+                bestSlot = i;
+            }
+        }
+        if (bestSlot >= 0 && origin.y - best >= cache.floorY) {
+            ++cache.cacheHits;
+            const int triangle = cache.triangles[bestSlot];
+            fillRayHit(triangle, best, down, outHit);
+            // 走到了相邻三角形上：以它为中心重建，下一帧仍然先测它
+            if (bestSlot != 0) fillGroundCache(triangle, cache);
+            return true;
+        }
+    }
+
+    ++cache.cacheMisses;
+    float t;
+    int hitIndex = -1;
+    if (!raycast(origin, down, FLT_MAX, false, t, &hitIndex)) {
+        cache.reset();
+        return false;
+    }
+    fillRayHit(hitIndex, t, down, outHit);
+    fillGroundCache(hitIndex, cache);
+    return true;
+}
+
+/**
+ * 以 triangle 为中心填充贴地缓存
+ * 先放入它与共享顶点的一圈三角形，再补上范围内高于 floorY 的其它三角形；
+ * 数量超出上限时退回只用命中的三角形本身，仍然放不下则清空缓存
+ */
+void TerrainCollider::fillGroundCache(int triangle, GroundCache& cache) {
+    if (_vertexTriangleOffsets.empty()) buildVertexTriangles();
+
+    const uint32_t* corners = &_mesh.getIndices()[(size_t)triangle * 3];
+    for (int pass = 0; pass < 2; ++pass) {
+        cache.ownerSerial = _serial;
+        cache.count = 0;
+        bool overflow = false;
+        auto add = [&cache, &overflow, this](int t) {
+            if (std::find(cache.triangles, cache.triangles + cache.count, t) != cache.triangles + cache.count) return;
+            if (cache.count == GroundCache::kMaxTriangles) {
+                overflow = true;
+                return;
+            }
+            Vec3 bmin, bmax;
+            _soa.getBounds(t, bmin, bmax);
+            float* b = cache.bounds[cache.count];
+            b[0] = bmin.x;
+            b[1] = bmax.x;
+            b[2] = bmin.z;
+            b[3] = bmax.z;
+            b[4] = bmax.y;
+            cache.triangles[cache.count] = t;
+            ++cache.count;
+        };
+
+        add(triangle);
+        if (pass == 0) {
+            for (int k = 0; k < 3; ++k) {
+                for (uint32_t i = _vertexTriangleOffsets[corners[k]]; i < _vertexTriangleOffsets[corners[k] + 1]; ++i) {
+                    add(_vertexTriangles[i]);
+                }
+            }
+            if (overflow) continue;
+        }
+
+        cache.minX = cache.minZ = cache.floorY = FLT_MAX;
+        cache.maxX = cache.maxZ = -FLT_MAX;
+        for (int i = 0; i < cache.count; ++i) {
+            Vec3 bmin, bmax;
+            _soa.getBounds(cache.triangles[i], bmin, bmax);
+            cache.minX = std::min(cache.minX, bmin.x);
+            cache.maxX = std::max(cache.maxX, bmax.x);
+            cache.minZ = std::min(cache.minZ, bmin.z);
+            cache.maxZ = std::max(cache.maxZ, bmax.z);
+            cache.floorY = std::min(cache.floorY, bmin.y);
+        }
+
+        // 范围内最高点不低于 floorY 的三角形都可能挡在地面之上，必须一并检测。
+        // 范围按开区间处理，只在边界上接触的三角形不会覆盖范围内的点
+        forEachCandidate(Vec3(cache.minX, cache.floorY, cache.minZ), Vec3(cache.maxX, FLT_MAX, cache.maxZ), [&](int t) {
+            if (overflow) return;
+            Vec3 bmin, bmax;
+            _soa.getBounds(t, bmin, bmax);
+            if (bmax.y < cache.floorY || bmax.x <= cache.minX || bmin.x >= cache.maxX ||
+                bmax.z <= cache.minZ || bmin.z >= cache.maxZ) {
+                return;
+            }
+            add(t);
+        });
+        if (!overflow) return;
+    }
+    cache.reset();
+}
+
+/**
+ * 顶点 -> 三角形的反向索引：依赖 QuantizedMesh 合并后的共享顶点，共用顶点的三角形互为邻居
+ */
+void TerrainCollider::buildVertexTriangles() {
+    const auto& indices = _mesh.getIndices();
+    _vertexTriangleOffsets.assign(_mesh.getVertexCount() + 1, 0);
+    for (uint32_t v : indices) ++_vertexTriangleOffsets[v + 1];
+    for (int v = 0; v < _mesh.getVertexCount(); ++v) {
+        _vertexTriangleOffsets[v + 1] += _vertexTriangleOffsets[v];
+    }
 
-    // 如果射线在网格之外，不进行检测
-    if (c < 0 || c >= _grid.cols || r < 0 || r >= _grid.rows) return false;
+    _vertexTriangles.resize(indices.size());
+    std::vector<uint32_t> cursor(_vertexTriangleOffsets.begin(), _vertexTriangleOffsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        _vertexTriangles[cursor[indices[i]]++] = (int32_t)(i / 3);
+    }
+}
 
-    const auto& cellIndices = _grid.cells[r * _grid.cols + c];
-    float closestDist = FLT_MAX;
+/**
+ * 批量检测的排序键
+ * 网格模式：起点所在单元格下标（网格外的射线排在最后）
+ * BVH 模式：起点 XZ 在根节点范围内量化为 1024x1024 后的 Morton 码，空间上相邻的射线会落在同一子树
+ */
+uint32_t TerrainCollider::batchSortKey(const Vec3& origin) const {
+    if (_accelType == AccelType::BVH) {
+        const auto& nodes = _bvh.getNodes();
+        if (nodes.empty()) return 0;
+        const TerrainBVH::Node& root = nodes[0];
+        float sx = root.bmax[0] - root.bmin[0];
+        float sz = root.bmax[2] - root.bmin[2];
+        float fx = sx > 0.0f ? (origin.x - root.bmin[0]) / sx : 0.0f;
+        float fz = sz > 0.0f ? (origin.z - root.bmin[2]) / sz : 0.0f;
+        uint32_t qx = (uint32_t)(std::min(std::max(fx, 0.0f), 1.0f) * 1023.0f);
+        uint32_t qz = (uint32_t)(std::min(std::max(fz, 0.0f), 1.0f) * 1023.0f);
+        return spreadBits10(qx) | (spreadBits10(qz) << 1);
+    }
+
+    int c = (int)((origin.x - _grid.minX) / _grid.cellSize);
+    int r = (int)((origin.z - _grid.minZ) / _grid.cellSize);
+    if (c < 0 || c >= _grid.cols || r < 0 || r >= _grid.rows) return UINT32_MAX;
+    return (uint32_t)(r * _grid.cols + c);
+}
+
+namespace {
+
+/// 批量检测中一组竖直射线的最大数量
+const int kBatchBinSize = 64;
+
+/// BVH 模式下同一组射线 Morton 码相同的高位：低 10 位以外相同，即落在根节点 32x32 划分的同一块内
+const uint32_t kBatchBinShift = 10;
+
+} // namespace
+
+int TerrainCollider::rayIntersectsBatch(const CustomRay* rays, int count, float* outHitDist, RayHit* outHits) {
+    if (count <= 0) return 0;
+    if (_mesh.empty()) {
+        std::fill(outHitDist, outHitDist + count, kNoHit);
+        return 0;
+    }
+
+    // 1. 计算排序键，键相同时按输入下标排序，保证结果确定
+    _batchOrder.resize(count);
+    for (int i = 0; i < count; ++i) {
+        _batchOrder[i] = std::make_pair(batchSortKey(rays[i].origin), i);
+    }
+    std::sort(_batchOrder.begin(), _batchOrder.end());
+
+    // 2. 排序后相邻的竖直射线分为一组，整组只查询一次加速结构；其余射线逐条求解
+    int hits = 0;
+    for (size_t begin = 0; begin < _batchOrder.size();) {
+        const int first = _batchOrder[begin].second;
+        if (!isDownRay(rays[first].direction)) {
+            hits += solveBatchRay(rays[first], outHitDist[first], outHits ? &outHits[first] : nullptr);
+            ++begin;
+            continue;
+        }
+
+        const uint32_t binKey = _accelType == AccelType::BVH ? _batchOrder[begin].first >> kBatchBinShift
+                                                              : _batchOrder[begin].first;
+        size_t end = begin + 1;
+        while (end < _batchOrder.size() && end - begin < (size_t)kBatchBinSize) {
+            const uint32_t key = _accelType == AccelType::BVH ? _batchOrder[end].first >> kBatchBinShift
+                                                               : _batchOrder[end].first;
+            if (key != binKey || !isDownRay(rays[_batchOrder[end].second].direction)) break;
+            ++end;
+        }
+        hits += solveDownRayBin(rays, begin, end, outHitDist, outHits);
+        begin = end;
+    }
+    return hits;
+}
+
+/**
+ * 批量检测中单条射线的求解，结果写入 outHitDist / outHit
+ * @return int 命中时为 1
+ */
+int TerrainCollider::solveBatchRay(const CustomRay& ray, float& outHitDist, RayHit* outHit) {
+    bool hit;
+    if (outHit) {
+        hit = rayIntersects(ray, *outHit);
+        if (hit) outHitDist = outHit->distance;
+    } else {
+        hit = rayIntersects(ray, outHitDist);
+    }
+    if (!hit) outHitDist = kNoHit;
+    return hit ? 1 : 0;
+}
+
+/**
+ * 一组竖直向下射线（_batchOrder[begin, end)）的共享求解
+ * 先查高度场；其余射线的 XZ 起点合并为一个包围盒，
+ * 网格模式直接取共同所在单元格的三角形，BVH 模式只做一次包围盒遍历，
+ * 候选三角形按组的包围盒与最高起点筛选一次，再逐条射线检测 XZ 覆盖起点的候选。
+ * 命中距离与逐条调用 rayIntersects 相同。
+ * @return int 命中的射线数量
+ */
+int TerrainCollider::solveDownRayBin(const CustomRay* rays, size_t begin, size_t end, float* outHitDist,
+                                     RayHit* outHits) {
+    int hits = 0;
+
+    // 1. 高度场能直接给出结果的射线不参与三角形求交
+    _binRays.clear();
+    float minX = FLT_MAX, minZ = FLT_MAX, maxX = -FLT_MAX, maxZ = -FLT_MAX, maxY = -FLT_MAX;
+    for (size_t k = begin; k < end; ++k) {
+        const int i = _batchOrder[k].second;
+        const CustomRay& ray = rays[i];
+        float groundY;
+        const TerrainHeightfield::Probe probe =
+            probeHeightfield(ray.origin, groundY, outHits ? &outHits[i].normal : nullptr);
+        if (probe == TerrainHeightfield::Probe::Hit) {
+            outHitDist[i] = (ray.origin.y - groundY) / -ray.direction.y;
+            if (outHits) {
+                outHits[i].distance = outHitDist[i];
+                outHits[i].triangle = -1;
+            }
+            ++hits;
+            continue;
+        }
+        if (probe == TerrainHeightfield::Probe::Miss) {
+            outHitDist[i] = kNoHit;
+            continue;
+        }
+        _binRays.push_back(i);
+        minX = std::min(minX, ray.origin.x);
+        maxX = std::max(maxX, ray.origin.x);
+        minZ = std::min(minZ, ray.origin.z);
+        maxZ = std::max(maxZ, ray.origin.z);
+        maxY = std::max(maxY, ray.origin.y);
+    }
+    if (_binRays.empty()) return hits;
+
+    // 2. 整组的候选三角形：XZ 包围盒覆盖组内某个起点、且最低点不高于最高起点
+    _binCandidates.clear();
+    auto collect = [&](int t) {
+        if (!_soa.overlapsXZ(t, minX, maxX, minZ, maxZ)) return;
+        Vec3 bmin, bmax;
+        _soa.getBounds(t, bmin, bmax);
+        if (bmin.y > maxY) return;
+        _binCandidates.push_back(t);
+    };
+    if (_accelType == AccelType::BVH) {
+        _bvh.overlap(Vec3(minX, -FLT_MAX, minZ), Vec3(maxX, maxY, maxZ), [&](int first, int count) {
+            for (int t = first; t < first + count; ++t) collect(t);
+        });
+    } else {
+        // 同组射线的排序键相同，即位于同一单元格（或都在网格之外）
+        const int c = (int)((rays[_binRays[0]].origin.x - _grid.minX) / _grid.cellSize);
+        const int r = (int)((rays[_binRays[0]].origin.z - _grid.minZ) / _grid.cellSize);
+        if (c >= 0 && c < _grid.cols && r >= 0 && r < _grid.rows) {
+            const int cellIndex = r * _grid.cols + c;
+            for (uint32_t k = _grid.offsets[cellIndex]; k < _grid.offsets[cellIndex + 1]; ++k) {
+                collect(_grid.indices[k]);
+            }
+        }
+    }
+
+    // 3. 每条射线只检测覆盖自己起点的候选
+    for (int i : _binRays) {
+        const CustomRay& ray = rays[i];
+        float best = FLT_MAX;
+        int bestTriangle = -1;
+        for (int t : _binCandidates) {
+            if (!_soa.overlapsXZ(t, ray.origin.x, ray.origin.x, ray.origin.z, ray.origin.z)) continue;
+            float tHit;
+            if (_soa.intersect(t, ray.origin, ray.direction, tHit) && tHit < best) {
+                best = tHit;
+                bestTriangle = t;
+            }
+        }
+
+        if (bestTriangle < 0) {
+            outHitDist[i] = kNoHit;
+            continue;
+        }
+        outHitDist[i] = best;
+        if (outHits) fillRayHit(bestTriangle, best, ray.direction, outHits[i]);
+        ++hits;
+    }
+    return hits;
+}
+
+/**
+ * 网格路径
+ * 竖直射线只检测起点所在的单元格；其余射线先裁剪到网格范围，再沿 XZ 投影做 DDA 逐格遍历。
+ * 三角形可能跨越多个单元格，因此只有当最近交点落在当前单元格的出口之前时才能提前结束。
+ */
+bool TerrainCollider::raycastGrid(const Vec3& origin, const Vec3& dir, float tMax, bool anyHit, float& hitT,
+                                  int* hitIndex) {
+    float closestDist = tMax;
+    int closestIndex = -1;
     bool hit = false;
-    
-    for (int idx : cellIndices) {
-        const auto& tri = _triangles[idx];
-        
-        // 性能优化：快速 AABB 过滤 (2D 投影)
-        if (ray.origin.x < tri.minX || ray.origin.x > tri.maxX || ray.origin.z < tri.minZ || ray.origin.z > tri.maxZ) continue;
-
-        float t;
-        if (intersectTriangle(ray, tri, t)) {
-            if (t < closestDist && t > 0) {
+
+    if (dir.x == 0.0f && dir.z == 0.0f) {
+        int c = (int)((origin.x - _grid.minX) / _grid.cellSize);
+        int r = (int)((origin.z - _grid.minZ) / _grid.cellSize);
+
+        // 如果射线在网格之外，不进行检测
+        if (c < 0 || c >= _grid.cols || r < 0 || r >= _grid.rows) return false;
+
+        const int cellIndex = r * _grid.cols + c;
+        for (uint32_t k = _grid.offsets[cellIndex]; k < _grid.offsets[cellIndex + 1]; ++k) {
+            const int idx = _grid.indices[k];
+
+            // 性能优化：快速 AABB 过滤 (2D 投影)
+            if (!_soa.overlapsXZ(idx, origin.x, origin.x, origin.z, origin.z)) continue;
+
+            float t;
+            if (_soa.intersect(idx, origin, dir, t) && t < closestDist) {
                 closestDist = t;
+                closestIndex = idx;
                 hit = true;
+                if (anyHit) break;
             }
         }
+
+        if (hit) {
+            hitT = closestDist;
+            if (hitIndex) *hitIndex = closestIndex;
+        }
+        return hit;
+    }
+
+    // 1. 将射线参数区间裁剪到网格的 XZ 范围
+    const float gridMin[2] = {_grid.minX, _grid.minZ};
+    const float gridMax[2] = {_grid.minX + _grid.cols * _grid.cellSize, _grid.minZ + _grid.rows * _grid.cellSize};
+    const float o[2] = {origin.x, origin.z};
+    const float d[2] = {dir.x, dir.z};
+    float tEnter = 0.0f;
+    float tExit = tMax;
+    for (int a = 0; a < 2; ++a) {
+        if (d[a] == 0.0f) {
+            if (o[a] < gridMin[a] || o[a] > gridMax[a]) return false;
+            continue;
+        }
+        float t0 = (gridMin[a] - o[a]) / d[a];
+        float t1 = (gridMax[a] - o[a]) / d[a];
+        if (t0 > t1) std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tExit = std::min(tExit, t1);
+    }
+    if (tEnter > tExit) return false;
+
+    // 2. 起始单元格与 DDA 步进参数
+    int cell[2];
+    int step[2];
+    float tNext[2];
+    float tDelta[2];
+    const int dims[2] = {_grid.cols, _grid.rows};
+    for (int a = 0; a < 2; ++a) {
+        float p = o[a] + d[a] * tEnter;
+        cell[a] = std::min(std::max((int)((p - gridMin[a]) / _grid.cellSize), 0), dims[a] - 1);
+        if (d[a] > 0.0f) {
+            step[a] = 1;
+            tNext[a] = (gridMin[a] + (cell[a] + 1) * _grid.cellSize - o[a]) / d[a];
+            tDelta[a] = _grid.cellSize / d[a];
+        } else if (d[a] < 0.0f) {
+            step[a] = -1;
+            tNext[a] = (gridMin[a] + cell[a] * _grid.cellSize - o[a]) / d[a];
+            tDelta[a] = -_grid.cellSize / d[a];
+        } else {
+            step[a] = 0;
+            tNext[a] = FLT_MAX;
+            tDelta[a] = FLT_MAX;
+        }
+    }
+
+    // 3. 逐格检测，直到最近交点落在当前格内或走出裁剪区间
+    float cellEnter = tEnter;
+    while (true) {
+        const int axis = tNext[0] < tNext[1] ? 0 : 1;
+        const float cellExit = std::min(tNext[axis], tExit);
+
+        // 射线在本格内经过的 XZ 范围，用来跳过包围盒不相交的三角形
+        const float x0 = origin.x + dir.x * cellEnter, x1 = origin.x + dir.x * cellExit;
+        const float z0 = origin.z + dir.z * cellEnter, z1 = origin.z + dir.z * cellExit;
+        const float spanMinX = std::min(x0, x1), spanMaxX = std::max(x0, x1);
+        const float spanMinZ = std::min(z0, z1), spanMaxZ = std::max(z0, z1);
+
+        const int cellIndex = cell[1] * _grid.cols + cell[0];
+        for (uint32_t k = _grid.offsets[cellIndex]; k < _grid.offsets[cellIndex + 1]; ++k) {
+            const int idx = _grid.indices[k];
+            if (!_soa.overlapsXZ(idx, spanMinX, spanMaxX, spanMinZ, spanMaxZ)) continue;
+
+            float t;
+            if (_soa.intersect(idx, origin, dir, t) && t < closestDist) {
+                closestDist = t;
+                closestIndex = idx;
+                hit = true;
+                if (anyHit) {
+                    hitT = closestDist;
+                    if (hitIndex) *hitIndex = closestIndex;
+                    return true;
+                }
+            }
+        }
+
+        if (hit && closestDist <= cellExit) break;
+        if (cellExit >= tExit) break;
+
+        cellEnter = cellExit;
+        cell[axis] += step[axis];
+        tNext[axis] += tDelta[axis];
+        if (cell[axis] < 0 || cell[axis] >= dims[axis]) break;
+    }
+
+    if (hit) {
+        hitT = closestDist;
+        if (hitIndex) *hitIndex = closestIndex;
     }
-    
-    if (hit) hitDist = closestDist;
     return hit;
 }
 
 /**
- * 核心数学算法：Möller-Trumbore 射线-三角形相交检测
- * 此算法不需要计算平面方程，效率极高。
- * @param t 返回相交点在射线方向上的参数值（距离 = t * |direction|）
+ * BVH 路径：由近到远遍历叶子，命中后用更小的 tMax 剪枝剩余节点
+ * 叶子内的三角形连续存放，直接交给 SIMD 批量求交
  */
-bool TerrainCollider::intersectTriangle(const CustomRay& ray, const Triangle& tri, float& t) {
-    Vec3 edge1 = tri.v1 - tri.v0;
-    Vec3 edge2 = tri.v2 - tri.v0;
-    Vec3 h, s, q;
-    float a, f, u, v;
-    
-    Vec3::cross(ray.direction, edge2, &h);
-    a = edge1.dot(h);
-    
-    // 如果 a 接近 0，说明射线与三角形平面平行
-    if (a > -0.00001f && a < 0.00001f) return false;
-    
-    f = 1.0f / a;
-    s = ray.origin - tri.v0;
-    u = f * s.dot(h);
-    
-    // 检查重心坐标 u 是否在三角形内部
-    if (u < 0.0f || u > 1.0f) return false;
-    
-    Vec3::cross(s, edge1, &q);
-    v = f * ray.direction.dot(q);
-    
-    // 检查重心坐标 v 及 u+v 是否在三角形内部
-    if (v < 0.0f || u + v > 1.0f) return false;
-    
-    // 计算射线参数 t
-    t = f * edge2.dot(q);
-    
-    // 如果 t > 0，说明交点在射线正方向上
-    return t > 0.00001f;
+bool TerrainCollider::raycastBVH(const Vec3& origin, const Vec3& dir, float tMax, bool anyHit, float& hitT,
+                                 int* hitIndex) {
+    float closestDist = tMax;
+    int closestIndex = -1;
+    bool hit = _bvh.raycast(origin, dir, closestDist, [&](int first, int count, float& t) {
+        return _soa.intersectRange(first, count, origin, dir, t, closestIndex);
+    }, anyHit);
+
+    if (hit) {
+        hitT = closestDist;
+        if (hitIndex) *hitIndex = closestIndex;
+    }
+    return hit;
 }
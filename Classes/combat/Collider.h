@@ -2,8 +2,19 @@
 #define __COLLIDER_H__
 
 #include "cocos2d.h"
+#include "TerrainBVH.h"
+#include "TriangleSoA.h"
+#include "TerrainHeightfield.h"
+#include "QuantizedMesh.h"
+#include <cstdint>
+#include <functional>
 #include <vector>
 
+namespace CollisionCache {
+class Reader;
+class Writer;
+}
+
 /**
  * @class CustomRay
  * @brief 简单的射线类，用于碰撞检测
@@ -16,45 +27,359 @@ public:
     CustomRay(const cocos2d::Vec3& o, const cocos2d::Vec3& d) : origin(o), direction(d) {}
 };
 
+/**
+ * @class TerrainQuery
+ * @brief 角色与场景使用的地形查询接口
+ *
+ * 单块地形由 TerrainCollider 实现；分块流式加载的世界由 TerrainStreamer 实现，
+ * 查询按位置转发给已驻留的分块；StaticCollisionWorld 在任一地形之上叠加静态物件实例，
+ * 取两者中最近的结果。接口语义以 TerrainCollider 的同名方法为准。
+ */
+class TerrainQuery {
+public:
+    /**
+     * @brief 单个角色的贴地查询缓存（由角色持有，按需启用）
+     *
+     * 记录上一次命中的三角形、与它共享顶点的一圈三角形，以及这组三角形 XZ 范围内
+     * 高于其最低点的其它三角形（如桥面、墙根）。只要探测点仍落在这组三角形的范围内，
+     * 并且命中高度不低于它们的最低点，缓存内的最近命中就是全局最近命中，无需再扫描格子。
+     */
+    struct GroundCache {
+        static const int kMaxTriangles = 24;
+
+        uint32_t ownerSerial = 0;               ///< 填充缓存的碰撞器序号（0 表示无），换地形后自动失效
+        int count = 0;                          ///< 0 表示缓存为空
+        int triangles[kMaxTriangles];           ///< 第一个为上次命中的三角形
+        float bounds[kMaxTriangles][5];         ///< 各三角形的 minX, maxX, minZ, maxZ, maxY，用于跳过不可能更近的三角形
+        float minX = 0.0f, maxX = 0.0f, minZ = 0.0f, maxZ = 0.0f; ///< 缓存有效的 XZ 范围（开区间）
+        float floorY = 0.0f;                    ///< 命中高度不低于此值时结果才可信
+
+        int cacheHits = 0;    ///< 统计：由缓存直接解决的次数
+        int cacheMisses = 0;  ///< 统计：回退到完整查询的次数
+
+        void reset() { count = 0; }
+    };
+
+    /**
+     * @brief 带命中面信息的射线检测结果
+     */
+    struct RayHit {
+        float distance = 0.0f;                        ///< 与 rayIntersects 输出的 hitDist 含义相同
+        cocos2d::Vec3 normal = cocos2d::Vec3::UNIT_Y; ///< 命中三角形的单位法线，朝向射线起点一侧
+        int triangle = -1;                            ///< 命中三角形在所属碰撞器中的下标，-1 表示未知（例如由高度场求得）
+    };
+
+    /// rayIntersectsBatch 中未命中射线写入的距离
+    static constexpr float kNoHit = -1.0f;
+
+    /// 可直接跨越的台阶高度，地形扫掠的胶囊体底部也抬高到这个高度
+    static constexpr float kMaxStepHeight = 40.0f;
+
+    /// 可站立地面法线 y 分量的下限（cos 45°），更陡的面视为墙壁
+    static constexpr float kMinWalkableNormalY = 0.7071f;
+
+    /**
+     * @brief 角色能否从当前脚底高度走上一次地面探测的命中面（Character 与 Enemy 共用的判定）
+     * 上升高度必须小于台阶高度；上坡时命中面还必须足够平缓，下坡不限制坡度
+     * @param rise 地面高度减去当前脚底高度
+     * @param groundNormal 地面探测命中面的法线
+     */
+    static bool canStepOnto(float rise, const cocos2d::Vec3& groundNormal) {
+        return rise < kMaxStepHeight && (rise <= 0.0f || groundNormal.y >= kMinWalkableNormalY);
+    }
+
+    virtual ~TerrainQuery() {}
+
+    virtual bool rayIntersects(const CustomRay& ray, float& hitDist) = 0;
+    virtual bool rayIntersects(const CustomRay& ray, RayHit& outHit) = 0;
+    virtual bool segmentIntersects(const cocos2d::Vec3& from, const cocos2d::Vec3& to) = 0;
+    virtual bool segmentIntersects(const cocos2d::Vec3& from, const cocos2d::Vec3& to, float& outFraction) = 0;
+    /**
+     * @brief 胶囊体扫掠的首次接触（组合多个查询源的 slideCapsule 以此合并各自的碰撞）
+     * @param toi 输出：接触时间 [0, 1]
+     * @param normal 输出：接触法线（由地形指向胶囊）
+     */
+    virtual bool sweepCapsule(const cocos2d::Vec3& a, const cocos2d::Vec3& b, float radius,
+                              const cocos2d::Vec3& delta, float& toi, cocos2d::Vec3& normal) = 0;
+    virtual cocos2d::Vec3 slideCapsule(const cocos2d::Vec3& from, const cocos2d::Vec3& axisBottom,
+                                       const cocos2d::Vec3& axisTop, float radius, const cocos2d::Vec3& delta,
+                                       int maxIterations = 2) = 0;
+    virtual bool probeGround(const cocos2d::Vec3& origin, GroundCache& cache, RayHit& outHit) = 0;
+    virtual int rayIntersectsBatch(const CustomRay* rays, int count, float* outHitDist, RayHit* outHits = nullptr) = 0;
+};
+
 /**
  * @class TerrainCollider
  * @brief 处理 3D 地形碰撞的类
  */
-class TerrainCollider : public cocos2d::Ref {
+class TerrainCollider : public cocos2d::Ref, public TerrainQuery {
 public:
-    static TerrainCollider* create(cocos2d::Sprite3D* terrainModel, const std::string& objFilePath = "");
+    /**
+     * @brief 加速结构类型
+     */
+    enum class AccelType {
+        Grid, ///< 固定 32x32 的 XZ 均匀网格，非竖直射线按 DDA 逐格遍历
+        BVH   ///< SAH 构建的层次包围盒，查询代价与三角形数量成对数关系
+    };
+
+    /**
+     * @param simplifyTolerance 大于 0 时用 MeshSimplifier 把 .obj 网格简化为碰撞代理，
+     *        任一原始顶点到代理网格的偏差不超过该值（世界单位）
+     */
+    static TerrainCollider* create(cocos2d::Sprite3D* terrainModel, const std::string& objFilePath = "",
+                                   AccelType accel = AccelType::Grid, float simplifyTolerance = 0.0f);
+
+    /**
+     * @brief 从 .obj 创建碰撞网格，不依赖渲染模型
+     * 默认保持 .obj 的模型空间；
+     * 给出 scale / position 时按同样的变换烘焙到世界坐标（离线烘焙工具以此复现场景中的地形）
+     */
+    static TerrainCollider* createFromObj(const std::string& objFilePath, AccelType accel = AccelType::BVH,
+                                          float scale = 1.0f, const cocos2d::Vec3& position = cocos2d::Vec3::ZERO,
+                                          float simplifyTolerance = 0.0f);
     
-    bool init(cocos2d::Sprite3D* terrainModel, const std::string& objFilePath);
+    bool init(cocos2d::Sprite3D* terrainModel, const std::string& objFilePath, AccelType accel);
+
+    /**
+     * @brief 从已打开的烘焙文件中读取三角形、加速结构与高度场
+     * @param terrainModel 关联的渲染模型（可为空）
+     * @param reader 已校验的烘焙文件，段布局与碰撞缓存相同
+     * @param accel 期望的加速结构类型，与文件中记录的不一致时失败
+     */
+    bool initFromBake(cocos2d::Sprite3D* terrainModel, const CollisionCache::Reader& reader, AccelType accel);
+
+    /**
+     * @brief 把碰撞数据写成碰撞缓存格式的文件
+     * @param extraSections 可选：在写出前追加其它段（如烘焙工具的出生点与导航数据）
+     * @return bool 是否写入成功
+     */
+    bool writeToFile(const std::string& fullPath, uint64_t key,
+                     const std::function<void(CollisionCache::Writer&)>& extraSections = nullptr) const;
 
     /**
      * @brief 射线检测
+     * 竖直向下的射线优先查询烘焙的高度场（误差不超过 TerrainHeightfield::kMaxError），
+     * 高度场标记为不连续的区域再回退到精确的三角形求交
      * @param ray 射线
      * @param hitDist 输出：碰撞距离
      * @return bool 是否碰撞
      */
-    bool rayIntersects(const CustomRay& ray, float& hitDist);
+    bool rayIntersects(const CustomRay& ray, float& hitDist) override;
 
-private:
-    cocos2d::Sprite3D* _terrain;
-    // 这里可以存储简化的物理网格数据
-    struct Triangle {
-        cocos2d::Vec3 v0, v1, v2;
-        float minX, maxX, minZ, maxZ; // 预计算的 XZ 边界，用于快速过滤
+    /**
+     * @brief 射线检测，同时返回命中面的法线
+     * 竖直向下的射线先查高度场，法线取插值曲面的梯度法线，triangle 为 -1；
+     * 单元格内有过陡的三角形、或高度场无法给出结果时做精确的三角形求交
+     * @param ray 射线
+     * @param outHit 输出：碰撞距离、法线与三角形下标
+     * @return bool 是否碰撞
+     */
+    bool rayIntersects(const CustomRay& ray, RayHit& outHit) override;
+
+    /**
+     * @brief 线段遮挡检测（视线、镜头遮挡），找到任意一个交点即返回
+     * @param from 线段起点
+     * @param to 线段终点
+     * @return bool 线段是否被地形挡住
+     */
+    bool segmentIntersects(const cocos2d::Vec3& from, const cocos2d::Vec3& to) override;
+
+    /**
+     * @brief 线段检测，返回最近交点
+     * @param outFraction 输出：最近交点在线段上的比例 [0, 1]，交点 = from + (to - from) * outFraction
+     * @return bool 线段是否被地形挡住
+     */
+    bool segmentIntersects(const cocos2d::Vec3& from, const cocos2d::Vec3& to, float& outFraction) override;
+
+    /**
+     * @brief 胶囊体扫掠结果
+     */
+    struct SweepHit {
+        float toi = 1.0f;       ///< 接触时间 [0, 1]，接触位置 = 起点 + delta * toi
+        cocos2d::Vec3 normal;   ///< 接触法线（由地形指向胶囊）
+        cocos2d::Vec3 point;    ///< 地形上的接触点
     };
-    std::vector<Triangle> _triangles;
+
+    /**
+     * @brief 胶囊体扫掠：轴线 (a, b)、半径 radius 的胶囊沿 delta 平移，求与地形的首次接触
+     * 用扫掠包围盒在 BVH / 网格中粗筛三角形，再逐个解析求解接触时间
+     * @return bool 移动过程中是否碰到地形
+     */
+    bool sweepCapsule(const cocos2d::Vec3& a, const cocos2d::Vec3& b, float radius,
+                      const cocos2d::Vec3& delta, SweepHit& outHit);
+    bool sweepCapsule(const cocos2d::Vec3& a, const cocos2d::Vec3& b, float radius,
+                      const cocos2d::Vec3& delta, float& toi, cocos2d::Vec3& normal) override;
+
+    /**
+     * @brief 沿墙滑动的水平移动
+     * 每次扫掠碰到地形后停在接触点，去掉剩余位移中指向墙面的水平分量后继续，最多 maxIterations 次
+     * @param from 起始位置（脚底）
+     * @param axisBottom, axisTop 胶囊轴线两端相对脚底的偏移
+     * @param radius 胶囊半径
+     * @param delta 期望位移（只使用 XZ 分量）
+     * @return Vec3 实际到达的位置（Y 与 from 相同）
+     */
+    cocos2d::Vec3 slideCapsule(const cocos2d::Vec3& from, const cocos2d::Vec3& axisBottom, const cocos2d::Vec3& axisTop,
+                               float radius, const cocos2d::Vec3& delta, int maxIterations = 2) override;
+
+    /**
+     * @brief 带缓存的竖直向下地面探测，结果与 rayIntersects(CustomRay(origin, (0, -1, 0)), RayHit&) 一致
+     * 先查高度场；落在不连续区域时检测缓存中的三角形，离开缓存范围时再做完整查询并以新的命中三角形重建缓存
+     * @param origin 射线起点
+     * @param cache 调用方持有的缓存
+     * @param outHit 输出：起点到地面的距离与地面三角形的法线，调用方据此一次判定可走还是墙壁
+     * @return bool 是否碰撞
+     */
+    bool probeGround(const cocos2d::Vec3& origin, GroundCache& cache, RayHit& outHit) override;
+
+    /**
+     * @brief 批量射线检测
+     * 先按射线起点所在的网格单元（网格模式）或 Morton 码（BVH 模式）排序，
+     * 排序后相邻的竖直向下射线（同一单元格，或 BVH 根节点 32x32 划分的同一块内，每组最多 64 条）
+     * 合并为一组：整组只做一次加速结构查询，候选三角形由组内射线共享；其余射线逐条求解。
+     * 结果与逐条调用 rayIntersects 相同，并按输入顺序写出。
+     * @param rays 射线数组
+     * @param count 射线数量
+     * @param outHitDist 输出：长度为 count，命中时为碰撞距离，未命中时为 kNoHit
+     * @param outHits 可选输出：长度为 count 的命中面信息，规则与 rayIntersects(const CustomRay&, RayHit&) 相同
+     * @return int 命中的射线数量
+     */
+    int rayIntersectsBatch(const CustomRay* rays, int count, float* outHitDist, RayHit* outHits = nullptr) override;
+
+    AccelType getAccelType() const { return _accelType; }
+
+    /**
+     * @brief 碰撞网格（与查询同一坐标空间），供导航网格等加载期处理读取
+     */
+    const QuantizedMesh& getMesh() const { return _mesh; }
+
+    /**
+     * @brief 第 i 个三角形的单位法线（朝上一侧），由 SoA 中的两条边现算
+     */
+    cocos2d::Vec3 getTriangleNormal(int i) const { return _soa.getNormal(i); }
+
+    /**
+     * @brief 碰撞数据常驻内存的总字节数：量化网格、查询用 SoA、加速结构、高度场与顶点邻接表
+     */
+    size_t getMemoryBytes() const;
+
+    /**
+     * @brief 碰撞网格的包围盒（与查询使用同一坐标空间）
+     * @return bool 网格为空时返回 false
+     */
+    bool getBounds(cocos2d::Vec3& outMin, cocos2d::Vec3& outMax) const;
+
+    /**
+     * @brief 加载耗时统计（毫秒）
+     */
+    struct LoadStats {
+        bool fromCache = false;
+        int triangleCount = 0;
+        int parseThreads = 0;
+        float parseMs = 0.0f;  ///< .obj 解析（命中缓存时为 0）
+        float buildMs = 0.0f;  ///< 加速结构与高度场构建（命中缓存时为 0）
+        float heightfieldFastRatio = 0.0f; ///< 高度场可直接插值的单元格比例
+        int sourceTriangleCount = 0;       ///< 简化前的三角形数（未简化或命中缓存时为 0）
+        float simplifyDeviation = 0.0f;    ///< 碰撞代理相对 .obj 网格的最大偏差（缓存中一并保存）
+        float simplifyMs = 0.0f;
+        float cacheMs = 0.0f;  ///< 读取或写入缓存
+        float totalMs = 0.0f;
+    };
+
+    const LoadStats& getLoadStats() const { return _loadStats; }
+
+private:
+    cocos2d::Sprite3D* _terrain = nullptr; ///< 关联的渲染模型，可为空
+    float _scale = 1.0f;                    ///< 烘焙进三角形的缩放与位置（取自渲染模型或 createFromObj 的参数）
+    cocos2d::Vec3 _position;
+    float _simplifyTolerance = 0.0f;        ///< 碰撞代理的简化容差，0 表示直接使用 .obj 网格
+    AccelType _accelType = AccelType::Grid;
+    LoadStats _loadStats;
+
+    // 进程内唯一的序号，贴地缓存以它识别填充者：分块卸载后新碰撞器即使复用同一地址也不会误用旧缓存
+    const uint32_t _serial = allocateSerial();
+    static uint32_t allocateSerial();
+
+    // 碰撞网格：索引顶点缓冲 + 16 位量化坐标
+    QuantizedMesh _mesh;
+
+    // 查询用的 SoA 副本（解码后的顶点 + 预计算边），顺序与 _mesh 的三角形一致，法线按需由两条边现算
+    TriangleSoA _soa;
+
+    void fillRayHit(int triangle, float t, const cocos2d::Vec3& dir, RayHit& outHit) const;
+
+    void buildSoA();
 
     void extractTriangles(cocos2d::Sprite3D* model);
     bool loadFromObj(const std::string& objFilePath);
-    bool intersectTriangle(const CustomRay& ray, const Triangle& tri, float& t);
+
+    // 二进制碰撞缓存：首次解析 .obj 后写入可写目录，之后启动直接映射读取
+    std::string getCachePath(const std::string& objFilePath) const;
+    uint64_t computeCacheKey(const std::string& objFullPath) const;
+    bool loadFromCache(const std::string& cachePath, uint64_t key);
+    bool loadSections(const CollisionCache::Reader& reader);
+    void saveToCache(const std::string& cachePath, uint64_t key) const;
 
     // 空间网格优化
     struct Grid {
-        float minX, minZ, cellSize;
-        int cols, rows;
-        std::vector<std::vector<int>> cells; // 每个格子存储三角形索引
+        float minX = 0.0f, minZ = 0.0f, cellSize = 1.0f; // 只在网格模式下由 buildGrid 设置
+        int cols = 0, rows = 0;
+        std::vector<uint32_t> offsets; // 格子 i 的三角形为 indices[offsets[i], offsets[i + 1])
+        std::vector<int32_t> indices;  // 所有格子的三角形索引，连续存放
     } _grid;
 
     void buildGrid();
+
+    // BVH 加速结构（_mesh 的三角形会按叶子顺序重排，叶子直接引用连续区间）
+    TerrainBVH _bvh;
+
+    void buildBVH();
+
+    // 竖直射线的高度场快速路径
+    TerrainHeightfield _heightfield;
+
+    void buildHeightfield();
+
+    /**
+     * 查询高度场；需要法线时只在全部三角形都可站立的单元格返回 Probe::Hit，
+     * 梯度法线本身超出坡度限制时也返回 Probe::Exact，保证 canStepOnto 的判定与精确求交一致
+     */
+    TerrainHeightfield::Probe probeHeightfield(const cocos2d::Vec3& origin, float& outGroundY,
+                                               cocos2d::Vec3* outNormal) const;
+
+    /**
+     * 精确求交的统一入口
+     * @param tMax 只接受 t < tMax 的交点（线段查询时为 1）
+     * @param anyHit 为 true 时找到任意交点即返回
+     */
+    bool raycast(const cocos2d::Vec3& origin, const cocos2d::Vec3& dir, float tMax, bool anyHit, float& hitT,
+                 int* hitIndex = nullptr);
+    bool raycastGrid(const cocos2d::Vec3& origin, const cocos2d::Vec3& dir, float tMax, bool anyHit, float& hitT,
+                     int* hitIndex);
+    bool raycastBVH(const cocos2d::Vec3& origin, const cocos2d::Vec3& dir, float tMax, bool anyHit, float& hitT,
+                    int* hitIndex);
+
+    // 贴地缓存：每个顶点相邻的三角形（偏移表 + 扁平索引），首次使用缓存时构建
+    std::vector<uint32_t> _vertexTriangleOffsets;
+    std::vector<int32_t> _vertexTriangles;
+
+    void buildVertexTriangles();
+    void fillGroundCache(int triangle, GroundCache& cache);
+
+    /**
+     * 粗筛：访问包围盒可能与 [bmin, bmax] 相交的三角形（网格模式下跨格的三角形会重复出现）
+     */
+    template <typename Fn>
+    void forEachCandidate(const cocos2d::Vec3& bmin, const cocos2d::Vec3& bmax, Fn fn) const;
+
+    std::vector<int> _sweepCandidates; ///< 扫掠粗筛结果，复用以避免每帧分配
+
+    uint32_t batchSortKey(const cocos2d::Vec3& origin) const;
+    int solveBatchRay(const CustomRay& ray, float& outHitDist, RayHit* outHit);
+    int solveDownRayBin(const CustomRay* rays, size_t begin, size_t end, float* outHitDist, RayHit* outHits);
+    std::vector<std::pair<uint32_t, int>> _batchOrder; ///< 批量检测的排序缓冲，复用以避免每帧分配
+    std::vector<int> _binRays;       ///< 当前一组中需要三角形求交的射线下标
+    std::vector<int> _binCandidates; ///< 当前一组共享的候选三角形
 };
 
 #endif // __COLLIDER_H__
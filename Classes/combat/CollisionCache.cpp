@@ -0,0 +1,205 @@
+#include "CollisionCache.h"
+#include "cocos2d.h"
+#include <algorithm>
+#include <cstring>
+
+USING_NS_CC;
+
+namespace CollisionCache {
+
+namespace {
+
+const uint32_t kMagic = 0x43434B57;   ///< 'WKCC'
+const size_t kKeySampleBytes = 64 * 1024; ///< hashFile 对文件头尾各采样的字节数
+const uint16_t kEndianTag = 0x0102;   ///< 按本机字节序写入，读回不一致说明字节序不同
+const size_t kSectionAlign = 16;
+
+/**
+ * 文件头（40 字节）
+ */
+struct FileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t endianTag;
+    uint32_t sectionCount;
+    uint32_t reserved;
+    uint64_t sourceKey;
+    uint64_t checksum;   ///< 覆盖段表与全部段数据
+    uint64_t totalSize;  ///< 整个文件的字节数，用于发现被截断的文件
+};
+
+/**
+ * 段表项（24 字节），offset 相对文件起始位置
+ */
+struct SectionEntry {
+    uint32_t tag;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+inline size_t alignUp(size_t v) {
+    return (v + kSectionAlign - 1) & ~(kSectionAlign - 1);
+}
+
+} // namespace
+
+uint64_t hash(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+uint64_t hashFile(const std::string& fullPath, uint64_t seed) {
+    uint64_t key = seed;
+    MappedFile file;
+    if (file.open(fullPath)) {
+        uint64_t size = file.size();
+        key = hash(&size, sizeof(size), key);
+        size_t head = std::min(file.size(), kKeySampleBytes);
+        key = hash(file.data(), head, key);
+        if (file.size() > head) {
+            size_t tail = std::min(file.size() - head, kKeySampleBytes);
+            key = hash(file.data() + file.size() - tail, tail, key);
+        }
+    } else {
+        // 无法映射（如 Android APK 内的资源）时只用文件大小
+        int64_t size = FileUtils::getInstance()->getFileSize(fullPath);
+        key = hash(&size, sizeof(size), key);
+    }
+    return key;
+}
+
+void Writer::addSection(uint32_t tag, const void* data, size_t size) {
+    _sections.push_back({tag, data, size});
+}
+
+bool Writer::write(const std::string& fullPath, uint64_t sourceKey) const {
+    // 1. 计算布局
+    size_t tableOffset = sizeof(FileHeader);
+    size_t offset = alignUp(tableOffset + sizeof(SectionEntry) * _sections.size());
+
+    std::vector<SectionEntry> table(_sections.size());
+    for (size_t i = 0; i < _sections.size(); ++i) {
+        table[i].tag = _sections[i].tag;
+        table[i].reserved = 0;
+        table[i].offset = offset;
+        table[i].size = _sections[i].size;
+        offset = alignUp(offset + _sections[i].size);
+    }
+
+    // 2. 拼装整个文件（对齐填充部分保持为 0）
+    std::vector<unsigned char> buffer(offset, 0);
+    if (!table.empty()) {
+        memcpy(buffer.data() + tableOffset, table.data(), sizeof(SectionEntry) * table.size());
+    }
+    for (size_t i = 0; i < _sections.size(); ++i) {
+        if (_sections[i].size > 0) {
+            memcpy(buffer.data() + table[i].offset, _sections[i].data, _sections[i].size);
+        }
+    }
+
+    FileHeader header;
+    header.magic = kMagic;
+    header.version = kFormatVersion;
+    header.endianTag = kEndianTag;
+    header.sectionCount = (uint32_t)_sections.size();
+    header.reserved = 0;
+    header.sourceKey = sourceKey;
+    header.totalSize = buffer.size();
+    header.checksum = hash(buffer.data() + tableOffset, buffer.size() - tableOffset);
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    // 3. 写临时文件后重命名
+    std::string tmpPath = fullPath + ".tmp";
+    Data data;
+    data.fastSet(buffer.data(), (ssize_t)buffer.size());
+    bool ok = FileUtils::getInstance()->writeDataToFile(data, tmpPath);
+    data.fastSet(nullptr, 0); // 内存归 buffer 所有，避免 Data 析构时释放
+
+    if (!ok) {
+        CCLOG("CollisionCache: failed to write %s", tmpPath.c_str());
+        return false;
+    }
+    FileUtils::getInstance()->removeFile(fullPath);
+    if (!FileUtils::getInstance()->renameFile(tmpPath, fullPath)) {
+        CCLOG("CollisionCache: failed to rename %s", tmpPath.c_str());
+        FileUtils::getInstance()->removeFile(tmpPath);
+        return false;
+    }
+    return true;
+}
+
+bool Reader::open(const std::string& fullPath, uint64_t expectedKey) {
+    close();
+    if (!_file.open(fullPath)) return false;
+
+    const char* base = _file.data();
+    size_t fileSize = _file.size();
+
+    // 1. 头部校验（顺序从廉价到昂贵，校验和放在最后）
+    if (fileSize < sizeof(FileHeader)) {
+        close();
+        return false;
+    }
+    FileHeader header;
+    memcpy(&header, base, sizeof(header));
+
+    if (header.magic != kMagic || header.endianTag != kEndianTag) {
+        CCLOG("CollisionCache: %s is not a valid cache file", fullPath.c_str());
+        close();
+        return false;
+    }
+    if (header.version != kFormatVersion || header.sourceKey != expectedKey) {
+        CCLOG("CollisionCache: %s is stale, rebuilding", fullPath.c_str());
+        close();
+        return false;
+    }
+    size_t tableOffset = sizeof(FileHeader);
+    size_t tableEnd = tableOffset + sizeof(SectionEntry) * (size_t)header.sectionCount;
+    if (header.totalSize != fileSize || tableEnd > fileSize) {
+        CCLOG("CollisionCache: %s is truncated", fullPath.c_str());
+        close();
+        return false;
+    }
+    if (hash(base + tableOffset, fileSize - tableOffset) != header.checksum) {
+        CCLOG("CollisionCache: %s checksum mismatch", fullPath.c_str());
+        close();
+        return false;
+    }
+
+    // 2. 段表
+    _sections.reserve(header.sectionCount);
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        SectionEntry entry;
+        memcpy(&entry, base + tableOffset + sizeof(SectionEntry) * i, sizeof(entry));
+        if (entry.offset > fileSize || entry.size > fileSize - entry.offset) {
+            close();
+            return false;
+        }
+        _sections.push_back({entry.tag, base + entry.offset, (size_t)entry.size});
+    }
+    return true;
+}
+
+const void* Reader::getSection(uint32_t tag, size_t& outSize) const {
+    for (const auto& s : _sections) {
+        if (s.tag == tag) {
+            outSize = s.size;
+            return s.data;
+        }
+    }
+    outSize = 0;
+    return nullptr;
+}
+
+void Reader::close() {
+    _sections.clear();
+    _file.close();
+}
+
+} // namespace CollisionCache
@@ -0,0 +1,111 @@
+#ifndef __COLLISION_CACHE_H__
+#define __COLLISION_CACHE_H__
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class CollisionCache
+ * @brief 分段式二进制碰撞缓存文件（版本号 + 来源键 + 校验和 + 段表）
+ *
+ * 文件布局：
+ *   FileHeader | SectionEntry[sectionCount] | 段数据（每段 16 字节对齐）
+ *
+ * 段由四字符标签标识（如 'TRIS'、'BVHN'），读取方按标签取出所需的段，
+ * 不认识的段直接忽略，因此后续可以追加新的段（高度场、导航数据等）而不破坏旧读取逻辑。
+ * 数据按本机字节序写入，头部记录字节序标记，不匹配时视为缓存失效。
+ */
+namespace CollisionCache {
+
+/// 缓存格式版本，修改任何段的内存布局或三角形生成规则时都必须递增
+/// v2：多边形面按扇形拆分，不再只取前三个顶点
+/// v3：新增高度场段（HFHD/HFCT/HFHT/HFFL）
+/// v4：三角形改为量化索引网格（QHDR/QPOS/QIDX 取代 TRIS）
+/// v5：高度场单元格标记增加 kCellSteep
+const uint16_t kFormatVersion = 5;
+
+/**
+ * @brief 由四个字符组成段标签
+ */
+inline uint32_t makeTag(char a, char b, char c, char d) {
+    return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+}
+
+/**
+ * @brief 64 位 FNV-1a 哈希，可通过 seed 串联多段数据
+ */
+uint64_t hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ULL);
+
+/**
+ * @brief 源文件的内容摘要：文件大小与头尾各 64KB 的内容（无法映射时只用文件大小），可通过 seed 串联
+ * 碰撞缓存与离线烘焙文件都用它判断源 .obj 是否变化
+ */
+uint64_t hashFile(const std::string& fullPath, uint64_t seed = 14695981039346656037ULL);
+
+/**
+ * @class Writer
+ * @brief 收集若干段数据并一次性写出缓存文件
+ *
+ * addSection 只记录指针，数据必须在 write 调用结束前保持有效。
+ */
+class Writer {
+public:
+    void addSection(uint32_t tag, const void* data, size_t size);
+
+    /**
+     * @brief 写出缓存文件（先写临时文件再重命名，避免中途退出留下半个文件）
+     * @param fullPath 目标文件完整路径
+     * @param sourceKey 来源键，读取时必须与之匹配
+     * @return bool 是否写入成功
+     */
+    bool write(const std::string& fullPath, uint64_t sourceKey) const;
+
+private:
+    struct Pending {
+        uint32_t tag;
+        const void* data;
+        size_t size;
+    };
+    std::vector<Pending> _sections;
+};
+
+/**
+ * @class Reader
+ * @brief 以内存映射方式打开缓存文件并校验，段数据直接指向映射内存
+ */
+class Reader {
+public:
+    /**
+     * @brief 映射并校验缓存文件
+     * @param fullPath 缓存文件完整路径
+     * @param expectedKey 期望的来源键，不匹配则视为过期
+     * @return bool 文件存在且魔数、版本、字节序、来源键、长度与校验和全部通过
+     */
+    bool open(const std::string& fullPath, uint64_t expectedKey);
+
+    /**
+     * @brief 按标签查找段
+     * @param tag 段标签
+     * @param outSize 输出：段字节数
+     * @return const void* 段数据指针（指向映射内存，Reader 关闭后失效），不存在时返回 nullptr
+     */
+    const void* getSection(uint32_t tag, size_t& outSize) const;
+
+    void close();
+
+private:
+    struct SectionView {
+        uint32_t tag;
+        const char* data;
+        size_t size;
+    };
+
+    MappedFile _file;
+    std::vector<SectionView> _sections;
+};
+
+} // namespace CollisionCache
+
+#endif // __COLLISION_CACHE_H__
@@ -1,7 +1,21 @@
 #include "CombatComponent.h"
 #include "HealthComponent.h"
-#include "../player/Character.h"
-#include "../enemy/Enemy.h"
+
+namespace {
+
+const float kMeleeReach = 30.0f; ///< 近战判定在 XZ 轴上向外膨胀的距离
+
+/// 攻击者 AABB 在 XZ 轴上膨胀 kMeleeReach 后的攻击范围
+AABB meleeAttackBox(const AABB& attackerAABB) {
+    AABB attackAABB = attackerAABB;
+    attackAABB._min.x -= kMeleeReach;
+    attackAABB._max.x += kMeleeReach;
+    attackAABB._min.z -= kMeleeReach;
+    attackAABB._max.z += kMeleeReach;
+    return attackAABB;
+}
+
+} // namespace
 
 /**
  * @brief CombatComponent构造函数
@@ -129,26 +143,35 @@ float CombatComponent::getCritDamage() const {
 }
 
 /**
- * @brief 执行攻击动作
- * @details 实现实体的攻击逻辑
- * @param target 攻击目标节点
+ * @brief 执行攻击动作（登记表句柄）
+ * @details 设置了自定义攻击回调时交给回调，否则对目标的生命与战斗组件结算伤害，组件直接从登记表取得
+ * @param registry 战斗参与者登记表
+ * @param target 目标句柄
  * @return bool 攻击是否成功执行
  */
-bool CombatComponent::attack(Node* target) {
-    if (!target) {
-        return false;  // 目标不存在，攻击失败
+bool CombatComponent::attack(const CombatantRegistry& registry, CombatantRegistry::Handle target) {
+    if (!registry.isValid(target)) {
+        return false;  // 目标已注销
     }
 
-    // 检查是否设置了自定义攻击回调
     if (_attackCallback) {
-        return _attackCallback(target);  // 调用自定义攻击逻辑
+        return _attackCallback(registry.getOwner(target));
     }
 
-    // 默认攻击逻辑
-    // 1. 获取目标的健康组件
-    HealthComponent* targetHealth = dynamic_cast<HealthComponent*>(target->getComponent("HealthComponent"));
-    if (!targetHealth || targetHealth->isDead()) {
-        return false;  // 目标没有健康组件或已死亡
+    return dealDamage(registry.getHealth(target), registry.getCombat(target));
+}
+
+/**
+ * @brief 伤害结算
+ * @param targetHealth 目标的健康组件
+ * @param targetCombat 目标的战斗组件
+ * @return bool 伤害是否被目标接受（目标无敌或已死亡时为 false）
+ * 目标使用伤害队列时返回 true 只表示已排队，死亡与无敌在 DamageQueue::flush 时再检查
+ */
+bool CombatComponent::dealDamage(HealthComponent* targetHealth, CombatComponent* targetCombat) {
+    // 1. 检查目标的健康组件
+    if (!targetHealth || targetHealth->isDead() || targetHealth->isInvincible()) {
+        return false;  // 目标没有健康组件、已死亡或无敌
     }
 
     // 2. 计算总伤害
@@ -162,7 +185,6 @@ bool CombatComponent::attack(Node* target) {
 
     // 4. 获取目标的防御值（从目标的CombatComponent获取）
     float targetDefense = 0.0f;
-    CombatComponent* targetCombat = dynamic_cast<CombatComponent*>(target->getComponent("CombatComponent"));
     if (targetCombat) {
         targetDefense = targetCombat->getDefense();
     }
@@ -170,74 +192,81 @@ bool CombatComponent::attack(Node* target) {
     // 5. 计算防御减免后的最终伤害
     float finalDamage = calculateDamage(totalDamage, targetDefense);
 
-    // 6. 对目标造成伤害
-    targetHealth->takeDamage(finalDamage, this->getOwner());
-
-    return true;  // 攻击成功
+    // 6. 对目标造成伤害（使用伤害队列时只是排队）
+    return targetHealth->takeDamage(finalDamage, this->getOwner());
 }
 
 /**
- * @brief 执行近战范围攻击
+ * @brief 执行近战范围攻击（登记表句柄）
+ * @details 目标的存活状态与世界包围盒都从登记表的连续数组中读取
  * @param attackerCollider 攻击者的碰撞器
- * @param potentialTargets 潜在的目标列表
+ * @param registry 战斗参与者登记表
+ * @param targets 潜在目标的句柄
+ * @param count 句柄数量
  * @return int 命中的目标数量
  */
-int CombatComponent::executeMeleeAttack(const CharacterCollider& attackerCollider, const std::vector<Node*>& potentialTargets) {
+int CombatComponent::executeMeleeAttack(const CharacterCollider& attackerCollider, const CombatantRegistry& registry,
+                                        const CombatantRegistry::Handle* targets, int count) {
     int hitCount = 0;
-    const AABB& attackerAABB = attackerCollider.worldAABB;
+    const AABB attackAABB = meleeAttackBox(attackerCollider.worldAABB);
 
-    for (Node* target : potentialTargets) {
-        if (!target || target == this->getOwner()) continue;
+    for (int i = 0; i < count; ++i) {
+        const CombatantRegistry::Handle target = targets[i];
+        if (!registry.isValid(target) || registry.getOwner(target) == this->getOwner()) continue;
 
-        // 1. 检查目标是否具有健康组件且存活
-        HealthComponent* health = dynamic_cast<HealthComponent*>(target->getComponent("HealthComponent"));
-        if (!health || health->isDead()) {
-            CCLOG("MeleeAttack: Target has no HealthComponent or is dead");
-            continue;
-        }
+        HealthComponent* health = registry.getHealth(target);
+        if (!health || health->isDead()) continue;
 
-        // 2. 获取目标的 AABB 碰撞体
-        AABB targetAABB;
-        bool hasCollider = false;
-
-        auto character = dynamic_cast<Character*>(target);
-        if (character) {
-            targetAABB = character->getCollider().worldAABB;
-            hasCollider = true;
-        } else {
-            auto enemy = dynamic_cast<Enemy*>(target);
-            if (enemy) {
-                targetAABB = enemy->getCollider().worldAABB;
-                hasCollider = true;
+        if (attackAABB.intersects(registry.getBounds(target))) {
+            if (this->attack(registry, target)) {
+                hitCount++;
             }
         }
+    }
 
-        if (!hasCollider) {
-            CCLOG("MeleeAttack: Target has no collider");
-            continue;
-        }
+    return hitCount;
+}
 
-        // 3. 碰撞检测：增加一定的攻击范围（膨胀 AABB）
-        // 我们给攻击者 AABB 在 XZ 轴上各增加 30 像素的“触手”范围
-        AABB attackAABB = attackerAABB;
-        attackAABB._min.x -= 30.0f;
-        attackAABB._max.x += 30.0f;
-        attackAABB._min.z -= 30.0f;
-        attackAABB._max.z += 30.0f;
-
-        if (attackAABB.intersects(targetAABB)) {
-            CCLOG("MeleeAttack: Hit detected! Dealing damage.");
-            // 4. 执行攻击结算
-            if (this->attack(target)) {
+/**
+ * @brief 按攻击形状执行范围攻击
+ * @details 候选目标的存活状态与包围盒取自登记表，命中掩码由 AttackTargets 一次批量求出
+ * @param shape 攻击形状
+ * @param origin 攻击者脚底的世界坐标
+ * @param forward 攻击者的世界朝向
+ * @param actors 场景级角色空间哈希
+ * @param registry 战斗参与者登记表
+ * @param targetLayers 可被攻击的角色层
+ * @return int 命中的目标数量
+ */
+int CombatComponent::executeShapeAttack(const AttackShape& shape, const Vec3& origin, const Vec3& forward,
+                                        ActorSpatialHash& actors, const CombatantRegistry& registry, uint32_t targetLayers) {
+    AABB queryBox = shape.getBounds(origin, forward);
+    const Vec3 margin(ActorSpatialHash::kQueryMargin, ActorSpatialHash::kQueryMargin, ActorSpatialHash::kQueryMargin);
+    queryBox._min -= margin;
+    queryBox._max += margin;
+
+    _shapeCandidates.clear();
+    actors.queryCombatants(queryBox, targetLayers, _shapeCandidates, this->getOwner());
+
+    _shapeHandles.clear();
+    _shapeTargets.clear();
+    for (CombatantRegistry::Handle target : _shapeCandidates) {
+        if (!registry.isValid(target) || registry.getOwner(target) == this->getOwner()) continue;
+        HealthComponent* health = registry.getHealth(target);
+        if (!health || health->isDead()) continue;
+        _shapeHandles.push_back(target);
+        _shapeTargets.add(registry.getBounds(target));
+    }
+    if (_shapeHandles.empty()) return 0;
+
+    int hitCount = 0;
+    if (_shapeTargets.test(shape, origin, forward, _shapeMask) > 0) {
+        for (int i = 0; i < (int)_shapeHandles.size(); ++i) {
+            if (AttackTargets::isHit(_shapeMask, i) && this->attack(registry, _shapeHandles[i])) {
                 hitCount++;
             }
-        } else {
-            // 调试日志，帮助判断距离
-            float dist = this->getOwner()->getPosition3D().distance(target->getPosition3D());
-            CCLOG("MeleeAttack: No intersection. Distance: %.2f", dist);
         }
     }
-
     return hitCount;
 }
 
@@ -1,13 +1,18 @@
 #pragma once
 
 #include "cocos2d.h"
+#include "ActorSpatialHash.h"
+#include "AttackShape.h"
 #include "CharacterCollider.h"
+#include "CombatantRegistry.h"
 #include <vector>
 #include <functional>
 #include <unordered_map>
 
 USING_NS_CC;
 
+class HealthComponent;
+
 /**
  * @class CombatComponent
  * @brief 战斗组件，负责处理实体的攻击行为、战斗属性和技能管理
@@ -37,19 +42,36 @@ public:
     float getCritDamage() const;
 
     /**
-     * @brief 执行攻击结算（对单个目标造成伤害）
-     * @param target 目标节点
+     * @brief 执行攻击结算（目标由登记表句柄指定，直接取用其生命与战斗组件）
+     * @param registry 战斗参与者登记表
+     * @param target 目标句柄
      * @return bool 是否成功造成伤害
      */
-    bool attack(Node* target);
+    bool attack(const CombatantRegistry& registry, CombatantRegistry::Handle target);
 
     /**
-     * @brief 执行近战范围攻击
+     * @brief 执行近战范围攻击（目标由登记表句柄指定，包围盒取自登记表）
      * @param attackerCollider 攻击者的碰撞器（提供当前 AABB）
-     * @param potentialTargets 潜在的目标列表
+     * @param registry 战斗参与者登记表
+     * @param targets 潜在目标的句柄
+     * @param count 句柄数量
+     * @return int 命中的目标数量
+     */
+    int executeMeleeAttack(const CharacterCollider& attackerCollider, const CombatantRegistry& registry,
+                           const CombatantRegistry::Handle* targets, int count);
+
+    /**
+     * @brief 按攻击形状执行范围攻击：空间哈希筛出形状包围盒内的目标，再一次批量判定全部候选
+     * @param shape 攻击形状（技能数据）
+     * @param origin 攻击者脚底的世界坐标
+     * @param forward 攻击者的世界朝向
+     * @param actors 场景级角色空间哈希
+     * @param registry 战斗参与者登记表（提供目标当前的包围盒）
+     * @param targetLayers 可被攻击的角色层（ActorSpatialHash::Layer）
      * @return int 命中的目标数量
      */
-    int executeMeleeAttack(const CharacterCollider& attackerCollider, const std::vector<Node*>& potentialTargets);
+    int executeShapeAttack(const AttackShape& shape, const Vec3& origin, const Vec3& forward, ActorSpatialHash& actors,
+                           const CombatantRegistry& registry, uint32_t targetLayers);
 
     void setAttackCallback(const AttackCallback& callback);
     bool castSkill(const std::string& skillName, Node* target = nullptr);
@@ -58,6 +80,14 @@ public:
     void setWeaponDamage(float damage);
 
 protected:
+    /**
+     * @brief 计算伤害（含暴击与目标防御）并作用到目标
+     * @param targetHealth 目标的生命组件
+     * @param targetCombat 目标的战斗组件（可为空，视为没有防御）
+     * @return bool 伤害是否被目标接受（已结算或已排队；排队的伤害在结算时再检查死亡与无敌）
+     */
+    bool dealDamage(HealthComponent* targetHealth, CombatComponent* targetCombat);
+
     float _attackPower;
     float _defense;
     float _critRate;
@@ -65,6 +95,12 @@ protected:
     float _weaponDamage;
 
     AttackCallback _attackCallback;
+
+    // 形状攻击的候选目标（复用内存）
+    std::vector<CombatantRegistry::Handle> _shapeCandidates;
+    std::vector<CombatantRegistry::Handle> _shapeHandles;
+    AttackTargets _shapeTargets;
+    std::vector<uint32_t> _shapeMask;
 };
 
 
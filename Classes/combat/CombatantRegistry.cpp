@@ -0,0 +1,55 @@
+#include "CombatantRegistry.h"
+
+USING_NS_CC;
+
+const CombatantRegistry::Handle CombatantRegistry::kInvalidHandle;
+
+CombatantRegistry::Handle CombatantRegistry::add(Node* owner, HealthComponent* health, CombatComponent* combat,
+                                                 const AABB& bounds) {
+    if (!owner) return kInvalidHandle;
+
+    uint32_t slot;
+    if (!_freeSlots.empty()) {
+        slot = _freeSlots.back();
+        _freeSlots.pop_back();
+    } else {
+        if ((int)_handles.size() >= kMaxCombatants) {
+            CCLOG("CombatantRegistry: too many combatants (%d)", kMaxCombatants);
+            return kInvalidHandle;
+        }
+        slot = (uint32_t)_handles.size();
+        _handles.push_back(kInvalidHandle);
+        _owners.push_back(nullptr);
+        _health.push_back(nullptr);
+        _combat.push_back(nullptr);
+        _bounds.push_back(AABB());
+        _generations.push_back(1);
+    }
+
+    // 代数从 1 开始，句柄不等于 kInvalidHandle
+    const Handle handle = ((Handle)_generations[slot] << 16) | slot;
+
+    _handles[slot] = handle;
+    _owners[slot] = owner;
+    _health[slot] = health;
+    _combat[slot] = combat;
+    _bounds[slot] = bounds;
+    return handle;
+}
+
+void CombatantRegistry::remove(Handle handle) {
+    if (!isValid(handle)) return;
+    const uint32_t slot = handle & kSlotMask;
+    _handles[slot] = kInvalidHandle;
+    _owners[slot] = nullptr;
+    _health[slot] = nullptr;
+    _combat[slot] = nullptr;
+
+    // 代数用尽时槽位退役：再复用就会回绕到已经发出过的句柄
+    if (_generations[slot] == 0xffff) {
+        ++_retiredSlots;
+        return;
+    }
+    ++_generations[slot];
+    _freeSlots.push_back(slot);
+}
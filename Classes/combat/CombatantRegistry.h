@@ -0,0 +1,74 @@
+#ifndef __COMBATANT_REGISTRY_H__
+#define __COMBATANT_REGISTRY_H__
+
+#include "cocos2d.h"
+#include <cstdint>
+#include <vector>
+
+class HealthComponent;
+class CombatComponent;
+
+/**
+ * @class CombatantRegistry
+ * @brief 战斗参与者（玩家与敌人）登记表：整数句柄直接索引生命、战斗属性与世界包围盒
+ *
+ * 角色进入场景时登记，离开场景时注销；碰撞器更新后同步世界包围盒。
+ * 各项数据按槽位存放在连续数组中，近战判定与伤害结算按句柄取用，
+ * 不再按名称查找组件，也不需要 dynamic_cast 判断目标类型。
+ * 句柄低 16 位是槽位，高 16 位是该槽位的代数：注销时代数加一，槽位复用后旧句柄失效，
+ * 不会指向新的角色；代数用尽的槽位不再复用，旧句柄不会因为回绕重新生效。
+ */
+class CombatantRegistry {
+public:
+    typedef uint32_t Handle;
+
+    static const Handle kInvalidHandle = 0;
+    static const int kMaxCombatants = 0xffff; ///< 同时登记的角色上限
+
+    /**
+     * @brief 登记一个角色
+     * @param owner 角色节点（不持有引用，角色离开场景前必须注销）
+     * @return Handle 句柄，登记数已满时返回 kInvalidHandle
+     */
+    Handle add(cocos2d::Node* owner, HealthComponent* health, CombatComponent* combat, const cocos2d::AABB& bounds);
+
+    /**
+     * @brief 注销角色，句柄随即失效
+     */
+    void remove(Handle handle);
+
+    bool isValid(Handle handle) const {
+        const uint32_t slot = handle & kSlotMask;
+        return handle != kInvalidHandle && slot < _handles.size() && _handles[slot] == handle;
+    }
+
+    /**
+     * @brief 同步世界包围盒（碰撞器更新后调用）
+     */
+    void setBounds(Handle handle, const cocos2d::AABB& bounds) {
+        if (isValid(handle)) _bounds[handle & kSlotMask] = bounds;
+    }
+
+    // 以下访问要求句柄有效
+    cocos2d::Node* getOwner(Handle handle) const { return _owners[handle & kSlotMask]; }
+    HealthComponent* getHealth(Handle handle) const { return _health[handle & kSlotMask]; }
+    CombatComponent* getCombat(Handle handle) const { return _combat[handle & kSlotMask]; }
+    const cocos2d::AABB& getBounds(Handle handle) const { return _bounds[handle & kSlotMask]; }
+
+    int getCount() const { return (int)(_handles.size() - _freeSlots.size()) - _retiredSlots; }
+
+private:
+    static const uint32_t kSlotMask = 0xffff;
+
+    // 按槽位存放，_handles[slot] 为 kInvalidHandle 表示空槽
+    std::vector<Handle> _handles;
+    std::vector<cocos2d::Node*> _owners;
+    std::vector<HealthComponent*> _health;
+    std::vector<CombatComponent*> _combat;
+    std::vector<cocos2d::AABB> _bounds;
+    std::vector<uint16_t> _generations; ///< 槽位的代数，从 1 开始，注销时加一
+    std::vector<uint32_t> _freeSlots;
+    int _retiredSlots = 0; ///< 代数用尽、不再复用的槽位数
+};
+
+#endif // __COMBATANT_REGISTRY_H__
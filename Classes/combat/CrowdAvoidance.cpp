@@ -0,0 +1,243 @@
+#include "CrowdAvoidance.h"
+#include "ActorSpatialHash.h"
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+
+USING_NS_CC;
+
+constexpr float CrowdAvoidance::kNeighborDist;
+constexpr float CrowdAvoidance::kTimeHorizon;
+
+namespace {
+
+const float kEpsilon = 1e-5f;
+
+inline float det(const Vec2& a, const Vec2& b) { return a.x * b.y - a.y * b.x; }
+
+/**
+ * 在半径为 radius 的速度圆内，沿第 lineNo 条约束线求满足前面所有约束、离 optVelocity 最近的点
+ * directionOpt 为 true 时 optVelocity 是方向，求该方向上最远的点
+ */
+template <typename LineT>
+bool linearProgram1(const std::vector<LineT>& lines, size_t lineNo, float radius, const Vec2& optVelocity,
+                    bool directionOpt, Vec2& result) {
+    const LineT& line = lines[lineNo];
+    const float dotProduct = line.point.dot(line.direction);
+    const float discriminant = dotProduct * dotProduct + radius * radius - line.point.lengthSquared();
+    if (discriminant < 0.0f) return false; // 速度圆完全在约束线之外
+
+    const float sqrtDiscriminant = std::sqrt(discriminant);
+    float tLeft = -dotProduct - sqrtDiscriminant;
+    float tRight = -dotProduct + sqrtDiscriminant;
+
+    for (size_t i = 0; i < lineNo; ++i) {
+        const float denominator = det(line.direction, lines[i].direction);
+        const float numerator = det(lines[i].direction, line.point - lines[i].point);
+        if (std::fabs(denominator) <= kEpsilon) {
+            if (numerator < 0.0f) return false; // 平行且在外侧
+            continue;
+        }
+        const float t = numerator / denominator;
+        if (denominator >= 0.0f) {
+            tRight = std::min(tRight, t);
+        } else {
+            tLeft = std::max(tLeft, t);
+        }
+        if (tLeft > tRight) return false;
+    }
+
+    if (directionOpt) {
+        result = line.point + line.direction * (optVelocity.dot(line.direction) > 0.0f ? tRight : tLeft);
+    } else {
+        const float t = line.direction.dot(optVelocity - line.point);
+        result = line.point + line.direction * std::min(std::max(t, tLeft), tRight);
+    }
+    return true;
+}
+
+/**
+ * 逐条加入约束的增量二维线性规划
+ * @return size_t 第一条无法满足的约束下标，全部满足时返回约束数
+ */
+template <typename LineT>
+size_t linearProgram2(const std::vector<LineT>& lines, float radius, const Vec2& optVelocity, bool directionOpt,
+                      Vec2& result) {
+    if (directionOpt) {
+        result = optVelocity * radius;
+    } else if (optVelocity.lengthSquared() > radius * radius) {
+        result = optVelocity.getNormalized() * radius;
+    } else {
+        result = optVelocity;
+    }
+
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (det(lines[i].direction, lines[i].point - result) > 0.0f) {
+            const Vec2 tempResult = result;
+            if (!linearProgram1(lines, i, radius, optVelocity, directionOpt, result)) {
+                result = tempResult;
+                return i;
+            }
+        }
+    }
+    return lines.size();
+}
+
+} // namespace
+
+CrowdAvoidance::~CrowdAvoidance() {
+    for (auto& agent : _agents) {
+        agent.owner->release();
+    }
+}
+
+void CrowdAvoidance::submit(CrowdAgent* agent, Node* owner, const Vec3& pos, float radius, const Vec3& velocity,
+                            const Vec3& preferredVelocity, float maxSpeed) {
+    if (!owner) return;
+    owner->retain();
+    _agents.push_back({agent, owner, Vec2(pos.x, pos.z), Vec2(velocity.x, velocity.z),
+                       Vec2(preferredVelocity.x, preferredVelocity.z), pos.y, radius, maxSpeed});
+}
+
+void CrowdAvoidance::solve(float dt) {
+    _lastAgents = 0;
+    _lastChecks = 0;
+    if (_agents.empty()) return;
+
+    _solving.swap(_agents);
+    _agents.clear();
+    const int count = (int)_solving.size();
+    _lastAgents = count;
+
+    _byOwner.resize(count);
+    for (int i = 0; i < count; ++i) _byOwner[i] = std::make_pair((const Node*)_solving[i].owner, i);
+    std::sort(_byOwner.begin(), _byOwner.end());
+
+    _results.resize(count);
+    int neighbors[kMaxNeighbors];
+    for (int i = 0; i < count; ++i) {
+        if (!_solving[i].client) continue;
+        const int n = findNeighbors(i, neighbors);
+        _results[i] = computeVelocity(i, neighbors, n, dt);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (_solving[i].client) {
+            _solving[i].client->onCrowdVelocityResolved(Vec3(_results[i].x, 0.0f, _results[i].y));
+        }
+        _solving[i].owner->release();
+    }
+    _solving.clear();
+}
+
+/**
+ * 角色空间哈希中离代理最近的 kMaxNeighbors 个角色里本帧提交过的代理（按距离升序）
+ */
+int CrowdAvoidance::findNeighbors(int self, int* outNeighbors) {
+    if (!_actors) return 0;
+    const Agent& agent = _solving[self];
+    _nearby.clear();
+    _actors->queryNearest(Vec3(agent.pos.x, agent.height, agent.pos.y), kMaxNeighbors, kNeighborDist,
+                          ActorSpatialHash::kLayerEnemy, _nearby, agent.owner);
+    _lastChecks += (int)_nearby.size();
+
+    int found = 0;
+    for (Node* node : _nearby) {
+        auto it = std::lower_bound(_byOwner.begin(), _byOwner.end(), std::make_pair((const Node*)node, -1));
+        if (it == _byOwner.end() || it->first != node) continue;
+        outNeighbors[found++] = it->second;
+    }
+    return found;
+}
+
+Vec2 CrowdAvoidance::computeVelocity(int self, const int* neighbors, int count, float dt) {
+    const Agent& agent = _solving[self];
+    const float invTimeHorizon = 1.0f / kTimeHorizon;
+
+    // 1. 每个邻居一条 ORCA 约束
+    _lines.clear();
+    for (int k = 0; k < count; ++k) {
+        const Agent& other = _solving[neighbors[k]];
+        const Vec2 relativePosition = other.pos - agent.pos;
+        const Vec2 relativeVelocity = agent.velocity - other.velocity;
+        const float distSq = relativePosition.lengthSquared();
+        const float combinedRadius = agent.radius + other.radius;
+        const float combinedRadiusSq = combinedRadius * combinedRadius;
+
+        Line line;
+        Vec2 u;
+        if (distSq > combinedRadiusSq) {
+            // 尚未重叠：速度障碍是截断锥
+            const Vec2 w = relativeVelocity - relativePosition * invTimeHorizon;
+            const float wLengthSq = w.lengthSquared();
+            const float dotProduct = w.dot(relativePosition);
+
+            if (dotProduct < 0.0f && dotProduct * dotProduct > combinedRadiusSq * wLengthSq) {
+                // 投影到截断圆上
+                const float wLength = std::sqrt(wLengthSq);
+                const Vec2 unitW = w / wLength;
+                line.direction.set(unitW.y, -unitW.x);
+                u = unitW * (combinedRadius * invTimeHorizon - wLength);
+            } else {
+                // 投影到锥的两条腰上
+                const float leg = std::sqrt(distSq - combinedRadiusSq);
+                if (det(relativePosition, w) > 0.0f) {
+                    line.direction.set(relativePosition.x * leg - relativePosition.y * combinedRadius,
+                                       relativePosition.x * combinedRadius + relativePosition.y * leg);
+                } else {
+                    line.direction.set(-(relativePosition.x * leg + relativePosition.y * combinedRadius),
+                                       -(-relativePosition.x * combinedRadius + relativePosition.y * leg));
+                }
+                line.direction = line.direction / distSq;
+                u = line.direction * relativeVelocity.dot(line.direction) - relativeVelocity;
+            }
+        } else {
+            // 已经重叠：在一帧内推开
+            const float invTimeStep = 1.0f / std::max(dt, 1e-3f);
+            const Vec2 w = relativeVelocity - relativePosition * invTimeStep;
+            const float wLength = w.length();
+            const Vec2 unitW = wLength > kEpsilon ? w / wLength : Vec2(1.0f, 0.0f);
+            line.direction.set(unitW.y, -unitW.x);
+            u = unitW * (combinedRadius * invTimeStep - wLength);
+        }
+
+        // 对方不受避障控制时由自己承担全部避让
+        const float responsibility = other.client ? 0.5f : 1.0f;
+        line.point = agent.velocity + u * responsibility;
+        _lines.push_back(line);
+    }
+
+    // 2. 线性规划；约束互相矛盾时退而求最小化最大违反量
+    Vec2 result;
+    const size_t lineFail = linearProgram2(_lines, agent.maxSpeed, agent.preferred, false, result);
+    if (lineFail < _lines.size()) {
+        float distance = 0.0f;
+        for (size_t i = lineFail; i < _lines.size(); ++i) {
+            if (det(_lines[i].direction, _lines[i].point - result) <= distance) continue;
+
+            _projLines.clear();
+            for (size_t j = 0; j < i; ++j) {
+                Line line;
+                const float determinant = det(_lines[i].direction, _lines[j].direction);
+                if (std::fabs(determinant) <= kEpsilon) {
+                    if (_lines[i].direction.dot(_lines[j].direction) > 0.0f) continue; // 同向平行
+                    line.point = (_lines[i].point + _lines[j].point) * 0.5f;
+                } else {
+                    line.point = _lines[i].point +
+                                 _lines[i].direction *
+                                     (det(_lines[j].direction, _lines[i].point - _lines[j].point) / determinant);
+                }
+                line.direction = (_lines[j].direction - _lines[i].direction).getNormalized();
+                _projLines.push_back(line);
+            }
+
+            const Vec2 tempResult = result;
+            if (linearProgram2(_projLines, agent.maxSpeed, Vec2(-_lines[i].direction.y, _lines[i].direction.x),
+                               true, result) < _projLines.size()) {
+                result = tempResult; // 理论上不会发生，保险起见保留上一个结果
+            }
+            distance = det(_lines[i].direction, _lines[i].point - result);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,107 @@
+#ifndef __CROWD_AVOIDANCE_H__
+#define __CROWD_AVOIDANCE_H__
+
+#include "cocos2d.h"
+#include <utility>
+#include <vector>
+
+class ActorSpatialHash;
+
+/**
+ * @class CrowdAgent
+ * @brief 避障结果的接收方（敌人）
+ */
+class CrowdAgent {
+public:
+    virtual ~CrowdAgent() {}
+
+    /**
+     * @brief 避障求解完成回调
+     * @param velocity 避开其他敌人后的水平速度（y 为 0）
+     */
+    virtual void onCrowdVelocityResolved(const cocos2d::Vec3& velocity) = 0;
+};
+
+/**
+ * @class CrowdAvoidance
+ * @brief 敌人之间的 ORCA（Optimal Reciprocal Collision Avoidance）局部避障
+ *
+ * 敌人在自己的 update 中提交位置、当前速度与期望速度，场景在所有子节点更新之后调用 solve：
+ * 代理存放在连续数组中，邻居由场景的角色空间哈希（ActorSpatialHash::queryNearest）给出，
+ * 只有本帧提交过的代理参与约束（哈希中的玩家与未提交的角色跳过）；
+ * 每个代理对最近的若干邻居各构造一条 ORCA 半平面约束，用二维线性规划求出
+ * 离期望速度最近的可行速度，结果按提交顺序回调，下一帧移动时生效。
+ * 相向的两个代理各承担一半的避让；不受避障控制的代理（如按技能脚本移动的 Boss）
+ * 只作为障碍参与，其他代理承担全部避让。
+ */
+class CrowdAvoidance {
+public:
+    static constexpr float kNeighborDist = 200.0f; ///< 邻居搜索半径
+    static constexpr float kTimeHorizon = 1.0f;    ///< 预测碰撞的时间窗口（秒）
+    static const int kMaxNeighbors = 10;           ///< 每个代理参与约束的最近邻居数
+
+    ~CrowdAvoidance();
+
+    /**
+     * @brief 设置查找邻居用的角色空间哈希（不持有），solve 前应已按本帧位置重建
+     * 未设置时各代理直接使用期望速度
+     */
+    void setActorHash(ActorSpatialHash* actors) { _actors = actors; }
+
+    /**
+     * @brief 提交一个代理
+     * @param agent 结果接收方，为空时该代理只作为障碍
+     * @param owner 接收方对应的节点（在角色空间哈希中的节点），solve 前保持引用
+     * @param pos 脚底位置
+     * @param radius 半径
+     * @param velocity 当前速度（只取 XZ）
+     * @param preferredVelocity 期望速度（只取 XZ）
+     * @param maxSpeed 最大速度
+     */
+    void submit(CrowdAgent* agent, cocos2d::Node* owner, const cocos2d::Vec3& pos, float radius,
+                const cocos2d::Vec3& velocity, const cocos2d::Vec3& preferredVelocity, float maxSpeed);
+
+    /**
+     * @brief 为本帧提交的全部代理求解避障速度并回调
+     * @param dt 帧间隔，代理已经重叠时用于在一帧内推开
+     */
+    void solve(float dt);
+
+    int getPendingCount() const { return (int)_agents.size(); }
+
+    /// 统计：上一次求解的代理数与距离检测次数
+    int getLastAgentCount() const { return _lastAgents; }
+    int getLastNeighborChecks() const { return _lastChecks; }
+
+private:
+    struct Agent {
+        CrowdAgent* client;
+        cocos2d::Node* owner;
+        cocos2d::Vec2 pos, velocity, preferred; ///< XZ 平面
+        float height;                           ///< 脚底高度，查询邻居时使用
+        float radius, maxSpeed;
+    };
+
+    /// ORCA 半平面：允许的速度在 direction 的左侧
+    struct Line {
+        cocos2d::Vec2 point, direction;
+    };
+
+    std::vector<Agent> _agents;
+    std::vector<Agent> _solving; ///< solve 期间使用，回调中再次提交不会干扰当前批次
+
+    ActorSpatialHash* _actors = nullptr;
+    std::vector<std::pair<const cocos2d::Node*, int>> _byOwner; ///< 按节点排序，由哈希返回的节点找到代理
+    std::vector<cocos2d::Node*> _nearby;
+
+    std::vector<cocos2d::Vec2> _results;
+    std::vector<Line> _lines;
+    std::vector<Line> _projLines;
+    int _lastAgents = 0;
+    int _lastChecks = 0;
+
+    int findNeighbors(int self, int* outNeighbors);
+    cocos2d::Vec2 computeVelocity(int self, const int* neighbors, int count, float dt);
+};
+
+#endif // __CROWD_AVOIDANCE_H__
@@ -0,0 +1,49 @@
+#include "DamageQueue.h"
+#include "HealthComponent.h"
+
+USING_NS_CC;
+
+DamageQueue::~DamageQueue() {
+    for (auto& event : _events) {
+        release(event);
+    }
+}
+
+void DamageQueue::push(HealthComponent* target, float damage, Node* attacker) {
+    if (!target) return;
+
+    Node* owner = target->getOwner();
+    if (!owner) {
+        target->applyDamage(damage, attacker);
+        return;
+    }
+
+    target->retain();
+    owner->retain();
+    if (attacker) attacker->retain();
+    _events.push_back({target, owner, attacker, damage});
+}
+
+int DamageQueue::flush() {
+    if (_events.empty()) return 0;
+
+    _resolving.swap(_events);
+    _events.clear();
+
+    for (auto& event : _resolving) {
+        event.target->applyDamage(event.damage, event.attacker);
+    }
+
+    const int count = (int)_resolving.size();
+    for (auto& event : _resolving) {
+        release(event);
+    }
+    _resolving.clear();
+    return count;
+}
+
+void DamageQueue::release(const Event& event) {
+    event.target->release();
+    event.owner->release();
+    if (event.attacker) event.attacker->release();
+}
@@ -0,0 +1,52 @@
+#ifndef __DAMAGE_QUEUE_H__
+#define __DAMAGE_QUEUE_H__
+
+#include "cocos2d.h"
+#include <vector>
+
+class HealthComponent;
+
+/**
+ * @class DamageQueue
+ * @brief 一帧内的伤害事件队列，场景在所有子节点更新之后统一结算
+ *
+ * 设置了队列的 HealthComponent 在 takeDamage 时只记录一条事件，扣血与受伤 / 死亡回调
+ * 延后到 flush 中按提交顺序执行，状态切换不再发生在其它状态的 onUpdate 或近战判定的目标循环中途。
+ * 事件对目标组件、目标节点与攻击者保持引用，flush 前被移除的角色不会被释放。
+ */
+class DamageQueue {
+public:
+    /**
+     * @brief 一条伤害事件
+     */
+    struct Event {
+        HealthComponent* target;  ///< 受伤者的健康组件
+        cocos2d::Node* owner;     ///< 健康组件所属的节点（回调绑定的对象）
+        cocos2d::Node* attacker;  ///< 攻击者，可为空
+        float damage;             ///< 未经处理的伤害值，结算时由 HealthComponent::applyDamage 处理
+    };
+
+    ~DamageQueue();
+
+    /**
+     * @brief 记录一次伤害，目标组件没有所属节点时立即结算
+     */
+    void push(HealthComponent* target, float damage, cocos2d::Node* attacker);
+
+    /**
+     * @brief 按提交顺序结算本帧的全部伤害
+     * 回调中再次产生的伤害（例如反伤）留到下一次 flush
+     * @return int 结算的事件数
+     */
+    int flush();
+
+    int getPendingCount() const { return (int)_events.size(); }
+
+private:
+    std::vector<Event> _events;
+    std::vector<Event> _resolving;  ///< flush 期间使用，回调中再次提交不会干扰当前批次
+
+    static void release(const Event& event);
+};
+
+#endif // __DAMAGE_QUEUE_H__
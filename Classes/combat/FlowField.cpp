@@ -0,0 +1,199 @@
+#include "FlowField.h"
+#include "Collider.h"
+#include <chrono>
+#include <cmath>
+#include <float.h>
+#include <functional>
+
+USING_NS_CC;
+
+constexpr float FlowField::kDefaultCellSize;
+
+namespace {
+
+// 八个方向按逆时针排列，相反方向为 (k + 4) % 8
+const int kDirX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+const int kDirZ[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+const float kDirCost[8] = {1.0f, 1.41421356f, 1.0f, 1.41421356f, 1.0f, 1.41421356f, 1.0f, 1.41421356f};
+
+const uint8_t kNoFlow = 0xFF; ///< 到不了目标
+const uint8_t kAtGoal = 0xFE; ///< 目标所在格子
+
+} // namespace
+
+bool FlowField::buildGrid(const NavMesh* mesh, TerrainQuery* terrain, float cellSize) {
+    _heights.clear();
+    _links.clear();
+    _flow.clear();
+    _goalCell = _pendingGoal = -1;
+    _building = false;
+    if (!mesh || mesh->getPolyCount() == 0 || cellSize <= 0.0f) return false;
+    auto startTime = std::chrono::steady_clock::now();
+
+    float minX = FLT_MAX, minZ = FLT_MAX, maxX = -FLT_MAX, maxZ = -FLT_MAX, maxY = -FLT_MAX;
+    for (int i = 0; i < mesh->getPolyCount(); ++i) {
+        for (const Vec3& v : mesh->getPoly(i).verts) {
+            minX = std::min(minX, v.x);
+            minZ = std::min(minZ, v.z);
+            maxX = std::max(maxX, v.x);
+            maxZ = std::max(maxZ, v.z);
+            maxY = std::max(maxY, v.y);
+        }
+    }
+    _minX = minX;
+    _minZ = minZ;
+    _cellSize = cellSize;
+    _cols = std::max(1, (int)std::ceil((maxX - minX) / cellSize));
+    _rows = std::max(1, (int)std::ceil((maxZ - minZ) / cellSize));
+    const int count = _cols * _rows;
+
+    // 1. 格子中心处最上层的多边形给出高度；没有多边形的格子不可行走
+    _heights.assign(count, 0.0f);
+    std::vector<int> cellPoly(count, -1);
+    const float probeY = maxY + 1000.0f;
+    for (int cell = 0; cell < count; ++cell) {
+        Vec3 center = cellCenter(cell);
+        center.y = probeY;
+        Vec3 ground;
+        cellPoly[cell] = mesh->findPoly(center, 0.0f, &ground);
+        if (cellPoly[cell] >= 0) _heights[cell] = ground.y;
+    }
+
+    // 2. 相邻格子的连通性：两个格子中心之间能沿导航网格直线走通
+    // 导航网格的连接与角色移动使用相同的坡度和台阶限制，陡坡与断崖都是边界边；
+    // 立在地面上的薄墙不切断导航网格，再用台阶高度处的线段（角色胶囊的底部）检查
+    const Vec3 stepUp(0.0f, TerrainQuery::kMaxStepHeight, 0.0f);
+    _links.assign(count, 0);
+    for (int z = 0; z < _rows; ++z) {
+        for (int x = 0; x < _cols; ++x) {
+            const int cell = z * _cols + x;
+            if (cellPoly[cell] < 0) continue;
+            const Vec3 from = cellCenter(cell);
+            uint8_t links = 0;
+            for (int k = 0; k < 8; k += 2) {
+                const int nx = x + kDirX[k], nz = z + kDirZ[k];
+                if (nx < 0 || nz < 0 || nx >= _cols || nz >= _rows) continue;
+                const int n = nz * _cols + nx;
+                if (cellPoly[n] < 0) continue;
+                const Vec3 to = cellCenter(n);
+                if (!mesh->walkStraight(cellPoly[cell], from, to, cellPoly[n])) continue;
+                if (terrain && terrain->segmentIntersects(from + stepUp, to + stepUp)) continue;
+                links |= (uint8_t)(1 << k);
+            }
+            _links[cell] = links;
+        }
+    }
+    // 斜向：两侧的正向格子都与两端相连
+    for (int z = 0; z < _rows; ++z) {
+        for (int x = 0; x < _cols; ++x) {
+            const int cell = z * _cols + x;
+            for (int k = 1; k < 8; k += 2) {
+                const int ka = k - 1, kb = (k + 1) % 8;
+                if (!(_links[cell] & (1 << ka)) || !(_links[cell] & (1 << kb))) continue;
+                const int a = (z + kDirZ[ka]) * _cols + (x + kDirX[ka]);
+                const int b = (z + kDirZ[kb]) * _cols + (x + kDirX[kb]);
+                // a 到斜对角格子的方向为 kb，b 到斜对角格子的方向为 ka
+                if ((_links[a] & (1 << kb)) && (_links[b] & (1 << ka))) _links[cell] |= (uint8_t)(1 << k);
+            }
+        }
+    }
+
+    _flow.assign(count, kNoFlow);
+    _pendingFlow.assign(count, kNoFlow);
+    _cost.assign(count, FLT_MAX);
+
+    auto endTime = std::chrono::steady_clock::now();
+    CCLOG("FlowField: %dx%d cells (%.0f units), built in %.2f ms", _cols, _rows, cellSize,
+          std::chrono::duration<double, std::milli>(endTime - startTime).count());
+    return true;
+}
+
+void FlowField::setGoal(const Vec3& pos) {
+    if (!hasGrid()) return;
+    const int cell = cellAt(pos);
+    if (cell < 0 || !_links[cell]) return;
+
+    if (cell == _goalCell) {
+        // 格子内移动只更新最后一段的指向；扩散途中回到原格子时放弃扩散
+        _goalPos = pos;
+        _building = false;
+        return;
+    }
+    if (_building && cell == _pendingGoal) {
+        _pendingGoalPos = pos;
+        return;
+    }
+
+    // 开始新的波前扩散（覆盖尚未完成的扩散）
+    std::fill(_cost.begin(), _cost.end(), FLT_MAX);
+    std::fill(_pendingFlow.begin(), _pendingFlow.end(), kNoFlow);
+    _open.clear();
+    _cost[cell] = 0.0f;
+    _pendingFlow[cell] = kAtGoal;
+    _open.push_back(std::make_pair(0.0f, cell));
+    _pendingGoal = cell;
+    _pendingGoalPos = pos;
+    _building = true;
+}
+
+void FlowField::update() {
+    _lastCells = 0;
+    if (!_building) return;
+
+    const std::greater<std::pair<float, int>> heapOrder;
+    while (!_open.empty() && _lastCells < _cellBudget) {
+        std::pop_heap(_open.begin(), _open.end(), heapOrder);
+        const std::pair<float, int> top = _open.back();
+        _open.pop_back();
+        const int cell = top.second;
+        if (top.first > _cost[cell]) continue;
+        ++_lastCells;
+
+        const int x = cell % _cols, z = cell / _cols;
+        const uint8_t links = _links[cell];
+        for (int k = 0; k < 8; ++k) {
+            if (!(links & (1 << k))) continue;
+            const int n = (z + kDirZ[k]) * _cols + (x + kDirX[k]);
+            const float cost = top.first + kDirCost[k];
+            if (cost >= _cost[n]) continue;
+            _cost[n] = cost;
+            _pendingFlow[n] = (uint8_t)((k + 4) % 8); // 从 n 走回 cell
+            _open.push_back(std::make_pair(cost, n));
+            std::push_heap(_open.begin(), _open.end(), heapOrder);
+        }
+    }
+
+    if (_open.empty()) {
+        // 扩散完成，切换到新的场
+        _flow.swap(_pendingFlow);
+        _goalCell = _pendingGoal;
+        _goalPos = _pendingGoalPos;
+        _building = false;
+        ++_builds;
+    }
+}
+
+bool FlowField::sample(const Vec3& pos, Vec3& outDir) const {
+    if (_goalCell < 0) return false;
+    const int cell = cellAt(pos);
+    if (cell < 0) return false;
+
+    const uint8_t flow = _flow[cell];
+    if (flow == kNoFlow) return false;
+    const Vec3 target = flow == kAtGoal ? _goalPos : cellCenter(cell + kDirZ[flow] * _cols + kDirX[flow]);
+    outDir.set(target.x - pos.x, 0.0f, target.z - pos.z);
+    return true;
+}
+
+int FlowField::cellAt(const Vec3& pos) const {
+    const int x = (int)std::floor((pos.x - _minX) / _cellSize);
+    const int z = (int)std::floor((pos.z - _minZ) / _cellSize);
+    if (x < 0 || z < 0 || x >= _cols || z >= _rows) return -1;
+    return z * _cols + x;
+}
+
+Vec3 FlowField::cellCenter(int cell) const {
+    const int x = cell % _cols, z = cell / _cols;
+    return Vec3(_minX + (x + 0.5f) * _cellSize, _heights.empty() ? 0.0f : _heights[cell],
+                _minZ + (z + 0.5f) * _cellSize);
+}
@@ -0,0 +1,93 @@
+#ifndef __FLOW_FIELD_H__
+#define __FLOW_FIELD_H__
+
+#include "cocos2d.h"
+#include "NavMesh.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+class TerrainQuery;
+
+/**
+ * @class FlowField
+ * @brief 共享的追击流场：导航网格上的 XZ 均匀网格，每个格子记录通往目标（玩家）的下一个格子
+ *
+ * 所有追击的敌人采样同一张场，每次采样 O(1)，代价与敌人数量无关。
+ * 只有目标跨过格子边界时才从目标格子重新做 Dijkstra 波前扩散；
+ * 扩散按每帧格子预算分摊到多帧，完成前敌人继续使用上一张场。
+ *
+ * 格子的可行走性与高度取自导航网格（格子中心处最上层的多边形），
+ * 两个相邻格子的中心之间能沿导航网格直线走通（NavMesh::walkStraight），
+ * 且台阶高度处的连线不穿过地形（立在地面上、没有切断导航网格的薄墙）时相连；
+ * 斜向相连还要求两侧的正向格子都相连，避免贴着障碍物拐角穿过。
+ */
+class FlowField {
+public:
+    static constexpr float kDefaultCellSize = 25.0f; ///< 默认格子边长
+    static const int kDefaultCellBudget = 16384;      ///< 每帧波前扩散的格子数预算
+
+    /**
+     * @brief 由导航网格生成网格（会丢弃当前的场）
+     * @param terrain 生成导航网格的地形，用于检查格子之间的薄墙；为空时只检查导航网格
+     * @return bool 导航网格为空时返回 false
+     */
+    bool buildGrid(const NavMesh* mesh, TerrainQuery* terrain, float cellSize = kDefaultCellSize);
+
+    bool hasGrid() const { return !_heights.empty(); }
+
+    void setCellBudget(int cellsPerFrame) { _cellBudget = std::max(1, cellsPerFrame); }
+
+    /**
+     * @brief 设置目标位置；目标所在的格子变化时开始新的波前扩散
+     * 目标落在不可行走（或与周围都不相连）的格子上时保留当前的场
+     */
+    void setGoal(const cocos2d::Vec3& pos);
+
+    /**
+     * @brief 在预算内推进波前，扩散完成后切换到新的场
+     */
+    void update();
+
+    /**
+     * @brief 采样 pos 处的移动方向（XZ 平面，未归一化）
+     * 指向下一个格子的中心；在目标格子内时直接指向目标
+     * @return bool pos 不在网格上、所在格子到不了目标或场尚未生成时返回 false
+     */
+    bool sample(const cocos2d::Vec3& pos, cocos2d::Vec3& outDir) const;
+
+    /// 统计：格子数、上一帧扩散的格子数、已完成的扩散次数
+    int getCols() const { return _cols; }
+    int getRows() const { return _rows; }
+    int getLastFrameCells() const { return _lastCells; }
+    int getBuildCount() const { return _builds; }
+
+private:
+    // 网格
+    float _minX = 0.0f, _minZ = 0.0f, _cellSize = 1.0f;
+    int _cols = 0, _rows = 0;
+    std::vector<float> _heights; ///< 格子中心的地面高度
+    std::vector<uint8_t> _links; ///< 第 k 位表示与第 k 个方向的相邻格子相连，0 表示不可行走或孤立
+
+    // 当前使用的场
+    std::vector<uint8_t> _flow; ///< 下一个格子的方向下标，0xFF 表示到不了目标，0xFE 表示目标所在格子
+    int _goalCell = -1;
+    cocos2d::Vec3 _goalPos = cocos2d::Vec3::ZERO;
+
+    // 正在扩散的场
+    std::vector<float> _cost;
+    std::vector<uint8_t> _pendingFlow;
+    std::vector<std::pair<float, int>> _open; ///< (代价, 格子) 最小堆，过期条目出堆时跳过
+    int _pendingGoal = -1;
+    cocos2d::Vec3 _pendingGoalPos = cocos2d::Vec3::ZERO;
+    bool _building = false;
+
+    int _cellBudget = kDefaultCellBudget;
+    int _lastCells = 0;
+    int _builds = 0;
+
+    int cellAt(const cocos2d::Vec3& pos) const;
+    cocos2d::Vec3 cellCenter(int cell) const;
+};
+
+#endif // __FLOW_FIELD_H__
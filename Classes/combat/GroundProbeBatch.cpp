@@ -0,0 +1,70 @@
+#include "GroundProbeBatch.h"
+
+USING_NS_CC;
+
+constexpr float GroundProbeBatch::kProbeHeight;
+
+GroundProbeBatch::~GroundProbeBatch() {
+    for (auto& req : _requests) {
+        req.owner->release();
+    }
+}
+
+void GroundProbeBatch::submit(GroundProbeClient* client, Ref* owner, const Vec3& footPos) {
+    if (!client || !owner) return;
+    owner->retain();
+    _requests.push_back({client, owner});
+    _rays.push_back(CustomRay(footPos + Vec3(0, kProbeHeight, 0), Vec3(0, -1, 0)));
+}
+
+void GroundProbeBatch::flush() {
+    if (_requests.empty()) return;
+
+    _resolving.swap(_requests);
+    _requests.clear();
+
+    const int count = (int)_resolving.size();
+    _hitDist.resize(count);
+    _hits.assign(count, TerrainQuery::RayHit());
+    if (_collider) {
+        // 有缓存的探测通常只需测试一个三角形，直接求解；其余的合并批量求解
+        _batchSlots.clear();
+        _batchRays.clear();
+        for (int i = 0; i < count; ++i) {
+            TerrainQuery::GroundCache* cache = _resolving[i].client->getGroundCache();
+            if (cache) {
+                _hitDist[i] = _collider->probeGround(_rays[i].origin, *cache, _hits[i]) ? _hits[i].distance
+                                                                                         : TerrainQuery::kNoHit;
+            } else {
+                _batchSlots.push_back(i);
+                _batchRays.push_back(_rays[i]);
+            }
+        }
+
+        if (!_batchSlots.empty()) {
+            _batchHitDist.resize(_batchSlots.size());
+            _batchHits.resize(_batchSlots.size());
+            _collider->rayIntersectsBatch(_batchRays.data(), (int)_batchRays.size(), _batchHitDist.data(),
+                                          _batchHits.data());
+            for (size_t k = 0; k < _batchSlots.size(); ++k) {
+                _hitDist[_batchSlots[k]] = _batchHitDist[k];
+                _hits[_batchSlots[k]] = _batchHits[k];
+            }
+        }
+    } else {
+        std::fill(_hitDist.begin(), _hitDist.end(), TerrainQuery::kNoHit);
+    }
+
+    // 回调中重新提交的请求追加在 _rays 末尾，留到下一批处理
+    for (int i = 0; i < count; ++i) {
+        float groundY = _rays[i].origin.y - _hitDist[i];
+        bool hit = _hitDist[i] != TerrainQuery::kNoHit;
+        _resolving[i].client->onGroundProbeResolved(hit, groundY, _hits[i].normal);
+    }
+    _rays.erase(_rays.begin(), _rays.begin() + count);
+
+    for (auto& req : _resolving) {
+        req.owner->release();
+    }
+    _resolving.clear();
+}
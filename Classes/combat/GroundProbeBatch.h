@@ -0,0 +1,80 @@
+#ifndef __GROUND_PROBE_BATCH_H__
+#define __GROUND_PROBE_BATCH_H__
+
+#include "cocos2d.h"
+#include "Collider.h"
+#include <vector>
+
+/**
+ * @class GroundProbeClient
+ * @brief 地面探测结果的接收方（角色、敌人）
+ */
+class GroundProbeClient {
+public:
+    virtual ~GroundProbeClient() {}
+
+    /**
+     * @brief 探测完成回调
+     * @param hit 是否检测到地面
+     * @param groundY 地面高度（hit 为 false 时无意义）
+     * @param groundNormal 地面三角形的单位法线（朝上），用于区分可走的坡面与墙壁
+     */
+    virtual void onGroundProbeResolved(bool hit, float groundY, const cocos2d::Vec3& groundNormal) = 0;
+
+    /**
+     * @brief 接收方持有的贴地缓存，返回非空时该探测改走 TerrainQuery::probeGround
+     */
+    virtual TerrainQuery::GroundCache* getGroundCache() { return nullptr; }
+};
+
+/**
+ * @class GroundProbeBatch
+ * @brief 收集一帧内所有角色的贴地射线，统一调用 TerrainQuery::rayIntersectsBatch 求解
+ *
+ * 角色在自己的 update 中 submit，场景在所有子节点更新之后调用 flush，
+ * 结果按提交顺序回调给各角色。提供了贴地缓存的角色逐个走缓存查询，其余的合并为一批。
+ */
+class GroundProbeBatch {
+public:
+    /// 探测射线起点相对脚底的高度
+    static constexpr float kProbeHeight = 500.0f;
+
+    ~GroundProbeBatch();
+
+    void setTerrainCollider(TerrainQuery* collider) { _collider = collider; }
+    TerrainQuery* getTerrainCollider() const { return _collider; }
+
+    /**
+     * @brief 提交一次从 footPos 上方竖直向下的地面探测
+     * @param client 结果接收方
+     * @param owner 接收方对应的节点，flush 前保持引用，防止本帧内被移除后释放
+     * @param footPos 待检测的脚底位置（世界坐标）
+     */
+    void submit(GroundProbeClient* client, cocos2d::Ref* owner, const cocos2d::Vec3& footPos);
+
+    /**
+     * @brief 一次性求解本帧提交的全部探测并回调
+     */
+    void flush();
+
+    int getPendingCount() const { return (int)_requests.size(); }
+
+private:
+    struct Request {
+        GroundProbeClient* client;
+        cocos2d::Ref* owner;
+    };
+
+    TerrainQuery* _collider = nullptr;
+    std::vector<Request> _requests;
+    std::vector<Request> _resolving;  ///< flush 期间使用，回调中再次提交不会干扰当前批次
+    std::vector<CustomRay> _rays;
+    std::vector<float> _hitDist;
+    std::vector<TerrainQuery::RayHit> _hits;
+    std::vector<int> _batchSlots;          ///< 没有缓存、需要批量求解的请求下标
+    std::vector<CustomRay> _batchRays;
+    std::vector<float> _batchHitDist;
+    std::vector<TerrainQuery::RayHit> _batchHits;
+};
+
+#endif // __GROUND_PROBE_BATCH_H__
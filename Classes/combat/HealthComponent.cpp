@@ -1,4 +1,5 @@
 #include "HealthComponent.h"
+#include "DamageQueue.h"
 #include <algorithm>
 
 /**
@@ -14,7 +15,8 @@ HealthComponent::HealthComponent() :
     _maxHealth(0.0f),            ///< 默认最大生命值为0
     _currentHealth(0.0f),        ///< 默认当前生命值为0
     _isInvincible(false),        ///< 默认不处于无敌状态
-    _isDead(false)               ///< 默认未死亡
+    _isDead(false),              ///< 默认未死亡
+    _damageQueue(nullptr)        ///< 默认立即结算伤害
 {
     setName("HealthComponent");  // 设置唯一组件名称
 }
@@ -74,7 +76,30 @@ bool HealthComponent::init(float maxHealth) {
 }
 
 /**
- * @brief 处理实体受伤逻辑
+ * @brief 处理实体受伤
+ *
+ * 设置了伤害队列时只记录事件，由场景在所有子节点更新之后统一结算，
+ * 受伤 / 死亡回调不会在攻击者的状态更新或目标循环中途触发。
+ * 无敌与死亡在提交时检查一次，结算时由 applyDamage 再检查一次。
+ *
+ * @param damage 伤害值
+ * @param attacker 攻击者节点（可选）
+ * @return bool 伤害是否被接受
+ */
+bool HealthComponent::takeDamage(float damage, Node* attacker) {
+    if (_isInvincible || _isDead) {
+        return false;
+    }
+    if (_damageQueue) {
+        _damageQueue->push(this, damage, attacker);
+        return true;
+    }
+    applyDamage(damage, attacker);
+    return true;
+}
+
+/**
+ * @brief 立即结算实体受伤
  *
  * 受伤处理流程：
  * 1. 检查实体是否无敌
@@ -89,16 +114,16 @@ bool HealthComponent::init(float maxHealth) {
  * @param damage 伤害值
  * @param attacker 攻击者节点（可选，用于追踪伤害来源）
  */
-void HealthComponent::takeDamage(float damage, Node* attacker) {
+void HealthComponent::applyDamage(float damage, Node* attacker) {
     // 1. 检查实体是否无敌
     if (_isInvincible) {
-        CCLOG("HealthComponent::takeDamage: Entity is invincible, damage ignored");
+        CCLOG("HealthComponent::applyDamage: Entity is invincible, damage ignored");
         return;
     }
 
     // 2. 检查实体是否已经死亡
     if (_isDead) {
-        CCLOG("HealthComponent::takeDamage: Entity is already dead, damage ignored");
+        CCLOG("HealthComponent::applyDamage: Entity is already dead, damage ignored");
         return;
     }
 
@@ -112,7 +137,7 @@ void HealthComponent::takeDamage(float damage, Node* attacker) {
     // 5. 确保当前生命值不会小于0
     _currentHealth = std::max(_currentHealth, 0.0f);
 
-    CCLOG("HealthComponent::takeDamage: Entity took %.2f damage, health: %.2f/%.2f",
+    CCLOG("HealthComponent::applyDamage: Entity took %.2f damage, health: %.2f/%.2f",
         actualDamage, _currentHealth, _maxHealth);
 
     // 6. 触发受伤回调
@@ -123,7 +148,7 @@ void HealthComponent::takeDamage(float damage, Node* attacker) {
     // 7. 检查是否死亡
     if (_currentHealth <= 0.0f && !_isDead) {
         _isDead = true;
-        CCLOG("HealthComponent::takeDamage: Entity died");
+        CCLOG("HealthComponent::applyDamage: Entity died");
 
         // 8. 如果死亡，触发死亡回调
         if (_onDeadCallback) {
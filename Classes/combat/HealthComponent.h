@@ -5,6 +5,8 @@
 
 USING_NS_CC;
 
+class DamageQueue;
+
 /**
  * @class HealthComponent
  * @brief 生命值组件，负责处理实体的生命值、受伤和死亡逻辑
@@ -43,10 +45,28 @@ public:
 
     /**
      * @brief 处理实体受伤
+     * 设置了伤害队列时只记录事件，扣血与回调延后到 DamageQueue::flush；否则立即结算
+     * 提交时已无敌或已死亡的伤害直接拒绝；排队的伤害在结算时还会再检查一次
+     * （同一帧先结算的伤害可能已经致死，或目标在结算前进入无敌），届时被忽略
      * @param damage 伤害值
      * @param attacker 攻击者（可选）
+     * @return bool 伤害是否被接受（已结算或已排队），不表示排队的伤害一定生效
+     */
+    bool takeDamage(float damage, Node* attacker = nullptr);
+
+    /**
+     * @brief 立即结算一次伤害并触发回调（由 takeDamage 或 DamageQueue::flush 调用）
+     * @param damage 伤害值
+     * @param attacker 攻击者（可选）
+     */
+    void applyDamage(float damage, Node* attacker = nullptr);
+
+    /**
+     * @brief 设置伤害队列
+     * @param queue 场景级伤害队列，为空时 takeDamage 立即结算
      */
-    void takeDamage(float damage, Node* attacker = nullptr);
+    void setDamageQueue(DamageQueue* queue) { _damageQueue = queue; }
+    DamageQueue* getDamageQueue() const { return _damageQueue; }
 
     /**
      * @brief 恢复生命值
@@ -135,6 +155,7 @@ protected:
     float _currentHealth; ///< 当前生命值
     bool _isInvincible; ///< 是否无敌
     bool _isDead; ///< 是否死亡
+    DamageQueue* _damageQueue; ///< 伤害队列（可为空）
 
     std::function<void(float, Node*)> _onHurtCallback; ///< 受伤回调
     std::function<void(Node*)> _onDeadCallback; ///< 死亡回调
@@ -0,0 +1,192 @@
+#include "InfluenceMap.h"
+#include "Collider.h"
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+
+USING_NS_CC;
+
+constexpr float InfluenceMap::kCellSize;
+constexpr float InfluenceMap::kDecay;
+constexpr float InfluenceMap::kSlotRadius;
+constexpr float InfluenceMap::kThreatRange;
+constexpr float InfluenceMap::kBlocked;
+
+namespace {
+
+const float kThreatWeight = 4.0f;       ///< 威胁在包围位分数中的权重
+const float kDistanceWeight = 0.01f;    ///< 领取包围位时每单位距离的代价
+const float kThreatCosHalfAngle = 0.5f; ///< 威胁扇形的半角余弦（60 度）
+
+inline int cellCoord(float v) { return (int)std::floor(v / InfluenceMap::kCellSize); }
+
+inline int wrap(int v) {
+    const int m = v % InfluenceMap::kGridSize;
+    return m < 0 ? m + InfluenceMap::kGridSize : m;
+}
+
+} // namespace
+
+InfluenceMap::InfluenceMap() : _cells(kGridSize * kGridSize) {
+    // 第一次 update 之前包围位还没有位置，全部视为阻挡
+    for (Slot& slot : _slots) slot.score = kBlocked;
+}
+
+int InfluenceMap::cellIndex(int cx, int cz) const {
+    if (!_hasWindow || cx < _originX || cz < _originZ || cx >= _originX + kGridSize || cz >= _originZ + kGridSize) {
+        return -1;
+    }
+    return wrap(cz) * kGridSize + wrap(cx);
+}
+
+const InfluenceMap::Cell* InfluenceMap::cellAt(const Vec3& pos) const {
+    const int i = cellIndex(cellCoord(pos.x), cellCoord(pos.z));
+    return i >= 0 ? &_cells[i] : nullptr;
+}
+
+void InfluenceMap::resetCell(int cx, int cz) {
+    Cell& cell = _cells[wrap(cz) * kGridSize + wrap(cx)];
+    cell.occupancy = 0.0f;
+    cell.threat = 0.0f;
+    cell.ground = 0.0f;
+    cell.walkable = !_mesh; // 没有导航网格时不计地形代价
+    if (!_mesh) return;
+
+    // 地面高度：格子中心处离玩家高度最近的一层（区分桥面与桥下）
+    const Vec3 center((cx + 0.5f) * kCellSize, _playerY, (cz + 0.5f) * kCellSize);
+    Vec3 ground;
+    if (_mesh->findPoly(center, 0.0f, &ground) < 0) return;
+    cell.ground = ground.y;
+    cell.walkable = true;
+}
+
+/**
+ * 地形代价：格子中心在导航网格上，且与玩家当前的高度差不超过一级台阶加上坡度爬升
+ */
+float InfluenceMap::terrainCost(const Cell& cell) const {
+    if (!cell.walkable) return kBlocked;
+    if (!_mesh) return 0.0f;
+    const float rise = std::fabs(cell.ground - _playerY);
+    const float reach = TerrainQuery::kMaxStepHeight + kSlotRadius;
+    return rise > reach ? kBlocked : rise / reach;
+}
+
+/**
+ * 只重置新窗口中不在旧窗口里的格子（玩家每次跨格通常只有一行或一列）
+ */
+void InfluenceMap::moveWindow(int originX, int originZ) {
+    const bool hadWindow = _hasWindow;
+    const int oldX = _originX, oldZ = _originZ;
+    _originX = originX;
+    _originZ = originZ;
+    _hasWindow = true;
+    for (int cz = originZ; cz < originZ + kGridSize; ++cz) {
+        for (int cx = originX; cx < originX + kGridSize; ++cx) {
+            const bool kept = hadWindow && cx >= oldX && cz >= oldZ && cx < oldX + kGridSize && cz < oldZ + kGridSize;
+            if (!kept) resetCell(cx, cz);
+        }
+    }
+}
+
+void InfluenceMap::stampOccupancy(const Vec3& pos, float radius) {
+    const int x0 = cellCoord(pos.x - radius), x1 = cellCoord(pos.x + radius);
+    const int z0 = cellCoord(pos.z - radius), z1 = cellCoord(pos.z + radius);
+    for (int cz = z0; cz <= z1; ++cz) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            const int i = cellIndex(cx, cz);
+            if (i >= 0) _cells[i].occupancy += 1.0f;
+        }
+    }
+}
+
+void InfluenceMap::update(const Vec3& playerPos, const Vec3& playerForward) {
+    // 1. 按本帧的印章给包围位打分
+    for (Slot& slot : _slots) {
+        const Cell* cell = cellAt(slot.pos);
+        slot.score = cell ? cell->occupancy + cell->threat * kThreatWeight + terrainCost(*cell) : kBlocked;
+    }
+
+    // 2. 衰减
+    for (Cell& cell : _cells) {
+        cell.occupancy *= kDecay;
+        cell.threat *= kDecay;
+    }
+
+    // 3. 窗口跟随玩家
+    _playerY = playerPos.y;
+    const int originX = cellCoord(playerPos.x) - kGridSize / 2;
+    const int originZ = cellCoord(playerPos.z) - kGridSize / 2;
+    if (!_hasWindow || originX != _originX || originZ != _originZ) moveWindow(originX, originZ);
+
+    // 4. 玩家正前方的威胁扇形
+    Vec3 forward(playerForward.x, 0.0f, playerForward.z);
+    if (forward.lengthSquared() > 1e-6f) {
+        forward.normalize();
+        const int reach = (int)std::ceil(kThreatRange / kCellSize);
+        const int pcx = cellCoord(playerPos.x), pcz = cellCoord(playerPos.z);
+        for (int cz = pcz - reach; cz <= pcz + reach; ++cz) {
+            for (int cx = pcx - reach; cx <= pcx + reach; ++cx) {
+                const float dx = (cx + 0.5f) * kCellSize - playerPos.x;
+                const float dz = (cz + 0.5f) * kCellSize - playerPos.z;
+                const float dist = std::sqrt(dx * dx + dz * dz);
+                if (dist > kThreatRange || dist < 1e-3f) continue;
+                if ((dx * forward.x + dz * forward.z) / dist < kThreatCosHalfAngle) continue;
+                const int i = cellIndex(cx, cz);
+                if (i >= 0) _cells[i].threat += 1.0f - dist / kThreatRange;
+            }
+        }
+    }
+
+    // 5. 包围位跟随玩家（分数在下一帧按新的印章计算）
+    for (int k = 0; k < kSlotCount; ++k) {
+        const float angle = (float)k * 2.0f * (float)M_PI / (float)kSlotCount;
+        _slots[k].pos = Vec3(playerPos.x + std::cos(angle) * kSlotRadius, playerPos.y,
+                             playerPos.z + std::sin(angle) * kSlotRadius);
+    }
+    ++_tick;
+}
+
+int InfluenceMap::claimSlot(const void* who, const Vec3& from, int current) {
+    if (current >= 0 && current < kSlotCount && _slots[current].owner == who && _slots[current].score < kBlocked) {
+        _slots[current].claimTick = _tick;
+        return current;
+    }
+
+    int best = -1;
+    float bestCost = FLT_MAX;
+    for (int k = 0; k < kSlotCount; ++k) {
+        const Slot& slot = _slots[k];
+        const bool taken = slot.owner && slot.owner != who && slot.claimTick + 1 >= _tick;
+        if (taken || slot.score >= kBlocked) continue;
+        const float cost = slot.score + from.distance(slot.pos) * kDistanceWeight;
+        if (cost < bestCost) {
+            bestCost = cost;
+            best = k;
+        }
+    }
+    if (best >= 0) {
+        if (current >= 0 && current < kSlotCount && current != best) releaseSlot(who, current);
+        _slots[best].owner = who;
+        _slots[best].claimTick = _tick;
+    }
+    return best;
+}
+
+void InfluenceMap::releaseSlot(const void* who, int slot) {
+    if (slot >= 0 && slot < kSlotCount && _slots[slot].owner == who) _slots[slot].owner = nullptr;
+}
+
+float InfluenceMap::getOccupancy(const Vec3& pos) const {
+    const Cell* cell = cellAt(pos);
+    return cell ? cell->occupancy : 0.0f;
+}
+
+float InfluenceMap::getThreat(const Vec3& pos) const {
+    const Cell* cell = cellAt(pos);
+    return cell ? cell->threat : 0.0f;
+}
+
+float InfluenceMap::getTerrainCost(const Vec3& pos) const {
+    const Cell* cell = cellAt(pos);
+    return cell ? terrainCost(*cell) : 0.0f;
+}
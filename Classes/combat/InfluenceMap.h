@@ -0,0 +1,102 @@
+#ifndef __INFLUENCE_MAP_H__
+#define __INFLUENCE_MAP_H__
+
+#include "cocos2d.h"
+#include "NavMesh.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class InfluenceMap
+ * @brief 以玩家为中心的战术影响图，为追击的敌人分配包围位
+ *
+ * 固定大小的网格窗口跟随玩家，按世界格子坐标取模环形寻址，玩家跨过格子时
+ * 只重置新进入窗口的格子。每个格子有三层：
+ * - 占用：敌人每帧在自己的位置盖章，每帧整体衰减，读到的是近期的聚集程度；
+ * - 威胁：玩家每帧在正前方的扇形内盖章，同样衰减；
+ * - 地形：格子进入窗口时从导航网格取地面高度，打分时与玩家当前的高度比较
+ *   （不可行走或高度差过大时为阻挡），玩家在窗口内爬坡时地形代价随之更新。
+ * 包围位是玩家周围一圈固定的点，每帧按所在格子的三层求一次分数；
+ * 敌人领取包围位时只比较 kSlotCount 个候选，代价与敌人数量无关。
+ */
+class InfluenceMap {
+public:
+    static constexpr float kCellSize = 20.0f;    ///< 格子边长
+    static const int kGridSize = 32;             ///< 窗口边长（格子数）
+    static constexpr float kDecay = 0.8f;        ///< 占用与威胁每帧的衰减系数
+    static const int kSlotCount = 8;             ///< 包围位数量
+    static constexpr float kSlotRadius = 60.0f;  ///< 包围位到玩家的距离（小于敌人的攻击距离）
+    static constexpr float kThreatRange = 120.0f; ///< 玩家正前方威胁扇形的半径
+    static constexpr float kBlocked = 1000.0f;   ///< 阻挡格子的地形代价
+
+    InfluenceMap();
+
+    void setNavMesh(const NavMesh* mesh) { _mesh = mesh; }
+
+    /**
+     * @brief 在敌人位置盖占用章（敌人每帧调用）
+     */
+    void stampOccupancy(const cocos2d::Vec3& pos, float radius);
+
+    /**
+     * @brief 每帧在所有敌人更新之后调用一次：
+     * 按本帧的印章给包围位打分，然后衰减、跟随玩家移动窗口并盖威胁章
+     * @param playerPos 玩家位置（与敌人同一坐标系）
+     * @param playerForward 玩家朝向（XZ 平面）
+     */
+    void update(const cocos2d::Vec3& playerPos, const cocos2d::Vec3& playerForward);
+
+    /**
+     * @brief 领取包围位：已持有且未被阻挡时续期，否则在未被他人持有的包围位中取
+     * 分数加上距离代价最低的一个
+     * @param who 领取者
+     * @param from 领取者位置
+     * @param current 领取者当前持有的包围位，没有时为 -1
+     * @return int 包围位下标，全部被占用或阻挡时返回 -1
+     */
+    int claimSlot(const void* who, const cocos2d::Vec3& from, int current);
+
+    /**
+     * @brief 归还包围位（不归还时在领取者停止续期后的下一帧自动释放）
+     */
+    void releaseSlot(const void* who, int slot);
+
+    const cocos2d::Vec3& getSlotPosition(int slot) const { return _slots[slot].pos; }
+    float getSlotScore(int slot) const { return _slots[slot].score; }
+
+    /// 调试：pos 所在格子的各层数值（不在窗口内时返回 0）
+    float getOccupancy(const cocos2d::Vec3& pos) const;
+    float getThreat(const cocos2d::Vec3& pos) const;
+    float getTerrainCost(const cocos2d::Vec3& pos) const;
+
+private:
+    struct Cell {
+        float occupancy = 0.0f;
+        float threat = 0.0f;
+        float ground = 0.0f;   ///< 格子中心的地面高度
+        bool walkable = false; ///< 格子中心在导航网格上
+    };
+
+    struct Slot {
+        cocos2d::Vec3 pos;
+        float score = 0.0f;
+        const void* owner = nullptr;
+        unsigned claimTick = 0;
+    };
+
+    const NavMesh* _mesh = nullptr;
+    std::vector<Cell> _cells; ///< 下标为 (世界格子坐标 mod kGridSize)
+    int _originX = 0, _originZ = 0; ///< 窗口左下角的世界格子坐标
+    bool _hasWindow = false;
+    float _playerY = 0.0f;
+    Slot _slots[kSlotCount];
+    unsigned _tick = 1;
+
+    int cellIndex(int cx, int cz) const;
+    const Cell* cellAt(const cocos2d::Vec3& pos) const;
+    void resetCell(int cx, int cz);
+    float terrainCost(const Cell& cell) const;
+    void moveWindow(int originX, int originZ);
+};
+
+#endif // __INFLUENCE_MAP_H__
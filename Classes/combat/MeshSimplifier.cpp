@@ -0,0 +1,486 @@
+#include "MeshSimplifier.h"
+#include "CapsuleSweep.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <float.h>
+#include <queue>
+
+USING_NS_CC;
+
+namespace {
+
+const int kMaxPasses = 8;           ///< 一轮内被拒绝的折叠在邻域变化后可能变为合法，最多重试的轮数
+const float kVerticalNormalY = 0.05f; ///< 法线 |y| 低于该比例的三角形视为竖直，不参与高度差计算
+const int kMaxValence = 12;           ///< 折叠后顶点的最大邻点数，避免平坦区域全部并入同一个顶点形成扇形
+const double kLengthWeight = 1e-6;    ///< 边长平方的权重：QEM 代价相同（如平坦区域）时优先折叠短边，使简化均匀推进
+
+/**
+ * 对称 4x4 二次型，只存上三角的 10 个系数
+ */
+struct Quadric {
+    double a[10] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+    void addPlane(double nx, double ny, double nz, double d, double w) {
+        a[0] += w * nx * nx; a[1] += w * nx * ny; a[2] += w * nx * nz; a[3] += w * nx * d;
+        a[4] += w * ny * ny; a[5] += w * ny * nz; a[6] += w * ny * d;
+        a[7] += w * nz * nz; a[8] += w * nz * d;
+        a[9] += w * d * d;
+    }
+
+    void add(const Quadric& o) {
+        for (int i = 0; i < 10; ++i) a[i] += o.a[i];
+    }
+
+    double evaluate(const Vec3& p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        return a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + 2.0 * a[3] * x +
+               a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y +
+               a[7] * z * z + 2.0 * a[8] * z + a[9];
+    }
+};
+
+/**
+ * 折叠候选：from 并入 to。顶点每次被并入后 stamp 递增，旧候选出堆时按 stamp 判定过期
+ */
+struct Candidate {
+    double cost;
+    int from, to;
+    unsigned fromStamp, toStamp;
+
+    bool operator<(const Candidate& o) const { return cost > o.cost; } // 代价小的先出堆
+};
+
+inline Vec3 faceNormal(const Vec3& a, const Vec3& b, const Vec3& c) {
+    Vec3 n;
+    Vec3::cross(b - a, c - a, &n);
+    return n;
+}
+
+/**
+ * 折叠后的候选三角形，预先算好 XZ 重心坐标所需的倒数，同一次评估中被所有原始边复用
+ */
+struct FanTriangle {
+    Vec3 a, b, c;
+    float invNy; ///< 1 / 法线 y 分量（未归一化），三角形接近竖直时为 0
+
+    FanTriangle(const Vec3& a_, const Vec3& b_, const Vec3& c_) : a(a_), b(b_), c(c_) {
+        const Vec3 n = faceNormal(a, b, c);
+        const float len = n.length();
+        invNy = (len == 0.0f || std::fabs(n.y) < kVerticalNormalY * len) ? 0.0f : 1.0f / n.y;
+    }
+
+    /**
+     * 原始边 pq 在 XZ 投影上与三角形重叠部分的最大竖直偏差，不重叠（或三角形接近竖直）返回 -1。
+     * 重心坐标与高度差沿边都是线性的，把边裁剪到三个重心坐标都非负的区间后只需在两端求值
+     */
+    float segmentDeviation(const Vec3& p, const Vec3& q) const {
+        if (invNy == 0.0f) return -1.0f;
+
+        // 留一点容差使共享边上的点至少落在一侧
+        const float eps = -1e-5f;
+        const float u0 = ((b.z - p.z) * (c.x - p.x) - (b.x - p.x) * (c.z - p.z)) * invNy;
+        const float v0 = ((c.z - p.z) * (a.x - p.x) - (c.x - p.x) * (a.z - p.z)) * invNy;
+        const float u1 = ((b.z - q.z) * (c.x - q.x) - (b.x - q.x) * (c.z - q.z)) * invNy;
+        const float v1 = ((c.z - q.z) * (a.x - q.x) - (c.x - q.x) * (a.z - q.z)) * invNy;
+        const float w0 = 1.0f - u0 - v0, w1 = 1.0f - u1 - v1;
+
+        float t0 = 0.0f, t1 = 1.0f;
+        auto clip = [eps, &t0, &t1](float s0, float s1) {
+            const float ds = s1 - s0;
+            if (ds == 0.0f) return s0 >= eps;
+            const float t = (eps - s0) / ds;
+            if (ds > 0.0f) {
+                t0 = std::max(t0, t);
+            } else {
+                t1 = std::min(t1, t);
+            }
+            return t0 <= t1;
+        };
+        if (!clip(u0, u1) || !clip(v0, v1) || !clip(w0, w1)) return -1.0f;
+
+        auto deviationAt = [&](float t) {
+            const float u = u0 + (u1 - u0) * t, v = v0 + (v1 - v0) * t, w = w0 + (w1 - w0) * t;
+            return std::fabs(p.y + (q.y - p.y) * t - (u * a.y + v * b.y + w * c.y));
+        };
+        return std::max(deviationAt(t0), deviationAt(t1));
+    }
+
+    /**
+     * 竖直面上无法比较高度时的偏差：边两端到三角形最近距离的较大值
+     */
+    float segmentDistance(const Vec3& p, const Vec3& q) const {
+        Vec3 onSegment, onTriangle;
+        const float dp = CapsuleSweep::closestPointsSegmentTriangle(p, p, a, b, c, onSegment, onTriangle);
+        const float dq = CapsuleSweep::closestPointsSegmentTriangle(q, q, a, b, c, onSegment, onTriangle);
+        return std::sqrt(std::max(dp, dq));
+    }
+
+    float deviation(const Vec3& p, const Vec3& q) const {
+        const float dev = segmentDeviation(p, q);
+        return dev >= 0.0f ? dev : segmentDistance(p, q);
+    }
+};
+
+class Simplifier {
+public:
+    Simplifier(const MeshSimplifier::Options& options) : _options(options) {}
+
+    bool load(const std::vector<Vec3>& vertices, const std::vector<int>& indices);
+    void run();
+    void store(std::vector<Vec3>& vertices, std::vector<int>& indices, MeshSimplifier::Stats& stats) const;
+
+private:
+    typedef std::array<int, 3> Face;
+
+    bool reachedTarget() const {
+        return _options.targetTriangles > 0 && _aliveFaces <= _options.targetTriangles;
+    }
+
+    static bool contains(const Face& f, int v) { return f[0] == v || f[1] == v || f[2] == v; }
+
+    void collectRing(int v, std::vector<int>& out) const;
+    void pushCandidate(int from, int to);
+    void pushAllCandidates();
+    bool tryCollapse(int from, int to);
+
+    MeshSimplifier::Options _options;
+    std::vector<Vec3> _pos;
+    std::vector<Face> _faces;
+    std::vector<bool> _faceAlive;
+    std::vector<std::vector<int>> _vertexFaces;
+    std::vector<Quadric> _quadrics;
+    std::vector<unsigned> _stamps;
+    std::vector<bool> _locked;
+    std::vector<bool> _dead;
+    int _aliveFaces = 0;
+
+    // 误差度量：每条原始边登记在 XZ 投影与之重叠的所有当前三角形上。
+    // 两张分片线性曲面的高度差在叠加剖分的顶点处取极值，这些点都位于原始边上，
+    // 因此沿原始边求得的最大偏差就是整片区域的最大偏差
+    std::vector<std::pair<Vec3, Vec3>> _edges;
+    std::vector<std::vector<int>> _faceEdges;
+    std::vector<unsigned> _edgeSeen; ///< 同一次评估内去重：一条边可能登记在多个受影响的三角形上
+    unsigned _evalStamp = 0;
+
+    std::priority_queue<Candidate> _heap;
+
+    // tryCollapse 复用的缓冲
+    std::vector<int> _ringFrom, _ringTo, _fan;
+    std::vector<FanTriangle> _fanTris;
+    std::vector<std::pair<int, int>> _assign; ///< (原始边, 三角形)
+};
+
+/**
+ * 焊接坐标完全相同的顶点（.obj 中常见的 UV 接缝重复顶点），建立面邻接、锁定边界并初始化二次型与原始边
+ */
+bool Simplifier::load(const std::vector<Vec3>& vertices, const std::vector<int>& indices) {
+    std::vector<int> order(vertices.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = (int)i;
+    auto less = [&vertices](int a, int b) {
+        const Vec3& p = vertices[a];
+        const Vec3& q = vertices[b];
+        if (p.x != q.x) return p.x < q.x;
+        if (p.y != q.y) return p.y < q.y;
+        return p.z < q.z;
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    std::vector<int> remap(vertices.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i == 0 || less(order[i - 1], order[i])) _pos.push_back(vertices[order[i]]);
+        remap[order[i]] = (int)_pos.size() - 1;
+    }
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        Face f = {remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]]};
+        if (f[0] == f[1] || f[1] == f[2] || f[0] == f[2]) continue;
+        _faces.push_back(f);
+    }
+    if (_faces.empty()) return false;
+
+    const int vertexCount = (int)_pos.size();
+    _aliveFaces = (int)_faces.size();
+    _faceAlive.assign(_faces.size(), true);
+    _vertexFaces.resize(vertexCount);
+    _quadrics.resize(vertexCount);
+    _stamps.assign(vertexCount, 0);
+    _locked.assign(vertexCount, false);
+    _dead.assign(vertexCount, false);
+    _faceEdges.resize(_faces.size());
+
+    // 边记录为 (顶点对, 所在三角形)，排序后相邻的记录属于同一条边
+    struct EdgeRef {
+        uint64_t key;
+        int face;
+        bool operator<(const EdgeRef& o) const { return key < o.key; }
+    };
+    std::vector<EdgeRef> edges;
+    edges.reserve(_faces.size() * 3);
+    for (size_t f = 0; f < _faces.size(); ++f) {
+        const Face& face = _faces[f];
+        const Vec3 n = faceNormal(_pos[face[0]], _pos[face[1]], _pos[face[2]]);
+        const float len = n.length();
+        for (int k = 0; k < 3; ++k) {
+            const int v = face[k];
+            _vertexFaces[v].push_back((int)f);
+            const int w = face[(k + 1) % 3];
+            edges.push_back({((uint64_t)std::min(v, w) << 32) | (uint32_t)std::max(v, w), (int)f});
+
+            if (len > 0.0f) {
+                const Vec3 un = n / len;
+                _quadrics[v].addPlane(un.x, un.y, un.z, -un.dot(_pos[face[0]]), 0.5 * len);
+            }
+        }
+    }
+
+    for (int v = 0; v < vertexCount; ++v) {
+        if (_vertexFaces[v].empty()) _dead[v] = true;
+    }
+
+    // 边界边（1 个面）与非流形边（超过 2 个面）的端点保持不动
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j].key == edges[i].key) ++j;
+        const int a = (int)(edges[i].key >> 32), b = (int)(edges[i].key & 0xFFFFFFFFu);
+        if (j - i != 2) {
+            _locked[a] = true;
+            _locked[b] = true;
+        }
+        const int edge = (int)_edges.size();
+        _edges.push_back(std::make_pair(_pos[a], _pos[b]));
+        for (size_t k = i; k < j; ++k) _faceEdges[edges[k].face].push_back(edge);
+        i = j;
+    }
+    _edgeSeen.assign(_edges.size(), 0);
+    return true;
+}
+
+void Simplifier::collectRing(int v, std::vector<int>& out) const {
+    out.clear();
+    for (int f : _vertexFaces[v]) {
+        for (int w : _faces[f]) {
+            if (w != v) out.push_back(w);
+        }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void Simplifier::pushCandidate(int from, int to) {
+    if (_locked[from]) return;
+    Quadric q = _quadrics[from];
+    q.add(_quadrics[to]);
+    const double cost = q.evaluate(_pos[to]) + kLengthWeight * (_pos[to] - _pos[from]).lengthSquared();
+    _heap.push({cost, from, to, _stamps[from], _stamps[to]});
+}
+
+void Simplifier::pushAllCandidates() {
+    std::vector<int> ring;
+    for (int v = 0; v < (int)_pos.size(); ++v) {
+        if (_dead[v] || _locked[v]) continue;
+        collectRing(v, ring);
+        for (int w : ring) pushCandidate(v, w);
+    }
+}
+
+/**
+ * 尝试把 from 并入 to，检查拓扑、法线与偏差，全部通过才修改网格
+ */
+bool Simplifier::tryCollapse(int from, int to) {
+    // 1. 拓扑：两端点的公共邻点必须恰好是共享三角形的对顶点（link condition），否则折叠会产生重复面或非流形边
+    int sharedFaces = 0;
+    for (int f : _vertexFaces[from]) {
+        if (contains(_faces[f], to)) ++sharedFaces;
+    }
+    if (sharedFaces == 0) return false;
+
+    collectRing(from, _ringFrom);
+    collectRing(to, _ringTo);
+    int common = 0;
+    for (size_t i = 0, j = 0; i < _ringFrom.size() && j < _ringTo.size();) {
+        if (_ringFrom[i] < _ringTo[j]) {
+            ++i;
+        } else if (_ringFrom[i] > _ringTo[j]) {
+            ++j;
+        } else {
+            ++common;
+            ++i;
+            ++j;
+        }
+    }
+    if (common != sharedFaces) return false;
+    if ((int)(_ringFrom.size() + _ringTo.size()) - common - 2 > kMaxValence) return false;
+
+    // 2. 几何：保留下来的三角形不能退化，法线变化不能超过限制
+    _fan.clear();
+    _fanTris.clear();
+    for (int f : _vertexFaces[from]) {
+        const Face& face = _faces[f];
+        if (contains(face, to)) continue;
+
+        std::array<Vec3, 3> tri;
+        for (int k = 0; k < 3; ++k) tri[k] = _pos[face[k] == from ? to : face[k]];
+        const Vec3 n0 = faceNormal(_pos[face[0]], _pos[face[1]], _pos[face[2]]);
+        const Vec3 n1 = faceNormal(tri[0], tri[1], tri[2]);
+        const float len0 = n0.length(), len1 = n1.length();
+        if (len1 == 0.0f) return false;
+        if (len0 > 0.0f && n0.dot(n1) < _options.minNormalCos * len0 * len1) return false;
+        _fan.push_back(f);
+        _fanTris.push_back(FanTriangle(tri[0], tri[1], tri[2]));
+    }
+    const size_t modifiedCount = _fan.size(); ///< _fan 前段为 from 的保留三角形，后段为 to 周围不变的三角形
+    for (int f : _vertexFaces[to]) {
+        const Face& face = _faces[f];
+        if (contains(face, from)) continue;
+        _fan.push_back(f);
+        _fanTris.push_back(FanTriangle(_pos[face[0]], _pos[face[1]], _pos[face[2]]));
+    }
+    if (_fan.empty()) return false;
+
+    // 3. 误差：登记在 from 周围三角形（将被修改或删除）上的原始边，重新与折叠后的扇形求偏差，
+    //    任何一段超出容差即放弃。to 周围不含 from 的三角形没有变化，其上已有的登记保持不变
+    ++_evalStamp;
+    _assign.clear();
+    for (int f : _vertexFaces[from]) {
+        for (int edge : _faceEdges[f]) {
+            if (_edgeSeen[edge] == _evalStamp) continue;
+            _edgeSeen[edge] = _evalStamp;
+
+            const Vec3& p = _edges[edge].first;
+            const Vec3& q = _edges[edge].second;
+            bool covered = false;
+            for (size_t k = 0; k < _fan.size(); ++k) {
+                const float dev = _fanTris[k].segmentDeviation(p, q);
+                if (dev < 0.0f) continue;
+                if (dev > _options.maxError) return false;
+                _assign.push_back(std::make_pair(edge, (int)k));
+                covered = true;
+            }
+            if (covered) continue;
+
+            // 竖直墙面或 XZ 投影重叠的区域：按空间距离登记到最近的三角形
+            float best = FLT_MAX;
+            int bestK = -1;
+            for (size_t k = 0; k < _fan.size(); ++k) {
+                const float dist = _fanTris[k].segmentDistance(p, q);
+                if (dist < best) {
+                    best = dist;
+                    bestK = (int)k;
+                }
+            }
+            if (best > _options.maxError) return false;
+            _assign.push_back(std::make_pair(edge, bestK));
+        }
+    }
+
+    // 4. 提交：删除共享三角形，其余三角形改指向 to
+    for (int f : _vertexFaces[from]) {
+        Face& face = _faces[f];
+        _faceEdges[f].clear();
+        if (contains(face, to)) {
+            _faceAlive[f] = false;
+            --_aliveFaces;
+            for (int v : face) {
+                if (v == from) continue;
+                auto& list = _vertexFaces[v];
+                list.erase(std::remove(list.begin(), list.end(), f), list.end());
+            }
+        } else {
+            for (int& v : face) {
+                if (v == from) v = to;
+            }
+            _vertexFaces[to].push_back(f);
+        }
+    }
+    _vertexFaces[from].clear();
+    _dead[from] = true;
+    _quadrics[to].add(_quadrics[from]);
+    ++_stamps[to];
+
+    for (const auto& a : _assign) {
+        std::vector<int>& list = _faceEdges[_fan[a.second]];
+        if ((size_t)a.second >= modifiedCount && std::find(list.begin(), list.end(), a.first) != list.end()) continue;
+        list.push_back(a.first);
+    }
+
+    // to 与其邻点的局部几何都变了：此前因偏差被拒绝的邻边可能变为合法，全部重新入堆（旧候选随 stamp 过期）
+    collectRing(to, _ringTo);
+    for (int w : _ringTo) ++_stamps[w];
+    for (int w : _ringTo) {
+        collectRing(w, _ringFrom);
+        for (int x : _ringFrom) {
+            pushCandidate(w, x);
+            if (!std::binary_search(_ringTo.begin(), _ringTo.end(), x)) pushCandidate(x, w);
+        }
+    }
+    for (int w : _ringTo) pushCandidate(to, w);
+    return true;
+}
+
+void Simplifier::run() {
+    for (int pass = 0; pass < kMaxPasses && !reachedTarget(); ++pass) {
+        pushAllCandidates();
+        int collapsed = 0;
+        while (!_heap.empty() && !reachedTarget()) {
+            const Candidate c = _heap.top();
+            _heap.pop();
+            if (_dead[c.from] || _dead[c.to] || c.fromStamp != _stamps[c.from] || c.toStamp != _stamps[c.to]) {
+                continue;
+            }
+            if (tryCollapse(c.from, c.to)) ++collapsed;
+        }
+        std::priority_queue<Candidate>().swap(_heap);
+        if (collapsed == 0) break;
+    }
+}
+
+void Simplifier::store(std::vector<Vec3>& vertices, std::vector<int>& indices, MeshSimplifier::Stats& stats) const {
+    std::vector<int> remap(_pos.size(), -1);
+    vertices.clear();
+    indices.clear();
+    indices.reserve((size_t)_aliveFaces * 3);
+    float maxDeviation = 0.0f;
+    for (size_t f = 0; f < _faces.size(); ++f) {
+        if (!_faceAlive[f]) continue;
+        const Face& face = _faces[f];
+        for (int v : face) {
+            if (remap[v] < 0) {
+                remap[v] = (int)vertices.size();
+                vertices.push_back(_pos[v]);
+            }
+            indices.push_back(remap[v]);
+        }
+
+        const FanTriangle tri(_pos[face[0]], _pos[face[1]], _pos[face[2]]);
+        for (int edge : _faceEdges[f]) {
+            maxDeviation = std::max(maxDeviation, tri.deviation(_edges[edge].first, _edges[edge].second));
+        }
+    }
+
+    stats.inputVertices = (int)_pos.size();
+    stats.inputTriangles = (int)_faces.size();
+    stats.outputVertices = (int)vertices.size();
+    stats.outputTriangles = _aliveFaces;
+    stats.lockedVertices = (int)std::count(_locked.begin(), _locked.end(), true);
+    stats.maxDeviation = maxDeviation;
+}
+
+} // namespace
+
+bool MeshSimplifier::simplify(std::vector<Vec3>& vertices, std::vector<int>& indices,
+                              const Options& options, Stats* stats) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    Simplifier simplifier(options);
+    if (!simplifier.load(vertices, indices)) return false;
+    simplifier.run();
+
+    Stats result;
+    simplifier.store(vertices, indices, result);
+    result.simplifyMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    if (stats) *stats = result;
+    return true;
+}
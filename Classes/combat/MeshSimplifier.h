@@ -0,0 +1,48 @@
+#ifndef __MESH_SIMPLIFIER_H__
+#define __MESH_SIMPLIFIER_H__
+
+#include "cocos2d.h"
+#include <vector>
+
+/**
+ * @class MeshSimplifier
+ * @brief 二次误差度量（QEM）边折叠简化，为渲染地形生成误差受控的碰撞代理网格
+ *
+ * 按 QEM 代价从小到大做半边折叠（顶点并入相邻顶点，不产生新坐标，简化后的顶点是原顶点的子集）。
+ * 每条原始边登记在 XZ 投影与之重叠的所有当前三角形上，折叠前把受影响的原始边裁剪到新三角形内求偏差：
+ * - 有重叠时取重叠区间两端的竖直高度差（高度差沿边线性变化，两张分片线性曲面的最大高度差必在原始边上取到）；
+ * - 否则（竖直墙面、多层结构）取边两端到新三角形的最近距离。
+ * 任一原始边超出 maxError、面法线翻转或变化过大、破坏流形拓扑的折叠都会被拒绝。
+ * 边界边与非流形边上的顶点保持不动，分块地形的接缝因此不会被简化开。
+ */
+class MeshSimplifier {
+public:
+    struct Options {
+        float maxError = 2.0f;        ///< 原始网格到简化网格的最大竖直偏差（与顶点同一坐标空间）
+        int targetTriangles = 0;      ///< 三角形数降到该值即停止，0 表示只受误差约束
+        float minNormalCos = 0.7f;    ///< 折叠前后同一三角形法线夹角余弦的下限
+    };
+
+    struct Stats {
+        int inputTriangles = 0;
+        int outputTriangles = 0;
+        int inputVertices = 0;   ///< 焊接重合顶点之后
+        int outputVertices = 0;
+        int lockedVertices = 0;  ///< 位于边界 / 非流形边上而未参与折叠的顶点
+        float maxDeviation = 0.0f; ///< 原始网格到简化网格的实际最大偏差
+        float simplifyMs = 0.0f;
+    };
+
+    /**
+     * @brief 就地简化索引三角网格
+     * @param vertices 输入输出：顶点，输出只包含仍被引用的顶点
+     * @param indices 输入输出：三角形顶点下标，每 3 个为一个三角形
+     * @param options 简化参数
+     * @param stats 可选输出：简化统计
+     * @return bool 输入是否至少包含一个有效三角形
+     */
+    static bool simplify(std::vector<cocos2d::Vec3>& vertices, std::vector<int>& indices,
+                         const Options& options, Stats* stats = nullptr);
+};
+
+#endif // __MESH_SIMPLIFIER_H__
@@ -0,0 +1,467 @@
+#include "NavMesh.h"
+#include "Collider.h"
+#include "CollisionCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <float.h>
+#include <functional>
+
+USING_NS_CC;
+
+constexpr float NavMesh::kClusterSize;
+
+namespace {
+
+const float kInsideEps = -1e-4f; ///< XZ 重心坐标容差，使共享边上的点至少落在一侧
+
+// 烘焙文件中的导航段
+const uint32_t kTagNavPolys = CollisionCache::makeTag('N', 'A', 'V', 'P');
+const uint32_t kTagNavStepLinks = CollisionCache::makeTag('N', 'A', 'V', 'S');
+
+inline float cross2(float ux, float uz, float wx, float wz) { return ux * wz - uz * wx; }
+
+/**
+ * XZ 平面上的重心坐标（三角形 XZ 投影退化时返回 false）
+ */
+bool barycentricXZ(const NavMesh::Poly& poly, float x, float z, float& u, float& v, float& w) {
+    const Vec3& a = poly.verts[0];
+    const Vec3& b = poly.verts[1];
+    const Vec3& c = poly.verts[2];
+    const float area = cross2(b.x - a.x, b.z - a.z, c.x - a.x, c.z - a.z);
+    if (std::fabs(area) < 1e-8f) return false;
+    const float inv = 1.0f / area;
+    u = cross2(b.x - x, b.z - z, c.x - x, c.z - z) * inv;
+    v = cross2(c.x - x, c.z - z, a.x - x, a.z - z) * inv;
+    w = 1.0f - u - v;
+    return true;
+}
+
+/**
+ * XZ 平面上点到线段的最近点
+ */
+void closestOnSegmentXZ(const Vec3& a, const Vec3& b, float x, float z, float& outX, float& outZ) {
+    const float dx = b.x - a.x, dz = b.z - a.z;
+    const float len2 = dx * dx + dz * dz;
+    float t = len2 > 0.0f ? ((x - a.x) * dx + (z - a.z) * dz) / len2 : 0.0f;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    outX = a.x + dx * t;
+    outZ = a.z + dz * t;
+}
+
+/**
+ * 边界边在 XZ 上的位置键：两端点按 (x, z) 排序，端点完全重合的边键相同
+ */
+struct EdgeKeyXZ {
+    float x0, z0, x1, z1;
+    int poly, edge;
+
+    bool sameEdge(const EdgeKeyXZ& o) const { return x0 == o.x0 && z0 == o.z0 && x1 == o.x1 && z1 == o.z1; }
+    bool operator<(const EdgeKeyXZ& o) const {
+        if (x0 != o.x0) return x0 < o.x0;
+        if (z0 != o.z0) return z0 < o.z0;
+        if (x1 != o.x1) return x1 < o.x1;
+        return z1 < o.z1;
+    }
+};
+
+} // namespace
+
+NavMesh* NavMesh::create(const TerrainCollider* collider) {
+    NavMesh* ret = new (std::nothrow) NavMesh();
+    if (ret && ret->init(collider)) {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+bool NavMesh::init(const TerrainCollider* collider) {
+    if (!collider) return false;
+    auto startTime = std::chrono::steady_clock::now();
+
+    // 1. 可行走的三角形成为多边形
+    const QuantizedMesh& mesh = collider->getMesh();
+    const auto& indices = mesh.getIndices();
+    const int triangleCount = mesh.getTriangleCount();
+    std::vector<int> polyTriangle;
+    _polys.clear();
+    for (int t = 0; t < triangleCount; ++t) {
+        if (collider->getTriangleNormal(t).y < TerrainQuery::kMinWalkableNormalY) continue;
+        Poly poly;
+        mesh.getTriangle(t, poly.verts[0], poly.verts[1], poly.verts[2]);
+        poly.neighbors[0] = poly.neighbors[1] = poly.neighbors[2] = -1;
+        poly.center = (poly.verts[0] + poly.verts[1] + poly.verts[2]) / 3.0f;
+        _polys.push_back(poly);
+        polyTriangle.push_back(t);
+    }
+    if (_polys.empty()) return false;
+
+    // 2. 共享边（QuantizedMesh 已合并重合顶点）：恰好被两个可行走三角形共用的边相连
+    struct EdgeRef {
+        uint64_t key;
+        int poly, edge;
+        bool operator<(const EdgeRef& o) const { return key < o.key; }
+    };
+    std::vector<EdgeRef> edges;
+    edges.reserve(_polys.size() * 3);
+    for (int p = 0; p < (int)_polys.size(); ++p) {
+        const uint32_t* idx = &indices[(size_t)polyTriangle[p] * 3];
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t a = idx[k], b = idx[(k + 1) % 3];
+            edges.push_back({((uint64_t)std::min(a, b) << 32) | std::max(a, b), p, k});
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j].key == edges[i].key) ++j;
+        if (j - i == 2) {
+            _polys[edges[i].poly].neighbors[edges[i].edge] = edges[i + 1].poly;
+            _polys[edges[i + 1].poly].neighbors[edges[i + 1].edge] = edges[i].poly;
+        }
+        i = j;
+    }
+
+    // 3. 台阶连接：XZ 投影重合的边界边，两端高度差都在台阶高度之内
+    std::vector<EdgeKeyXZ> boundary;
+    for (int p = 0; p < (int)_polys.size(); ++p) {
+        for (int k = 0; k < 3; ++k) {
+            if (_polys[p].neighbors[k] >= 0) continue;
+            const Vec3* a = &_polys[p].verts[k];
+            const Vec3* b = &_polys[p].verts[(k + 1) % 3];
+            if (b->x < a->x || (b->x == a->x && b->z < a->z)) std::swap(a, b);
+            boundary.push_back({a->x, a->z, b->x, b->z, p, k});
+        }
+    }
+    std::sort(boundary.begin(), boundary.end());
+    _stepLinks = 0;
+    auto endpointGap = [this](const EdgeKeyXZ& e, float x, float z, float y) {
+        const Poly& poly = _polys[e.poly];
+        const Vec3& a = poly.verts[e.edge];
+        const Vec3& b = poly.verts[(e.edge + 1) % 3];
+        return std::fabs(((a.x == x && a.z == z) ? a.y : b.y) - y);
+    };
+    for (size_t i = 0; i < boundary.size();) {
+        size_t j = i + 1;
+        while (j < boundary.size() && boundary[j].sameEdge(boundary[i])) ++j;
+        for (size_t m = i; m < j; ++m) {
+            const EdgeKeyXZ& e = boundary[m];
+            const Poly& poly = _polys[e.poly];
+            if (poly.neighbors[e.edge] >= 0) continue;
+            const Vec3& a = poly.verts[e.edge];
+            const Vec3& b = poly.verts[(e.edge + 1) % 3];
+            for (size_t n = m + 1; n < j; ++n) {
+                const EdgeKeyXZ& o = boundary[n];
+                if (o.poly == e.poly || _polys[o.poly].neighbors[o.edge] >= 0) continue;
+                if (endpointGap(o, a.x, a.z, a.y) > TerrainQuery::kMaxStepHeight ||
+                    endpointGap(o, b.x, b.z, b.y) > TerrainQuery::kMaxStepHeight) {
+                    continue;
+                }
+                _polys[e.poly].neighbors[e.edge] = o.poly;
+                _polys[o.poly].neighbors[o.edge] = e.poly;
+                ++_stepLinks;
+                break;
+            }
+        }
+        i = j;
+    }
+
+    buildCells();
+    buildClusters();
+
+    const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    CCLOG("NavMesh: %d walkable polys of %d triangles, %d step links, grid %dx%d, %d clusters, built in %.2f ms",
+          (int)_polys.size(), triangleCount, _stepLinks, _cols, _rows, (int)_clusters.size(), ms);
+    return true;
+}
+
+NavMesh* NavMesh::createFromBake(const CollisionCache::Reader& reader) {
+    NavMesh* ret = new (std::nothrow) NavMesh();
+    if (ret && ret->initFromBake(reader)) {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+bool NavMesh::initFromBake(const CollisionCache::Reader& reader) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    size_t polySize = 0, stepSize = 0;
+    auto polys = static_cast<const Poly*>(reader.getSection(kTagNavPolys, polySize));
+    auto stepLinks = static_cast<const int32_t*>(reader.getSection(kTagNavStepLinks, stepSize));
+    if (!polys || polySize == 0 || polySize % sizeof(Poly) != 0 || !stepLinks || stepSize != sizeof(int32_t)) {
+        return false;
+    }
+
+    const int polyCount = (int)(polySize / sizeof(Poly));
+    for (int p = 0; p < polyCount; ++p) {
+        for (int n : polys[p].neighbors) {
+            if (n < -1 || n >= polyCount) return false;
+        }
+    }
+    _polys.assign(polys, polys + polyCount);
+    _stepLinks = *stepLinks;
+
+    buildCells();
+    buildClusters();
+
+    const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    CCLOG("NavMesh: %d baked polys, %d step links, grid %dx%d, %d clusters, loaded in %.2f ms",
+          polyCount, _stepLinks, _cols, _rows, (int)_clusters.size(), ms);
+    return true;
+}
+
+void NavMesh::addBakeSections(CollisionCache::Writer& writer) const {
+    static_assert(sizeof(int) == sizeof(int32_t), "step link count is written as int32_t");
+    writer.addSection(kTagNavPolys, _polys.data(), _polys.size() * sizeof(Poly));
+    writer.addSection(kTagNavStepLinks, &_stepLinks, sizeof(int32_t));
+}
+
+/**
+ * 多边形按 XZ 包围盒放入所有覆盖到的格子，格子边长使每格平均约 4 个多边形
+ */
+void NavMesh::buildCells() {
+    float maxX = -FLT_MAX, maxZ = -FLT_MAX;
+    _minX = _minZ = FLT_MAX;
+    for (const Poly& poly : _polys) {
+        for (const Vec3& v : poly.verts) {
+            _minX = std::min(_minX, v.x);
+            _minZ = std::min(_minZ, v.z);
+            maxX = std::max(maxX, v.x);
+            maxZ = std::max(maxZ, v.z);
+        }
+    }
+    const float width = std::max(maxX - _minX, 1.0f);
+    const float depth = std::max(maxZ - _minZ, 1.0f);
+    _cellSize = std::sqrt(width * depth * 4.0f / (float)_polys.size());
+    _cols = std::max(1, (int)std::ceil(width / _cellSize));
+    _rows = std::max(1, (int)std::ceil(depth / _cellSize));
+
+    auto forEachCell = [this](const Poly& poly, const std::function<void(int)>& fn) {
+        float x0 = poly.verts[0].x, x1 = x0, z0 = poly.verts[0].z, z1 = z0;
+        for (int k = 1; k < 3; ++k) {
+            x0 = std::min(x0, poly.verts[k].x);
+            x1 = std::max(x1, poly.verts[k].x);
+            z0 = std::min(z0, poly.verts[k].z);
+            z1 = std::max(z1, poly.verts[k].z);
+        }
+        const int c0 = std::min(std::max((int)((x0 - _minX) / _cellSize), 0), _cols - 1);
+        const int c1 = std::min(std::max((int)((x1 - _minX) / _cellSize), 0), _cols - 1);
+        const int r0 = std::min(std::max((int)((z0 - _minZ) / _cellSize), 0), _rows - 1);
+        const int r1 = std::min(std::max((int)((z1 - _minZ) / _cellSize), 0), _rows - 1);
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) fn(r * _cols + c);
+        }
+    };
+
+    _cellOffsets.assign((size_t)_cols * _rows + 1, 0);
+    for (const Poly& poly : _polys) {
+        forEachCell(poly, [this](int cell) { ++_cellOffsets[cell + 1]; });
+    }
+    for (size_t i = 1; i < _cellOffsets.size(); ++i) _cellOffsets[i] += _cellOffsets[i - 1];
+
+    _cellPolys.resize(_cellOffsets.back());
+    std::vector<uint32_t> cursor(_cellOffsets.begin(), _cellOffsets.end() - 1);
+    for (int p = 0; p < (int)_polys.size(); ++p) {
+        forEachCell(_polys[p], [this, &cursor, p](int cell) { _cellPolys[cursor[cell]++] = p; });
+    }
+}
+
+/**
+ * 多边形中心所在的 kClusterSize 区域内做连通分量，每个分量为一个簇
+ */
+void NavMesh::buildClusters() {
+    const int polyCount = (int)_polys.size();
+    std::vector<int64_t> region(polyCount);
+    for (int p = 0; p < polyCount; ++p) {
+        const int64_t rx = (int64_t)std::floor((_polys[p].center.x - _minX) / kClusterSize);
+        const int64_t rz = (int64_t)std::floor((_polys[p].center.z - _minZ) / kClusterSize);
+        region[p] = (rz << 32) | rx;
+    }
+
+    // 1. 区域内洪泛
+    _clusters.clear();
+    _polyCluster.assign(polyCount, -1);
+    std::vector<int32_t> stack;
+    std::vector<Vec3> sums;
+    for (int seed = 0; seed < polyCount; ++seed) {
+        if (_polyCluster[seed] >= 0) continue;
+        const int cluster = (int)sums.size();
+        sums.push_back(Vec3::ZERO);
+        _polyCluster[seed] = cluster;
+        stack.push_back(seed);
+        while (!stack.empty()) {
+            const int p = stack.back();
+            stack.pop_back();
+            sums[cluster] += _polys[p].center;
+            for (int n : _polys[p].neighbors) {
+                if (n < 0 || _polyCluster[n] >= 0 || region[n] != region[p]) continue;
+                _polyCluster[n] = cluster;
+                stack.push_back(n);
+            }
+        }
+    }
+
+    // 2. 簇中心取离平均位置最近的多边形中心（保证在簇内），并收集跨簇的连接
+    _clusters.resize(sums.size());
+    std::vector<int> counts(sums.size(), 0);
+    for (int p = 0; p < polyCount; ++p) ++counts[_polyCluster[p]];
+    std::vector<float> bestDist(sums.size(), FLT_MAX);
+    for (int p = 0; p < polyCount; ++p) {
+        const int c = _polyCluster[p];
+        const float d = _polys[p].center.distanceSquared(sums[c] / (float)counts[c]);
+        if (d < bestDist[c]) {
+            bestDist[c] = d;
+            _clusters[c].center = _polys[p].center;
+        }
+        for (int n : _polys[p].neighbors) {
+            if (n < 0 || _polyCluster[n] == c) continue;
+            std::vector<int32_t>& links = _clusters[c].neighbors;
+            if (std::find(links.begin(), links.end(), _polyCluster[n]) == links.end()) links.push_back(_polyCluster[n]);
+        }
+    }
+}
+
+Vec3 NavMesh::closestPoint(int poly, const Vec3& pos) const {
+    const Poly& p = _polys[poly];
+    float u, v, w;
+    if (!barycentricXZ(p, pos.x, pos.z, u, v, w)) return p.center;
+
+    float x = pos.x, z = pos.z;
+    if (u < 0.0f || v < 0.0f || w < 0.0f) {
+        float best = FLT_MAX;
+        for (int k = 0; k < 3; ++k) {
+            float ex, ez;
+            closestOnSegmentXZ(p.verts[k], p.verts[(k + 1) % 3], pos.x, pos.z, ex, ez);
+            const float d = (ex - pos.x) * (ex - pos.x) + (ez - pos.z) * (ez - pos.z);
+            if (d < best) {
+                best = d;
+                x = ex;
+                z = ez;
+            }
+        }
+        barycentricXZ(p, x, z, u, v, w);
+    }
+    return Vec3(x, u * p.verts[0].y + v * p.verts[1].y + w * p.verts[2].y, z);
+}
+
+int NavMesh::findPoly(const Vec3& pos, float searchRadius, Vec3* outPoint) const {
+    if (_polys.empty()) return -1;
+
+    // 1. pos 所在格子中 XZ 包含 pos 的多边形，取表面高度最接近 pos 的一层（桥面与桥下地面）
+    const int c = (int)std::floor((pos.x - _minX) / _cellSize);
+    const int r = (int)std::floor((pos.z - _minZ) / _cellSize);
+    int best = -1;
+    float bestGap = FLT_MAX;
+    float bestY = 0.0f;
+    if (c >= 0 && c < _cols && r >= 0 && r < _rows) {
+        const int cell = r * _cols + c;
+        for (uint32_t i = _cellOffsets[cell]; i < _cellOffsets[cell + 1]; ++i) {
+            const Poly& poly = _polys[_cellPolys[i]];
+            float u, v, w;
+            if (!barycentricXZ(poly, pos.x, pos.z, u, v, w) || u < kInsideEps || v < kInsideEps || w < kInsideEps) {
+                continue;
+            }
+            const float y = u * poly.verts[0].y + v * poly.verts[1].y + w * poly.verts[2].y;
+            const float gap = std::fabs(y - pos.y);
+            if (gap < bestGap) {
+                bestGap = gap;
+                best = _cellPolys[i];
+                bestY = y;
+            }
+        }
+    }
+    if (best >= 0) {
+        if (outPoint) outPoint->set(pos.x, bestY, pos.z);
+        return best;
+    }
+
+    // 2. 半径内 XZ 距离最近的多边形（站在陡坡、墙根等不可行走的位置时）
+    if (searchRadius <= 0.0f) return -1;
+    const int c0 = std::max((int)std::floor((pos.x - searchRadius - _minX) / _cellSize), 0);
+    const int c1 = std::min((int)std::floor((pos.x + searchRadius - _minX) / _cellSize), _cols - 1);
+    const int r0 = std::max((int)std::floor((pos.z - searchRadius - _minZ) / _cellSize), 0);
+    const int r1 = std::min((int)std::floor((pos.z + searchRadius - _minZ) / _cellSize), _rows - 1);
+    float bestDist = searchRadius * searchRadius;
+    Vec3 bestPoint;
+    for (int rr = r0; rr <= r1; ++rr) {
+        for (int cc = c0; cc <= c1; ++cc) {
+            const int cell = rr * _cols + cc;
+            for (uint32_t i = _cellOffsets[cell]; i < _cellOffsets[cell + 1]; ++i) {
+                const Vec3 p = closestPoint(_cellPolys[i], pos);
+                const float d = (p.x - pos.x) * (p.x - pos.x) + (p.z - pos.z) * (p.z - pos.z);
+                const float gap = std::fabs(p.y - pos.y);
+                if (d < bestDist || (d == bestDist && best >= 0 && gap < bestGap)) {
+                    bestDist = d;
+                    bestGap = gap;
+                    best = _cellPolys[i];
+                    bestPoint = p;
+                }
+            }
+        }
+    }
+    if (best >= 0 && outPoint) *outPoint = bestPoint;
+    return best;
+}
+
+bool NavMesh::walkStraight(int fromPoly, const Vec3& from, const Vec3& to, int toPoly) const {
+    if (fromPoly < 0 || toPoly < 0) return false;
+    const float dx = to.x - from.x, dz = to.z - from.z;
+    int cur = fromPoly;
+    for (int step = 0; step < kMaxWalkPolys; ++step) {
+        if (cur == toPoly) return true;
+        const Poly& poly = _polys[cur];
+        const Vec3* v = poly.verts;
+        const float area = cross2(v[1].x - v[0].x, v[1].z - v[0].z, v[2].x - v[0].x, v[2].z - v[0].z);
+        if (std::fabs(area) < 1e-8f) return false;
+        const float sign = area > 0.0f ? 1.0f : -1.0f;
+
+        // 线段离开多边形的边：各边内侧距离沿线段递减到 0 的最早一条
+        // 恰好穿过顶点时两条边同时离开，优先取有邻居的一条
+        float exitT = FLT_MAX;
+        int exitEdge = -1;
+        for (int k = 0; k < 3; ++k) {
+            const Vec3& a = v[k];
+            const Vec3& b = v[(k + 1) % 3];
+            const float ex = b.x - a.x, ez = b.z - a.z;
+            const float s1 = cross2(ex, ez, dx, dz) * sign;
+            if (s1 >= 0.0f) continue;
+            const float t = -cross2(ex, ez, from.x - a.x, from.z - a.z) * sign / s1;
+            if (exitEdge < 0 || t < exitT - 1e-5f ||
+                (t <= exitT + 1e-5f && poly.neighbors[exitEdge] < 0 && poly.neighbors[k] >= 0)) {
+                exitT = t;
+                exitEdge = k;
+            }
+        }
+        // 终点落在当前多边形内，但当前多边形不是 toPoly（另一层，例如桥下）
+        if (exitEdge < 0 || exitT >= 1.0f) return false;
+        cur = poly.neighbors[exitEdge];
+        if (cur < 0) return false;
+    }
+    return false;
+}
+
+bool NavMesh::getPortal(int from, int to, Vec3& outLeft, Vec3& outRight) const {
+    const Poly& poly = _polys[from];
+    for (int k = 0; k < 3; ++k) {
+        if (poly.neighbors[k] != to) continue;
+        const Vec3& a = poly.verts[k];
+        const Vec3& b = poly.verts[(k + 1) % 3];
+        // 以多边形中心指向边中点为前进方向，叉积为正的一侧记为左
+        const float dx = (a.x + b.x) * 0.5f - poly.center.x;
+        const float dz = (a.z + b.z) * 0.5f - poly.center.z;
+        if (cross2(dx, dz, a.x - poly.center.x, a.z - poly.center.z) > 0.0f) {
+            outLeft = a;
+            outRight = b;
+        } else {
+            outLeft = b;
+            outRight = a;
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,126 @@
+#ifndef __NAV_MESH_H__
+#define __NAV_MESH_H__
+
+#include "cocos2d.h"
+#include <cstdint>
+#include <vector>
+
+class TerrainCollider;
+namespace CollisionCache {
+class Reader;
+class Writer;
+}
+
+/**
+ * @class NavMesh
+ * @brief 由地形碰撞网格生成的导航网格：每个可行走的三角形是一个多边形
+ *
+ * 生成规则与角色移动（TerrainQuery::canStepOnto）一致：
+ * - 法线 y 分量不低于 TerrainQuery::kMinWalkableNormalY 的三角形可行走；
+ * - 共享一条边的可行走三角形直接相连；
+ * - 没有共享边、但 XZ 投影重合的边界边（竖直台阶面两侧、拼接的独立网格）
+ *   两端高度差都不超过 TerrainQuery::kMaxStepHeight 时作为台阶连接。
+ * 多边形按 XZ 均匀网格分桶（偏移表 + 扁平索引），用于定位起点与终点所在的多边形。
+ *
+ * 分层寻路用的簇：按 kClusterSize 的 XZ 区域划分，区域内互相连通的多边形为一个簇，
+ * 有多边形跨区域相连的两个簇互为邻居。
+ *
+ * 离线烘焙（WorldBake）只保存多边形及其连接关系，定位网格与簇在加载时由多边形重建。
+ *
+ * 一个导航网格只覆盖生成它的单个碰撞器（整块地形），不支持分块流式地形：
+ * 分块按需加载和淘汰，没有导航数据，场景在流式模式下不设置导航网格。
+ */
+class NavMesh : public cocos2d::Ref {
+public:
+    struct Poly {
+        cocos2d::Vec3 verts[3];
+        int32_t neighbors[3]; ///< 边 (verts[k], verts[(k + 1) % 3]) 对面的多边形，-1 表示边界
+        cocos2d::Vec3 center;
+    };
+
+    struct Cluster {
+        cocos2d::Vec3 center;           ///< 簇内离各多边形中心平均位置最近的多边形中心
+        std::vector<int32_t> neighbors; ///< 相邻的簇
+    };
+
+    static constexpr float kClusterSize = 200.0f; ///< 簇所在区域的边长
+    static const int kMaxWalkPolys = 256;         ///< walkStraight 最多经过的多边形数
+
+    /**
+     * @brief 由碰撞器的三角形生成导航网格
+     * @return NavMesh* 没有可行走三角形时返回 nullptr
+     */
+    static NavMesh* create(const TerrainCollider* collider);
+
+    bool init(const TerrainCollider* collider);
+
+    /**
+     * @brief 由烘焙文件中的导航段创建
+     * @return NavMesh* 段缺失或数据不一致时返回 nullptr
+     */
+    static NavMesh* createFromBake(const CollisionCache::Reader& reader);
+
+    bool initFromBake(const CollisionCache::Reader& reader);
+
+    /**
+     * @brief 把多边形与台阶连接数登记为烘焙文件的段（只记录指针，写出前自身必须保持有效）
+     */
+    void addBakeSections(CollisionCache::Writer& writer) const;
+
+    int getPolyCount() const { return (int)_polys.size(); }
+    const Poly& getPoly(int i) const { return _polys[i]; }
+
+    /**
+     * @brief 查找 pos 所在的多边形
+     * XZ 投影包含 pos 的多边形中取表面高度最接近 pos 的一个（区分桥面与桥下地面）；
+     * 都不包含时在 searchRadius 内取 XZ 距离最近的多边形
+     * @param outPoint 输出：多边形上离 pos 最近的点（XZ 夹到多边形内，Y 取表面高度）
+     * @return int 多边形下标，找不到返回 -1
+     */
+    int findPoly(const cocos2d::Vec3& pos, float searchRadius, cocos2d::Vec3* outPoint = nullptr) const;
+
+    /**
+     * @brief 多边形上 XZ 距离 pos 最近的点，Y 取该点的表面高度
+     */
+    cocos2d::Vec3 closestPoint(int poly, const cocos2d::Vec3& pos) const;
+
+    /**
+     * @brief 多边形 from 到相邻多边形 to 的入口边，左右以从 from 走向 to 的方向为准
+     * @return bool to 不是 from 的邻居时返回 false
+     */
+    bool getPortal(int from, int to, cocos2d::Vec3& outLeft, cocos2d::Vec3& outRight) const;
+
+    /**
+     * @brief 沿导航网格从 from 直线走到 to（XZ 平面），逐个穿过线段离开多边形时经过的边
+     * 穿过的边都与相邻多边形相连（共享边或台阶连接）且最终到达 toPoly 时可直达，
+     * 途中遇到边界边（陡坡、墙体、断崖）或经过的多边形超过 kMaxWalkPolys 时不可直达
+     * @param fromPoly from 所在的多边形
+     * @param toPoly to 所在的多边形
+     */
+    bool walkStraight(int fromPoly, const cocos2d::Vec3& from, const cocos2d::Vec3& to, int toPoly) const;
+
+    int getClusterCount() const { return (int)_clusters.size(); }
+    const Cluster& getCluster(int i) const { return _clusters[i]; }
+    int getPolyCluster(int poly) const { return _polyCluster[poly]; }
+
+    /// 统计：台阶连接的边数
+    int getStepLinkCount() const { return _stepLinks; }
+
+private:
+    std::vector<Poly> _polys;
+    int _stepLinks = 0;
+
+    // 定位用的 XZ 网格：格子 i 的多边形为 _cellPolys[_cellOffsets[i], _cellOffsets[i + 1])
+    float _minX = 0.0f, _minZ = 0.0f, _cellSize = 1.0f;
+    int _cols = 0, _rows = 0;
+    std::vector<uint32_t> _cellOffsets;
+    std::vector<int32_t> _cellPolys;
+
+    std::vector<Cluster> _clusters;
+    std::vector<int32_t> _polyCluster;
+
+    void buildCells();
+    void buildClusters();
+};
+
+#endif // __NAV_MESH_H__
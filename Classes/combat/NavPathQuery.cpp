@@ -0,0 +1,413 @@
+#include "NavPathQuery.h"
+#include <functional>
+
+USING_NS_CC;
+
+constexpr float NavPathQuery::kLocateRadius;
+
+namespace {
+
+/// o -> a 与 o -> b 在 XZ 平面上的叉积，为正时 b 在 o -> a 的左侧（与 NavMesh::getPortal 的左右约定一致）
+inline float side(const Vec3& o, const Vec3& a, const Vec3& b) {
+    return (a.x - o.x) * (b.z - o.z) - (a.z - o.z) * (b.x - o.x);
+}
+
+inline bool sameXZ(const Vec3& a, const Vec3& b) {
+    const float dx = a.x - b.x, dz = a.z - b.z;
+    return dx * dx + dz * dz < 1e-6f;
+}
+
+} // namespace
+
+void NavPathQuery::setNavMesh(const NavMesh* mesh) {
+    _mesh = mesh;
+    const size_t count = mesh ? (size_t)mesh->getPolyCount() : 0;
+    _visitStamp.assign(count, 0);
+    _closedStamp.assign(count, 0);
+    _g.resize(count);
+    _parent.resize(count);
+    _nodePos.resize(count);
+    _stamp = 0;
+
+    const size_t clusters = mesh ? (size_t)mesh->getClusterCount() : 0;
+    _clusterAllowed.assign(clusters, 0);
+    _clusterVisit.assign(clusters, 0);
+    _clusterG.resize(clusters);
+    _clusterParent.resize(clusters);
+    _clusterStamp = 0;
+    _clusterPaths.clear();
+    _status = Status::Failed;
+}
+
+NavPathQuery::Status NavPathQuery::findPath(const Vec3& start, const Vec3& goal, std::vector<Vec3>& outPath,
+                                            int maxNodes) {
+    outPath.clear();
+    if (initSlicedFindPath(start, goal, maxNodes) == Status::Failed) return Status::Failed;
+    updateSlicedFindPath(maxNodes);
+    return finalizeSlicedFindPath(outPath);
+}
+
+void NavPathQuery::resetStamps() {
+    if (++_stamp == 0) {
+        std::fill(_visitStamp.begin(), _visitStamp.end(), 0);
+        std::fill(_closedStamp.begin(), _closedStamp.end(), 0);
+        std::fill(_clusterAllowed.begin(), _clusterAllowed.end(), 0);
+        _stamp = 1;
+    }
+}
+
+NavPathQuery::Status NavPathQuery::initSlicedFindPath(const Vec3& start, const Vec3& goal, int maxNodes) {
+    _lastExpanded = 0;
+    _status = Status::Failed;
+    if (!_mesh) return _status;
+
+    const int startPoly = _mesh->findPoly(start, kLocateRadius, &_startPoint);
+    if (startPoly < 0) return _status;
+    // 终点不在导航网格附近（如玩家站在陡坡上）时仍然搜索，路径通往离它最近的可达多边形
+    _goal = goal;
+    _goalPoint = goal;
+    _goalPoly = _mesh->findPoly(goal, kLocateRadius, &_goalPoint);
+    _maxNodes = std::max(1, maxNodes);
+
+    resetStamps();
+
+    // 1. 簇路径：走廊只在簇路径经过的簇内展开；终点不可达时不限制，按节点上限找最近点
+    _restricted = false;
+    if (_goalPoly >= 0) {
+        const std::vector<int32_t>& clusters =
+            findClusterPath(_mesh->getPolyCluster(startPoly), _mesh->getPolyCluster(_goalPoly));
+        if (!clusters.empty()) {
+            for (int c : clusters) _clusterAllowed[c] = _stamp;
+            _restricted = true;
+        }
+    }
+
+    // 2. 多边形级 A* 的起点
+    _open.clear();
+    _visitStamp[startPoly] = _stamp;
+    _g[startPoly] = 0.0f;
+    _parent[startPoly] = -1;
+    _nodePos[startPoly] = _startPoint;
+    _best = startPoly;
+    _bestDist = _startPoint.distance(_goalPoint);
+    _open.push_back(std::make_pair(_bestDist, startPoly));
+    _status = Status::InProgress;
+    return _status;
+}
+
+NavPathQuery::Status NavPathQuery::updateSlicedFindPath(int maxIter, int* outDoneIter) {
+    int done = 0;
+    const std::greater<std::pair<float, int>> heapOrder;
+    while (_status == Status::InProgress && done < maxIter) {
+        if (_open.empty() || _lastExpanded >= _maxNodes) {
+            _status = Status::Partial;
+            break;
+        }
+
+        std::pop_heap(_open.begin(), _open.end(), heapOrder);
+        const int p = _open.back().second;
+        _open.pop_back();
+        if (_closedStamp[p] == _stamp) continue;
+        _closedStamp[p] = _stamp;
+        ++_lastExpanded;
+        ++done;
+
+        if (p == _goalPoly) {
+            _status = Status::Found;
+            break;
+        }
+
+        const NavMesh::Poly& poly = _mesh->getPoly(p);
+        for (int k = 0; k < 3; ++k) {
+            const int n = poly.neighbors[k];
+            if (n < 0 || _closedStamp[n] == _stamp) continue;
+            if (_restricted && _clusterAllowed[_mesh->getPolyCluster(n)] != _stamp) continue;
+
+            const Vec3 mid = (poly.verts[k] + poly.verts[(k + 1) % 3]) * 0.5f;
+            const float g = _g[p] + _nodePos[p].distance(mid);
+            if (_visitStamp[n] == _stamp && g >= _g[n]) continue;
+
+            _visitStamp[n] = _stamp;
+            _g[n] = g;
+            _parent[n] = p;
+            _nodePos[n] = mid;
+            const float h = mid.distance(_goalPoint);
+            if (h < _bestDist) {
+                _bestDist = h;
+                _best = n;
+            }
+            _open.push_back(std::make_pair(g + h, n));
+            std::push_heap(_open.begin(), _open.end(), heapOrder);
+        }
+    }
+    if (outDoneIter) *outDoneIter = done;
+    return _status;
+}
+
+NavPathQuery::Status NavPathQuery::finalizeSlicedFindPath(std::vector<Vec3>& outPath) {
+    outPath.clear();
+    if (_status == Status::Failed) return _status;
+    if (_status == Status::InProgress) _status = Status::Partial;
+
+    // 回溯走廊并拉直
+    const bool found = _status == Status::Found;
+    const int last = found ? _goalPoly : _best;
+    const Vec3 endPoint = found ? _goalPoint : _mesh->closestPoint(_best, _goal);
+    _corridor.clear();
+    for (int p = last; p >= 0; p = _parent[p]) _corridor.push_back(p);
+    std::reverse(_corridor.begin(), _corridor.end());
+
+    stringPull(_startPoint, endPoint, outPath);
+    return _status;
+}
+
+/**
+ * 簇图上的 A*（簇中心之间的直线距离为代价），结果按 (from, to) 缓存
+ */
+const std::vector<int32_t>& NavPathQuery::findClusterPath(int from, int to) {
+    const uint64_t key = ((uint64_t)(uint32_t)from << 32) | (uint32_t)to;
+    auto it = _clusterPaths.find(key);
+    if (it != _clusterPaths.end()) {
+        ++_cacheHits;
+        return it->second;
+    }
+    ++_cacheMisses;
+    if (_clusterPaths.size() >= (size_t)kClusterCacheSize) _clusterPaths.clear();
+    std::vector<int32_t>& path = _clusterPaths[key];
+
+    if (++_clusterStamp == 0) {
+        std::fill(_clusterVisit.begin(), _clusterVisit.end(), 0);
+        _clusterStamp = 1;
+    }
+    const Vec3& target = _mesh->getCluster(to).center;
+    const std::greater<std::pair<float, int>> heapOrder;
+    _clusterOpen.clear();
+    _clusterVisit[from] = _clusterStamp;
+    _clusterG[from] = 0.0f;
+    _clusterParent[from] = -1;
+    _clusterOpen.push_back(std::make_pair(_mesh->getCluster(from).center.distance(target), from));
+    while (!_clusterOpen.empty()) {
+        std::pop_heap(_clusterOpen.begin(), _clusterOpen.end(), heapOrder);
+        const std::pair<float, int> top = _clusterOpen.back();
+        _clusterOpen.pop_back();
+        const int c = top.second;
+        if (c == to) {
+            for (int p = to; p >= 0; p = _clusterParent[p]) path.push_back(p);
+            std::reverse(path.begin(), path.end());
+            break;
+        }
+        const Vec3& center = _mesh->getCluster(c).center;
+        if (top.first > _clusterG[c] + center.distance(target)) continue; // 过期条目
+
+        for (int n : _mesh->getCluster(c).neighbors) {
+            const Vec3& nc = _mesh->getCluster(n).center;
+            const float g = _clusterG[c] + center.distance(nc);
+            if (_clusterVisit[n] == _clusterStamp && g >= _clusterG[n]) continue;
+            _clusterVisit[n] = _clusterStamp;
+            _clusterG[n] = g;
+            _clusterParent[n] = c;
+            _clusterOpen.push_back(std::make_pair(g + nc.distance(target), n));
+            std::push_heap(_clusterOpen.begin(), _clusterOpen.end(), heapOrder);
+        }
+    }
+    return path;
+}
+
+/**
+ * Simple Stupid Funnel：沿走廊的入口边收紧左右边界，
+ * 新的边点越过另一侧边界时，那一侧的端点成为拐点（新的漏斗顶点）
+ */
+void NavPathQuery::stringPull(const Vec3& start, const Vec3& end, std::vector<Vec3>& outPath) {
+    // 入口边：首尾分别是退化为一点的起点与终点
+    _portalLeft.clear();
+    _portalRight.clear();
+    _portalLeft.push_back(start);
+    _portalRight.push_back(start);
+    for (size_t i = 0; i + 1 < _corridor.size(); ++i) {
+        Vec3 left, right;
+        _mesh->getPortal(_corridor[i], _corridor[i + 1], left, right);
+        _portalLeft.push_back(left);
+        _portalRight.push_back(right);
+    }
+    _portalLeft.push_back(end);
+    _portalRight.push_back(end);
+
+    outPath.push_back(start);
+    Vec3 apex = start, left = start, right = start;
+    int apexIndex = 0, leftIndex = 0, rightIndex = 0;
+    const int count = (int)_portalLeft.size();
+    for (int i = 1; i < count; ++i) {
+        const Vec3& newLeft = _portalLeft[i];
+        const Vec3& newRight = _portalRight[i];
+
+        // 右边界向内收紧
+        if (side(apex, right, newRight) >= 0.0f) {
+            if (sameXZ(apex, right) || side(apex, left, newRight) < 0.0f) {
+                right = newRight;
+                rightIndex = i;
+            } else {
+                // 越过左边界：左端点成为拐点
+                apex = left;
+                apexIndex = leftIndex;
+                outPath.push_back(apex);
+                left = right = apex;
+                leftIndex = rightIndex = apexIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+
+        // 左边界向内收紧
+        if (side(apex, left, newLeft) <= 0.0f) {
+            if (sameXZ(apex, left) || side(apex, right, newLeft) > 0.0f) {
+                left = newLeft;
+                leftIndex = i;
+            } else {
+                apex = right;
+                apexIndex = rightIndex;
+                outPath.push_back(apex);
+                left = right = apex;
+                leftIndex = rightIndex = apexIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+    }
+
+    if (!sameXZ(outPath.back(), end) || outPath.size() == 1) outPath.push_back(end);
+}
+
+/* ==================== NavPathQueue ==================== */
+
+NavPathQueue::NavPathQueue() : _slots(kMaxRequests) {}
+
+NavPathQueue::~NavPathQueue() {
+    CC_SAFE_RELEASE(_navMesh);
+}
+
+void NavPathQueue::setNavMesh(NavMesh* mesh) {
+    CC_SAFE_RETAIN(mesh);
+    CC_SAFE_RELEASE(_navMesh);
+    _navMesh = mesh;
+    _query.setNavMesh(mesh);
+
+    // 旧网格上的请求全部作废
+    for (Slot& slot : _slots) {
+        slot.handle = kInvalidHandle;
+        slot.status = RequestStatus::Invalid;
+    }
+    _pending.clear();
+    _active = kInvalidHandle;
+}
+
+NavPathQueue::Handle NavPathQueue::request(const Vec3& start, const Vec3& goal) {
+    for (int i = 0; i < (int)_slots.size(); ++i) {
+        Slot& slot = _slots[i];
+        if (slot.status != RequestStatus::Invalid) continue;
+
+        // 句柄低 8 位为槽位，高位为序号，槽位复用后旧句柄失效
+        if (++_serial >= (1u << 24)) _serial = 1;
+        slot.handle = (_serial << 8) | (uint32_t)i;
+        slot.status = RequestStatus::Pending;
+        slot.start = start;
+        slot.goal = goal;
+        slot.path.clear();
+        _pending.push_back(slot.handle);
+        return slot.handle;
+    }
+    return kInvalidHandle;
+}
+
+int NavPathQueue::slotOf(Handle handle) const {
+    const int i = (int)(handle & 0xFF);
+    if (handle == kInvalidHandle || i >= (int)_slots.size() || _slots[i].handle != handle) return -1;
+    return i;
+}
+
+NavPathQueue::RequestStatus NavPathQueue::getStatus(Handle handle) const {
+    const int i = slotOf(handle);
+    return i >= 0 ? _slots[i].status : RequestStatus::Invalid;
+}
+
+NavPathQueue::RequestStatus NavPathQueue::fetchPath(Handle handle, std::vector<Vec3>& outPath) {
+    const int i = slotOf(handle);
+    if (i < 0) return RequestStatus::Invalid;
+    Slot& slot = _slots[i];
+    const RequestStatus status = slot.status;
+    if (status == RequestStatus::Pending) return status;
+
+    outPath.swap(slot.path);
+    slot.path.clear();
+    slot.handle = kInvalidHandle;
+    slot.status = RequestStatus::Invalid;
+    return status;
+}
+
+void NavPathQueue::cancel(Handle handle) {
+    const int i = slotOf(handle);
+    if (i < 0) return;
+    // 排队中的句柄留在队列里，出队时发现槽位已失效便跳过
+    _slots[i].handle = kInvalidHandle;
+    _slots[i].status = RequestStatus::Invalid;
+    if (_active == handle) _active = kInvalidHandle;
+}
+
+void NavPathQueue::complete(int slot, NavPathQuery::Status status) {
+    Slot& s = _slots[slot];
+    switch (status) {
+    case NavPathQuery::Status::Found:
+        s.status = RequestStatus::Found;
+        break;
+    case NavPathQuery::Status::Partial:
+        s.status = RequestStatus::Partial;
+        break;
+    default:
+        s.status = RequestStatus::Failed;
+        s.path.clear();
+        break;
+    }
+    s.doneFrame = _frame;
+    ++_lastQueries;
+}
+
+void NavPathQueue::update() {
+    ++_frame;
+    _lastQueries = 0;
+    _lastNodes = 0;
+
+    // 回收长时间未取走的结果
+    for (Slot& slot : _slots) {
+        if (slot.status != RequestStatus::Invalid && slot.status != RequestStatus::Pending &&
+            _frame - slot.doneFrame > (unsigned)kResultLifetime) {
+            slot.handle = kInvalidHandle;
+            slot.status = RequestStatus::Invalid;
+        }
+    }
+
+    while (_lastNodes < _nodeBudget) {
+        if (_active == kInvalidHandle) {
+            if (_pending.empty()) break;
+            const Handle next = _pending.front();
+            _pending.pop_front();
+            const int i = slotOf(next);
+            if (i < 0) continue; // 已撤销
+
+            if (_query.initSlicedFindPath(_slots[i].start, _slots[i].goal) == NavPathQuery::Status::Failed) {
+                complete(i, NavPathQuery::Status::Failed);
+                continue;
+            }
+            _active = next;
+        }
+
+        // 执行到预算用完，没有结束的请求下一帧继续
+        int done = 0;
+        const NavPathQuery::Status status = _query.updateSlicedFindPath(_nodeBudget - _lastNodes, &done);
+        _lastNodes += std::max(done, 1);
+        if (status == NavPathQuery::Status::InProgress) continue;
+
+        const int i = slotOf(_active);
+        _query.finalizeSlicedFindPath(_slots[i].path);
+        complete(i, status);
+        _active = kInvalidHandle;
+    }
+}
@@ -0,0 +1,213 @@
+#ifndef __NAV_PATH_QUERY_H__
+#define __NAV_PATH_QUERY_H__
+
+#include "cocos2d.h"
+#include "NavMesh.h"
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class NavPathQuery
+ * @brief 导航网格上的分层 A* 寻路与拉绳（funnel）路径平滑
+ *
+ * 先在簇图（NavMesh::Cluster）上求簇路径，再把多边形级 A* 限制在簇路径经过的簇内，
+ * 长距离查询只展开走廊附近的多边形。簇路径按 (起点簇, 终点簇) 缓存，
+ * 同一区域的重复查询不再做簇级搜索。
+ *
+ * 节点池按多边形下标预先分配，用查询序号区分本次查询访问过的节点，
+ * 重复查询不需要清空，也不会产生内存分配。
+ * A* 的节点位置取进入该多边形时经过的边中点，启发函数为到终点的直线距离。
+ * 走廊（多边形序列）求出后用 Simple Stupid Funnel 算法拉直，得到贴着拐角的最短折线。
+ *
+ * 查询可以分片执行：initSlicedFindPath 之后多次调用 updateSlicedFindPath，
+ * 每次最多展开指定数量的节点，结束后由 finalizeSlicedFindPath 输出路径。
+ */
+class NavPathQuery {
+public:
+    enum class Status {
+        Failed,    ///< 起点附近没有可行走的多边形
+        Partial,   ///< 终点不可达或超出节点上限，路径通往离终点最近的多边形
+        Found,     ///< 到达终点
+        InProgress ///< 分片查询尚未结束
+    };
+
+    static const int kDefaultMaxNodes = 8192;      ///< 单次查询最多展开的节点数
+    static const int kClusterCacheSize = 4096;     ///< 簇路径缓存的条目上限，超出时清空
+    static constexpr float kLocateRadius = 150.0f; ///< 起点 / 终点不在导航网格上时，向周围搜索多边形的半径
+
+    void setNavMesh(const NavMesh* mesh);
+    const NavMesh* getNavMesh() const { return _mesh; }
+
+    /**
+     * @brief 一次性求 start 到 goal 的路径
+     * @param outPath 输出：路径点（世界坐标），第一个点是起点在导航网格上的投影，最后一个是终点或最近点
+     * @param maxNodes 展开节点数上限
+     */
+    Status findPath(const cocos2d::Vec3& start, const cocos2d::Vec3& goal, std::vector<cocos2d::Vec3>& outPath,
+                    int maxNodes = kDefaultMaxNodes);
+
+    /**
+     * @brief 开始分片查询：定位起终点并求簇路径
+     * @return Status 起点不在导航网格附近时返回 Failed，否则返回 InProgress
+     */
+    Status initSlicedFindPath(const cocos2d::Vec3& start, const cocos2d::Vec3& goal, int maxNodes = kDefaultMaxNodes);
+
+    /**
+     * @brief 继续分片查询
+     * @param maxIter 本次最多展开的节点数
+     * @param outDoneIter 输出：本次实际展开的节点数
+     * @return Status 未结束时返回 InProgress
+     */
+    Status updateSlicedFindPath(int maxIter, int* outDoneIter = nullptr);
+
+    /**
+     * @brief 输出分片查询的路径（查询尚未结束时按当前最接近终点的节点输出部分路径）
+     */
+    Status finalizeSlicedFindPath(std::vector<cocos2d::Vec3>& outPath);
+
+    /// 统计：当前（或上一次）查询展开的节点数
+    int getLastExpandedCount() const { return _lastExpanded; }
+
+    /// 统计：簇路径缓存命中与未命中次数
+    int getClusterCacheHits() const { return _cacheHits; }
+    int getClusterCacheMisses() const { return _cacheMisses; }
+
+private:
+    const NavMesh* _mesh = nullptr;
+
+    // 节点池：下标即多边形下标
+    std::vector<unsigned> _visitStamp;  ///< 等于 _stamp 时 g / parent / pos 有效
+    std::vector<unsigned> _closedStamp; ///< 等于 _stamp 时节点已关闭
+    std::vector<float> _g;
+    std::vector<int> _parent;
+    std::vector<cocos2d::Vec3> _nodePos;
+    unsigned _stamp = 0;
+    int _lastExpanded = 0;
+
+    std::vector<std::pair<float, int>> _open; ///< (f, 多边形) 最小堆，过期条目出堆时跳过
+    std::vector<int> _corridor;
+    std::vector<cocos2d::Vec3> _portalLeft, _portalRight;
+
+    // 分片查询的状态
+    Status _status = Status::Failed;
+    int _goalPoly = -1;
+    int _best = -1;
+    float _bestDist = 0.0f;
+    int _maxNodes = kDefaultMaxNodes;
+    bool _restricted = false;
+    cocos2d::Vec3 _startPoint, _goalPoint, _goal;
+
+    // 簇级搜索：_clusterAllowed 等于 _stamp 的簇在本次查询的簇路径上
+    std::vector<unsigned> _clusterAllowed;
+    std::vector<unsigned> _clusterVisit;
+    std::vector<float> _clusterG;
+    std::vector<int> _clusterParent;
+    std::vector<std::pair<float, int>> _clusterOpen;
+    unsigned _clusterStamp = 0;
+    std::unordered_map<uint64_t, std::vector<int32_t>> _clusterPaths; ///< 簇路径缓存，空表示不可达
+    int _cacheHits = 0;
+    int _cacheMisses = 0;
+
+    const std::vector<int32_t>& findClusterPath(int from, int to);
+    void resetStamps();
+    void stringPull(const cocos2d::Vec3& start, const cocos2d::Vec3& end, std::vector<cocos2d::Vec3>& outPath);
+};
+
+/**
+ * @class NavPathQueue
+ * @brief 异步寻路请求队列：按帧预算分片执行，避免大量敌人同时寻路造成单帧卡顿
+ *
+ * 敌人在状态更新中 request 得到句柄，之后每帧用 getStatus / fetchPath 轮询结果；
+ * 场景每帧调用一次 update，按提交顺序执行请求，本帧累计展开的节点数达到预算后，
+ * 执行到一半的请求和剩余请求留到下一帧继续。
+ * 结果在完成后保留 kResultLifetime 帧，未取走的（如发起请求的敌人已被移除）自动回收。
+ */
+class NavPathQueue {
+public:
+    typedef uint32_t Handle;
+
+    enum class RequestStatus {
+        Invalid, ///< 句柄无效、已取走或已过期
+        Pending, ///< 排队或执行中
+        Failed,  ///< 起点附近没有可行走的多边形
+        Partial, ///< 路径通往离终点最近的可达位置
+        Found    ///< 路径到达终点
+    };
+
+    static const Handle kInvalidHandle = 0;
+    static const int kDefaultNodeBudget = 4096; ///< 每帧展开节点数的预算
+    static const int kMaxRequests = 128;        ///< 同时存在的请求（含未取走的结果）上限
+    static const int kResultLifetime = 120;     ///< 结果保留的帧数
+
+    NavPathQueue();
+    ~NavPathQueue();
+
+    /**
+     * @brief 设置导航网格（持有引用）。导航网格只覆盖单个碰撞器，见 NavMesh
+     */
+    void setNavMesh(NavMesh* mesh);
+    NavMesh* getNavMesh() const { return _navMesh; }
+
+    void setNodeBudget(int nodesPerFrame) { _nodeBudget = std::max(1, nodesPerFrame); }
+
+    /**
+     * @brief 提交寻路请求（世界坐标）
+     * @return Handle 请求句柄，请求数已满时返回 kInvalidHandle
+     */
+    Handle request(const cocos2d::Vec3& start, const cocos2d::Vec3& goal);
+
+    RequestStatus getStatus(Handle handle) const;
+
+    /**
+     * @brief 取走已完成请求的路径并释放句柄
+     * @param outPath 输出：路径点，寻路失败时为空
+     * @return RequestStatus 请求仍在执行时返回 Pending（不修改 outPath）
+     */
+    RequestStatus fetchPath(Handle handle, std::vector<cocos2d::Vec3>& outPath);
+
+    /**
+     * @brief 撤销请求（排队、执行中或已完成）
+     */
+    void cancel(Handle handle);
+
+    /**
+     * @brief 在预算内执行请求
+     */
+    void update();
+
+    int getPendingCount() const { return (int)_pending.size() + (_active != kInvalidHandle ? 1 : 0); }
+
+    const NavPathQuery& getQuery() const { return _query; }
+
+    /// 统计：上一帧完成的请求数与展开的节点数
+    int getLastFrameQueries() const { return _lastQueries; }
+    int getLastFrameNodes() const { return _lastNodes; }
+
+private:
+    struct Slot {
+        Handle handle = kInvalidHandle;
+        RequestStatus status = RequestStatus::Invalid;
+        cocos2d::Vec3 start, goal;
+        std::vector<cocos2d::Vec3> path;
+        unsigned doneFrame = 0;
+    };
+
+    NavMesh* _navMesh = nullptr; ///< 持有引用
+    NavPathQuery _query;
+    std::vector<Slot> _slots;
+    std::deque<Handle> _pending;
+    Handle _active = kInvalidHandle; ///< 正在分片执行的请求
+    uint32_t _serial = 0;
+    unsigned _frame = 0;
+    int _nodeBudget = kDefaultNodeBudget;
+    int _lastQueries = 0;
+    int _lastNodes = 0;
+
+    int slotOf(Handle handle) const;
+    void complete(int slot, NavPathQuery::Status status);
+};
+
+#endif // __NAV_PATH_QUERY_H__
@@ -0,0 +1,305 @@
+#include "ObjParser.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+USING_NS_CC;
+
+namespace {
+
+const size_t kMinChunkBytes = 512 * 1024; ///< 每个线程至少处理的字节数，小文件不值得开线程
+const int kMaxThreads = 8;
+
+/**
+ * 单个分块的解析上下文
+ */
+struct Chunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    int vertexBase = 0;   ///< 本块第一个顶点的全局下标（第一趟前缀和得到）
+    int vertexCount = 0;
+    std::vector<int> indices;
+    int faceCount = 0;
+    int skippedFaces = 0;
+};
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+inline const char* findLineEnd(const char* p, const char* end) {
+    const void* nl = memchr(p, '\n', end - p);
+    return nl ? static_cast<const char*>(nl) : end;
+}
+
+inline bool isVertexLine(const char* p, const char* lineEnd) {
+    return lineEnd - p >= 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t');
+}
+
+inline bool isFaceLine(const char* p, const char* lineEnd) {
+    return lineEnd - p >= 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t');
+}
+
+/**
+ * 解析十进制整数，成功时推进 p
+ */
+bool parseInt(const char*& p, const char* end, int& out) {
+    const char* s = p;
+    bool neg = false;
+    if (s < end && (*s == '-' || *s == '+')) {
+        neg = (*s == '-');
+        ++s;
+    }
+    if (s >= end || !isDigit(*s)) return false;
+
+    int64_t v = 0;
+    while (s < end && isDigit(*s)) {
+        if (v < INT32_MAX) v = v * 10 + (*s - '0');
+        ++s;
+    }
+    if (v > INT32_MAX) v = INT32_MAX;
+    out = neg ? -(int)v : (int)v;
+    p = s;
+    return true;
+}
+
+/**
+ * 解析浮点数（[+-]digits[.digits][e[+-]digits]），成功时推进 p
+ * 先用 64 位整数累积最多 19 位有效数字，再按 10 的幂缩放，精度满足碰撞网格需要
+ */
+bool parseFloat(const char*& p, const char* end, float& out) {
+    static const double kPow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* s = p;
+    bool neg = false;
+    if (s < end && (*s == '-' || *s == '+')) {
+        neg = (*s == '-');
+        ++s;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exp10 = 0;
+    bool any = false;
+
+    while (s < end && isDigit(*s)) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*s - '0');
+            if (mantissa) ++digits;
+        } else {
+            ++exp10;
+        }
+        any = true;
+        ++s;
+    }
+    if (s < end && *s == '.') {
+        ++s;
+        while (s < end && isDigit(*s)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*s - '0');
+                if (mantissa) ++digits;
+                --exp10;
+            }
+            any = true;
+            ++s;
+        }
+    }
+    if (!any) return false;
+
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        const char* e = s + 1;
+        int expValue = 0;
+        if (parseInt(e, end, expValue)) {
+            exp10 += std::max(-400, std::min(400, expValue));
+            s = e;
+        }
+    }
+
+    double v = (double)mantissa;
+    if (exp10 < 0) {
+        v = (exp10 >= -22) ? v / kPow10[-exp10] : v * std::pow(10.0, exp10);
+    } else if (exp10 > 0) {
+        v = (exp10 <= 22) ? v * kPow10[exp10] : v * std::pow(10.0, exp10);
+    }
+    out = (float)(neg ? -v : v);
+    p = s;
+    return true;
+}
+
+/**
+ * 第一趟：只统计顶点行数量
+ */
+void countVertices(Chunk& chunk) {
+    int count = 0;
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* lineEnd = findLineEnd(p, chunk.end);
+        if (isVertexLine(p, lineEnd)) ++count;
+        p = lineEnd + 1;
+    }
+    chunk.vertexCount = count;
+}
+
+/**
+ * 第二趟：解析顶点与面
+ * 顶点写入 vertices[vertexBase...]；面索引只能引用到当前位置为止已定义的顶点
+ */
+void parseChunk(Chunk& chunk, Vec3* vertices) {
+    Vec3* dst = vertices + chunk.vertexBase;
+    int localVertices = 0;
+
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* lineEnd = findLineEnd(p, chunk.end);
+
+        if (isVertexLine(p, lineEnd)) {
+            // 第一趟已为该行预留位置，格式错误时保留为原点，保证后续下标不错位
+            const char* s = p + 2;
+            float xyz[3] = {0.0f, 0.0f, 0.0f};
+            for (int i = 0; i < 3; ++i) {
+                s = skipSpaces(s, lineEnd);
+                if (!parseFloat(s, lineEnd, xyz[i])) break;
+            }
+            dst[localVertices++] = Vec3(xyz[0], xyz[1], xyz[2]);
+        } else if (isFaceLine(p, lineEnd)) {
+            ++chunk.faceCount;
+            const int available = chunk.vertexBase + localVertices;
+            const size_t rollback = chunk.indices.size();
+            int first = -1, prev = -1, corners = 0;
+            bool bad = false;
+
+            const char* s = p + 2;
+            while (true) {
+                s = skipSpaces(s, lineEnd);
+                if (s >= lineEnd) break;
+
+                // 形如 v、v/vt、v//vn、v/vt/vn，只取顶点索引
+                int raw = 0;
+                if (!parseInt(s, lineEnd, raw) || raw == 0) {
+                    bad = true;
+                    break;
+                }
+                while (s < lineEnd && !isSpace(*s)) ++s;
+
+                // 正数索引从 1 开始；负数索引相对当前已定义的顶点数量
+                int idx = raw > 0 ? raw - 1 : available + raw;
+                if (idx < 0 || idx >= available) {
+                    bad = true;
+                    break;
+                }
+
+                // 扇形拆分：(0, i-1, i)
+                if (corners == 0) {
+                    first = idx;
+                } else if (corners >= 2) {
+                    chunk.indices.push_back(first);
+                    chunk.indices.push_back(prev);
+                    chunk.indices.push_back(idx);
+                }
+                prev = idx;
+                ++corners;
+            }
+
+            if (bad || corners < 3) {
+                chunk.indices.resize(rollback);
+                ++chunk.skippedFaces;
+            }
+        }
+
+        p = lineEnd + 1;
+    }
+}
+
+/**
+ * 在 threadCount 个线程上对每个分块执行 fn，第 0 块由调用线程处理
+ */
+template <typename Fn>
+void runParallel(std::vector<Chunk>& chunks, Fn fn) {
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size() - 1);
+    for (size_t i = 1; i < chunks.size(); ++i) {
+        workers.emplace_back([&chunks, &fn, i]() { fn(chunks[i]); });
+    }
+    fn(chunks[0]);
+    for (auto& t : workers) t.join();
+}
+
+} // namespace
+
+bool ObjParser::parse(const char* data, size_t size,
+                      std::vector<Vec3>& outVertices,
+                      std::vector<int>& outIndices,
+                      Stats* stats) {
+    auto startTime = std::chrono::steady_clock::now();
+    outVertices.clear();
+    outIndices.clear();
+    if (!data || size == 0) return false;
+
+    // 1. 按行边界切分
+    int hw = (int)std::thread::hardware_concurrency();
+    int threadCount = (int)std::min<size_t>(size / kMinChunkBytes, (size_t)std::min(kMaxThreads, std::max(1, hw)));
+    threadCount = std::max(1, threadCount);
+
+    const char* end = data + size;
+    std::vector<Chunk> chunks(threadCount);
+    const char* cursor = data;
+    for (int i = 0; i < threadCount; ++i) {
+        chunks[i].begin = cursor;
+        if (i == threadCount - 1) {
+            cursor = end;
+        } else {
+            const char* target = std::max(cursor, data + size * (i + 1) / threadCount);
+            cursor = std::min(end, findLineEnd(target, end) + 1);
+        }
+        chunks[i].end = cursor;
+    }
+
+    // 2. 统计顶点数，前缀和得到每块的全局起始下标
+    runParallel(chunks, countVertices);
+    int totalVertices = 0;
+    for (auto& chunk : chunks) {
+        chunk.vertexBase = totalVertices;
+        totalVertices += chunk.vertexCount;
+    }
+    outVertices.resize(totalVertices);
+
+    // 3. 并行解析，按块顺序拼接三角形
+    Vec3* vertexData = outVertices.data();
+    runParallel(chunks, [vertexData](Chunk& chunk) { parseChunk(chunk, vertexData); });
+
+    size_t totalIndices = 0;
+    for (const auto& chunk : chunks) totalIndices += chunk.indices.size();
+    outIndices.reserve(totalIndices);
+
+    int faceCount = 0, skippedFaces = 0;
+    for (const auto& chunk : chunks) {
+        outIndices.insert(outIndices.end(), chunk.indices.begin(), chunk.indices.end());
+        faceCount += chunk.faceCount;
+        skippedFaces += chunk.skippedFaces;
+    }
+
+    if (stats) {
+        stats->vertexCount = totalVertices;
+        stats->faceCount = faceCount;
+        stats->triangleCount = (int)(outIndices.size() / 3);
+        stats->skippedFaces = skippedFaces;
+        stats->threadCount = threadCount;
+        stats->parseMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    }
+    return !outIndices.empty();
+}
@@ -0,0 +1,46 @@
+#ifndef __OBJ_PARSER_H__
+#define __OBJ_PARSER_H__
+
+#include "cocos2d.h"
+#include <vector>
+
+/**
+ * @class ObjParser
+ * @brief 只提取几何信息（v / f）的 .obj 解析器，直接在内存缓冲区上扫描，不做逐行分配
+ *
+ * 解析分两趟并行完成：
+ *   1. 把缓冲区按行边界切成若干块，各线程统计本块的顶点数，前缀和得到每块的全局顶点起始下标；
+ *   2. 各线程解析本块，顶点直接写入全局数组的对应位置，面索引（含负数相对索引）当场解析为绝对下标。
+ * 三角形按块顺序拼接，因此结果与单线程顺序解析完全一致。
+ * 多边形面按扇形拆分为三角形，纹理/法线索引被忽略。
+ */
+class ObjParser {
+public:
+    /**
+     * @brief 解析统计信息
+     */
+    struct Stats {
+        int vertexCount = 0;
+        int faceCount = 0;      ///< 读到的面数量（拆分前）
+        int triangleCount = 0;
+        int skippedFaces = 0;   ///< 因索引越界或格式错误被丢弃的面
+        int threadCount = 0;
+        float parseMs = 0.0f;
+    };
+
+    /**
+     * @brief 解析 .obj 文本
+     * @param data 文件内容（无需以 '\0' 结尾）
+     * @param size 字节数
+     * @param outVertices 输出：模型空间顶点
+     * @param outIndices 输出：三角形顶点下标，每 3 个为一个三角形，均为 0 起始的合法下标
+     * @param stats 可选输出：解析统计
+     * @return bool 是否解析出至少一个三角形
+     */
+    static bool parse(const char* data, size_t size,
+                      std::vector<cocos2d::Vec3>& outVertices,
+                      std::vector<int>& outIndices,
+                      Stats* stats = nullptr);
+};
+
+#endif // __OBJ_PARSER_H__
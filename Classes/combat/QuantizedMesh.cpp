@@ -0,0 +1,96 @@
+#include "QuantizedMesh.h"
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+#include <unordered_map>
+
+USING_NS_CC;
+
+void QuantizedMesh::clear() {
+    _header = Header();
+    _positions.clear();
+    _indices.clear();
+}
+
+bool QuantizedMesh::build(const std::vector<Vec3>& vertices, const std::vector<int>& indices) {
+    clear();
+    if (vertices.empty() || indices.size() < 3) return false;
+
+    float bmin[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float bmax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (const auto& v : vertices) {
+        const float p[3] = {v.x, v.y, v.z};
+        for (int a = 0; a < 3; ++a) {
+            bmin[a] = std::min(bmin[a], p[a]);
+            bmax[a] = std::max(bmax[a], p[a]);
+        }
+    }
+    float invStep[3];
+    for (int a = 0; a < 3; ++a) {
+        _header.origin[a] = bmin[a];
+        _header.step[a] = (bmax[a] - bmin[a]) / 65535.0f;
+        invStep[a] = _header.step[a] > 0.0f ? 1.0f / _header.step[a] : 0.0f;
+    }
+
+    // 量化并合并坐标相同的顶点
+    std::vector<uint32_t> remap(vertices.size());
+    std::unordered_map<uint64_t, uint32_t> welded;
+    welded.reserve(vertices.size());
+    _positions.reserve(vertices.size() * 3);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const float p[3] = {vertices[i].x, vertices[i].y, vertices[i].z};
+        uint16_t q[3];
+        for (int a = 0; a < 3; ++a) {
+            float f = std::floor((p[a] - bmin[a]) * invStep[a] + 0.5f);
+            q[a] = (uint16_t)std::min(std::max(f, 0.0f), 65535.0f);
+        }
+        const uint64_t key = (uint64_t)q[0] | ((uint64_t)q[1] << 16) | ((uint64_t)q[2] << 32);
+        auto it = welded.find(key);
+        if (it == welded.end()) {
+            const uint32_t id = (uint32_t)(_positions.size() / 3);
+            welded.emplace(key, id);
+            _positions.insert(_positions.end(), q, q + 3);
+            remap[i] = id;
+        } else {
+            remap[i] = it->second;
+        }
+    }
+
+    _indices.reserve(indices.size());
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        const uint32_t a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+        if (a == b || b == c || a == c) continue;
+        _indices.push_back(a);
+        _indices.push_back(b);
+        _indices.push_back(c);
+    }
+    _positions.shrink_to_fit();
+    _indices.shrink_to_fit();
+    return !_indices.empty();
+}
+
+bool QuantizedMesh::assign(const Header& header, const uint16_t* positions, size_t positionCount,
+                           const uint32_t* indices, size_t indexCount) {
+    clear();
+    if (positionCount == 0 || positionCount % 3 != 0 || indexCount == 0 || indexCount % 3 != 0) return false;
+
+    const uint32_t vertexCount = (uint32_t)(positionCount / 3);
+    for (size_t i = 0; i < indexCount; ++i) {
+        if (indices[i] >= vertexCount) return false;
+    }
+
+    _header = header;
+    _positions.assign(positions, positions + positionCount);
+    _indices.assign(indices, indices + indexCount);
+    return true;
+}
+
+void QuantizedMesh::reorderTriangles(const std::vector<int>& order) {
+    std::vector<uint32_t> reordered;
+    reordered.reserve(order.size() * 3);
+    for (int t : order) {
+        const uint32_t* idx = &_indices[(size_t)t * 3];
+        reordered.insert(reordered.end(), idx, idx + 3);
+    }
+    _indices.swap(reordered);
+}
@@ -0,0 +1,84 @@
+#ifndef __QUANTIZED_MESH_H__
+#define __QUANTIZED_MESH_H__
+
+#include "cocos2d.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class QuantizedMesh
+ * @brief 碰撞网格的紧凑存储：索引顶点缓冲 + 相对包围盒量化为 16 位的顶点坐标
+ *
+ * 每个顶点 6 字节，每个三角形 12 字节索引；相同量化坐标的顶点在构建时合并。
+ * 量化步长 = 包围盒边长 / 65535，解码误差不超过半个步长（2000 单位的地形约 0.015 单位）。
+ * 所有查询都基于解码后的坐标，因此射线、扫掠和高度场看到的是同一份几何。
+ */
+class QuantizedMesh {
+public:
+    /**
+     * @brief 解码参数（也作为碰撞缓存中的段头）
+     */
+    struct Header {
+        float origin[3] = {0.0f, 0.0f, 0.0f};
+        float step[3] = {0.0f, 0.0f, 0.0f};
+    };
+
+    /**
+     * @brief 由浮点顶点与三角形索引构建，退化三角形（量化后顶点重合）会被丢弃
+     * @return bool 是否至少保留了一个三角形
+     */
+    bool build(const std::vector<cocos2d::Vec3>& vertices, const std::vector<int>& indices);
+
+    /**
+     * @brief 直接载入缓存中的数据，长度或索引越界时返回 false
+     */
+    bool assign(const Header& header, const uint16_t* positions, size_t positionCount,
+                const uint32_t* indices, size_t indexCount);
+
+    void clear();
+    bool empty() const { return _indices.empty(); }
+
+    int getTriangleCount() const { return (int)(_indices.size() / 3); }
+    int getVertexCount() const { return (int)(_positions.size() / 3); }
+
+    cocos2d::Vec3 getVertex(uint32_t v) const {
+        const uint16_t* q = &_positions[(size_t)v * 3];
+        return cocos2d::Vec3(_header.origin[0] + q[0] * _header.step[0],
+                             _header.origin[1] + q[1] * _header.step[1],
+                             _header.origin[2] + q[2] * _header.step[2]);
+    }
+
+    void getTriangle(int t, cocos2d::Vec3& v0, cocos2d::Vec3& v1, cocos2d::Vec3& v2) const {
+        const uint32_t* idx = &_indices[(size_t)t * 3];
+        v0 = getVertex(idx[0]);
+        v1 = getVertex(idx[1]);
+        v2 = getVertex(idx[2]);
+    }
+
+    /**
+     * @brief 按给定顺序重排三角形（BVH 叶子顺序），order[i] 为新位置 i 对应的原三角形下标
+     */
+    void reorderTriangles(const std::vector<int>& order);
+
+    void getBounds(cocos2d::Vec3& outMin, cocos2d::Vec3& outMax) const {
+        outMin.set(_header.origin[0], _header.origin[1], _header.origin[2]);
+        outMax.set(_header.origin[0] + 65535.0f * _header.step[0],
+                   _header.origin[1] + 65535.0f * _header.step[1],
+                   _header.origin[2] + 65535.0f * _header.step[2]);
+    }
+
+    const Header& getHeader() const { return _header; }
+    const std::vector<uint16_t>& getPositions() const { return _positions; }
+    const std::vector<uint32_t>& getIndices() const { return _indices; }
+
+    size_t getMemoryBytes() const {
+        return _positions.capacity() * sizeof(uint16_t) + _indices.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    Header _header;
+    std::vector<uint16_t> _positions; ///< 每个顶点 xyz 三个量化分量
+    std::vector<uint32_t> _indices;   ///< 每个三角形三个顶点下标
+};
+
+#endif // __QUANTIZED_MESH_H__
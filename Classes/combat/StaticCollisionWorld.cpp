@@ -0,0 +1,365 @@
+#include "StaticCollisionWorld.h"
+#include "CapsuleSweep.h"
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+
+USING_NS_CC;
+
+namespace {
+
+/// 用单位四元数旋转向量：v' = v + 2w(u x v) + 2u x (u x v)
+Vec3 rotate(const Quaternion& q, const Vec3& v) {
+    const Vec3 u(q.x, q.y, q.z);
+    Vec3 uv, uuv;
+    Vec3::cross(u, v, &uv);
+    Vec3::cross(u, uv, &uuv);
+    return v + uv * (2.0f * q.w) + uuv * 2.0f;
+}
+
+Quaternion conjugate(const Quaternion& q) {
+    return Quaternion(-q.x, -q.y, -q.z, q.w);
+}
+
+/// 胶囊 (a, b, radius) 沿 delta 平移扫过的包围盒
+void sweptBounds(const Vec3& a, const Vec3& b, float radius, const Vec3& delta, Vec3& bmin, Vec3& bmax) {
+    bmin.set(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+    bmax.set(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+    bmin.set(std::min(bmin.x, bmin.x + delta.x), std::min(bmin.y, bmin.y + delta.y), std::min(bmin.z, bmin.z + delta.z));
+    bmax.set(std::max(bmax.x, bmax.x + delta.x), std::max(bmax.y, bmax.y + delta.y), std::max(bmax.z, bmax.z + delta.z));
+    bmin -= Vec3(radius, radius, radius);
+    bmax += Vec3(radius, radius, radius);
+}
+
+} // namespace
+
+StaticCollisionWorld* StaticCollisionWorld::create() {
+    auto pRet = new (std::nothrow) StaticCollisionWorld();
+    if (pRet) {
+        pRet->autorelease();
+    }
+    return pRet;
+}
+
+StaticCollisionWorld::~StaticCollisionWorld() {
+    for (auto mesh : _meshes) {
+        mesh->release();
+    }
+}
+
+int StaticCollisionWorld::addMesh(const std::string& objFilePath, TerrainCollider::AccelType accel) {
+    auto it = _meshByPath.find(objFilePath);
+    if (it != _meshByPath.end()) return it->second;
+
+    TerrainCollider* mesh = TerrainCollider::createFromObj(objFilePath, accel);
+    if (!mesh) {
+        CCLOG("StaticCollisionWorld: failed to load collision mesh %s", objFilePath.c_str());
+        return -1;
+    }
+    mesh->retain();
+    _meshes.push_back(mesh);
+    int id = (int)_meshes.size() - 1;
+    _meshByPath[objFilePath] = id;
+    return id;
+}
+
+int StaticCollisionWorld::addInstance(int meshId, const Vec3& position, const Quaternion& rotation, float scale) {
+    if (meshId < 0 || meshId >= (int)_meshes.size() || scale <= 0.0f) return -1;
+
+    Instance inst;
+    inst.mesh = meshId;
+    inst.position = position;
+    inst.scale = scale;
+    const float len = std::sqrt(rotation.x * rotation.x + rotation.y * rotation.y +
+                                rotation.z * rotation.z + rotation.w * rotation.w);
+    inst.rotation = len > 0.0f ? Quaternion(rotation.x / len, rotation.y / len, rotation.z / len, rotation.w / len)
+                               : Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // 模型空间包围盒的 8 个角变换到世界空间后取包围盒
+    Vec3 localMin, localMax;
+    _meshes[meshId]->getBounds(localMin, localMax);
+    inst.bmin.set(FLT_MAX, FLT_MAX, FLT_MAX);
+    inst.bmax.set(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (int corner = 0; corner < 8; ++corner) {
+        Vec3 p((corner & 1) ? localMax.x : localMin.x,
+               (corner & 2) ? localMax.y : localMin.y,
+               (corner & 4) ? localMax.z : localMin.z);
+        p = toWorldPoint(inst, p);
+        inst.bmin.set(std::min(inst.bmin.x, p.x), std::min(inst.bmin.y, p.y), std::min(inst.bmin.z, p.z));
+        inst.bmax.set(std::max(inst.bmax.x, p.x), std::max(inst.bmax.y, p.y), std::max(inst.bmax.z, p.z));
+    }
+
+    _instances.push_back(inst);
+    _dirty = true;
+    return (int)_instances.size() - 1;
+}
+
+void StaticCollisionWorld::build() {
+    _dirty = false;
+    _tlasOrder.clear();
+    _tlas.clear();
+    if (_instances.empty()) return;
+
+    std::vector<TerrainBVH::Prim> prims(_instances.size());
+    for (size_t i = 0; i < _instances.size(); ++i) {
+        prims[i].bmin = _instances[i].bmin;
+        prims[i].bmax = _instances[i].bmax;
+    }
+    _tlas.build(prims, _tlasOrder, 1);
+
+    CCLOG("StaticCollisionWorld: %d instances of %d meshes, %d top-level nodes.",
+          (int)_instances.size(), (int)_meshes.size(), (int)_tlas.getNodes().size());
+}
+
+Vec3 StaticCollisionWorld::toLocalPoint(const Instance& inst, const Vec3& p) const {
+    return rotate(conjugate(inst.rotation), p - inst.position) * (1.0f / inst.scale);
+}
+
+Vec3 StaticCollisionWorld::toLocalVector(const Instance& inst, const Vec3& v) const {
+    return rotate(conjugate(inst.rotation), v) * (1.0f / inst.scale);
+}
+
+Vec3 StaticCollisionWorld::toWorldPoint(const Instance& inst, const Vec3& p) const {
+    return rotate(inst.rotation, p * inst.scale) + inst.position;
+}
+
+Vec3 StaticCollisionWorld::toWorldVector(const Instance& inst, const Vec3& v) const {
+    return rotate(inst.rotation, v * inst.scale);
+}
+
+/**
+ * 射线变换到模型空间后参数 t 不变：world(o + t * d) = local(o) + t * local(d)
+ */
+bool StaticCollisionWorld::raycastInstance(const Instance& inst, const Vec3& origin, const Vec3& dir,
+                                           float tMax, bool anyHit, float& hitT) {
+    TerrainCollider* mesh = _meshes[inst.mesh];
+    const Vec3 localOrigin = toLocalPoint(inst, origin);
+    const Vec3 localDir = toLocalVector(inst, dir);
+
+    if (tMax == FLT_MAX) {
+        return mesh->rayIntersects(CustomRay(localOrigin, localDir), hitT);
+    }
+    const Vec3 localEnd = localOrigin + localDir * tMax;
+    if (anyHit) {
+        if (!mesh->segmentIntersects(localOrigin, localEnd)) return false;
+        hitT = tMax;
+        return true;
+    }
+    float fraction;
+    if (!mesh->segmentIntersects(localOrigin, localEnd, fraction)) return false;
+    hitT = fraction * tMax;
+    return true;
+}
+
+/**
+ * 顶层遍历：由近到远访问实例包围盒，逐个实例在模型空间求交并缩小 tMax
+ */
+bool StaticCollisionWorld::raycast(const Vec3& origin, const Vec3& dir, float tMax, bool anyHit,
+                                   float& hitT, int* hitInstance) {
+    if (_dirty) build();
+    if (_tlas.empty()) return false;
+
+    float closest = tMax;
+    int closestInstance = -1;
+    bool hit = _tlas.raycast(origin, dir, closest, [&](int first, int count, float& t) {
+        bool leafHit = false;
+        for (int i = first; i < first + count; ++i) {
+            const int id = _tlasOrder[i];
+            float instT;
+            // 遮挡查询中 instT 直接取 t（只关心是否被挡），不要求更近
+            if (raycastInstance(_instances[id], origin, dir, t, anyHit, instT) && (anyHit || instT < t)) {
+                t = instT;
+                closestInstance = id;
+                leafHit = true;
+                if (anyHit) break;
+            }
+        }
+        return leafHit;
+    }, anyHit);
+
+    if (hit) {
+        hitT = closest;
+        if (hitInstance) *hitInstance = closestInstance;
+    }
+    return hit;
+}
+
+bool StaticCollisionWorld::rayIntersectsInstances(const CustomRay& ray, float& hitDist, int* outInstance) {
+    return raycast(ray.origin, ray.direction, FLT_MAX, false, hitDist, outInstance);
+}
+
+bool StaticCollisionWorld::raycastInstancesHit(const CustomRay& ray, float tMax, RayHit& outHit) {
+    float t;
+    int id = -1;
+    if (!raycast(ray.origin, ray.direction, tMax, false, t, &id)) return false;
+
+    // 命中面的法线在实例的模型空间重新求一次（只在命中时多一次单网格查询）
+    const Instance& inst = _instances[id];
+    RayHit localHit;
+    outHit.normal = Vec3::UNIT_Y;
+    if (_meshes[inst.mesh]->rayIntersects(CustomRay(toLocalPoint(inst, ray.origin), toLocalVector(inst, ray.direction)),
+                                          localHit)) {
+        outHit.normal = toWorldVector(inst, localHit.normal).getNormalized();
+    }
+    outHit.distance = t;
+    outHit.triangle = -1;
+    return true;
+}
+
+/**
+ * 以下查询先交给地形，再用地形的结果作为上限与物件求交，物件只在更近时覆盖地形的结果
+ */
+bool StaticCollisionWorld::rayIntersects(const CustomRay& ray, float& hitDist) {
+    bool hit = _terrain && _terrain->rayIntersects(ray, hitDist);
+    float t;
+    if (raycast(ray.origin, ray.direction, hit ? hitDist : FLT_MAX, false, t, nullptr)) {
+        hitDist = t;
+        hit = true;
+    }
+    return hit;
+}
+
+bool StaticCollisionWorld::rayIntersects(const CustomRay& ray, RayHit& outHit) {
+    bool hit = _terrain && _terrain->rayIntersects(ray, outHit);
+    if (raycastInstancesHit(ray, hit ? outHit.distance : FLT_MAX, outHit)) hit = true;
+    return hit;
+}
+
+bool StaticCollisionWorld::segmentIntersects(const Vec3& from, const Vec3& to) {
+    if (_terrain && _terrain->segmentIntersects(from, to)) return true;
+    float t;
+    return raycast(from, to - from, 1.0f, true, t, nullptr);
+}
+
+bool StaticCollisionWorld::segmentIntersects(const Vec3& from, const Vec3& to, float& outFraction) {
+    bool hit = _terrain && _terrain->segmentIntersects(from, to, outFraction);
+    float t;
+    if (raycast(from, to - from, hit ? outFraction : 1.0f, false, t, nullptr)) {
+        outFraction = t;
+        hit = true;
+    }
+    return hit;
+}
+
+/**
+ * 贴地探测：地形部分沿用地形自己的缓存，物件按竖直射线求交，更高的物件顶面覆盖地形
+ */
+bool StaticCollisionWorld::probeGround(const Vec3& origin, GroundCache& cache, RayHit& outHit) {
+    bool hit = _terrain && _terrain->probeGround(origin, cache, outHit);
+    if (raycastInstancesHit(CustomRay(origin, Vec3(0.0f, -1.0f, 0.0f)), hit ? outHit.distance : FLT_MAX, outHit)) {
+        hit = true;
+    }
+    return hit;
+}
+
+int StaticCollisionWorld::rayIntersectsBatch(const CustomRay* rays, int count, float* outHitDist, RayHit* outHits) {
+    if (count <= 0) return 0;
+
+    int hits = 0;
+    if (_terrain) {
+        hits = _terrain->rayIntersectsBatch(rays, count, outHitDist, outHits);
+    } else {
+        std::fill(outHitDist, outHitDist + count, kNoHit);
+    }
+
+    if (_dirty) build();
+    if (_tlas.empty()) return hits;
+
+    for (int i = 0; i < count; ++i) {
+        const bool terrainHit = outHitDist[i] != kNoHit;
+        const float tMax = terrainHit ? outHitDist[i] : FLT_MAX;
+        if (outHits) {
+            RayHit hit;
+            if (!raycastInstancesHit(rays[i], tMax, hit)) continue;
+            outHits[i] = hit;
+            outHitDist[i] = hit.distance;
+        } else {
+            float t;
+            if (!raycast(rays[i].origin, rays[i].direction, tMax, false, t, nullptr)) continue;
+            outHitDist[i] = t;
+        }
+        if (!terrainHit) ++hits;
+    }
+    return hits;
+}
+
+/**
+ * 胶囊体扫掠：顶层按扫掠包围盒筛选实例，胶囊变换到模型空间后半径按缩放比例缩小，
+ * 接触时间不变，法线与接触点变换回世界空间
+ */
+bool StaticCollisionWorld::sweepInstances(const Vec3& a, const Vec3& b, float radius, const Vec3& delta,
+                                          TerrainCollider::SweepHit& outHit) {
+    if (_dirty) build();
+    if (_tlas.empty()) return false;
+
+    Vec3 bmin, bmax;
+    sweptBounds(a, b, radius, delta, bmin, bmax);
+
+    bool hit = false;
+    _tlas.overlap(bmin, bmax, [&](int first, int count) {
+        for (int i = first; i < first + count; ++i) {
+            const Instance& inst = _instances[_tlasOrder[i]];
+            if (inst.bmax.x < bmin.x || inst.bmin.x > bmax.x || inst.bmax.y < bmin.y || inst.bmin.y > bmax.y ||
+                inst.bmax.z < bmin.z || inst.bmin.z > bmax.z) {
+                continue;
+            }
+
+            TerrainCollider::SweepHit localHit;
+            if (!_meshes[inst.mesh]->sweepCapsule(toLocalPoint(inst, a), toLocalPoint(inst, b), radius / inst.scale,
+                                                  toLocalVector(inst, delta), localHit)) {
+                continue;
+            }
+            if (!hit || localHit.toi < outHit.toi) {
+                outHit.toi = localHit.toi;
+                outHit.normal = toWorldVector(inst, localHit.normal).getNormalized();
+                outHit.point = toWorldPoint(inst, localHit.point);
+                hit = true;
+            }
+        }
+    });
+    return hit;
+}
+
+bool StaticCollisionWorld::sweepCapsule(const Vec3& a, const Vec3& b, float radius, const Vec3& delta,
+                                        float& toi, Vec3& normal) {
+    bool hit = _terrain && _terrain->sweepCapsule(a, b, radius, delta, toi, normal);
+    TerrainCollider::SweepHit instHit;
+    if (sweepInstances(a, b, radius, delta, instHit) && (!hit || instHit.toi < toi)) {
+        toi = instHit.toi;
+        normal = instHit.normal;
+        hit = true;
+    }
+    return hit;
+}
+
+/**
+ * 先让地形单独滑动：地形原地不动（被挡住，或分块地形的目标分块尚未驻留）时直接返回；
+ * 移动范围内没有物件时地形的结果就是最终结果，否则用合并后的扫掠重新滑动
+ */
+Vec3 StaticCollisionWorld::slideCapsule(const Vec3& from, const Vec3& axisBottom, const Vec3& axisTop,
+                                        float radius, const Vec3& delta, int maxIterations) {
+    if (_terrain) {
+        const Vec3 moved = _terrain->slideCapsule(from, axisBottom, axisTop, radius, delta, maxIterations);
+        if (moved == from) return moved;
+
+        if (_dirty) build();
+        // 沿墙滑动会改变方向，按水平位移长度向四周扩展
+        const float reach = std::sqrt(delta.x * delta.x + delta.z * delta.z);
+        Vec3 bmin, bmax;
+        sweptBounds(from + axisBottom, from + axisTop, radius + reach, Vec3::ZERO, bmin, bmax);
+        bool nearInstance = false;
+        _tlas.overlap(bmin, bmax, [&](int first, int count) {
+            for (int i = first; i < first + count && !nearInstance; ++i) {
+                const Instance& inst = _instances[_tlasOrder[i]];
+                nearInstance = inst.bmax.x >= bmin.x && inst.bmin.x <= bmax.x && inst.bmax.y >= bmin.y &&
+                               inst.bmin.y <= bmax.y && inst.bmax.z >= bmin.z && inst.bmin.z <= bmax.z;
+            }
+        });
+        if (!nearInstance) return moved;
+    }
+
+    return CapsuleSweep::slide(from, axisBottom, axisTop, delta, maxIterations,
+                               [this, radius](const Vec3& a, const Vec3& b, const Vec3& d, float& toi, Vec3& normal) {
+        return sweepCapsule(a, b, radius, d, toi, normal);
+    });
+}
@@ -0,0 +1,126 @@
+#ifndef __STATIC_COLLISION_WORLD_H__
+#define __STATIC_COLLISION_WORLD_H__
+
+#include "cocos2d.h"
+#include "Collider.h"
+#include "TerrainBVH.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class StaticCollisionWorld
+ * @brief 静态场景物件（房屋、桥、岩石、棚子）的两级碰撞世界，叠加在地形之上作为角色的地形查询
+ *
+ * 底层：每种物件一个模型空间的 TerrainCollider，多个实例共享同一份网格；
+ * 顶层：以实例的世界包围盒构建 BVH。查询先遍历顶层 BVH，再把射线 / 胶囊变换到实例的
+ * 模型空间交给底层网格求解，结果变换回世界空间。
+ *
+ * 实例变换限定为 位置 + 旋转 + 均匀缩放：射线参数、线段比例和扫掠的接触时间在这种变换下保持不变，
+ * 胶囊体变换后仍是胶囊体（半径按缩放比例变化）。
+ *
+ * TerrainQuery 的各个查询同时作用于地形（setTerrain 给出的整块或分块地形）与物件实例，取最近的结果：
+ * 贴地探测可以站上物件顶部，射线与线段被物件遮挡，沿墙滑动同时绕开地形与物件。
+ * 物件命中的 RayHit::triangle 为 -1（三角形属于物件网格，不在地形中）。
+ */
+class StaticCollisionWorld : public cocos2d::Ref, public TerrainQuery {
+public:
+    static StaticCollisionWorld* create();
+
+    virtual ~StaticCollisionWorld();
+
+    /**
+     * @brief 设置作为底层的地形查询（不持有引用，由场景持有），为空时只查询物件
+     */
+    void setTerrain(TerrainQuery* terrain) { _terrain = terrain; }
+    TerrainQuery* getTerrain() const { return _terrain; }
+
+    /**
+     * @brief 注册模型空间的碰撞网格，同一路径只加载一次
+     * @return int 网格 id，加载失败返回 -1
+     */
+    int addMesh(const std::string& objFilePath, TerrainCollider::AccelType accel = TerrainCollider::AccelType::BVH);
+
+    /**
+     * @brief 添加一个物件实例
+     * @param meshId addMesh 返回的网格 id
+     * @param position 世界坐标位置
+     * @param rotation 旋转
+     * @param scale 均匀缩放
+     * @return int 实例 id，网格 id 无效时返回 -1
+     */
+    int addInstance(int meshId, const cocos2d::Vec3& position,
+                    const cocos2d::Quaternion& rotation = cocos2d::Quaternion(0.0f, 0.0f, 0.0f, 1.0f),
+                    float scale = 1.0f);
+
+    /**
+     * @brief 重建顶层 BVH（添加实例后的首次查询也会自动调用）
+     */
+    void build();
+
+    /**
+     * @brief 只与物件实例求交的射线检测
+     * @param outInstance 可选输出：命中的实例 id
+     */
+    bool rayIntersectsInstances(const CustomRay& ray, float& hitDist, int* outInstance = nullptr);
+
+    bool rayIntersects(const CustomRay& ray, float& hitDist) override;
+    bool rayIntersects(const CustomRay& ray, RayHit& outHit) override;
+    bool segmentIntersects(const cocos2d::Vec3& from, const cocos2d::Vec3& to) override;
+    bool segmentIntersects(const cocos2d::Vec3& from, const cocos2d::Vec3& to, float& outFraction) override;
+    bool sweepCapsule(const cocos2d::Vec3& a, const cocos2d::Vec3& b, float radius, const cocos2d::Vec3& delta,
+                      float& toi, cocos2d::Vec3& normal) override;
+    cocos2d::Vec3 slideCapsule(const cocos2d::Vec3& from, const cocos2d::Vec3& axisBottom, const cocos2d::Vec3& axisTop,
+                               float radius, const cocos2d::Vec3& delta, int maxIterations = 2) override;
+    bool probeGround(const cocos2d::Vec3& origin, GroundCache& cache, RayHit& outHit) override;
+    int rayIntersectsBatch(const CustomRay* rays, int count, float* outHitDist, RayHit* outHits = nullptr) override;
+
+    int getMeshCount() const { return (int)_meshes.size(); }
+    int getInstanceCount() const { return (int)_instances.size(); }
+
+private:
+    struct Instance {
+        int mesh;
+        cocos2d::Vec3 position;
+        cocos2d::Quaternion rotation; ///< 已归一化
+        float scale;
+        cocos2d::Vec3 bmin, bmax;     ///< 世界包围盒
+    };
+
+    cocos2d::Vec3 toLocalPoint(const Instance& inst, const cocos2d::Vec3& p) const;
+    cocos2d::Vec3 toLocalVector(const Instance& inst, const cocos2d::Vec3& v) const;
+    cocos2d::Vec3 toWorldPoint(const Instance& inst, const cocos2d::Vec3& p) const;
+    cocos2d::Vec3 toWorldVector(const Instance& inst, const cocos2d::Vec3& v) const;
+
+    /**
+     * 在单个实例中求交，只接受 t < tMax 的交点（tMax 为 FLT_MAX 时按无限长射线处理）
+     */
+    bool raycastInstance(const Instance& inst, const cocos2d::Vec3& origin, const cocos2d::Vec3& dir,
+                         float tMax, bool anyHit, float& hitT);
+
+    bool raycast(const cocos2d::Vec3& origin, const cocos2d::Vec3& dir, float tMax, bool anyHit,
+                 float& hitT, int* hitInstance);
+
+    /**
+     * 射线在物件实例上的命中比 tMax 更近时写入 outHit（法线变换回世界空间）
+     */
+    bool raycastInstancesHit(const CustomRay& ray, float tMax, RayHit& outHit);
+
+    /**
+     * 只与物件实例做胶囊体扫掠
+     */
+    bool sweepInstances(const cocos2d::Vec3& a, const cocos2d::Vec3& b, float radius, const cocos2d::Vec3& delta,
+                        TerrainCollider::SweepHit& outHit);
+
+    TerrainQuery* _terrain = nullptr;
+
+    std::vector<TerrainCollider*> _meshes;               ///< 持有引用
+    std::unordered_map<std::string, int> _meshByPath;
+    std::vector<Instance> _instances;
+
+    TerrainBVH _tlas;
+    std::vector<int> _tlasOrder; ///< 顶层叶子区间 -> 实例 id
+    bool _dirty = false;
+};
+
+#endif // __STATIC_COLLISION_WORLD_H__
@@ -0,0 +1,190 @@
+#include "TerrainBVH.h"
+#include <algorithm>
+
+USING_NS_CC;
+
+namespace {
+
+const int kBinCount = 16;     ///< 每个轴的 SAH 分桶数量
+const int kMinLeafSize = 4;   ///< 图元数不超过该值时直接成为叶子（按批量宽度放大）
+const int kMaxLeafSize = 16;  ///< SAH 认为不值得再分时，叶子最多容纳的图元数（按批量宽度放大）
+const int kMaxDepth = 48;     ///< 深度上限，保证遍历栈不会溢出
+const float kTraversalCost = 1.0f; ///< 相对于一次三角形求交的遍历代价
+
+struct Bounds {
+    Vec3 bmin = Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vec3 bmax = Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    void grow(const Vec3& p) {
+        bmin.x = std::min(bmin.x, p.x); bmin.y = std::min(bmin.y, p.y); bmin.z = std::min(bmin.z, p.z);
+        bmax.x = std::max(bmax.x, p.x); bmax.y = std::max(bmax.y, p.y); bmax.z = std::max(bmax.z, p.z);
+    }
+    void grow(const Bounds& b) {
+        if (b.bmin.x > b.bmax.x) return;
+        grow(b.bmin);
+        grow(b.bmax);
+    }
+    float area() const {
+        if (bmin.x > bmax.x) return 0.0f;
+        Vec3 e = bmax - bmin;
+        return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+};
+
+inline float axisOf(const Vec3& v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+/**
+ * 递归构建上下文：持有图元数据与正在重排的下标数组
+ */
+struct Builder {
+    const std::vector<TerrainBVH::Prim>& prims;
+    std::vector<Vec3> centroids;
+    std::vector<int>& order;
+    std::vector<TerrainBVH::Node>& nodes;
+    int packet;
+    int minLeafSize;
+    int maxLeafSize;
+
+    Builder(const std::vector<TerrainBVH::Prim>& p, std::vector<int>& o, std::vector<TerrainBVH::Node>& n, int leafPacket)
+        : prims(p), order(o), nodes(n), packet(std::max(1, leafPacket)),
+          minLeafSize(std::max(kMinLeafSize, packet)), maxLeafSize(std::max(kMaxLeafSize, packet * 2)) {
+        centroids.resize(prims.size());
+        for (size_t i = 0; i < prims.size(); ++i) {
+            centroids[i] = (prims[i].bmin + prims[i].bmax) * 0.5f;
+        }
+    }
+
+    /// 叶子求交代价：一次处理 packet 个图元，不足一批也按一批计
+    float packets(int count) const {
+        return (float)((count + packet - 1) / packet);
+    }
+
+    void makeLeaf(int nodeIdx, int first, int count) {
+        nodes[nodeIdx].leftOrFirst = first;
+        nodes[nodeIdx].count = count;
+    }
+
+    void subdivide(int nodeIdx, int first, int count, int depth) {
+        // 1. 计算节点包围盒与质心包围盒
+        Bounds bounds, centroidBounds;
+        for (int i = first; i < first + count; ++i) {
+            const auto& p = prims[order[i]];
+            bounds.grow(p.bmin);
+            bounds.grow(p.bmax);
+            centroidBounds.grow(centroids[order[i]]);
+        }
+
+        TerrainBVH::Node& node = nodes[nodeIdx];
+        node.bmin[0] = bounds.bmin.x; node.bmin[1] = bounds.bmin.y; node.bmin[2] = bounds.bmin.z;
+        node.bmax[0] = bounds.bmax.x; node.bmax[1] = bounds.bmax.y; node.bmax[2] = bounds.bmax.z;
+
+        if (count <= minLeafSize || depth >= kMaxDepth) {
+            makeLeaf(nodeIdx, first, count);
+            return;
+        }
+
+        // 2. 在三个轴上分桶评估 SAH 代价，寻找最优划分
+        int bestAxis = -1;
+        int bestSplit = -1;
+        float bestCost = FLT_MAX;
+
+        for (int axis = 0; axis < 3; ++axis) {
+            float cMin = axisOf(centroidBounds.bmin, axis);
+            float cMax = axisOf(centroidBounds.bmax, axis);
+            if (cMax - cMin < 1e-6f) continue; // 该轴上质心重合，无法划分
+
+            int binCounts[kBinCount] = {0};
+            Bounds binBounds[kBinCount];
+            float scale = kBinCount / (cMax - cMin);
+
+            for (int i = first; i < first + count; ++i) {
+                int b = std::min(kBinCount - 1, (int)((axisOf(centroids[order[i]], axis) - cMin) * scale));
+                binCounts[b]++;
+                binBounds[b].grow(prims[order[i]].bmin);
+                binBounds[b].grow(prims[order[i]].bmax);
+            }
+
+            // 从右往左累积，得到每个划分面右侧的面积与数量
+            float rightArea[kBinCount - 1];
+            int rightCount[kBinCount - 1];
+            Bounds acc;
+            int accCount = 0;
+            for (int b = kBinCount - 1; b > 0; --b) {
+                acc.grow(binBounds[b]);
+                accCount += binCounts[b];
+                rightArea[b - 1] = acc.area();
+                rightCount[b - 1] = accCount;
+            }
+
+            acc = Bounds();
+            accCount = 0;
+            for (int b = 0; b < kBinCount - 1; ++b) {
+                acc.grow(binBounds[b]);
+                accCount += binCounts[b];
+                if (accCount == 0 || rightCount[b] == 0) continue;
+                float cost = acc.area() * packets(accCount) + rightArea[b] * packets(rightCount[b]);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+
+        // 3. 与"不划分"的代价比较
+        float parentArea = bounds.area();
+        float leafCost = packets(count);
+        float splitCost = parentArea > 0.0f ? kTraversalCost + bestCost / parentArea : FLT_MAX;
+
+        int mid = first;
+        if (bestAxis >= 0 && (splitCost < leafCost || count > maxLeafSize)) {
+            float cMin = axisOf(centroidBounds.bmin, bestAxis);
+            float cMax = axisOf(centroidBounds.bmax, bestAxis);
+            float scale = kBinCount / (cMax - cMin);
+            auto it = std::partition(order.begin() + first, order.begin() + first + count, [&](int idx) {
+                int b = std::min(kBinCount - 1, (int)((axisOf(centroids[idx], bestAxis) - cMin) * scale));
+                return b <= bestSplit;
+            });
+            mid = (int)(it - order.begin());
+        } else if (count > maxLeafSize) {
+            // 质心完全重合（退化情况）：按下标中点强制划分，避免出现超大叶子
+            mid = first + count / 2;
+        } else {
+            makeLeaf(nodeIdx, first, count);
+            return;
+        }
+
+        if (mid == first || mid == first + count) {
+            mid = first + count / 2;
+        }
+
+        // 4. 兄弟节点成对分配，然后递归
+        int leftIdx = (int)nodes.size();
+        nodes.push_back(TerrainBVH::Node());
+        nodes.push_back(TerrainBVH::Node());
+        nodes[nodeIdx].leftOrFirst = leftIdx;
+        nodes[nodeIdx].count = 0;
+
+        subdivide(leftIdx, first, mid - first, depth + 1);
+        subdivide(leftIdx + 1, mid, first + count - mid, depth + 1);
+    }
+};
+
+} // namespace
+
+void TerrainBVH::build(const std::vector<Prim>& prims, std::vector<int>& outOrder, int leafPacket) {
+    _nodes.clear();
+    outOrder.resize(prims.size());
+    for (size_t i = 0; i < prims.size(); ++i) outOrder[i] = (int)i;
+    if (prims.empty()) return;
+
+    // 满二叉树节点数上界为 2N - 1
+    _nodes.reserve(prims.size() * 2);
+    _nodes.push_back(Node());
+
+    Builder builder(prims, outOrder, _nodes, leafPacket);
+    builder.subdivide(0, 0, (int)prims.size(), 0);
+    _nodes.shrink_to_fit();
+}
@@ -0,0 +1,189 @@
+#ifndef __TERRAIN_BVH_H__
+#define __TERRAIN_BVH_H__
+
+#include "cocos2d.h"
+#include <vector>
+#include <utility>
+#include <float.h>
+
+/**
+ * @class TerrainBVH
+ * @brief 基于 SAH（表面积启发式）构建的层次包围盒，节点以扁平数组存储
+ *
+ * 根节点位于下标 0，兄弟节点成对连续存放：左孩子下标由 leftOrFirst 给出，右孩子为
+ * leftOrFirst + 1。叶子节点引用一段连续的图元区间 [first, first + count)，
+ * 构建时会输出图元的重排顺序，调用方需按该顺序重排自己的三角形数组。
+ */
+class TerrainBVH {
+public:
+    /**
+     * @brief 扁平节点（32 字节，两个节点正好占一条 64 字节缓存行）
+     */
+    struct Node {
+        float bmin[3];
+        int leftOrFirst; ///< 内部节点：左孩子下标；叶子节点：首个图元下标
+        float bmax[3];
+        int count;       ///< 0 表示内部节点，>0 表示叶子中的图元数量
+
+        bool isLeaf() const { return count > 0; }
+    };
+
+    /**
+     * @brief 构建输入：单个图元的包围盒
+     */
+    struct Prim {
+        cocos2d::Vec3 bmin;
+        cocos2d::Vec3 bmax;
+    };
+
+    /**
+     * @brief 使用分桶 SAH 构建 BVH
+     * @param prims 图元包围盒列表
+     * @param outOrder 输出：重排后的图元顺序，outOrder[i] 为第 i 个位置对应的原始下标
+     * @param leafPacket 叶子求交的批量宽度（SIMD 通道数），SAH 按 ceil(count / leafPacket) 计算叶子代价
+     */
+    void build(const std::vector<Prim>& prims, std::vector<int>& outOrder, int leafPacket = 1);
+
+    /**
+     * @brief 清空所有节点
+     */
+    void clear() { _nodes.clear(); }
+
+    /**
+     * @brief 直接载入已构建好的节点（来自碰撞缓存），图元须已按构建时的顺序排列
+     */
+    void assign(const Node* nodes, size_t count) { _nodes.assign(nodes, nodes + count); }
+
+    bool empty() const { return _nodes.empty(); }
+
+    const std::vector<Node>& getNodes() const { return _nodes; }
+
+    /**
+     * @brief 射线遍历，按由近到远的顺序访问与射线相交的叶子
+     * @param origin 射线起点
+     * @param dir 射线方向（无需归一化）
+     * @param tMax 输入/输出：当前最近命中参数，叶子回调命中后会被缩小
+     * @param leafFn 叶子回调 bool(int first, int count, float& tMax)，命中返回 true
+     * @param anyHit 为 true 时首个叶子命中后立即返回（遮挡查询），此时 tMax 不一定是最近命中
+     * @return bool 是否有任意叶子报告命中
+     */
+    template <typename LeafFn>
+    bool raycast(const cocos2d::Vec3& origin, const cocos2d::Vec3& dir, float& tMax, LeafFn leafFn,
+                 bool anyHit = false) const;
+
+    /**
+     * @brief 包围盒重叠查询，访问所有与 [bmin, bmax] 相交的叶子（用于扫掠等形状查询的粗筛）
+     * @param leafFn 叶子回调 void(int first, int count)
+     */
+    template <typename LeafFn>
+    void overlap(const cocos2d::Vec3& bmin, const cocos2d::Vec3& bmax, LeafFn leafFn) const;
+
+private:
+    static bool slabTest(const Node& node, const float o[3], const float invD[3], float tMax, float& tNear);
+
+    std::vector<Node> _nodes;
+};
+
+inline bool TerrainBVH::slabTest(const Node& node, const float o[3], const float invD[3], float tMax, float& tNear) {
+    float t0 = 0.0f;
+    float t1 = tMax;
+    for (int a = 0; a < 3; ++a) {
+        float tA = (node.bmin[a] - o[a]) * invD[a];
+        float tB = (node.bmax[a] - o[a]) * invD[a];
+        if (tA > tB) std::swap(tA, tB);
+        // 射线平行于该轴时 invD 取 ±FLT_MAX（有限值），0 * FLT_MAX 仍为 0，不会产生 NaN
+        if (tA > t0) t0 = tA;
+        if (tB < t1) t1 = tB;
+        if (t0 > t1) return false;
+    }
+    tNear = t0;
+    return true;
+}
+
+template <typename LeafFn>
+bool TerrainBVH::raycast(const cocos2d::Vec3& origin, const cocos2d::Vec3& dir, float& tMax, LeafFn leafFn,
+                         bool anyHit) const {
+    if (_nodes.empty()) return false;
+
+    const float o[3] = {origin.x, origin.y, origin.z};
+    const float d[3] = {dir.x, dir.y, dir.z};
+    float invD[3];
+    for (int a = 0; a < 3; ++a) {
+        invD[a] = (d[a] > 1e-12f || d[a] < -1e-12f) ? 1.0f / d[a] : (d[a] >= 0.0f ? FLT_MAX : -FLT_MAX);
+    }
+
+    float tNear;
+    if (!slabTest(_nodes[0], o, invD, tMax, tNear)) return false;
+
+    // 固定大小的遍历栈，SAH 构建的树深度远小于 64
+    int stack[64];
+    int sp = 0;
+    stack[sp++] = 0;
+    bool hit = false;
+
+    while (sp > 0) {
+        const Node& node = _nodes[stack[--sp]];
+
+        if (node.isLeaf()) {
+            if (leafFn(node.leftOrFirst, node.count, tMax)) {
+                if (anyHit) return true;
+                hit = true;
+            }
+            continue;
+        }
+
+        const int left = node.leftOrFirst;
+        const int right = left + 1;
+        float tL, tR;
+        bool hitL = slabTest(_nodes[left], o, invD, tMax, tL);
+        bool hitR = slabTest(_nodes[right], o, invD, tMax, tR);
+
+        // 先压远的，再压近的，保证近的先出栈，便于尽早缩小 tMax
+        if (hitL && hitR) {
+            if (tL <= tR) {
+                stack[sp++] = right;
+                stack[sp++] = left;
+            } else {
+                stack[sp++] = left;
+                stack[sp++] = right;
+            }
+        } else if (hitL) {
+            stack[sp++] = left;
+        } else if (hitR) {
+            stack[sp++] = right;
+        }
+    }
+    return hit;
+}
+
+template <typename LeafFn>
+void TerrainBVH::overlap(const cocos2d::Vec3& bmin, const cocos2d::Vec3& bmax, LeafFn leafFn) const {
+    if (_nodes.empty()) return;
+
+    const float qmin[3] = {bmin.x, bmin.y, bmin.z};
+    const float qmax[3] = {bmax.x, bmax.y, bmax.z};
+    auto overlaps = [&](const Node& node) {
+        for (int a = 0; a < 3; ++a) {
+            if (node.bmax[a] < qmin[a] || node.bmin[a] > qmax[a]) return false;
+        }
+        return true;
+    };
+
+    if (!overlaps(_nodes[0])) return;
+    int stack[64];
+    int sp = 0;
+    stack[sp++] = 0;
+
+    while (sp > 0) {
+        const Node& node = _nodes[stack[--sp]];
+        if (node.isLeaf()) {
+            leafFn(node.leftOrFirst, node.count);
+            continue;
+        }
+        const int left = node.leftOrFirst;
+        if (overlaps(_nodes[left])) stack[sp++] = left;
+        if (overlaps(_nodes[left + 1])) stack[sp++] = left + 1;
+    }
+}
+
+#endif // __TERRAIN_BVH_H__
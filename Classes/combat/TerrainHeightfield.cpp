@@ -0,0 +1,332 @@
+#include "TerrainHeightfield.h"
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+
+USING_NS_CC;
+
+constexpr float TerrainHeightfield::kMaxError;
+const uint8_t TerrainHeightfield::kCellDiscontinuous;
+const uint8_t TerrainHeightfield::kCellSteep;
+
+namespace {
+
+const int kMaxSamplesPerAxis = 1024;
+const uint8_t kOverflow = 0xFF;       ///< 采样点层数超过 kMaxLayers
+const float kMergeEpsilon = 1e-3f;    ///< 相邻三角形共享边上的重复高度
+const float kInsideEpsilon = 1e-6f;
+
+/**
+ * @brief 烘焙期间使用的半步长采样网格
+ *
+ * 偶数坐标点是最终保存的采样点，奇数坐标点是单元格边中点与中心，只用于校验插值误差。
+ */
+struct BakeGrid {
+    int cols = 0;
+    int rows = 0;
+    std::vector<uint8_t> counts;
+    std::vector<float> heights;  ///< 每点 kMaxLayers 个槽位
+
+    int index(int px, int pz) const { return pz * cols + px; }
+
+    void insert(int idx, float h) {
+        uint8_t& n = counts[idx];
+        if (n == kOverflow) return;
+        float* slots = &heights[(size_t)idx * TerrainHeightfield::kMaxLayers];
+        for (int k = 0; k < n; ++k) {
+            if (std::fabs(slots[k] - h) < kMergeEpsilon) return;
+        }
+        if (n == TerrainHeightfield::kMaxLayers) {
+            n = kOverflow;
+            return;
+        }
+        // 插入排序，保持从高到低
+        int k = n++;
+        while (k > 0 && slots[k - 1] < h) {
+            slots[k] = slots[k - 1];
+            --k;
+        }
+        slots[k] = h;
+    }
+};
+
+/**
+ * @brief 三角形在 XZ 平面上的投影是否与矩形相交（分离轴测试）
+ */
+bool triangleOverlapsRect(const Vec3* v, float x0, float z0, float x1, float z1) {
+    for (int e = 0; e < 3; ++e) {
+        const Vec3& a = v[e];
+        const Vec3& b = v[(e + 1) % 3];
+        const Vec3& c = v[(e + 2) % 3];
+        // 边的法线方向，取指向第三个顶点的一侧
+        float nx = b.z - a.z;
+        float nz = a.x - b.x;
+        float side = nx * (c.x - a.x) + nz * (c.z - a.z);
+        if (side < 0.0f) {
+            nx = -nx;
+            nz = -nz;
+        }
+        // 矩形在法线方向上的最大投影仍位于边外侧，则分离
+        float px = nx >= 0.0f ? x1 : x0;
+        float pz = nz >= 0.0f ? z1 : z0;
+        if (nx * (px - a.x) + nz * (pz - a.z) < 0.0f) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void TerrainHeightfield::clear() {
+    _header = Header();
+    _counts.clear();
+    _heights.clear();
+    _cellFlags.clear();
+}
+
+bool TerrainHeightfield::bake(const std::vector<Vec3>& triangleVertices, float cellSize, float walkableNormalY) {
+    clear();
+
+    const int triCount = (int)(triangleVertices.size() / 3);
+    if (triCount == 0) return false;
+
+    float minX = FLT_MAX, minZ = FLT_MAX, maxX = -FLT_MAX, maxZ = -FLT_MAX;
+    double extentSum = 0.0;
+    for (int t = 0; t < triCount; ++t) {
+        const Vec3* v = &triangleVertices[t * 3];
+        float tMinX = std::min(v[0].x, std::min(v[1].x, v[2].x));
+        float tMaxX = std::max(v[0].x, std::max(v[1].x, v[2].x));
+        float tMinZ = std::min(v[0].z, std::min(v[1].z, v[2].z));
+        float tMaxZ = std::max(v[0].z, std::max(v[1].z, v[2].z));
+        minX = std::min(minX, tMinX);
+        maxX = std::max(maxX, tMaxX);
+        minZ = std::min(minZ, tMinZ);
+        maxZ = std::max(maxZ, tMaxZ);
+        extentSum += std::max(tMaxX - tMinX, tMaxZ - tMinZ);
+    }
+
+    const float width = maxX - minX;
+    const float depth = maxZ - minZ;
+    const float span = std::max(width, depth);
+    if (span <= 0.0f) return false;
+
+    // 单元格取三角形平均尺寸的一半，大多数单元格内最多只有一条折边，插值误差小
+    if (cellSize <= 0.0f) {
+        cellSize = (float)(extentSum / triCount) * 0.5f;
+    }
+    cellSize = std::max(cellSize, span / kMaxSamplesPerAxis);
+    cellSize = std::min(cellSize, span / 16.0f);
+
+    const int cols = std::max(1, (int)std::ceil(width / cellSize));
+    const int rows = std::max(1, (int)std::ceil(depth / cellSize));
+    const float half = cellSize * 0.5f;
+
+    // 1. 将所有三角形光栅化到半步长采样网格上，收集每个点的全部表面高度
+    BakeGrid grid;
+    grid.cols = cols * 2 + 1;
+    grid.rows = rows * 2 + 1;
+    grid.counts.assign((size_t)grid.cols * grid.rows, 0);
+    grid.heights.assign(grid.counts.size() * kMaxLayers, 0.0f);
+
+    for (int t = 0; t < triCount; ++t) {
+        const Vec3* v = &triangleVertices[t * 3];
+        const float e1x = v[1].x - v[0].x, e1z = v[1].z - v[0].z;
+        const float e2x = v[2].x - v[0].x, e2z = v[2].z - v[0].z;
+        const float area2 = e1x * e2z - e1z * e2x;
+        // 竖直的墙面不会被竖直射线命中
+        if (std::fabs(area2) < 1e-8f) continue;
+        const float invArea = 1.0f / area2;
+        const float e1y = v[1].y - v[0].y, e2y = v[2].y - v[0].y;
+
+        float tMinX = std::min(v[0].x, std::min(v[1].x, v[2].x));
+        float tMaxX = std::max(v[0].x, std::max(v[1].x, v[2].x));
+        float tMinZ = std::min(v[0].z, std::min(v[1].z, v[2].z));
+        float tMaxZ = std::max(v[0].z, std::max(v[1].z, v[2].z));
+        int px0 = std::max(0, (int)std::ceil((tMinX - minX) / half - 1e-4f));
+        int px1 = std::min(grid.cols - 1, (int)std::floor((tMaxX - minX) / half + 1e-4f));
+        int pz0 = std::max(0, (int)std::ceil((tMinZ - minZ) / half - 1e-4f));
+        int pz1 = std::min(grid.rows - 1, (int)std::floor((tMaxZ - minZ) / half + 1e-4f));
+
+        for (int pz = pz0; pz <= pz1; ++pz) {
+            const float dz = minZ + pz * half - v[0].z;
+            for (int px = px0; px <= px1; ++px) {
+                const float dx = minX + px * half - v[0].x;
+                const float u = (dx * e2z - dz * e2x) * invArea;
+                const float w = (e1x * dz - e1z * dx) * invArea;
+                if (u < -kInsideEpsilon || w < -kInsideEpsilon || u + w > 1.0f + kInsideEpsilon) continue;
+                grid.insert(grid.index(px, pz), v[0].y + u * e1y + w * e2y);
+            }
+        }
+    }
+
+    // 2. 逐单元格校验：九个点层数一致，且各层在边中点、中心处的插值误差不超过 kMaxError
+    std::vector<uint8_t> flags((size_t)cols * rows, 0);
+    // 每层在单元格九个点上的高度范围，第 3 步用来匹配单元格内的三角形
+    std::vector<float> layerMin((size_t)cols * rows * kMaxLayers, FLT_MAX);
+    std::vector<float> layerMax((size_t)cols * rows * kMaxLayers, -FLT_MAX);
+    int maxLayers = 0;
+
+    for (int j = 0; j < rows; ++j) {
+        for (int i = 0; i < cols; ++i) {
+            const size_t cell = (size_t)j * cols + i;
+            const int cx = i * 2, cz = j * 2;
+            const int layers = grid.counts[grid.index(cx, cz)];
+
+            bool ok = layers != kOverflow;
+            for (int dz = 0; dz <= 2 && ok; ++dz) {
+                for (int dx = 0; dx <= 2 && ok; ++dx) {
+                    ok = grid.counts[grid.index(cx + dx, cz + dz)] == layers;
+                }
+            }
+            if (!ok) {
+                flags[cell] |= kCellDiscontinuous;
+                continue;
+            }
+            maxLayers = std::max(maxLayers, layers);
+
+            for (int k = 0; k < layers && ok; ++k) {
+                auto h = [&](int dx, int dz) {
+                    return grid.heights[(size_t)grid.index(cx + dx, cz + dz) * kMaxLayers + k];
+                };
+                const float h00 = h(0, 0), h10 = h(2, 0), h01 = h(0, 2), h11 = h(2, 2);
+                const float checks[5][3] = {
+                    {0.5f, 0.0f, h(1, 0)}, {0.0f, 0.5f, h(0, 1)}, {1.0f, 0.5f, h(2, 1)},
+                    {0.5f, 1.0f, h(1, 2)}, {0.5f, 0.5f, h(1, 1)},
+                };
+                for (const auto& c : checks) {
+                    float a = h00 + (h10 - h00) * c[0];
+                    float b = h01 + (h11 - h01) * c[0];
+                    if (std::fabs(a + (b - a) * c[1] - c[2]) > kMaxError) {
+                        ok = false;
+                        break;
+                    }
+                }
+
+                float& lo = layerMin[cell * kMaxLayers + k];
+                float& hi = layerMax[cell * kMaxLayers + k];
+                for (int dz = 0; dz <= 2; ++dz) {
+                    for (int dx = 0; dx <= 2; ++dx) {
+                        lo = std::min(lo, h(dx, dz));
+                        hi = std::max(hi, h(dx, dz));
+                    }
+                }
+            }
+            if (!ok) flags[cell] |= kCellDiscontinuous;
+        }
+    }
+
+    // 3. 采样点之间可能藏着小物件或窄条表面：与单元格相交的每个三角形，
+    //    其在单元格内的高度范围必须落在某一层的范围内，否则该单元格走精确求交；
+    //    同时标记含有过陡三角形的单元格
+    for (int t = 0; t < triCount; ++t) {
+        const Vec3* v = &triangleVertices[t * 3];
+        const float e1x = v[1].x - v[0].x, e1z = v[1].z - v[0].z;
+        const float e2x = v[2].x - v[0].x, e2z = v[2].z - v[0].z;
+        const float area2 = e1x * e2z - e1z * e2x;
+        if (std::fabs(area2) < 1e-8f) continue;
+        const float invArea = 1.0f / area2;
+        const float e1y = v[1].y - v[0].y, e2y = v[2].y - v[0].y;
+        auto planeY = [&](float x, float z) {
+            const float dx = x - v[0].x, dz = z - v[0].z;
+            return v[0].y + (dx * e2z - dz * e2x) * invArea * e1y + (e1x * dz - e1z * dx) * invArea * e2y;
+        };
+
+        float tMinX = std::min(v[0].x, std::min(v[1].x, v[2].x));
+        float tMaxX = std::max(v[0].x, std::max(v[1].x, v[2].x));
+        float tMinZ = std::min(v[0].z, std::min(v[1].z, v[2].z));
+        float tMaxZ = std::max(v[0].z, std::max(v[1].z, v[2].z));
+        float tMinY = std::min(v[0].y, std::min(v[1].y, v[2].y));
+        float tMaxY = std::max(v[0].y, std::max(v[1].y, v[2].y));
+        Vec3 n;
+        Vec3::cross(v[1] - v[0], v[2] - v[0], &n);
+        const bool steep = std::fabs(n.y) < walkableNormalY * n.length();
+        int i0 = std::max(0, (int)((tMinX - minX) / cellSize));
+        int i1 = std::min(cols - 1, (int)((tMaxX - minX) / cellSize));
+        int j0 = std::max(0, (int)((tMinZ - minZ) / cellSize));
+        int j1 = std::min(rows - 1, (int)((tMaxZ - minZ) / cellSize));
+
+        for (int j = j0; j <= j1; ++j) {
+            for (int i = i0; i <= i1; ++i) {
+                const size_t cell = (size_t)j * cols + i;
+                if (flags[cell] & kCellDiscontinuous) continue;
+
+                const float x0 = minX + i * cellSize, x1 = x0 + cellSize;
+                const float z0 = minZ + j * cellSize, z1 = z0 + cellSize;
+                if (!triangleOverlapsRect(v, x0, z0, x1, z1)) continue;
+                if (steep) flags[cell] |= kCellSteep;
+
+                // 平面是线性的，三角形与矩形交集上的极值出现在其顶点上：
+                // 落在矩形内的三角形顶点，或矩形边上的点（不超过矩形角点处的平面值）
+                float lo = FLT_MAX, hi = -FLT_MAX;
+                const float corners[4][2] = {{x0, z0}, {x1, z0}, {x0, z1}, {x1, z1}};
+                for (const auto& c : corners) {
+                    float y = planeY(c[0], c[1]);
+                    lo = std::min(lo, y);
+                    hi = std::max(hi, y);
+                }
+                lo = std::max(lo, tMinY);
+                hi = std::min(hi, tMaxY);
+
+                const int layers = grid.counts[grid.index(i * 2, j * 2)];
+                bool matched = false;
+                for (int k = 0; k < layers && !matched; ++k) {
+                    matched = lo >= layerMin[cell * kMaxLayers + k] - kMaxError &&
+                              hi <= layerMax[cell * kMaxLayers + k] + kMaxError;
+                }
+                if (!matched) flags[cell] |= kCellDiscontinuous;
+            }
+        }
+    }
+
+    // 4. 只保留偶数坐标点作为最终采样点
+    _header.minX = minX;
+    _header.minZ = minZ;
+    _header.cellSize = cellSize;
+    _header.cols = cols;
+    _header.rows = rows;
+    _header.layers = maxLayers;
+
+    const size_t sampleCount = (size_t)(cols + 1) * (rows + 1);
+    _counts.assign(sampleCount, 0);
+    _heights.assign(sampleCount * maxLayers, 0.0f);
+    for (int j = 0; j <= rows; ++j) {
+        for (int i = 0; i <= cols; ++i) {
+            const int src = grid.index(i * 2, j * 2);
+            const int dst = sampleIndex(i, j);
+            const int n = grid.counts[src] == kOverflow ? 0 : std::min<int>(grid.counts[src], maxLayers);
+            _counts[dst] = (uint8_t)n;
+            for (int k = 0; k < n; ++k) {
+                _heights[sampleCount * k + dst] = grid.heights[(size_t)src * kMaxLayers + k];
+            }
+        }
+    }
+    _cellFlags.swap(flags);
+    return true;
+}
+
+bool TerrainHeightfield::assign(const Header& header, const uint8_t* counts, size_t countSize,
+                                const float* heights, size_t heightCount,
+                                const uint8_t* cellFlags, size_t flagSize) {
+    clear();
+    if (header.cols <= 0 || header.rows <= 0 || header.cellSize <= 0.0f ||
+        header.layers < 0 || header.layers > kMaxLayers) {
+        return false;
+    }
+    const size_t sampleCount = (size_t)(header.cols + 1) * (header.rows + 1);
+    if (countSize != sampleCount || heightCount != sampleCount * header.layers ||
+        flagSize != (size_t)header.cols * header.rows) {
+        return false;
+    }
+
+    _header = header;
+    _counts.assign(counts, counts + countSize);
+    _heights.assign(heights, heights + heightCount);
+    _cellFlags.assign(cellFlags, cellFlags + flagSize);
+    return true;
+}
+
+float TerrainHeightfield::getFastCellRatio() const {
+    if (_cellFlags.empty()) return 0.0f;
+    size_t fast = std::count_if(_cellFlags.begin(), _cellFlags.end(),
+                                [](uint8_t flags) { return !(flags & kCellDiscontinuous); });
+    return (float)fast / (float)_cellFlags.size();
+}
@@ -0,0 +1,141 @@
+#ifndef __TERRAIN_HEIGHTFIELD_H__
+#define __TERRAIN_HEIGHTFIELD_H__
+
+#include "cocos2d.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class TerrainHeightfield
+ * @brief 加载时由三角形烘焙出的多层高度场，用于竖直向下射线的 O(1) 查询
+ *
+ * 在 XZ 规则网格的每个采样点上记录所有经过该点的表面高度（从高到低，最多 kMaxLayers 层），
+ * 桥面、悬空平台等重叠结构占用额外的层。查询时对所在单元格四角做双线性插值。
+ *
+ * 烘焙时逐单元格校验：四角与五个内部校验点的层数必须一致，插值误差不超过 kMaxError，
+ * 且单元格内每个三角形的高度范围都能对应到某一层。校验失败的单元格（层边缘、陡坡、小物件等）
+ * 标记为不连续，查询时返回 Probe::Exact，由调用方回退到精确的三角形求交。
+ */
+class TerrainHeightfield {
+public:
+    static const int kMaxLayers = 4;
+
+    /// 单元格标记位
+    static const uint8_t kCellDiscontinuous = 1; ///< 校验失败，任何查询都需要精确求交
+    static const uint8_t kCellSteep = 2;         ///< 含有比可站立坡度更陡的三角形，需要法线的查询走精确求交
+    static constexpr float kMaxError = 1.0f; ///< 烘焙校验的插值误差容限（世界单位），校验点之间的误差可能略大
+
+    /**
+     * @brief 竖直查询结果
+     */
+    enum class Probe {
+        Hit,   ///< 找到起点下方的地面
+        Miss,  ///< 起点下方没有地面
+        Exact  ///< 位于不连续区域或高度过于接近起点，需要精确求交
+    };
+
+    /**
+     * @brief 网格参数（也作为碰撞缓存中的段头）
+     */
+    struct Header {
+        float minX = 0.0f;
+        float minZ = 0.0f;
+        float cellSize = 0.0f;
+        int32_t cols = 0;
+        int32_t rows = 0;
+        int32_t layers = 0;    ///< 实际使用的最大层数
+    };
+
+    /**
+     * @brief 由三角形烘焙高度场
+     * @param triangleVertices 三角形顶点（世界坐标），每 3 个为一个三角形
+     * @param cellSize 单元格边长，<= 0 时取三角形平均尺寸的一半
+     * @param walkableNormalY 可站立地面法线 y 分量的下限，单元格内有更陡的三角形时标记 kCellSteep
+     * @return bool 是否烘焙成功
+     */
+    bool bake(const std::vector<cocos2d::Vec3>& triangleVertices, float cellSize = 0.0f, float walkableNormalY = 0.0f);
+
+    /**
+     * @brief 从 origin 竖直向下查询最近的地面高度
+     * @param origin 射线起点
+     * @param outHeight 输出：地面高度（仅 Probe::Hit 时有效）
+     * @param outNormal 可选输出：插值曲面在该点的单位法线（由双线性插值的梯度求得，仅 Probe::Hit 时有效）。
+     *                  给出时 kCellSteep 单元格返回 Probe::Exact，快速路径上的法线只出现在全部可站立的单元格中
+     */
+    Probe probeDown(const cocos2d::Vec3& origin, float& outHeight, cocos2d::Vec3* outNormal = nullptr) const;
+
+    void clear();
+    bool empty() const { return _header.cols == 0; }
+
+    // 缓存读写
+    const Header& getHeader() const { return _header; }
+    const std::vector<uint8_t>& getLayerCounts() const { return _counts; }
+    const std::vector<float>& getHeights() const { return _heights; }
+    const std::vector<uint8_t>& getCellFlags() const { return _cellFlags; }
+
+    /**
+     * @brief 直接载入缓存中的高度场数据，长度不匹配时返回 false
+     */
+    bool assign(const Header& header, const uint8_t* counts, size_t countSize,
+                const float* heights, size_t heightCount, const uint8_t* cellFlags, size_t flagSize);
+
+    /// 快速路径覆盖的单元格比例（0~1）
+    float getFastCellRatio() const;
+
+private:
+    int sampleIndex(int i, int j) const { return j * (_header.cols + 1) + i; }
+
+    Header _header;
+    std::vector<uint8_t> _counts;    ///< 每个采样点的层数
+    std::vector<float> _heights;     ///< 按层连续存放：heights[layer * sampleCount + sample]
+    std::vector<uint8_t> _cellFlags; ///< 每个单元格的 kCellDiscontinuous / kCellSteep 标记
+};
+
+inline TerrainHeightfield::Probe TerrainHeightfield::probeDown(const cocos2d::Vec3& origin, float& outHeight,
+                                                               cocos2d::Vec3* outNormal) const {
+    const float fx = (origin.x - _header.minX) / _header.cellSize;
+    const float fz = (origin.z - _header.minZ) / _header.cellSize;
+    if (!(fx >= 0.0f && fz >= 0.0f && fx < (float)_header.cols && fz < (float)_header.rows)) {
+        return Probe::Exact;
+    }
+
+    const int i = (int)fx;
+    const int j = (int)fz;
+    const uint8_t flags = _cellFlags[j * _header.cols + i];
+    if ((flags & kCellDiscontinuous) || (outNormal && (flags & kCellSteep))) return Probe::Exact;
+
+    const float tx = fx - (float)i;
+    const float tz = fz - (float)j;
+    const int s00 = sampleIndex(i, j);
+    const int s01 = s00 + _header.cols + 1;
+    const int layers = _counts[s00];
+    const size_t stride = _counts.size();
+
+    // 各层从高到低排列，返回第一层位于起点下方的表面
+    for (int k = 0; k < layers; ++k) {
+        const float* h = _heights.data() + stride * k;
+        const float h0 = h[s00] + (h[s00 + 1] - h[s00]) * tx;
+        const float h1 = h[s01] + (h[s01 + 1] - h[s01]) * tx;
+        const float height = h0 + (h1 - h0) * tz;
+
+        const float gap = origin.y - height;
+        if (gap > kMaxError) {
+            outHeight = height;
+            if (outNormal) {
+                // 双线性曲面的梯度：dh/dx 取两条 X 向边斜率按 tz 插值，dh/dz 即 h1 - h0
+                const float dx = ((h[s00 + 1] - h[s00]) * (1.0f - tz) + (h[s01 + 1] - h[s01]) * tz) / _header.cellSize;
+                const float dz = (h1 - h0) / _header.cellSize;
+                *outNormal = cocos2d::Vec3(-dx, 1.0f, -dz);
+                outNormal->normalize();
+            }
+            return Probe::Hit;
+        }
+        if (gap >= -kMaxError) {
+            // 起点几乎贴着表面，插值误差可能改变命中与否
+            return Probe::Exact;
+        }
+    }
+    return Probe::Miss;
+}
+
+#endif // __TERRAIN_HEIGHTFIELD_H__
@@ -0,0 +1,572 @@
+#include "TerrainStreamer.h"
+#include "CapsuleSweep.h"
+#include "GroundProbeBatch.h"
+#include "core/AreaManager.h"
+#include "3d/CCSprite3D.h"
+#include "base/CCAsyncTaskPool.h"
+#include <cmath>
+#include <float.h>
+#include <sstream>
+
+USING_NS_CC;
+
+namespace {
+
+const float kSelectInterval = 0.25f;  ///< 重新挑选驻留分块的间隔（秒）
+const int kMaxConcurrentLoads = 2;    ///< 同时在后台构建的碰撞网格数量，避免远处分块抢占近处分块
+
+inline bool isVerticalDown(const Vec3& dir) {
+    return dir.x == 0.0f && dir.z == 0.0f && dir.y < 0.0f;
+}
+
+/// 未驻留分块上竖直射线的"原地支撑"距离：命中点位于起点下方 kProbeHeight 处
+inline float holdDistance(const Vec3& dir) {
+    return GroundProbeBatch::kProbeHeight / -dir.y;
+}
+
+} // namespace
+
+TerrainStreamer* TerrainStreamer::create(const std::string& manifestPath, Node* renderRoot) {
+    auto pRet = new (std::nothrow) TerrainStreamer();
+    if (pRet && pRet->init(manifestPath, renderRoot)) {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return nullptr;
+}
+
+/**
+ * 未完成的异步加载在回调中自行清理；渲染模型随 renderRoot 一起销毁，这里只释放引用
+ */
+TerrainStreamer::~TerrainStreamer() {
+    for (auto& load : _pendingLoads) {
+        load->owner = nullptr;
+    }
+    for (auto& tile : _tiles) {
+        CC_SAFE_RELEASE(tile.collider);
+        CC_SAFE_RELEASE(tile.sprite);
+    }
+}
+
+bool TerrainStreamer::init(const std::string& manifestPath, Node* renderRoot) {
+    _renderRoot = renderRoot;
+    if (!loadManifest(manifestPath) || _tiles.empty()) return false;
+
+    CCLOG("TerrainStreamer: %d tiles on a %dx%d grid (tile size %.0f), budget %d tiles",
+          (int)_tiles.size(), _cols, _rows, _tileSize, _residencyBudget);
+    return true;
+}
+
+bool TerrainStreamer::loadManifest(const std::string& manifestPath) {
+    const std::string text = FileUtils::getInstance()->getStringFromFile(manifestPath);
+    if (text.empty()) return false;
+
+    const size_t slash = manifestPath.find_last_of("/\\");
+    const std::string dir = (slash == std::string::npos) ? "" : manifestPath.substr(0, slash + 1);
+
+    std::istringstream in(text);
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if (kind == "grid") {
+            if (!(fields >> _originX >> _originZ >> _tileSize >> _cols >> _rows) ||
+                _tileSize <= 0.0f || _cols <= 0 || _rows <= 0) {
+                CCLOG("TerrainStreamer: bad grid line %d in %s", lineNo, manifestPath.c_str());
+                return false;
+            }
+            _tiles.clear();
+            _cells.assign((size_t)_cols * _rows, -1);
+        } else if (kind == "tile") {
+            Tile tile;
+            std::string render, collision;
+            if (_cells.empty() || !(fields >> tile.col >> tile.row >> render >> collision) ||
+                tile.col < 0 || tile.col >= _cols || tile.row < 0 || tile.row >= _rows) {
+                CCLOG("TerrainStreamer: bad tile line %d in %s", lineNo, manifestPath.c_str());
+                continue;
+            }
+            int& cell = _cells[(size_t)tile.row * _cols + tile.col];
+            if (cell >= 0) continue;
+
+            tile.minX = _originX + tile.col * _tileSize;
+            tile.maxX = tile.minX + _tileSize;
+            tile.minZ = _originZ + tile.row * _tileSize;
+            tile.maxZ = tile.minZ + _tileSize;
+            if (render != "-") tile.renderPath = dir + render;
+            tile.collisionPath = dir + collision;
+            cell = (int)_tiles.size();
+            _tiles.push_back(tile);
+        }
+    }
+    return true;
+}
+
+int TerrainStreamer::tileAt(float x, float z) const {
+    const float fx = (x - _originX) / _tileSize;
+    const float fz = (z - _originZ) / _tileSize;
+    if (!(fx >= 0.0f && fz >= 0.0f)) return -1;
+    const int c = (int)fx, r = (int)fz;
+    if (c >= _cols || r >= _rows) return -1;
+    return _cells[(size_t)r * _cols + c];
+}
+
+float TerrainStreamer::distanceToTile(const Tile& tile, float x, float z) const {
+    const float dx = std::max(std::max(tile.minX - x, x - tile.maxX), 0.0f);
+    const float dz = std::max(std::max(tile.minZ - z, z - tile.maxZ), 0.0f);
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+int TerrainStreamer::getResidentCount() const {
+    int count = 0;
+    for (const auto& tile : _tiles) {
+        if (tile.collider || tile.colliderLoading) ++count;
+    }
+    return count;
+}
+
+bool TerrainStreamer::isResident(const Vec3& pos) const {
+    const int t = tileAt(pos.x, pos.z);
+    return t >= 0 && _tiles[t].collider != nullptr;
+}
+
+/* ==================== 驻留调度 ==================== */
+
+/**
+ * 按优先级挑选本轮需要驻留的分块：附近的分块按距离排序，传送目的地与当前区域的分块排在其后
+ */
+void TerrainStreamer::selectTiles(const Vec3& playerPos) {
+    ++_selectRound;
+    for (auto& tile : _tiles) {
+        tile.priority = FLT_MAX;
+    }
+
+    for (auto& tile : _tiles) {
+        const float d = distanceToTile(tile, playerPos.x, playerPos.z);
+        if (d <= _streamRadius) tile.priority = d;
+    }
+
+    auto areas = AreaManager::getInstance();
+    int pointIndex;
+    if (areas->isNearTeleportPoint(playerPos, pointIndex)) {
+        const Vec3& dest = areas->getTeleportPoints()[areas->getTeleportTargetIndex(pointIndex)].position;
+        for (auto& tile : _tiles) {
+            const float d = distanceToTile(tile, dest.x, dest.z);
+            if (d <= _streamRadius) tile.priority = std::min(tile.priority, _streamRadius + d);
+        }
+    }
+
+    if (const AreaManager::AreaInfo* area = areas->getAreaAt(playerPos)) {
+        const Rect& r = area->bounds;
+        for (auto& tile : _tiles) {
+            if (tile.maxX < r.getMinX() || tile.minX > r.getMaxX() ||
+                tile.maxZ < r.getMinY() || tile.minZ > r.getMaxY()) {
+                continue;
+            }
+            const float d = distanceToTile(tile, playerPos.x, playerPos.z);
+            tile.priority = std::min(tile.priority, 2.0f * _streamRadius + d);
+        }
+    }
+
+    _wanted.clear();
+    for (int i = 0; i < (int)_tiles.size(); ++i) {
+        if (_tiles[i].priority < FLT_MAX) _wanted.push_back(i);
+    }
+    std::sort(_wanted.begin(), _wanted.end(), [this](int a, int b) {
+        return _tiles[a].priority < _tiles[b].priority;
+    });
+    if ((int)_wanted.size() > _residencyBudget) _wanted.resize(_residencyBudget);
+    for (int i : _wanted) {
+        _tiles[i].lastWanted = _selectRound;
+    }
+}
+
+void TerrainStreamer::update(float dt, const Vec3& playerPos) {
+    _selectTimer -= dt;
+    if (_selectTimer <= 0.0f) {
+        _selectTimer = kSelectInterval;
+        selectTiles(playerPos);
+    }
+
+    // 按优先级发起加载：碰撞网格限制并发数，渲染模型在碰撞网格开始加载后跟进
+    for (int i : _wanted) {
+        Tile& tile = _tiles[i];
+        if (!tile.collider && !tile.colliderLoading && !tile.colliderFailed && _colliderLoads < kMaxConcurrentLoads) {
+            requestCollider(i);
+        }
+        if (!tile.sprite && !tile.renderLoading && !tile.renderFailed && !tile.renderPath.empty() &&
+            (tile.collider || tile.colliderLoading)) {
+            requestRender(i);
+        }
+    }
+
+    evictOverBudget();
+}
+
+void TerrainStreamer::preload(const Vec3& center, float radius) {
+    for (int i = 0; i < (int)_tiles.size(); ++i) {
+        Tile& tile = _tiles[i];
+        if (distanceToTile(tile, center.x, center.z) > radius) continue;
+
+        if (!tile.collider && !tile.colliderLoading && !tile.colliderFailed) {
+            tile.collider = TerrainCollider::createFromObj(tile.collisionPath, _accelType);
+            if (tile.collider) {
+                tile.collider->retain();
+            } else {
+                tile.colliderFailed = true;
+                CCLOG("TerrainStreamer: failed to load tile collision %s", tile.collisionPath.c_str());
+            }
+        }
+        if (!tile.sprite && !tile.renderLoading && !tile.renderFailed && !tile.renderPath.empty()) {
+            auto sprite = Sprite3D::create(tile.renderPath);
+            if (sprite) {
+                attachSprite(i, sprite);
+            } else {
+                tile.renderFailed = true;
+            }
+        }
+        tile.lastWanted = _selectRound;
+    }
+}
+
+/**
+ * 碰撞网格在后台线程构建：TerrainCollider 直接 new 出来（不进入自动释放池），回到主线程后由分块持有
+ */
+void TerrainStreamer::requestCollider(int tile) {
+    Tile& t = _tiles[tile];
+    t.colliderLoading = true;
+    ++_colliderLoads;
+
+    auto load = std::make_shared<PendingLoad>();
+    load->owner = this;
+    load->tile = tile;
+    _pendingLoads.push_back(load);
+
+    const std::string fullPath = FileUtils::getInstance()->fullPathForFilename(t.collisionPath);
+    const TerrainCollider::AccelType accel = _accelType;
+    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_OTHER,
+        [load](void*) {
+            if (load->owner) {
+                load->owner->onColliderLoaded(load);
+            } else {
+                CC_SAFE_RELEASE(load->collider);
+            }
+        },
+        nullptr,
+        [load, fullPath, accel]() {
+            if (fullPath.empty()) return;
+            auto collider = new (std::nothrow) TerrainCollider();
+            if (collider && !collider->init(nullptr, fullPath, accel)) {
+                CC_SAFE_DELETE(collider);
+            }
+            load->collider = collider;
+        });
+}
+
+void TerrainStreamer::requestRender(int tile) {
+    _tiles[tile].renderLoading = true;
+
+    auto load = std::make_shared<PendingLoad>();
+    load->owner = this;
+    load->tile = tile;
+    _pendingLoads.push_back(load);
+
+    Sprite3D::createAsync(_tiles[tile].renderPath, [load](Sprite3D* sprite, void*) {
+        if (load->owner) load->owner->onRenderLoaded(load, sprite);
+    }, nullptr);
+}
+
+void TerrainStreamer::finishLoad(const std::shared_ptr<PendingLoad>& load) {
+    auto it = std::find(_pendingLoads.begin(), _pendingLoads.end(), load);
+    if (it != _pendingLoads.end()) _pendingLoads.erase(it);
+}
+
+void TerrainStreamer::onColliderLoaded(const std::shared_ptr<PendingLoad>& load) {
+    finishLoad(load);
+    --_colliderLoads;
+
+    Tile& tile = _tiles[load->tile];
+    tile.colliderLoading = false;
+    if (!load->collider) {
+        tile.colliderFailed = true;
+        CCLOG("TerrainStreamer: failed to load tile collision %s", tile.collisionPath.c_str());
+        return;
+    }
+    tile.collider = load->collider;
+    CCLOG("TerrainStreamer: tile (%d, %d) resident, %d triangles in %.2f ms, %d/%d tiles",
+          tile.col, tile.row, tile.collider->getLoadStats().triangleCount, tile.collider->getLoadStats().totalMs,
+          getResidentCount(), _residencyBudget);
+}
+
+void TerrainStreamer::onRenderLoaded(const std::shared_ptr<PendingLoad>& load, Sprite3D* sprite) {
+    finishLoad(load);
+
+    Tile& tile = _tiles[load->tile];
+    tile.renderLoading = false;
+    if (!sprite) {
+        tile.renderFailed = true;
+        return;
+    }
+    // 等待期间分块已被淘汰时直接丢弃（sprite 在自动释放池中）
+    if (tile.collider || tile.colliderLoading) attachSprite(load->tile, sprite);
+}
+
+void TerrainStreamer::attachSprite(int tile, Sprite3D* sprite) {
+    sprite->retain();
+    sprite->setCameraMask((unsigned short)CameraFlag::USER1);
+    if (_renderRoot) _renderRoot->addChild(sprite);
+    _tiles[tile].sprite = sprite;
+}
+
+/**
+ * 驻留数量超出预算时，从本轮未被挑中的分块里淘汰最久未被需要的；加载中的分块等加载完成后再参与淘汰
+ */
+void TerrainStreamer::evictOverBudget() {
+    int resident = getResidentCount();
+    while (resident > _residencyBudget) {
+        int victim = -1;
+        for (int i = 0; i < (int)_tiles.size(); ++i) {
+            const Tile& tile = _tiles[i];
+            if (!tile.collider || tile.lastWanted == _selectRound) continue;
+            if (victim < 0 || tile.lastWanted < _tiles[victim].lastWanted) victim = i;
+        }
+        if (victim < 0) break;
+        evict(victim);
+        --resident;
+    }
+}
+
+void TerrainStreamer::evict(int tile) {
+    Tile& t = _tiles[tile];
+    CC_SAFE_RELEASE_NULL(t.collider);
+    if (t.sprite) {
+        t.sprite->removeFromParent();
+        CC_SAFE_RELEASE_NULL(t.sprite);
+    }
+    CCLOG("TerrainStreamer: tile (%d, %d) evicted", t.col, t.row);
+}
+
+/* ==================== 查询转发 ==================== */
+
+void TerrainStreamer::collectResidentTiles(float minX, float maxX, float minZ, float maxZ,
+                                           std::vector<int>& out) const {
+    out.clear();
+    const int c0 = std::max((int)std::floor((minX - _originX) / _tileSize), 0);
+    const int c1 = std::min((int)std::floor((maxX - _originX) / _tileSize), _cols - 1);
+    const int r0 = std::max((int)std::floor((minZ - _originZ) / _tileSize), 0);
+    const int r1 = std::min((int)std::floor((maxZ - _originZ) / _tileSize), _rows - 1);
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            const int t = _cells[(size_t)r * _cols + c];
+            if (t >= 0 && _tiles[t].collider) out.push_back(t);
+        }
+    }
+}
+
+bool TerrainStreamer::probeGround(const Vec3& origin, GroundCache& cache, RayHit& outHit) {
+    const int t = tileAt(origin.x, origin.z);
+    if (t < 0) {
+        cache.reset();
+        return false;
+    }
+    if (!_tiles[t].collider) {
+        ++_heldProbes;
+        outHit = RayHit();
+        outHit.distance = GroundProbeBatch::kProbeHeight;
+        return true;
+    }
+    // 缓存记录的是分块碰撞器的序号，跨分块或分块重新加载后自动重建
+    return _tiles[t].collider->probeGround(origin, cache, outHit);
+}
+
+/**
+ * 竖直向下的射线直接交给所在分块（可走高度场快速路径），其余射线按带命中面信息的版本求解
+ */
+bool TerrainStreamer::rayIntersects(const CustomRay& ray, float& hitDist) {
+    if (isVerticalDown(ray.direction)) {
+        const int t = tileAt(ray.origin.x, ray.origin.z);
+        if (t < 0) return false;
+        if (!_tiles[t].collider) {
+            ++_heldProbes;
+            hitDist = holdDistance(ray.direction);
+            return true;
+        }
+        return _tiles[t].collider->rayIntersects(ray, hitDist);
+    }
+
+    RayHit hit;
+    if (!rayIntersects(ray, hit)) return false;
+    hitDist = hit.distance;
+    return true;
+}
+
+/**
+ * 非竖直射线先裁剪到分块网格范围，再与裁剪段 XZ 包围盒覆盖的已驻留分块逐个求交
+ * 三角形下标是命中分块内的下标；分块未驻留时的"原地支撑"没有命中面，法线取竖直向上
+ */
+bool TerrainStreamer::rayIntersects(const CustomRay& ray, RayHit& outHit) {
+    const Vec3& o = ray.origin;
+    const Vec3& d = ray.direction;
+    if (isVerticalDown(d)) {
+        const int t = tileAt(o.x, o.z);
+        if (t < 0) return false;
+        if (!_tiles[t].collider) {
+            ++_heldProbes;
+            outHit = RayHit();
+            outHit.distance = holdDistance(d);
+            return true;
+        }
+        return _tiles[t].collider->rayIntersects(ray, outHit);
+    }
+
+    float t0 = 0.0f, t1 = FLT_MAX;
+    const float lo[2] = {_originX, _originZ};
+    const float hi[2] = {_originX + _cols * _tileSize, _originZ + _rows * _tileSize};
+    const float p[2] = {o.x, o.z};
+    const float v[2] = {d.x, d.z};
+    for (int a = 0; a < 2; ++a) {
+        if (v[a] == 0.0f) {
+            if (p[a] < lo[a] || p[a] > hi[a]) return false;
+            continue;
+        }
+        float ta = (lo[a] - p[a]) / v[a], tb = (hi[a] - p[a]) / v[a];
+        if (ta > tb) std::swap(ta, tb);
+        t0 = std::max(t0, ta);
+        t1 = std::min(t1, tb);
+        if (t0 > t1) return false;
+    }
+    const float x0 = o.x + d.x * t0, x1 = (d.x == 0.0f) ? o.x : o.x + d.x * t1;
+    const float z0 = o.z + d.z * t0, z1 = (d.z == 0.0f) ? o.z : o.z + d.z * t1;
+    collectResidentTiles(std::min(x0, x1), std::max(x0, x1), std::min(z0, z1), std::max(z0, z1), _queryTiles);
+
+    bool hit = false;
+    for (int t : _queryTiles) {
+        RayHit tileHit;
+        if (_tiles[t].collider->rayIntersects(ray, tileHit) && (!hit || tileHit.distance < outHit.distance)) {
+            outHit = tileHit;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+bool TerrainStreamer::segmentIntersects(const Vec3& from, const Vec3& to) {
+    collectResidentTiles(std::min(from.x, to.x), std::max(from.x, to.x),
+                         std::min(from.z, to.z), std::max(from.z, to.z), _queryTiles);
+    for (int t : _queryTiles) {
+        if (_tiles[t].collider->segmentIntersects(from, to)) return true;
+    }
+    return false;
+}
+
+bool TerrainStreamer::segmentIntersects(const Vec3& from, const Vec3& to, float& outFraction) {
+    collectResidentTiles(std::min(from.x, to.x), std::max(from.x, to.x),
+                         std::min(from.z, to.z), std::max(from.z, to.z), _queryTiles);
+    bool hit = false;
+    for (int t : _queryTiles) {
+        float fraction;
+        if (_tiles[t].collider->segmentIntersects(from, to, fraction) && (!hit || fraction < outFraction)) {
+            outFraction = fraction;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+bool TerrainStreamer::sweepCapsule(const Vec3& a, const Vec3& b, float radius, const Vec3& delta,
+                                   float& toi, Vec3& normal) {
+    const float minX = std::min(std::min(a.x, b.x), std::min(a.x, b.x) + delta.x) - radius;
+    const float maxX = std::max(std::max(a.x, b.x), std::max(a.x, b.x) + delta.x) + radius;
+    const float minZ = std::min(std::min(a.z, b.z), std::min(a.z, b.z) + delta.z) - radius;
+    const float maxZ = std::max(std::max(a.z, b.z), std::max(a.z, b.z) + delta.z) + radius;
+    collectResidentTiles(minX, maxX, minZ, maxZ, _queryTiles);
+
+    bool hit = false;
+    for (int t : _queryTiles) {
+        TerrainCollider::SweepHit tileHit;
+        if (_tiles[t].collider->sweepCapsule(a, b, radius, delta, tileHit) && (!hit || tileHit.toi < toi)) {
+            toi = tileHit.toi;
+            normal = tileHit.normal;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+Vec3 TerrainStreamer::slideCapsule(const Vec3& from, const Vec3& axisBottom, const Vec3& axisTop,
+                                   float radius, const Vec3& delta, int maxIterations) {
+    // 目标点所在分块尚未驻留时原地等待，避免走进没有碰撞的区域
+    const int target = tileAt(from.x + delta.x, from.z + delta.z);
+    if (target >= 0 && !_tiles[target].collider) return from;
+
+    return CapsuleSweep::slide(from, axisBottom, axisTop, delta, maxIterations,
+                               [this, radius](const Vec3& a, const Vec3& b, const Vec3& d, float& toi, Vec3& normal) {
+        return sweepCapsule(a, b, radius, d, toi, normal);
+    });
+}
+
+/**
+ * 竖直射线按所在分块分组，每组交给分块碰撞器批量求解；其余射线逐条求交
+ */
+int TerrainStreamer::rayIntersectsBatch(const CustomRay* rays, int count, float* outHitDist, RayHit* outHits) {
+    if (count <= 0) return 0;
+
+    int hits = 0;
+    _batchOrder.clear();
+    for (int i = 0; i < count; ++i) {
+        const CustomRay& ray = rays[i];
+        if (!isVerticalDown(ray.direction)) {
+            RayHit hit;
+            if (rayIntersects(ray, hit)) {
+                outHitDist[i] = hit.distance;
+                if (outHits) outHits[i] = hit;
+                ++hits;
+            } else {
+                outHitDist[i] = kNoHit;
+            }
+            continue;
+        }
+
+        const int t = tileAt(ray.origin.x, ray.origin.z);
+        if (t < 0) {
+            outHitDist[i] = kNoHit;
+        } else if (!_tiles[t].collider) {
+            ++_heldProbes;
+            outHitDist[i] = holdDistance(ray.direction);
+            if (outHits) {
+                outHits[i] = RayHit();
+                outHits[i].distance = outHitDist[i];
+            }
+            ++hits;
+        } else {
+            _batchOrder.push_back(std::make_pair(t, i));
+        }
+    }
+    std::sort(_batchOrder.begin(), _batchOrder.end());
+
+    for (size_t begin = 0; begin < _batchOrder.size();) {
+        const int t = _batchOrder[begin].first;
+        size_t end = begin;
+        _batchRays.clear();
+        while (end < _batchOrder.size() && _batchOrder[end].first == t) {
+            _batchRays.push_back(rays[_batchOrder[end].second]);
+            ++end;
+        }
+        _batchHitDist.resize(_batchRays.size());
+        _batchHits.resize(outHits ? _batchRays.size() : 0);
+        hits += _tiles[t].collider->rayIntersectsBatch(_batchRays.data(), (int)_batchRays.size(), _batchHitDist.data(),
+                                                       outHits ? _batchHits.data() : nullptr);
+        for (size_t k = begin; k < end; ++k) {
+            outHitDist[_batchOrder[k].second] = _batchHitDist[k - begin];
+            if (outHits) outHits[_batchOrder[k].second] = _batchHits[k - begin];
+        }
+        begin = end;
+    }
+    return hits;
+}
@@ -0,0 +1,164 @@
+#ifndef __TERRAIN_STREAMER_H__
+#define __TERRAIN_STREAMER_H__
+
+#include "cocos2d.h"
+#include "Collider.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @class TerrainStreamer
+ * @brief 分块地形：按玩家位置在后台加载 / 淘汰分块，并把地形查询转发给已驻留的分块
+ *
+ * 世界在 XZ 平面上划分为等大的分块，每块有独立的渲染模型和碰撞网格（均为世界坐标）。
+ * 跨越分块边界的三角形在相邻分块中各存一份，因此竖直探测只需查询探测点所在的分块。
+ *
+ * 每次 update 按以下优先级挑选需要驻留的分块，最多保留 residencyBudget 块：
+ * 1. 与玩家 XZ 距离不超过 streamRadius 的分块（越近越优先）；
+ * 2. 玩家站在传送点上时，传送目的地附近的分块；
+ * 3. 与玩家所在 AreaManager 区域相交的分块（进入 Boss 区域时预取整个场地）。
+ * 碰撞网格在后台线程构建（命中碰撞缓存时只需映射文件），渲染模型通过 Sprite3D::createAsync 加载；
+ * 超出预算时淘汰最久未被需要的分块。
+ *
+ * 查询落在未驻留的分块上时不会让角色穿过世界：
+ * - 竖直向下的射线返回"原地支撑"，命中点在起点下方 GroundProbeBatch::kProbeHeight 处，
+ *   即角色当前的脚底高度，角色停在原高度等待分块加载；
+ * - 水平移动的目标点落在未驻留分块上时原地不动；
+ * - 其它射线与线段只和已驻留的分块求交。
+ * 落在清单范围之外（或清单中缺失的分块）的查询视为没有地形。
+ * 分块没有导航网格（NavMesh 只支持整块地形），敌人在流式地形上直线追击。
+ */
+class TerrainStreamer : public cocos2d::Ref, public TerrainQuery {
+public:
+    /**
+     * @brief 读取分块清单
+     * @param manifestPath 清单文件路径，分块模型路径相对于清单所在目录
+     * @param renderRoot 分块渲染模型的父节点（不持有引用）
+     *
+     * 清单为文本格式，# 开头的行为注释（由 world_bake tiles 从场景描述生成）：
+     *     grid <originX> <originZ> <tileSize> <cols> <rows>
+     *     tile <col> <row> <渲染 .obj> <碰撞 .obj>
+     */
+    static TerrainStreamer* create(const std::string& manifestPath, cocos2d::Node* renderRoot);
+
+    virtual ~TerrainStreamer();
+
+    bool init(const std::string& manifestPath, cocos2d::Node* renderRoot);
+
+    void setStreamRadius(float radius) { _streamRadius = radius; }
+    float getStreamRadius() const { return _streamRadius; }
+
+    /**
+     * @brief 同时驻留（含加载中）的分块数量上限
+     */
+    void setResidencyBudget(int maxTiles) { _residencyBudget = std::max(1, maxTiles); }
+    int getResidencyBudget() const { return _residencyBudget; }
+
+    /**
+     * @brief 每帧调用：重新挑选需要驻留的分块，发起加载并按预算淘汰
+     */
+    void update(float dt, const cocos2d::Vec3& playerPos);
+
+    /**
+     * @brief 在当前线程同步加载 center 周围 radius 内的分块（出生点贴地之前调用）
+     */
+    void preload(const cocos2d::Vec3& center, float radius);
+
+    /**
+     * @brief 该位置所在的分块是否已可查询
+     */
+    bool isResident(const cocos2d::Vec3& pos) const;
+
+    bool rayIntersects(const CustomRay& ray, float& hitDist) override;
+    bool rayIntersects(const CustomRay& ray, RayHit& outHit) override;
+    bool segmentIntersects(const cocos2d::Vec3& from, const cocos2d::Vec3& to) override;
+    bool segmentIntersects(const cocos2d::Vec3& from, const cocos2d::Vec3& to, float& outFraction) override;
+    bool sweepCapsule(const cocos2d::Vec3& a, const cocos2d::Vec3& b, float radius, const cocos2d::Vec3& delta,
+                      float& toi, cocos2d::Vec3& normal) override;
+    cocos2d::Vec3 slideCapsule(const cocos2d::Vec3& from, const cocos2d::Vec3& axisBottom, const cocos2d::Vec3& axisTop,
+                               float radius, const cocos2d::Vec3& delta, int maxIterations = 2) override;
+    bool probeGround(const cocos2d::Vec3& origin, GroundCache& cache, RayHit& outHit) override;
+    int rayIntersectsBatch(const CustomRay* rays, int count, float* outHitDist, RayHit* outHits = nullptr) override;
+
+    int getTileCount() const { return (int)_tiles.size(); }
+    int getResidentCount() const;
+    int getLoadingCount() const { return _colliderLoads; }
+
+    /// 统计：因分块未驻留而返回"原地支撑"的地面探测次数
+    int getHeldProbeCount() const { return _heldProbes; }
+
+private:
+    struct Tile {
+        int col = 0, row = 0;
+        float minX = 0.0f, maxX = 0.0f, minZ = 0.0f, maxZ = 0.0f;
+        std::string renderPath;
+        std::string collisionPath;
+
+        TerrainCollider* collider = nullptr;  ///< 持有引用，为空表示未驻留
+        cocos2d::Sprite3D* sprite = nullptr;  ///< 持有引用
+        bool colliderLoading = false;
+        bool renderLoading = false;
+        bool colliderFailed = false; ///< 加载失败的分块不再重试，查询按未驻留处理
+        bool renderFailed = false;
+
+        float priority = 0.0f;     ///< 本次挑选的优先级，越小越优先
+        unsigned lastWanted = 0;   ///< 最近一次被挑中的轮次，用于 LRU 淘汰
+    };
+
+    /**
+     * 一次异步加载（碰撞网格或渲染模型）。回调在主线程执行；streamer 先于回调析构时 owner 被置空，回调只做清理
+     */
+    struct PendingLoad {
+        TerrainStreamer* owner = nullptr;
+        int tile = -1;
+        TerrainCollider* collider = nullptr; ///< 由后台线程写入
+    };
+
+    bool loadManifest(const std::string& manifestPath);
+
+    int tileAt(float x, float z) const;
+    float distanceToTile(const Tile& tile, float x, float z) const;
+
+    void selectTiles(const cocos2d::Vec3& playerPos);
+    void requestCollider(int tile);
+    void requestRender(int tile);
+    void onColliderLoaded(const std::shared_ptr<PendingLoad>& load);
+    void onRenderLoaded(const std::shared_ptr<PendingLoad>& load, cocos2d::Sprite3D* sprite);
+    void finishLoad(const std::shared_ptr<PendingLoad>& load);
+    void attachSprite(int tile, cocos2d::Sprite3D* sprite);
+    void evictOverBudget();
+    void evict(int tile);
+
+    /**
+     * 收集 XZ 包围盒与 [minX, maxX] x [minZ, maxZ] 相交的已驻留分块
+     */
+    void collectResidentTiles(float minX, float maxX, float minZ, float maxZ, std::vector<int>& out) const;
+
+    cocos2d::Node* _renderRoot = nullptr;
+    TerrainCollider::AccelType _accelType = TerrainCollider::AccelType::BVH;
+
+    float _originX = 0.0f, _originZ = 0.0f, _tileSize = 1.0f;
+    int _cols = 0, _rows = 0;
+    std::vector<Tile> _tiles;
+    std::vector<int> _cells; ///< 网格单元 -> _tiles 下标，清单中缺失的单元为 -1
+
+    float _streamRadius = 600.0f;
+    int _residencyBudget = 16;
+    float _selectTimer = 0.0f;
+    unsigned _selectRound = 0;
+    std::vector<int> _wanted; ///< 本轮挑中的分块，按优先级排序
+
+    std::vector<std::shared_ptr<PendingLoad>> _pendingLoads;
+    int _colliderLoads = 0; ///< 正在后台构建的碰撞网格数量
+
+    int _heldProbes = 0;
+    std::vector<int> _queryTiles; ///< 查询时收集分块的缓冲，复用以避免每帧分配
+    std::vector<std::pair<int, int>> _batchOrder; ///< 批量检测按分块分组的排序缓冲
+    std::vector<CustomRay> _batchRays;
+    std::vector<float> _batchHitDist;
+    std::vector<RayHit> _batchHits;
+};
+
+#endif // __TERRAIN_STREAMER_H__
@@ -0,0 +1,153 @@
+#include "TriangleSoA.h"
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define TRIANGLE_SOA_SIMD 1
+#endif
+
+USING_NS_CC;
+
+namespace {
+
+#if defined(__AVX__)
+
+typedef __m256 VFloat;
+inline VFloat vLoad(const float* p) { return _mm256_loadu_ps(p); }
+inline VFloat vSet1(float x) { return _mm256_set1_ps(x); }
+inline VFloat vAdd(VFloat a, VFloat b) { return _mm256_add_ps(a, b); }
+inline VFloat vSub(VFloat a, VFloat b) { return _mm256_sub_ps(a, b); }
+inline VFloat vMul(VFloat a, VFloat b) { return _mm256_mul_ps(a, b); }
+inline VFloat vDiv(VFloat a, VFloat b) { return _mm256_div_ps(a, b); }
+inline VFloat vAnd(VFloat a, VFloat b) { return _mm256_and_ps(a, b); }
+inline VFloat vOr(VFloat a, VFloat b) { return _mm256_or_ps(a, b); }
+inline VFloat vLt(VFloat a, VFloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline VFloat vLe(VFloat a, VFloat b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+inline VFloat vGt(VFloat a, VFloat b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline VFloat vGe(VFloat a, VFloat b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline int vMoveMask(VFloat a) { return _mm256_movemask_ps(a); }
+inline void vStore(float* p, VFloat a) { _mm256_storeu_ps(p, a); }
+
+#elif defined(TRIANGLE_SOA_SIMD)
+
+typedef __m128 VFloat;
+inline VFloat vLoad(const float* p) { return _mm_loadu_ps(p); }
+inline VFloat vSet1(float x) { return _mm_set1_ps(x); }
+inline VFloat vAdd(VFloat a, VFloat b) { return _mm_add_ps(a, b); }
+inline VFloat vSub(VFloat a, VFloat b) { return _mm_sub_ps(a, b); }
+inline VFloat vMul(VFloat a, VFloat b) { return _mm_mul_ps(a, b); }
+inline VFloat vDiv(VFloat a, VFloat b) { return _mm_div_ps(a, b); }
+inline VFloat vAnd(VFloat a, VFloat b) { return _mm_and_ps(a, b); }
+inline VFloat vOr(VFloat a, VFloat b) { return _mm_or_ps(a, b); }
+inline VFloat vLt(VFloat a, VFloat b) { return _mm_cmplt_ps(a, b); }
+inline VFloat vLe(VFloat a, VFloat b) { return _mm_cmple_ps(a, b); }
+inline VFloat vGt(VFloat a, VFloat b) { return _mm_cmpgt_ps(a, b); }
+inline VFloat vGe(VFloat a, VFloat b) { return _mm_cmpge_ps(a, b); }
+inline int vMoveMask(VFloat a) { return _mm_movemask_ps(a); }
+inline void vStore(float* p, VFloat a) { _mm_storeu_ps(p, a); }
+
+#endif
+
+} // namespace
+
+void TriangleSoA::resize(int count) {
+    _count = count;
+    // 末尾填充的退化三角形（全零）行列式为 0，永远不会命中
+    size_t padded = (size_t)count + kLaneCount;
+    for (auto* arr : {&_v0x, &_v0y, &_v0z, &_e1x, &_e1y, &_e1z, &_e2x, &_e2y, &_e2z}) {
+        arr->assign(count > 0 ? padded : 0, 0.0f);
+    }
+}
+
+void TriangleSoA::set(int i, const Vec3& v0, const Vec3& v1, const Vec3& v2) {
+    _v0x[i] = v0.x; _v0y[i] = v0.y; _v0z[i] = v0.z;
+    _e1x[i] = v1.x - v0.x; _e1y[i] = v1.y - v0.y; _e1z[i] = v1.z - v0.z;
+    _e2x[i] = v2.x - v0.x; _e2y[i] = v2.y - v0.y; _e2z[i] = v2.z - v0.z;
+}
+
+bool TriangleSoA::intersectRangeScalar(int first, int count, const Vec3& origin, const Vec3& dir,
+                                       float& tMax, int& hitIndex) const {
+    bool hit = false;
+    for (int i = first; i < first + count; ++i) {
+        float t;
+        if (intersect(i, origin, dir, t) && t < tMax) {
+            tMax = t;
+            hitIndex = i;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+#if defined(TRIANGLE_SOA_SIMD)
+
+/**
+ * SIMD 版本：与 intersect() 逐步对应，每次处理 kLaneCount 个三角形
+ * 命中的通道按下标顺序以严格小于比较更新 tMax，与标量循环的结果（包括并列时的选择）一致
+ */
+bool TriangleSoA::intersectRange(int first, int count, const Vec3& origin, const Vec3& dir,
+                                 float& tMax, int& hitIndex) const {
+    if (count < kLaneCount) {
+        return intersectRangeScalar(first, count, origin, dir, tMax, hitIndex);
+    }
+
+    const VFloat ox = vSet1(origin.x), oy = vSet1(origin.y), oz = vSet1(origin.z);
+    const VFloat dx = vSet1(dir.x), dy = vSet1(dir.y), dz = vSet1(dir.z);
+    const VFloat eps = vSet1(0.00001f), negEps = vSet1(-0.00001f);
+    const VFloat zero = vSet1(0.0f), one = vSet1(1.0f);
+
+    bool hit = false;
+    const int end = first + count;
+    for (int i = first; i < end; i += kLaneCount) {
+        const VFloat e1x = vLoad(&_e1x[i]), e1y = vLoad(&_e1y[i]), e1z = vLoad(&_e1z[i]);
+        const VFloat e2x = vLoad(&_e2x[i]), e2y = vLoad(&_e2y[i]), e2z = vLoad(&_e2z[i]);
+
+        // h = dir x edge2
+        const VFloat hx = vSub(vMul(dy, e2z), vMul(dz, e2y));
+        const VFloat hy = vSub(vMul(dz, e2x), vMul(dx, e2z));
+        const VFloat hz = vSub(vMul(dx, e2y), vMul(dy, e2x));
+        const VFloat a = vAdd(vAdd(vMul(e1x, hx), vMul(e1y, hy)), vMul(e1z, hz));
+        VFloat mask = vOr(vLe(a, negEps), vGe(a, eps));
+
+        const VFloat f = vDiv(one, a);
+        const VFloat sx = vSub(ox, vLoad(&_v0x[i]));
+        const VFloat sy = vSub(oy, vLoad(&_v0y[i]));
+        const VFloat sz = vSub(oz, vLoad(&_v0z[i]));
+        const VFloat u = vMul(f, vAdd(vAdd(vMul(sx, hx), vMul(sy, hy)), vMul(sz, hz)));
+        mask = vAnd(mask, vAnd(vGe(u, zero), vLe(u, one)));
+
+        // q = s x edge1
+        const VFloat qx = vSub(vMul(sy, e1z), vMul(sz, e1y));
+        const VFloat qy = vSub(vMul(sz, e1x), vMul(sx, e1z));
+        const VFloat qz = vSub(vMul(sx, e1y), vMul(sy, e1x));
+        const VFloat v = vMul(f, vAdd(vAdd(vMul(dx, qx), vMul(dy, qy)), vMul(dz, qz)));
+        mask = vAnd(mask, vAnd(vGe(v, zero), vLe(vAdd(u, v), one)));
+
+        const VFloat t = vMul(f, vAdd(vAdd(vMul(e2x, qx), vMul(e2y, qy)), vMul(e2z, qz)));
+        mask = vAnd(mask, vAnd(vGt(t, eps), vLt(t, vSet1(tMax))));
+
+        int bits = vMoveMask(mask);
+        // 最后一组可能越过区间末尾，屏蔽多出的通道
+        if (end - i < kLaneCount) bits &= (1 << (end - i)) - 1;
+        if (!bits) continue;
+
+        float ts[kLaneCount];
+        vStore(ts, t);
+        for (int lane = 0; lane < kLaneCount; ++lane) {
+            if ((bits & (1 << lane)) && ts[lane] < tMax) {
+                tMax = ts[lane];
+                hitIndex = i + lane;
+                hit = true;
+            }
+        }
+    }
+    return hit;
+}
+
+#else
+
+bool TriangleSoA::intersectRange(int first, int count, const Vec3& origin, const Vec3& dir,
+                                 float& tMax, int& hitIndex) const {
+    return intersectRangeScalar(first, count, origin, dir, tMax, hitIndex);
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef __TRIANGLE_SOA_H__
+#define __TRIANGLE_SOA_H__
+
+#include "cocos2d.h"
+#include <algorithm>
+#include <vector>
+
+/**
+ * @class TriangleSoA
+ * @brief 结构数组（SoA）形式的三角形存储，预先计算两条边，供批量射线求交使用
+ *
+ * 每个分量单独成一个数组：v0、edge1 = v1 - v0、edge2 = v2 - v0。
+ * 数组末尾额外填充 kLaneCount 个退化三角形，使 SIMD 读取越过末尾时依然安全。
+ *
+ * intersectRange 按编译目标选择实现：定义 __AVX__ 时一次测试 8 个三角形，
+ * 支持 SSE2 时一次 4 个，其余平台（如 ARM 移动端）退化为逐个标量测试。
+ * 所有实现的运算顺序与标量版本一致，返回的最近命中结果完全相同。
+ */
+class TriangleSoA {
+public:
+#if defined(__AVX__)
+    static const int kLaneCount = 8;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    static const int kLaneCount = 4;
+#else
+    static const int kLaneCount = 1;
+#endif
+
+    /**
+     * @brief 分配 count 个三角形的空间（含末尾填充）
+     */
+    void resize(int count);
+
+    /**
+     * @brief 写入第 i 个三角形
+     */
+    void set(int i, const cocos2d::Vec3& v0, const cocos2d::Vec3& v1, const cocos2d::Vec3& v2);
+
+    void clear() { resize(0); }
+    int size() const { return _count; }
+
+    /// 九个分量数组（含末尾填充）占用的字节数
+    size_t getMemoryBytes() const { return _v0x.capacity() * sizeof(float) * 9; }
+
+    /**
+     * @brief 第 i 个三角形的包围盒（由 v0 与两条边还原，供粗筛使用）
+     */
+    void getBounds(int i, cocos2d::Vec3& bmin, cocos2d::Vec3& bmax) const {
+        bmin.set(_v0x[i] + std::min(0.0f, std::min(_e1x[i], _e2x[i])),
+                 _v0y[i] + std::min(0.0f, std::min(_e1y[i], _e2y[i])),
+                 _v0z[i] + std::min(0.0f, std::min(_e1z[i], _e2z[i])));
+        bmax.set(_v0x[i] + std::max(0.0f, std::max(_e1x[i], _e2x[i])),
+                 _v0y[i] + std::max(0.0f, std::max(_e1y[i], _e2y[i])),
+                 _v0z[i] + std::max(0.0f, std::max(_e1z[i], _e2z[i])));
+    }
+
+    /**
+     * @brief 第 i 个三角形的单位法线，由两条边的叉积现算，统一翻到 y >= 0 一侧（退化三角形返回 UNIT_Y）
+     */
+    cocos2d::Vec3 getNormal(int i) const {
+        cocos2d::Vec3 n(_e1y[i] * _e2z[i] - _e1z[i] * _e2y[i],
+                        _e1z[i] * _e2x[i] - _e1x[i] * _e2z[i],
+                        _e1x[i] * _e2y[i] - _e1y[i] * _e2x[i]);
+        const float len = n.length();
+        if (len <= 0.0f) return cocos2d::Vec3::UNIT_Y;
+        n = n / len;
+        return (n.y < 0.0f) ? -n : n;
+    }
+
+    /**
+     * @brief 第 i 个三角形的 XZ 投影包围盒是否与给定矩形相交
+     */
+    bool overlapsXZ(int i, float minX, float maxX, float minZ, float maxZ) const {
+        const float x = _v0x[i], z = _v0z[i];
+        return x + std::max(0.0f, std::max(_e1x[i], _e2x[i])) >= minX &&
+               x + std::min(0.0f, std::min(_e1x[i], _e2x[i])) <= maxX &&
+               z + std::max(0.0f, std::max(_e1z[i], _e2z[i])) >= minZ &&
+               z + std::min(0.0f, std::min(_e1z[i], _e2z[i])) <= maxZ;
+    }
+
+    /**
+     * @brief 标量 Möller-Trumbore 求交
+     * @param t 输出：射线参数（距离 = t * |dir|），仅在返回 true 时有效
+     * @return bool 是否命中（要求 t > 1e-5）
+     */
+    bool intersect(int i, const cocos2d::Vec3& origin, const cocos2d::Vec3& dir, float& t) const;
+
+    /**
+     * @brief 测试区间 [first, first + count) 内的所有三角形，保留最近的命中
+     * @param tMax 输入/输出：当前最近命中参数，只有更近的命中才会更新它
+     * @param hitIndex 输出：最近命中三角形下标（仅在返回 true 时更新）
+     * @return bool 区间内是否存在比 tMax 更近的命中
+     */
+    bool intersectRange(int first, int count, const cocos2d::Vec3& origin, const cocos2d::Vec3& dir,
+                        float& tMax, int& hitIndex) const;
+
+private:
+    bool intersectRangeScalar(int first, int count, const cocos2d::Vec3& origin, const cocos2d::Vec3& dir,
+                              float& tMax, int& hitIndex) const;
+
+    int _count = 0;
+    std::vector<float> _v0x, _v0y, _v0z;
+    std::vector<float> _e1x, _e1y, _e1z;
+    std::vector<float> _e2x, _e2y, _e2z;
+};
+
+inline bool TriangleSoA::intersect(int i, const cocos2d::Vec3& origin, const cocos2d::Vec3& dir, float& t) const {
+    const float e1x = _e1x[i], e1y = _e1y[i], e1z = _e1z[i];
+    const float e2x = _e2x[i], e2y = _e2y[i], e2z = _e2z[i];
+
+    // h = dir x edge2
+    const float hx = dir.y * e2z - dir.z * e2y;
+    const float hy = dir.z * e2x - dir.x * e2z;
+    const float hz = dir.x * e2y - dir.y * e2x;
+    const float a = e1x * hx + e1y * hy + e1z * hz;
+
+    // 射线与三角形平面平行
+    if (a > -0.00001f && a < 0.00001f) return false;
+
+    const float f = 1.0f / a;
+    const float sx = origin.x - _v0x[i];
+    const float sy = origin.y - _v0y[i];
+    const float sz = origin.z - _v0z[i];
+    const float u = f * (sx * hx + sy * hy + sz * hz);
+    if (u < 0.0f || u > 1.0f) return false;
+
+    // q = s x edge1
+    const float qx = sy * e1z - sz * e1y;
+    const float qy = sz * e1x - sx * e1z;
+    const float qz = sx * e1y - sy * e1x;
+    const float v = f * (dir.x * qx + dir.y * qy + dir.z * qz);
+    if (v < 0.0f || u + v > 1.0f) return false;
+
+    t = f * (e2x * qx + e2y * qy + e2z * qz);
+    return t > 0.00001f;
+}
+
+#endif // __TRIANGLE_SOA_H__
@@ -0,0 +1,525 @@
+#include "WorldBake.h"
+#include "CollisionCache.h"
+#include "GroundProbeBatch.h"
+#include "NavMesh.h"
+#include "3d/CCSprite3D.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+USING_NS_CC;
+
+namespace {
+
+// 烘焙文件在碰撞段之外追加的段
+const uint32_t kTagSpawns = CollisionCache::makeTag('S', 'P', 'W', 'N');
+
+const float kSpawnMatchEpsilon = 0.01f; ///< 出生点按 XZ 匹配的容差
+
+/// 与 BaseScene::snapToGround 相同的竖直探测，保证烘焙高度与运行时贴地结果一致
+bool probeAt(TerrainCollider* collider, float x, float z, float originY, float& outY) {
+    float hitDist;
+    if (!collider->rayIntersects(CustomRay(Vec3(x, originY, z), Vec3(0, -1, 0)), hitDist)) return false;
+    outY = originY - hitDist;
+    return true;
+}
+
+/// 分块网格：覆盖碰撞网格 XZ 范围的最小整块网格
+struct TileGrid {
+    float originX = 0.0f, originZ = 0.0f, size = 1.0f;
+    int cols = 0, rows = 0;
+
+    /// XZ 包围盒覆盖的分块范围（落在分块边界上的面同时属于两侧分块），超出网格的部分被截掉
+    bool range(float minX, float maxX, float minZ, float maxZ, int& c0, int& c1, int& r0, int& r1) const {
+        c0 = std::max(0, (int)std::floor((minX - originX) / size));
+        c1 = std::min(cols - 1, (int)std::floor((maxX - originX) / size));
+        r0 = std::max(0, (int)std::floor((minZ - originZ) / size));
+        r1 = std::min(rows - 1, (int)std::floor((maxZ - originZ) / size));
+        return c0 <= c1 && r0 <= r1;
+    }
+};
+
+/// 渲染网格一个面的角：顶点 / 纹理坐标 / 法线下标（0 起始，-1 表示缺失）
+struct ObjCorner {
+    int v = -1, vt = -1, vn = -1;
+};
+
+struct ObjFace {
+    int material = -1;
+    int first = 0;  ///< 第一个角在 RenderObj::corners 中的下标
+    int count = 0;
+};
+
+/// 切分渲染网格用的完整 .obj（ObjParser 只保留几何，这里还要保留纹理坐标、法线与材质）
+struct RenderObj {
+    std::string mtllib;
+    std::vector<Vec3> positions;         ///< 已变换到世界坐标
+    std::vector<std::string> texcoords;  ///< vt 行去掉前缀后的原文
+    std::vector<std::string> normals;    ///< vn 行去掉前缀后的原文（均匀缩放不改变法线）
+    std::vector<std::string> materials;
+    std::vector<ObjCorner> corners;
+    std::vector<ObjFace> faces;
+};
+
+/// 解析 "v"、"v/vt"、"v//vn"、"v/vt/vn" 形式的角，负数为相对下标
+bool parseCorner(const std::string& token, const RenderObj& obj, ObjCorner& out) {
+    int idx[3] = {0, 0, 0};
+    size_t pos = 0;
+    for (int k = 0; k < 3; ++k) {
+        const size_t slash = token.find('/', pos);
+        const std::string field = token.substr(pos, slash == std::string::npos ? std::string::npos : slash - pos);
+        if (!field.empty()) idx[k] = std::atoi(field.c_str());
+        if (slash == std::string::npos) break;
+        pos = slash + 1;
+    }
+
+    const int counts[3] = {(int)obj.positions.size(), (int)obj.texcoords.size(), (int)obj.normals.size()};
+    int* outIdx[3] = {&out.v, &out.vt, &out.vn};
+    for (int k = 0; k < 3; ++k) {
+        if (idx[k] == 0) continue;
+        const int i = idx[k] > 0 ? idx[k] - 1 : counts[k] + idx[k];
+        if (i < 0 || i >= counts[k]) return false;
+        *outIdx[k] = i;
+    }
+    return out.v >= 0;
+}
+
+bool parseRenderObj(const std::string& text, float scale, const Vec3& position, RenderObj& out) {
+    std::istringstream in(text);
+    std::string line, kind, rest;
+    int material = -1;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::istringstream fields(line);
+        kind.clear();
+        fields >> kind;
+        if (kind == "v") {
+            Vec3 p;
+            if (!(fields >> p.x >> p.y >> p.z)) return false;
+            out.positions.push_back(p * scale + position);
+        } else if (kind == "vt" || kind == "vn") {
+            std::getline(fields >> std::ws, rest);
+            (kind == "vt" ? out.texcoords : out.normals).push_back(rest);
+        } else if (kind == "usemtl") {
+            fields >> rest;
+            auto it = std::find(out.materials.begin(), out.materials.end(), rest);
+            material = (int)(it - out.materials.begin());
+            if (it == out.materials.end()) out.materials.push_back(rest);
+        } else if (kind == "mtllib") {
+            fields >> out.mtllib;
+        } else if (kind == "f") {
+            ObjFace face;
+            face.material = material;
+            face.first = (int)out.corners.size();
+            std::string token;
+            while (fields >> token) {
+                ObjCorner corner;
+                if (!parseCorner(token, out, corner)) break;
+                out.corners.push_back(corner);
+                ++face.count;
+            }
+            if (face.count >= 3) {
+                out.faces.push_back(face);
+            } else {
+                out.corners.resize(face.first);
+            }
+        }
+    }
+    return !out.faces.empty();
+}
+
+/// 把 obj 中的一个元素写到分块文件里，返回它在分块中的 1 起始下标（同一元素只写一次）
+int remapIndex(std::unordered_map<int, int>& remap, int index, int& next, bool& added) {
+    auto it = remap.find(index);
+    added = (it == remap.end());
+    if (!added) return it->second;
+    remap[index] = ++next;
+    return next;
+}
+
+std::string writeRenderTile(const RenderObj& obj, const std::vector<int>& faces) {
+    std::string vs, vts, vns, fs;
+    std::unordered_map<int, int> remapV, remapVt, remapVn;
+    int nextV = 0, nextVt = 0, nextVn = 0;
+    int material = -1;
+    char buf[128];
+    for (int f : faces) {
+        const ObjFace& face = obj.faces[f];
+        if (face.material != material && face.material >= 0) {
+            fs += "usemtl " + obj.materials[face.material] + "\n";
+            material = face.material;
+        }
+        fs += "f";
+        for (int k = 0; k < face.count; ++k) {
+            const ObjCorner& c = obj.corners[face.first + k];
+            bool added;
+            const int v = remapIndex(remapV, c.v, nextV, added);
+            if (added) {
+                const Vec3& p = obj.positions[c.v];
+                snprintf(buf, sizeof(buf), "v %.4f %.4f %.4f\n", p.x, p.y, p.z);
+                vs += buf;
+            }
+            snprintf(buf, sizeof(buf), " %d", v);
+            fs += buf;
+            if (c.vt >= 0 || c.vn >= 0) fs += "/";
+            if (c.vt >= 0) {
+                const int vt = remapIndex(remapVt, c.vt, nextVt, added);
+                if (added) vts += "vt " + obj.texcoords[c.vt] + "\n";
+                fs += std::to_string(vt);
+            }
+            if (c.vn >= 0) {
+                const int vn = remapIndex(remapVn, c.vn, nextVn, added);
+                if (added) vns += "vn " + obj.normals[c.vn] + "\n";
+                fs += "/" + std::to_string(vn);
+            }
+        }
+        fs += "\n";
+    }
+    const std::string header = obj.mtllib.empty() ? "" : "mtllib " + obj.mtllib + "\n";
+    return header + vs + vts + vns + fs;
+}
+
+std::string writeCollisionTile(const QuantizedMesh& mesh, const std::vector<int>& triangles) {
+    std::string vs, fs;
+    std::unordered_map<int, int> remap;
+    int next = 0;
+    char buf[128];
+    const std::vector<uint32_t>& indices = mesh.getIndices();
+    for (int t : triangles) {
+        int local[3];
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t index = indices[(size_t)t * 3 + k];
+            bool added;
+            local[k] = remapIndex(remap, (int)index, next, added);
+            if (added) {
+                const Vec3 p = mesh.getVertex(index);
+                snprintf(buf, sizeof(buf), "v %.4f %.4f %.4f\n", p.x, p.y, p.z);
+                vs += buf;
+            }
+        }
+        snprintf(buf, sizeof(buf), "f %d %d %d\n", local[0], local[1], local[2]);
+        fs += buf;
+    }
+    return vs + fs;
+}
+
+std::string directoryOf(const std::string& path) {
+    const size_t slash = path.find_last_of("/\\");
+    return (slash == std::string::npos) ? "" : path.substr(0, slash + 1);
+}
+
+std::vector<std::string> splitDirectory(const std::string& dir) {
+    std::vector<std::string> parts;
+    std::string part;
+    for (char c : dir + "/") {
+        if (c != '/' && c != '\\') {
+            part += c;
+            continue;
+        }
+        if (!part.empty() && part != ".") parts.push_back(part);
+        part.clear();
+    }
+    return parts;
+}
+
+/// 资源目录下从 fromDir 到 toDir 的相对路径（空串或以 / 结尾）
+std::string relativeDirectory(const std::string& fromDir, const std::string& toDir) {
+    const std::vector<std::string> from = splitDirectory(fromDir), to = splitDirectory(toDir);
+    size_t common = 0;
+    while (common < from.size() && common < to.size() && from[common] == to[common]) ++common;
+    std::string rel;
+    for (size_t i = common; i < from.size(); ++i) rel += "../";
+    for (size_t i = common; i < to.size(); ++i) rel += to[i] + "/";
+    return rel;
+}
+
+/// 复制材质库，贴图（map_* 行的最后一个字段）改为相对分块目录的路径
+std::string rebaseMaterialLibrary(const std::string& text, const std::string& texturePrefix) {
+    std::istringstream in(text);
+    std::string line, out;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const size_t last = line.find_last_of(" \t");
+        if (line.compare(0, 4, "map_") == 0 && last != std::string::npos && last + 1 < line.size()) {
+            line = line.substr(0, last + 1) + texturePrefix + line.substr(last + 1);
+        }
+        out += line + "\n";
+    }
+    return out;
+}
+
+} // namespace
+
+bool WorldBake::parseSceneDesc(const std::string& text, SceneDesc& out) {
+    out = SceneDesc();
+    std::istringstream in(text);
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        bool ok = true;
+        if (kind == "terrain") {
+            std::string accel;
+            ok = (fields >> out.terrainObj >> out.terrainScale >> out.terrainPosition.x >> out.terrainPosition.y
+                         >> out.terrainPosition.z >> accel) &&
+                 out.terrainScale > 0.0f && (accel == "bvh" || accel == "grid");
+            out.accel = (accel == "grid") ? TerrainCollider::AccelType::Grid : TerrainCollider::AccelType::BVH;
+        } else if (kind == "simplify") {
+            ok = (fields >> out.simplifyTolerance) && out.simplifyTolerance >= 0.0f;
+        } else if (kind == "spawn") {
+            Spawn spawn;
+            ok = (fields >> spawn.name >> spawn.x >> spawn.z) && spawn.name.size() < sizeof(BakedWorld::SpawnRecord::name);
+            if (ok) out.spawns.push_back(spawn);
+        } else if (kind == "prop") {
+            Prop prop;
+            ok = (fields >> prop.obj >> prop.x >> prop.z >> prop.yaw >> prop.scale) && prop.scale > 0.0f;
+            if (ok) out.props.push_back(prop);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            CCLOG("WorldBake: bad scene description line %d: %s", lineNo, line.c_str());
+            return false;
+        }
+    }
+    return !out.terrainObj.empty();
+}
+
+uint64_t WorldBake::computeKey(const std::string& descText, const std::string& objFullPath) {
+    // 不含 .obj 的完整路径：烘焙文件随资源发布，运行时的路径与烘焙时不同
+    uint64_t key = CollisionCache::hash(descText.data(), descText.size());
+    return CollisionCache::hashFile(objFullPath, key);
+}
+
+bool WorldBake::bake(const std::string& descPath, const std::string& outFullPath) {
+    const std::string descText = FileUtils::getInstance()->getStringFromFile(descPath);
+    SceneDesc desc;
+    if (descText.empty() || !parseSceneDesc(descText, desc)) {
+        CCLOG("WorldBake: cannot read scene description %s", descPath.c_str());
+        return false;
+    }
+    const std::string objFullPath = FileUtils::getInstance()->fullPathForFilename(desc.terrainObj);
+    if (objFullPath.empty()) {
+        CCLOG("WorldBake: terrain %s not found", desc.terrainObj.c_str());
+        return false;
+    }
+
+    TerrainCollider* collider = TerrainCollider::createFromObj(desc.terrainObj, desc.accel, desc.terrainScale,
+                                                               desc.terrainPosition, desc.simplifyTolerance);
+    if (!collider) {
+        CCLOG("WorldBake: failed to build collision for %s", desc.terrainObj.c_str());
+        return false;
+    }
+
+    std::vector<BakedWorld::SpawnRecord> spawns(desc.spawns.size());
+    for (size_t i = 0; i < desc.spawns.size(); ++i) {
+        const Spawn& s = desc.spawns[i];
+        BakedWorld::SpawnRecord& rec = spawns[i];
+        std::memset(&rec, 0, sizeof(rec));
+        std::strncpy(rec.name, s.name.c_str(), sizeof(rec.name) - 1);
+        rec.x = s.x;
+        rec.z = s.z;
+        rec.grounded = probeAt(collider, s.x, s.z, GroundProbeBatch::kProbeHeight, rec.y) ? 1 : 0;
+        if (!rec.grounded) {
+            CCLOG("WorldBake: spawn %s at (%.1f, %.1f) has no ground below", rec.name, s.x, s.z);
+        }
+    }
+
+    // 导航网格由烘焙出的碰撞网格生成，与运行时回退路径 NavMesh::create(collider) 的结果相同
+    NavMesh* navMesh = NavMesh::create(collider);
+    if (!navMesh) {
+        CCLOG("WorldBake: no walkable triangles in %s", desc.terrainObj.c_str());
+        return false;
+    }
+
+    const uint64_t key = computeKey(descText, objFullPath);
+    bool ok = collider->writeToFile(outFullPath, key, [&](CollisionCache::Writer& writer) {
+        writer.addSection(kTagSpawns, spawns.data(), spawns.size() * sizeof(BakedWorld::SpawnRecord));
+        navMesh->addBakeSections(writer);
+    });
+
+    CCLOG("WorldBake: %d triangles, %d spawns, %d nav polys -> %s%s", collider->getLoadStats().triangleCount,
+          (int)spawns.size(), navMesh->getPolyCount(), outFullPath.c_str(), ok ? "" : " (write failed)");
+    return ok;
+}
+
+bool WorldBake::bakeTiles(const std::string& descPath, const std::string& tileDir, const std::string& tileDirFullPath,
+                          float tileSize) {
+    FileUtils* fileUtils = FileUtils::getInstance();
+    const std::string descText = fileUtils->getStringFromFile(descPath);
+    SceneDesc desc;
+    if (descText.empty() || !parseSceneDesc(descText, desc) || tileSize <= 0.0f) {
+        CCLOG("WorldBake: cannot read scene description %s", descPath.c_str());
+        return false;
+    }
+
+    // 碰撞分块取自与 bake 相同的碰撞代理，流式地形与整块地形的碰撞结果一致
+    TerrainCollider* collider = TerrainCollider::createFromObj(desc.terrainObj, desc.accel, desc.terrainScale,
+                                                               desc.terrainPosition, desc.simplifyTolerance);
+    RenderObj render;
+    if (!collider || !parseRenderObj(fileUtils->getStringFromFile(desc.terrainObj), desc.terrainScale,
+                                     desc.terrainPosition, render)) {
+        CCLOG("WorldBake: failed to read terrain %s", desc.terrainObj.c_str());
+        return false;
+    }
+
+    Vec3 bmin, bmax;
+    collider->getBounds(bmin, bmax);
+    TileGrid grid;
+    grid.size = tileSize;
+    grid.originX = std::floor(bmin.x / tileSize) * tileSize;
+    grid.originZ = std::floor(bmin.z / tileSize) * tileSize;
+    grid.cols = std::max(1, (int)std::ceil((bmax.x - grid.originX) / tileSize));
+    grid.rows = std::max(1, (int)std::ceil((bmax.z - grid.originZ) / tileSize));
+
+    const size_t cellCount = (size_t)grid.cols * grid.rows;
+    std::vector<std::vector<int>> renderFaces(cellCount), collisionTris(cellCount);
+    int c0, c1, r0, r1;
+    for (int f = 0; f < (int)render.faces.size(); ++f) {
+        const ObjFace& face = render.faces[f];
+        float minX = FLT_MAX, maxX = -FLT_MAX, minZ = FLT_MAX, maxZ = -FLT_MAX;
+        for (int k = 0; k < face.count; ++k) {
+            const Vec3& p = render.positions[render.corners[face.first + k].v];
+            minX = std::min(minX, p.x);
+            maxX = std::max(maxX, p.x);
+            minZ = std::min(minZ, p.z);
+            maxZ = std::max(maxZ, p.z);
+        }
+        if (!grid.range(minX, maxX, minZ, maxZ, c0, c1, r0, r1)) continue;
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) renderFaces[(size_t)r * grid.cols + c].push_back(f);
+        }
+    }
+    const QuantizedMesh& mesh = collider->getMesh();
+    for (int t = 0; t < mesh.getTriangleCount(); ++t) {
+        Vec3 v0, v1, v2;
+        mesh.getTriangle(t, v0, v1, v2);
+        if (!grid.range(std::min(std::min(v0.x, v1.x), v2.x), std::max(std::max(v0.x, v1.x), v2.x),
+                        std::min(std::min(v0.z, v1.z), v2.z), std::max(std::max(v0.z, v1.z), v2.z),
+                        c0, c1, r0, r1)) {
+            continue;
+        }
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) collisionTris[(size_t)r * grid.cols + c].push_back(t);
+        }
+    }
+
+    fileUtils->createDirectory(tileDirFullPath);
+    bool ok = true;
+    if (!render.mtllib.empty()) {
+        const std::string objDir = directoryOf(desc.terrainObj);
+        const std::string mtlText = fileUtils->getStringFromFile(objDir + render.mtllib);
+        ok = !mtlText.empty() &&
+             fileUtils->writeStringToFile(rebaseMaterialLibrary(mtlText, relativeDirectory(tileDir, objDir)),
+                                          tileDirFullPath + render.mtllib);
+    }
+
+    char buf[256];
+    snprintf(buf, sizeof(buf), "# 由 world_bake tiles 从 %s 生成\ngrid %g %g %g %d %d\n", descPath.c_str(),
+             grid.originX, grid.originZ, grid.size, grid.cols, grid.rows);
+    std::string manifest = buf;
+    int tileCount = 0;
+    for (int r = 0; r < grid.rows && ok; ++r) {
+        for (int c = 0; c < grid.cols && ok; ++c) {
+            const size_t cell = (size_t)r * grid.cols + c;
+            if (collisionTris[cell].empty()) continue;
+
+            char name[64];
+            snprintf(name, sizeof(name), "tile_%d_%d", c, r);
+            const std::string collisionFile = std::string(name) + "_col.obj";
+            std::string renderFile = "-";
+            if (!renderFaces[cell].empty()) {
+                renderFile = std::string(name) + ".obj";
+                ok = fileUtils->writeStringToFile(writeRenderTile(render, renderFaces[cell]), tileDirFullPath + renderFile);
+            }
+            ok = ok && fileUtils->writeStringToFile(writeCollisionTile(mesh, collisionTris[cell]),
+                                                    tileDirFullPath + collisionFile);
+            manifest += "tile " + std::to_string(c) + " " + std::to_string(r) + " " + renderFile + " " +
+                        collisionFile + "\n";
+            ++tileCount;
+        }
+    }
+    ok = ok && fileUtils->writeStringToFile(manifest, tileDirFullPath + "manifest.txt");
+
+    CCLOG("WorldBake: %d tiles on a %dx%d grid (tile size %.0f) -> %s%s", tileCount, grid.cols, grid.rows, tileSize,
+          tileDirFullPath.c_str(), ok ? "" : " (write failed)");
+    return ok;
+}
+
+BakedWorld* BakedWorld::create(const std::string& descPath, const std::string& bakePath, Sprite3D* terrainModel) {
+    auto pRet = new (std::nothrow) BakedWorld();
+    if (pRet && pRet->init(descPath, bakePath, terrainModel)) {
+        pRet->autorelease();
+        return pRet;
+    }
+    delete pRet;
+    return nullptr;
+}
+
+BakedWorld::~BakedWorld() {
+    CC_SAFE_RELEASE(_collider);
+    CC_SAFE_RELEASE(_navMesh);
+}
+
+bool BakedWorld::init(const std::string& descPath, const std::string& bakePath, Sprite3D* terrainModel) {
+    const std::string descText = FileUtils::getInstance()->getStringFromFile(descPath);
+    if (descText.empty() || !WorldBake::parseSceneDesc(descText, _desc)) return false;
+
+    // 三角形已按描述中的变换烘焙为世界坐标，模型摆放不一致时数据不可用
+    if (terrainModel && (terrainModel->getScale() != _desc.terrainScale ||
+                         terrainModel->getPosition3D() != _desc.terrainPosition)) {
+        CCLOG("BakedWorld: terrain transform differs from %s, ignoring %s", descPath.c_str(), bakePath.c_str());
+        return false;
+    }
+
+    const std::string fullPath = FileUtils::getInstance()->fullPathForFilename(bakePath);
+    const std::string objFullPath = FileUtils::getInstance()->fullPathForFilename(_desc.terrainObj);
+    if (fullPath.empty() || objFullPath.empty()) return false;
+
+    CollisionCache::Reader reader;
+    if (!reader.open(fullPath, WorldBake::computeKey(descText, objFullPath))) {
+        CCLOG("BakedWorld: %s is missing or stale", bakePath.c_str());
+        return false;
+    }
+
+    size_t spawnSize = 0;
+    auto spawns = static_cast<const SpawnRecord*>(reader.getSection(kTagSpawns, spawnSize));
+    if ((spawnSize > 0 && !spawns) || spawnSize % sizeof(SpawnRecord) != 0) return false;
+
+    _navMesh = NavMesh::createFromBake(reader);
+    if (!_navMesh) {
+        CCLOG("BakedWorld: %s has no valid navigation sections", bakePath.c_str());
+        return false;
+    }
+    _navMesh->retain();
+
+    _collider = new (std::nothrow) TerrainCollider();
+    if (!_collider || !_collider->initFromBake(terrainModel, reader, _desc.accel)) return false;
+
+    _spawns.assign(spawns, spawns + spawnSize / sizeof(SpawnRecord));
+
+    CCLOG("BakedWorld: %s loaded, %d spawns, %d nav polys", bakePath.c_str(), (int)_spawns.size(),
+          _navMesh->getPolyCount());
+    return true;
+}
+
+bool BakedWorld::findSpawnHeight(float x, float z, float& outY) const {
+    for (const auto& s : _spawns) {
+        if (s.grounded && std::fabs(s.x - x) <= kSpawnMatchEpsilon && std::fabs(s.z - z) <= kSpawnMatchEpsilon) {
+            outY = s.y;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,138 @@
+#ifndef __WORLD_BAKE_H__
+#define __WORLD_BAKE_H__
+
+#include "cocos2d.h"
+#include "Collider.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class NavMesh;
+
+/**
+ * @namespace WorldBake
+ * @brief 离线世界烘焙：地形 .obj + 场景描述 -> 单个带版本号的二进制文件
+ *
+ * 烘焙文件沿用碰撞缓存的分段容器（CollisionCache），包含：
+ * - 碰撞网格、加速结构与高度场（与运行时碰撞缓存的段完全相同）；
+ * - 预先贴地的出生点高度（SPWN）；
+ * - 导航网格的多边形与连接关系（NAVP/NAVS），定位网格与簇在加载时重建。
+ * 来源键由场景描述全文与地形 .obj 的内容摘要（CollisionCache::hashFile）组成，任一变化都会使烘焙文件失效，
+ * 运行时回退到解析 .obj。
+ *
+ * 场景描述为文本格式，# 开头的行为注释：
+ *     terrain <.obj 路径> <缩放> <x> <y> <z> <bvh|grid>
+ *     simplify <容差>        （可选，碰撞代理相对渲染网格的最大偏差）
+ *     spawn <名称> <x> <z>
+ *     prop <.obj 路径> <x> <z> <朝向角度> <缩放>
+ * prop 行描述独立导出的静态物件，运行时放在地面上并加入 StaticCollisionWorld，不进入烘焙数据。
+ */
+namespace WorldBake {
+
+struct Spawn {
+    std::string name;
+    float x = 0.0f, z = 0.0f;
+};
+
+struct Prop {
+    std::string obj;
+    float x = 0.0f, z = 0.0f;
+    float yaw = 0.0f;   ///< 绕 Y 轴的朝向（角度）
+    float scale = 1.0f;
+};
+
+struct SceneDesc {
+    std::string terrainObj;
+    float terrainScale = 1.0f;
+    cocos2d::Vec3 terrainPosition;
+    TerrainCollider::AccelType accel = TerrainCollider::AccelType::BVH;
+    float simplifyTolerance = 0.0f;
+    std::vector<Spawn> spawns;
+    std::vector<Prop> props;
+};
+
+/**
+ * @brief 解析场景描述文本
+ * @return bool 是否包含合法的 terrain 行且没有无法识别的行
+ */
+bool parseSceneDesc(const std::string& text, SceneDesc& out);
+
+/**
+ * @brief 烘焙文件的来源键：场景描述全文 + 地形 .obj 的大小与头尾采样内容
+ */
+uint64_t computeKey(const std::string& descText, const std::string& objFullPath);
+
+/**
+ * @brief 执行烘焙（离线工具调用）
+ * @param descPath 场景描述路径（经 FileUtils 搜索路径解析）
+ * @param outFullPath 输出文件完整路径
+ * @return bool 是否成功写出
+ */
+bool bake(const std::string& descPath, const std::string& outFullPath);
+
+/**
+ * @brief 把场景描述中的地形切分为等大的 XZ 分块，写出 TerrainStreamer 读取的清单与分块 .obj（离线工具调用）
+ *
+ * 每个分块写出两个世界坐标的 .obj：
+ * - 渲染网格：原始 .obj 中 XZ 包围盒与分块相交的面，保留纹理坐标、法线与材质；
+ * - 碰撞网格：与 bake 相同的碰撞代理（已按 simplify 简化）中与分块相交的三角形。
+ * 跨越分块边界的面在相邻分块中各存一份；没有三角形的分块不写入清单。
+ * 原始 .obj 引用的材质库复制到分块目录，贴图路径改写为相对分块目录。
+ *
+ * @param descPath 场景描述路径（经 FileUtils 搜索路径解析）
+ * @param tileDir 分块目录在资源目录下的相对路径（以 / 结尾），清单写为 tileDir + "manifest.txt"
+ * @param tileDirFullPath 分块目录的完整路径（以 / 结尾）
+ * @param tileSize 分块边长（世界单位）
+ * @return bool 是否成功写出清单与全部分块
+ */
+bool bakeTiles(const std::string& descPath, const std::string& tileDir, const std::string& tileDirFullPath,
+               float tileSize);
+
+} // namespace WorldBake
+
+/**
+ * @class BakedWorld
+ * @brief 运行时加载的烘焙世界：映射烘焙文件，直接得到碰撞器、出生点高度和导航网格
+ */
+class BakedWorld : public cocos2d::Ref {
+public:
+    /**
+     * @brief 加载烘焙文件
+     * @param descPath 烘焙时使用的场景描述，用于校验来源键
+     * @param bakePath 烘焙文件路径
+     * @param terrainModel 已按场景描述摆放的地形模型（可为空），变换与描述不一致时加载失败
+     * @return BakedWorld* 文件缺失、过期或损坏时返回 nullptr
+     */
+    static BakedWorld* create(const std::string& descPath, const std::string& bakePath,
+                              cocos2d::Sprite3D* terrainModel);
+
+    virtual ~BakedWorld();
+
+    bool init(const std::string& descPath, const std::string& bakePath, cocos2d::Sprite3D* terrainModel);
+
+    TerrainCollider* getCollider() const { return _collider; }
+    NavMesh* getNavMesh() const { return _navMesh; }
+    const WorldBake::SceneDesc& getSceneDesc() const { return _desc; }
+
+    /**
+     * @brief 查找 XZ 与 (x, z) 重合的烘焙出生点
+     * @param outY 输出：出生点的地面高度
+     * @return bool 找到且烘焙时成功贴地
+     */
+    bool findSpawnHeight(float x, float z, float& outY) const;
+
+    /// 烘焙文件中的出生点记录
+    struct SpawnRecord {
+        char name[32];
+        float x, y, z;
+        uint32_t grounded;
+    };
+
+private:
+    TerrainCollider* _collider = nullptr; ///< 持有引用
+    NavMesh* _navMesh = nullptr;          ///< 持有引用
+    WorldBake::SceneDesc _desc;
+    std::vector<SpawnRecord> _spawns;
+};
+
+#endif // __WORLD_BAKE_H__
@@ -39,13 +39,17 @@ AreaManager::AreaType AreaManager::getCurrentAreaType(const Vec3& playerPos) {
     }
 
     // 检查是否在战斗区域
+    const AreaInfo* area = getAreaAt(playerPos);
+    return area ? area->type : AreaType::NONE;
+}
+
+const AreaManager::AreaInfo* AreaManager::getAreaAt(const Vec3& pos) const {
     for (const auto& area : _areas) {
-        if (area.bounds.containsPoint(Vec2(playerPos.x, playerPos.z))) {
-            return area.type;
+        if (area.bounds.containsPoint(Vec2(pos.x, pos.z))) {
+            return &area;
         }
     }
-
-    return AreaType::NONE;
+    return nullptr;
 }
 
 bool AreaManager::isNearTeleportPoint(const Vec3& playerPos, int& outPointIndex) {
@@ -66,7 +70,7 @@ void AreaManager::teleport(Node* player) {
     int currentIdx;
     if (isNearTeleportPoint(currentPos, currentIdx)) {
         // 如果在传送点 A，传送到 B；如果在 B，传送到 A
-        int targetIdx = (currentIdx == 0) ? 1 : 0;
+        int targetIdx = getTeleportTargetIndex(currentIdx);
         Vec3 targetPos = _teleportPoints[targetIdx].position;
         
         player->setPosition3D(targetPos);
@@ -42,11 +42,21 @@ public:
      */
     AreaType getCurrentAreaType(const cocos2d::Vec3& playerPos);
 
+    /**
+     * @brief 获取包含该位置的战斗区域（不考虑传送点），不在任何区域内时返回 nullptr
+     */
+    const AreaInfo* getAreaAt(const cocos2d::Vec3& pos) const;
+
     /**
      * @brief 检查玩家是否在传送点附近（可交互范围）
      */
     bool isNearTeleportPoint(const cocos2d::Vec3& playerPos, int& outPointIndex);
 
+    /**
+     * @brief 从传送点 fromIndex 传送时的目的地下标
+     */
+    int getTeleportTargetIndex(int fromIndex) const { return (fromIndex == 0) ? 1 : 0; }
+
     /**
      * @brief 执行传送逻辑
      * @param player 玩家对象
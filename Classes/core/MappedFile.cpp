@@ -0,0 +1,100 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& fullPath) {
+    close();
+
+    // 路径为 UTF-8，需转换为宽字符才能正确打开中文路径
+    int wlen = MultiByteToWideChar(CP_UTF8, 0, fullPath.c_str(), -1, nullptr, 0);
+    if (wlen <= 0) return false;
+    std::wstring wpath(wlen, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, fullPath.c_str(), -1, &wpath[0], wlen);
+
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    _fileHandle = file;
+    _mapHandle = mapping;
+    _data = static_cast<const char*>(view);
+    _size = (size_t)size.QuadPart;
+    return true;
+}
+
+void MappedFile::close() {
+    if (_data) UnmapViewOfFile(_data);
+    if (_mapHandle) CloseHandle((HANDLE)_mapHandle);
+    if (_fileHandle) CloseHandle((HANDLE)_fileHandle);
+    _data = nullptr;
+    _size = 0;
+    _mapHandle = nullptr;
+    _fileHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& fullPath) {
+    close();
+
+    int fd = ::open(fullPath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // 映射建立后即可关闭文件描述符，映射本身保持有效
+    ::close(fd);
+    if (addr == MAP_FAILED) return false;
+
+    _data = static_cast<const char*>(addr);
+    _size = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (_data) munmap(const_cast<char*>(_data), _size);
+    _data = nullptr;
+    _size = 0;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @class MappedFile
+ * @brief 只读内存映射文件（Windows 使用 CreateFileMapping，其余平台使用 mmap）
+ *
+ * 只能映射磁盘上的真实文件；Android APK 内的资源无法映射，open 会返回 false，
+ * 调用方应回退到 FileUtils 读取。
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief 映射文件
+     * @param fullPath 文件完整路径
+     * @return bool 是否映射成功（空文件视为失败）
+     */
+    bool open(const std::string& fullPath);
+
+    /**
+     * @brief 解除映射并关闭文件
+     */
+    void close();
+
+    bool isOpen() const { return _data != nullptr; }
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    void* _fileHandle = nullptr;
+    void* _mapHandle = nullptr;
+#endif
+};
+
+#endif // __MAPPED_FILE_H__
@@ -43,6 +43,8 @@ bool Boss::initBoss(const std::string& resRoot, const std::string& modelFile) {
   }
 
   setEnemyType(EnemyType::BOSS);
+  // Boss 的移动由技能状态直接控制，避障时只作为其他敌人的障碍。
+  setCrowdSteered(false);
 
   _viewRange = 500.0f;
   _maxChaseRange = 500.f;
@@ -52,35 +52,35 @@ static BossSkillConfig getCfg(const std::string& skill) {
     return BossSkillConfig{
       "Combo3", "combo3",
       0.35f, 0.0f, 0.50f, 0.65f,  // 增加所有时间参数以延长动画播放时间
-      0.f, M(1.2f), 12.f, false
+      0.f, AttackShape::sector(M(1.2f), 60.0f), 12.f, false  // 三连斩：前方 120 度扇形
     };
   }
   if (skill == "DashSlash") {
     return BossSkillConfig{
       "DashSlash", "rush",
       0.30f, 0.25f, 0.15f, 0.50f,
-      M(2.0f), M(1.4f), 16.f, true
+      M(2.0f), AttackShape::orientedBox(M(2.4f), M(0.5f)), 16.f, true  // 冲刺斩：沿冲刺方向的长条，覆盖停在玩家前的距离
     };
   }
   if (skill == "GroundSlam") {
     return BossSkillConfig{
       "GroundSlam", "groundslam",
       0.60f, 0.0f, 0.20f, 0.80f,
-      0.f, M(1.7f), 20.f, false
+      0.f, AttackShape::ring(0.f, M(1.7f), M(0.3f)), 20.f, false  // 砸地：身前落点周围的圆盘
     };
   }
   if (skill == "Roar") {
     return BossSkillConfig{
       "Roar", "roar",
       1.00f, 0.0f, 0.0f, 0.0f,
-      0.f, 0.f, 0.f, false
+      0.f, AttackShape(), 0.f, false  // 咆哮：没有伤害
     };
   }
   if (skill == "LeapSlam") {
     return BossSkillConfig{
       "LeapSlam", "rush",  // 首先播放rush动画
       0.35f, 0.35f, 0.15f, 1.30f,  // 延长recovery时间以容纳第二个动画
-      M(2.0f), M(3.0f), 26.f, true
+      M(2.0f), AttackShape::ring(0.f, M(3.0f)), 26.f, true  // 跳劈：落地冲击波
     };
   }
 
@@ -88,26 +88,33 @@ static BossSkillConfig getCfg(const std::string& skill) {
 }
 
 // 应用一次伤害判定
+// 判定形状以 Boss 当前位置为原点、沿技能朝向摆放，与玩家当前的包围盒求交
 // @param enemy 敌人对象
 // @param cfg 技能配置
 // @param dmgMul 伤害倍率
-static void applyHitOnce(Enemy* enemy, const BossSkillConfig& cfg, float dmgMul) {
-  if (!enemy) return;
+// @param facingW 技能朝向（世界坐标）
+static void applyHitOnce(Enemy* enemy, const BossSkillConfig& cfg, float dmgMul, const Vec3& facingW) {
+  if (!enemy || cfg.damage <= 0.f) return;
+
+  auto target = enemy->getTarget();
+  if (!target || !target->getHealth()) return;
+
+  // 玩家已登记时包围盒取自登记表，否则直接读碰撞器
+  auto registry = enemy->getCombatantRegistry();
+  const CombatantRegistry::Handle handle = target->getCombatantHandle();
+  const AABB& targetBox = (registry && registry->isValid(handle)) ? registry->getBounds(handle)
+                                                                  : target->getCollider().worldAABB;
 
-  Vec3 pW = enemy->getTargetWorldPos();
   Vec3 eW = enemy->getWorldPosition3D();
-  float dist = (pW - eW).length();
+  float dist = (enemy->getTargetWorldPos() - eW).length();
 
-  if (dist <= cfg.hitRadius) {
+  if (cfg.shape.test(eW, facingW, targetBox)) {
     float dmg = cfg.damage * dmgMul;
     CCLOG("[BossAttack] %s HIT dmg=%.2f dist=%.1f", cfg.skill.c_str(), dmg, dist);
 
     // 使用与普通敌人相同的减血逻辑
-    auto target = enemy->getTarget();
-    if (target && target->getHealth()) {
-      target->getHealth()->takeDamage(dmg, enemy);
-      CCLOG("Boss dealt %.2f damage to player", dmg);
-    }
+    target->getHealth()->takeDamage(dmg, enemy);
+    CCLOG("Boss dealt %.2f damage to player", dmg);
   }
   else {
     CCLOG("[BossAttack] %s miss dist=%.1f", cfg.skill.c_str(), dist);
@@ -252,6 +259,12 @@ void BossAttackState::onEnter(Enemy* enemy) {
   _startW = enemy->getWorldPosition3D();  // 记录起始位置
 
   _targetW = enemy->getTargetWorldPos();  // 获取目标位置
+
+  // 技能朝向：开始时面向玩家的水平方向
+  _facingW = _targetW - _startW;
+  _facingW.y = 0;
+  if (_facingW.lengthSquared() > 1e-6f) _facingW.normalize();
+  else _facingW = Vec3::UNIT_Z;
   if (_cfg.moveTime > 0.f && _cfg.lockTarget) {
     // 如果是移动类技能且需要锁定目标，则计算跳跃目标位置
     Vec3 toP = _targetW - _startW;
@@ -301,15 +314,17 @@ void BossAttackState::onUpdate(Enemy* enemy, float dt) {
     float denom = std::max(0.0001f, _cfg.moveTime);
     float t01 = std::min(1.0f, _timer / denom);  // 计算移动进度
 
-    // 计算当前位置
-    Vec3 newW = _startW + (_targetW - _startW) * t01;
-    newW.y = enemy->getWorldPosition3D().y;
+    // 从当前位置扫掠到本帧应到达的位置：帧间隔再大也不会越过玩家或穿过墙
+    Vec3 curW = enemy->getWorldPosition3D();
+    Vec3 wantW = _startW + (_targetW - _startW) * t01;
+    Vec3 moveW;
+    bool blocked = enemy->sweepMove(wantW - curW, ActorSpatialHash::kLayerPlayer, moveW);
 
     faceToWorldDir(enemy, _targetW - _startW);  // 让Boss面向目标方向
-    enemy->setPosition3D(worldToParentSpace(enemy, newW));  // 设置新位置
+    enemy->setPosition3D(worldToParentSpace(enemy, curW + moveW));  // 设置新位置
 
-    if (_timer >= _cfg.moveTime) {
-      gotoStage(Stage::Active);  // 移动完成后进入伤害判定阶段
+    if (blocked || _timer >= _cfg.moveTime) {
+      gotoStage(Stage::Active);  // 移动完成或停在首次接触处后进入伤害判定阶段
     }
     return;
   }
@@ -317,7 +332,7 @@ void BossAttackState::onUpdate(Enemy* enemy, float dt) {
   // 3) 伤害判定阶段
   if (_stage == Stage::Active) {
     if (!_didHit) {
-      applyHitOnce(enemy, _cfg, boss->getDmgMul());  // 应用伤害判定
+      applyHitOnce(enemy, _cfg, boss->getDmgMul(), _facingW);  // 应用伤害判定
       _didHit = true;  // 设置伤害判定标志
     }
 
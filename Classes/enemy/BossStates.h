@@ -6,6 +6,7 @@
 #include "core/StateMachine.h"   // BaseState/StateMachine 所在文件
 #include <string>
 #include "combat/HealthComponent.h"
+#include "combat/AttackShape.h"
 #include "combat/CombatComponent.h"
 
 // ========== 技能配置（AttackState 用）==========
@@ -20,7 +21,7 @@ struct BossSkillConfig {
   float recovery = 0.f;  // 技能后摇时间（秒）
 
   float dashDistance = 0.f; // Dash/Leap 跳跃到玩家的距离（世界单位）
-  float hitRadius = 0.f;    // 命中判定半径（世界单位）
+  AttackShape shape;        // 命中判定形状（世界单位，朝向为技能开始时面向玩家的方向）
   float damage = 0.f;       // 技能伤害值
   bool  lockTarget = true;  // 是否锁定跳跃目标位置
 };
@@ -107,6 +108,7 @@ private:
 
   cocos2d::Vec3 _startW = cocos2d::Vec3::ZERO;    // 起始世界位置
   cocos2d::Vec3 _targetW = cocos2d::Vec3::ZERO;   // 目标世界位置（用于位移）
+  cocos2d::Vec3 _facingW = cocos2d::Vec3::UNIT_Z; // 技能朝向（世界坐标，用于摆放判定形状）
 };
 
 // ========== Boss Hit ==========
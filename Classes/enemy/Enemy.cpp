@@ -7,7 +7,14 @@
 #include "combat/HealthComponent.h"
 #include "combat/CombatComponent.h"
 #include "combat/Collider.h"
+#include "combat/CapsuleSweep.h"
 #include "player/Wukong.h"
+#include <cfloat>
+
+// 寻路参数
+static const float kRepathInterval = 0.5f;  // 重新寻路的间隔（秒）
+static const float kRepathDistance = 50.0f; // 目标移动超过该距离时立即重新寻路
+static const float kWaypointRadius = 20.0f; // 到达路径点的 XZ 距离
 
 // 创建Enemy实例的静态工厂方法
 // @return Enemy* 创建成功返回敌人指针，失败返回nullptr
@@ -50,6 +57,36 @@ Enemy::~Enemy() {
     }
 }
 
+// 进入场景：登记到战斗参与者登记表
+void Enemy::onEnter() {
+    Node::onEnter();
+    if (_combatants && _combatantHandle == CombatantRegistry::kInvalidHandle) {
+        _combatantHandle = _combatants->add(this, _health, _combat, _collider.worldAABB);
+    }
+}
+
+// 离开场景（死亡移除或场景销毁）：从登记表注销
+void Enemy::onExit() {
+    if (_combatants) {
+        _combatants->remove(_combatantHandle);
+    }
+    _combatantHandle = CombatantRegistry::kInvalidHandle;
+    Node::onExit();
+}
+
+// 设置场景级战斗参与者登记表
+// @param registry 登记表，已在场景中时立即登记
+void Enemy::setCombatantRegistry(CombatantRegistry* registry) {
+    if (_combatants) {
+        _combatants->remove(_combatantHandle);
+    }
+    _combatantHandle = CombatantRegistry::kInvalidHandle;
+    _combatants = registry;
+    if (_combatants && isRunning()) {
+        _combatantHandle = _combatants->add(this, _health, _combat, _collider.worldAABB);
+    }
+}
+
 // 初始化Enemy
 // 初始化父类Node，创建状态机、生命值组件和战斗组件
 // @return bool 初始化成功返回true，失败返回false
@@ -85,16 +122,82 @@ bool Enemy::init() {
 void Enemy::update(float deltaTime) {
     Node::update(deltaTime);
     
-    // 更新状态机
+    // 更新状态机（移动类状态在其中给出期望速度）
+    _preferredVelocity = Vec3::ZERO;
     if (_stateMachine) {
         _stateMachine->update(deltaTime);
     }
 
+    // 在影响图上盖占用章，供其他敌人挑选包围位时参考
+    if (_influence && !isDead()) {
+        _influence->stampOccupancy(this->getPosition3D(), getBodyRadius());
+    }
+
+    updateCrowd(deltaTime);
     applyGravity(deltaTime);
-    applyMovement(deltaTime);
+    applyMovement(deltaTime); // 位置落定后会同步更新 AABB 碰撞盒
+}
 
-    // 更新 AABB 碰撞盒到世界空间
-    _collider.update(this);
+// 身体半径
+// @return float 地形扫掠胶囊体的半径
+float Enemy::getBodyRadius() const {
+    Vec3 axisBottom, axisTop;
+    float radius;
+    _collider.getCapsule(TerrainQuery::kMaxStepHeight, axisBottom, axisTop, radius);
+    return radius;
+}
+
+// 领取包围位
+// @param outPos 输出：包围位位置
+// @return bool 是否持有包围位
+bool Enemy::claimSurroundSlot(Vec3& outPos) {
+    if (!_influence) {
+        return false;
+    }
+    _surroundSlot = _influence->claimSlot(this, this->getPosition3D(), _surroundSlot);
+    if (_surroundSlot < 0) {
+        return false;
+    }
+    outPos = _influence->getSlotPosition(_surroundSlot);
+    return true;
+}
+
+// 归还包围位
+void Enemy::releaseSurroundSlot() {
+    if (_influence) {
+        _influence->releaseSlot(this, _surroundSlot);
+    }
+    _surroundSlot = -1;
+}
+
+// 避障
+// 按上一次避障求解的速度设置水平速度，并提交本帧的位置与期望速度
+// 状态在本帧停下（期望速度为零）而上一次求解仍是移动中的期望时直接清零，避免多滑一帧
+// @param dt 帧间隔时间
+void Enemy::updateCrowd(float dt) {
+    const Vec3 pos = this->getPosition3D();
+    const bool active = _crowd && !isDead();
+
+    if (_crowdSteered) {
+        Vec3 horizontal = active ? _crowdVelocity : _preferredVelocity;
+        if (active && _crowdSolvedMoving && _preferredVelocity.isZero()) {
+            horizontal = Vec3::ZERO; // 本帧状态已停下，上一次求解对应的是移动中的期望速度
+        }
+        _velocity.x = horizontal.x;
+        _velocity.z = horizontal.z;
+    }
+
+    if (active) {
+        Vec3 velocity(_velocity.x, 0.0f, _velocity.z);
+        if (!_crowdSteered && dt > 0.0f) {
+            velocity = (pos - _crowdLastPos) / dt; // 由状态直接移动，按位移估计速度
+            velocity.y = 0.0f;
+        }
+        _crowd->submit(_crowdSteered ? this : nullptr, this, pos, getBodyRadius(), velocity, _preferredVelocity,
+                       getMoveSpeed());
+        _crowdSolvedMoving = !_preferredVelocity.isZero();
+    }
+    _crowdLastPos = pos;
 }
 
 // 应用重力效果
@@ -108,46 +211,35 @@ void Enemy::applyGravity(float dt) {
 }
 
 // 应用移动效果
-// 处理敌人的位置更新和地形碰撞检测
+// 计算候选位置并提交地面探测；没有批处理时立即检测
 // @param dt 帧间隔时间
 void Enemy::applyMovement(float dt) {
     Vec3 oldPos = this->getPosition3D();
     Vec3 newPos = oldPos + _velocity * dt;
 
     if (_terrainCollider) {
-        // 射线检测新位置地面
-        CustomRay ray(newPos + Vec3(0, 500, 0), Vec3(0, -1, 0));
-        float hitDist;
-
-        if (_terrainCollider->rayIntersects(ray, hitDist)) {
-            float groundY = ray.origin.y - hitDist;
-            const float MAX_STEP_HEIGHT = 40.0f;
-
-            if (groundY - oldPos.y < MAX_STEP_HEIGHT) {
-                newPos.y = groundY;
-                this->setPosition3D(newPos);
-                
-                if (!_onGround && _velocity.y <= 0) {
-                    _onGround = true;
-                    _velocity.y = 0;
-                }
-            } else {
-                // 坡度太陡
-                Vec3 finalPos = oldPos;
-                finalPos.y += _velocity.y * dt; 
-                
-                if (finalPos.y <= groundY) {
-                    finalPos.y = groundY;
-                    _onGround = true;
-                    _velocity.y = 0;
-                }
-                this->setPosition3D(finalPos);
-            }
-        } else {
-            // 没检测到地面
-            this->setPosition3D(newPos);
-            _onGround = false;
+        // 水平位移先与地形做胶囊体扫掠，碰到墙面时沿墙滑动
+        Vec3 axisBottom, axisTop;
+        float radius;
+        _collider.getCapsule(TerrainQuery::kMaxStepHeight, axisBottom, axisTop, radius);
+        Vec3 slid = _terrainCollider->slideCapsule(oldPos, axisBottom, axisTop, radius, newPos - oldPos);
+        newPos.x = slid.x;
+        newPos.z = slid.z;
+
+        _pendingOldPos = oldPos;
+        _pendingNewPos = newPos;
+        _pendingDt = dt;
+
+        if (_groundProbes) {
+            _groundProbes->submit(this, this, newPos);
+            return;
         }
+
+        // 射线检测新位置地面
+        CustomRay ray(newPos + Vec3(0, GroundProbeBatch::kProbeHeight, 0), Vec3(0, -1, 0));
+        TerrainQuery::RayHit groundHit;
+        bool hit = _terrainCollider->probeGround(ray.origin, _groundCache, groundHit);
+        onGroundProbeResolved(hit, hit ? ray.origin.y - groundHit.distance : 0.0f, groundHit.normal);
     } else {
         this->setPosition3D(newPos);
         if (newPos.y <= 0.0f) {
@@ -157,9 +249,188 @@ void Enemy::applyMovement(float dt) {
             _velocity.y = 0.0f;
             _onGround = true;
         }
+        _collider.update(this);
+        if (_combatants) _combatants->setBounds(_combatantHandle, _collider.worldAABB);
     }
 }
 
+// 地面探测结果回调
+// 根据地面高度与坡度完成贴地、台阶判定，并更新 AABB 碰撞盒
+// @param hit 是否检测到地面
+// @param groundY 地面高度
+// @param groundNormal 地面法线，上坡时超出坡度限制视为墙壁
+void Enemy::onGroundProbeResolved(bool hit, float groundY, const Vec3& groundNormal) {
+    const Vec3 oldPos = _pendingOldPos;
+    Vec3 newPos = _pendingNewPos;
+    const float dt = _pendingDt;
+
+    if (hit) {
+        if (TerrainQuery::canStepOnto(groundY - oldPos.y, groundNormal)) {
+            newPos.y = groundY;
+            this->setPosition3D(newPos);
+            _hasSupport = true;
+            _supportPos = newPos;
+            
+            if (!_onGround && _velocity.y <= 0) {
+                _onGround = true;
+                _velocity.y = 0;
+            }
+        } else {
+            // 台阶太高或坡度太陡：留在原地，groundY 属于被拒绝的位置，落地只看原地的地面
+            Vec3 finalPos = oldPos;
+            finalPos.y += _velocity.y * dt; 
+            
+            float supportY;
+            if (findSupportHeight(oldPos, supportY) && finalPos.y <= supportY) {
+                finalPos.y = supportY;
+                _onGround = true;
+                _velocity.y = 0;
+            }
+            this->setPosition3D(finalPos);
+        }
+    } else {
+        // 没检测到地面
+        this->setPosition3D(newPos);
+        _onGround = false;
+        _hasSupport = false;
+    }
+
+    // 更新 AABB 碰撞盒到世界空间，同步到战斗参与者登记表
+    _collider.update(this);
+    if (_combatants) _combatants->setBounds(_combatantHandle, _collider.worldAABB);
+}
+
+// 原地地面高度
+// 被推挤、击退或直接设置过位置时在原地补测一次（很少发生，不走批处理）
+// @param pos 当前位置
+// @param outY 输出：地面高度
+// @return bool 是否有地面
+bool Enemy::findSupportHeight(const Vec3& pos, float& outY) {
+    if (_hasSupport && _supportPos.x == pos.x && _supportPos.z == pos.z) {
+        outY = _supportPos.y;
+        return true;
+    }
+    if (!_terrainCollider) return false;
+
+    CustomRay ray(pos + Vec3(0, GroundProbeBatch::kProbeHeight, 0), Vec3(0, -1, 0));
+    TerrainQuery::RayHit groundHit;
+    if (!_terrainCollider->probeGround(ray.origin, _groundCache, groundHit)) return false;
+    outY = ray.origin.y - groundHit.distance;
+    _hasSupport = true;
+    _supportPos.set(pos.x, outY, pos.z);
+    return true;
+}
+
+// 连续碰撞的水平位移
+// 地形扫掠只做一次、不沿墙滑动：技能位移碰到墙就停下；
+// 角色扫掠用空间哈希中上一帧结束时的包围盒，起始时已重叠的角色不阻挡（交给推挤处理）
+// @param delta 期望的世界水平位移
+// @param layers 阻挡位移的角色层
+// @param outDelta 输出：实际可走的位移
+// @return bool 是否被挡住
+bool Enemy::sweepMove(const Vec3& delta, uint32_t layers, Vec3& outDelta) {
+    outDelta = Vec3(delta.x, 0.0f, delta.z);
+    if (outDelta.lengthSquared() <= 1e-6f) return false;
+
+    const Vec3 fromW = getWorldPosition3D();
+    bool blocked = false;
+
+    if (_terrainCollider) {
+        Vec3 axisBottom, axisTop;
+        float radius;
+        _collider.getCapsule(TerrainQuery::kMaxStepHeight, axisBottom, axisTop, radius);
+        const Vec3 reached = _terrainCollider->slideCapsule(fromW, axisBottom, axisTop, radius, outDelta, 1);
+        const Vec3 moved(reached.x - fromW.x, 0.0f, reached.z - fromW.z);
+        if (moved.distanceSquared(outDelta) > 1e-4f) {
+            outDelta = moved;
+            blocked = true;
+        }
+    }
+
+    if (_actors && outDelta.lengthSquared() > 1e-6f) {
+        ActorSpatialHash::SweepHit hit;
+        if (_actors->sweepAABB(_collider.worldAABB, outDelta, layers, hit, this)) {
+            // 停在接触处，沿接触面法线留出间隙，下一次扫掠不会从相交状态开始
+            outDelta = outDelta * hit.toi + hit.normal * CapsuleSweep::kSlideSkin;
+            outDelta.y = 0.0f;
+            blocked = true;
+        }
+    }
+    return blocked;
+}
+
+// 采样追击流场
+// @param outDir 输出：移动方向
+// @return bool 流场是否给出了方向
+bool Enemy::sampleFlowField(Vec3& outDir) const {
+    return _flowField && _flowField->sample(this->getPosition3D(), outDir);
+}
+
+// 沿导航路径走向目标
+// @param goal 目标位置（父节点坐标）
+// @param dt 帧间隔时间
+// @return Vec3 本帧应朝向的路径点
+Vec3 Enemy::steerTowards(const Vec3& goal, float dt) {
+    if (!_navPaths || !_navPaths->getNavMesh()) {
+        return goal;
+    }
+
+    const Vec3 pos = this->getPosition3D();
+
+    // 取回已完成的寻路结果；路径第一个点是提交请求时的位置，从第二个点开始跟随
+    if (_navRequest != NavPathQueue::kInvalidHandle) {
+        const NavPathQueue::RequestStatus status = _navPaths->fetchPath(_navRequest, _navPath);
+        if (status != NavPathQueue::RequestStatus::Pending) {
+            _navRequest = NavPathQueue::kInvalidHandle;
+            _navPathIndex = _navPath.size() > 1 ? 1 : 0;
+            _navPathComplete = status == NavPathQueue::RequestStatus::Found;
+        }
+    }
+
+    // 没有进行中的请求时，目标走远或间隔到期就重新寻路
+    _navRepathTimer -= dt;
+    if (_navRequest == NavPathQueue::kInvalidHandle &&
+        (!_hasNavGoal || _navRepathTimer <= 0.0f ||
+         goal.distanceSquared(_navGoal) > kRepathDistance * kRepathDistance)) {
+        _navRequest = _navPaths->request(pos, goal);
+        if (_navRequest != NavPathQueue::kInvalidHandle) {
+            _navGoal = goal;
+            _hasNavGoal = true;
+            _navRepathTimer = kRepathInterval;
+        }
+    }
+
+    // 跳过已经到达的路径点
+    while (_navPathIndex < _navPath.size()) {
+        const Vec3& waypoint = _navPath[_navPathIndex];
+        const float dx = waypoint.x - pos.x;
+        const float dz = waypoint.z - pos.z;
+        if (dx * dx + dz * dz > kWaypointRadius * kWaypointRadius) break;
+        ++_navPathIndex;
+    }
+
+    if (_navPath.empty()) {
+        return goal; // 第一条路径还没算出来或寻路失败：直线前进
+    }
+    if (_navPathIndex >= _navPath.size()) {
+        return _navPathComplete ? goal : pos; // 目标不可达时停在最近点
+    }
+    return _navPath[_navPathIndex];
+}
+
+// 丢弃当前路径
+void Enemy::clearNavPath() {
+    if (_navPaths) {
+        _navPaths->cancel(_navRequest);
+    }
+    _navRequest = NavPathQueue::kInvalidHandle;
+    _navPath.clear();
+    _navPathIndex = 0;
+    _navPathComplete = false;
+    _hasNavGoal = false;
+    _navRepathTimer = 0.0f;
+}
+
 // 获取移动速度
 // @return float 当前移动速度
 float Enemy::getMoveSpeed() const {
@@ -178,6 +449,38 @@ float Enemy::getViewRange() const {
     return _viewRange;
 }
 
+// 感知玩家
+// 先做距离判断，再从双方包围盒上部连一条线段检测地形遮挡
+// （不从脚底连线，避免被脚下的地面起伏误判为遮挡）
+// @return bool 是否能看到玩家
+bool Enemy::canSeeTarget() const {
+    if (!_target || _target->isDead()) return false;
+
+    if (getTargetDistance() > _viewRange) return false;
+    if (!_terrainCollider) return true;
+
+    Vec3 eye = getWorldPosition3D();
+    Vec3 targetPos = getTargetWorldPos();
+
+    eye.y += (_collider.worldAABB._max.y - _collider.worldAABB._min.y) * 0.8f;
+    const AABB& targetBox = _target->getCollider().worldAABB;
+    targetPos.y += (targetBox._max.y - targetBox._min.y) * 0.5f;
+    return !_terrainCollider->segmentIntersects(eye, targetPos);
+}
+
+// 到玩家的距离
+// 空间哈希每帧重建时已求出玩家周围敌人到玩家的距离，感知判断直接读取；
+// 没有空间哈希、焦点不是自己的目标或自己不在表中（刚生成）时按世界坐标计算
+// @return float 距离
+float Enemy::getTargetDistance() const {
+    if (!_target) return FLT_MAX;
+    float dist;
+    if (_actors && _actors->getFocus() == _target && _actors->getFocusDistance(this, dist)) {
+        return dist;
+    }
+    return getWorldPosition3D().distance(getTargetWorldPos());
+}
+
 // 获取是否可以移动
 // @return bool 是否允许移动且未死亡
 bool Enemy::canMove() const {
@@ -8,16 +8,23 @@
 
 #include "cocos2d.h"
 #include "core/StateMachine.h"
+#include "combat/ActorSpatialHash.h"
 #include "combat/CharacterCollider.h"
+#include "combat/CombatantRegistry.h"
+#include "combat/CrowdAvoidance.h"
+#include "combat/GroundProbeBatch.h"
+#include "combat/FlowField.h"
+#include "combat/InfluenceMap.h"
+#include "combat/NavPathQuery.h"
 
 USING_NS_CC;
 class HealthComponent;
 class CombatComponent;
-class TerrainCollider;
+class TerrainQuery;
 class Wukong;
 
 /// Enemy 类：敌人基类，所有敌人类型都继承自此类
-class Enemy : public Node {
+class Enemy : public Node, public GroundProbeClient, public CrowdAgent {
  public:
   /// EnemyType 枚举：敌人类型
   enum class EnemyType {
@@ -39,6 +46,12 @@ class Enemy : public Node {
   
   /// 更新敌人状态(状态切换,移动,攻击冷却,AI 判断)
   virtual void update(float deltaTime) override;
+
+  /// 进入场景时登记到战斗参与者登记表
+  virtual void onEnter() override;
+
+  /// 离开场景时从登记表注销
+  virtual void onExit() override;
     
     // 获取移动速度
     // @return float 移动速度
@@ -51,6 +64,32 @@ class Enemy : public Node {
     // 获取视野范围
     // @return float 视野范围
     float getViewRange() const;
+
+    // 到玩家的距离：优先读取场景空间哈希缓存的焦点距离，没有缓存时直接计算世界坐标距离
+    // @return float 距离，超出空间哈希焦点范围时为 FLT_MAX
+    float getTargetDistance() const;
+
+    // 设置场景级角色空间哈希（感知时读取到玩家的距离，技能位移时扫掠角色）
+    void setActorHash(ActorSpatialHash* actors) { _actors = actors; }
+
+    // 连续碰撞的水平位移，供冲刺、跳劈等由状态直接摆放位置的技能使用：
+    // 先与地形做胶囊体扫掠，再与空间哈希中的角色做包围盒扫掠，停在首次接触处，结果与帧间隔无关
+    // @param delta 期望的世界水平位移（从当前位置出发）
+    // @param layers 阻挡位移的角色层（ActorSpatialHash::Layer 按位或）
+    // @param outDelta 输出：实际可走的位移
+    // @return bool 是否在走完 delta 之前被地形或角色挡住
+    bool sweepMove(const Vec3& delta, uint32_t layers, Vec3& outDelta);
+
+    // 设置场景级战斗参与者登记表（在场景中时立即登记）
+    void setCombatantRegistry(CombatantRegistry* registry);
+    CombatantRegistry* getCombatantRegistry() const { return _combatants; }
+
+    // 在登记表中的句柄，未登记时为 CombatantRegistry::kInvalidHandle
+    CombatantRegistry::Handle getCombatantHandle() const { return _combatantHandle; }
+
+    // 感知玩家：目标存活、在视野范围内，且视线未被地形遮挡
+    // @return bool 是否能看到玩家
+    bool canSeeTarget() const;
     
     // 获取是否可以移动
     // @return bool 是否可以移动
@@ -74,7 +113,66 @@ class Enemy : public Node {
 
     // 设置地形碰撞器
     // @param collider 地形碰撞器指针
-    void setTerrainCollider(TerrainCollider* collider) { _terrainCollider = collider; }
+    void setTerrainCollider(TerrainQuery* collider) { _terrainCollider = collider; }
+
+    // 设置场景级地面探测批处理（为空时每帧立即单独检测）
+    void setGroundProbeBatch(GroundProbeBatch* batch) { _groundProbes = batch; }
+
+    // 地面探测结果回调：按台阶高度与地面坡度完成贴地、挡墙与落地判定
+    // @param hit 是否检测到地面
+    // @param groundY 地面高度
+    // @param groundNormal 地面法线
+    void onGroundProbeResolved(bool hit, float groundY, const Vec3& groundNormal) override;
+
+    // 贴地缓存：每帧位移很小，地面探测大多只需检测上一帧的三角形
+    TerrainQuery::GroundCache* getGroundCache() override { return &_groundCache; }
+
+    // 设置场景级寻路队列（为空或没有导航网格时直线走向目标）
+    void setNavPathQueue(NavPathQueue* queue) { _navPaths = queue; }
+
+    // 设置场景级避障求解器（为空时直接按期望速度移动）
+    void setCrowdAvoidance(CrowdAvoidance* crowd) { _crowd = crowd; }
+
+    // 设置是否由避障控制移动；为 false 时（按技能脚本移动的 Boss）只作为其他敌人的障碍
+    void setCrowdSteered(bool steered) { _crowdSteered = steered; }
+
+    // 设置本帧的期望水平速度（父节点坐标），由状态每帧给出，不设置时为零
+    void setPreferredVelocity(const Vec3& velocity) { _preferredVelocity = velocity; }
+
+    // 避障结果回调：下一帧按该水平速度移动
+    // @param velocity 避开其他敌人后的水平速度
+    void onCrowdVelocityResolved(const Vec3& velocity) override { _crowdVelocity = velocity; }
+
+    // 设置场景级战术影响图（为空时不分配包围位）
+    void setInfluenceMap(InfluenceMap* map) { _influence = map; }
+
+    // 领取（或续期）玩家周围的包围位
+    // @param outPos 输出：包围位位置（父节点坐标）
+    // @return bool 没有影响图或包围位都被占用时返回 false
+    bool claimSurroundSlot(Vec3& outPos);
+
+    // 归还包围位
+    void releaseSurroundSlot();
+
+    // 是否持有包围位
+    bool hasSurroundSlot() const { return _surroundSlot >= 0; }
+
+    // 设置场景共享的追击流场（为空时追击也按单独的寻路请求走）
+    void setFlowField(const FlowField* field) { _flowField = field; }
+
+    // 采样追击流场
+    // @param outDir 输出：朝向玩家的移动方向（父节点坐标，未归一化）
+    // @return bool 流场可用且当前位置能走到玩家时返回 true
+    bool sampleFlowField(Vec3& outDir) const;
+
+    // 沿导航路径走向目标：轮询寻路请求的结果，目标移动较远或到达重新寻路的间隔时提交新的请求
+    // @param goal 目标位置（父节点坐标，与地形碰撞器一致）
+    // @param dt 帧间隔时间
+    // @return Vec3 本帧应朝向的路径点；还没有路径时返回 goal，部分路径走完时返回当前位置
+    Vec3 steerTowards(const Vec3& goal, float dt);
+
+    // 丢弃当前路径并撤销尚未完成的寻路请求
+    void clearNavPath();
 
     // 获取碰撞组件
     // @return CharacterCollider& 碰撞组件引用
@@ -197,13 +295,27 @@ protected:
     // 更新精灵位置
     void updateSpritePosition();
     
+    // 身体半径（与地形扫掠用的胶囊体一致）
+    float getBodyRadius() const;
+
+    // 避障：按上一次求解的速度设置水平速度，并提交本帧的位置与期望速度
+    // @param dt 帧间隔时间
+    void updateCrowd(float dt);
+
     // 应用重力效果
     // @param dt 帧间隔时间
     void applyGravity(float dt);
     
     // 应用移动效果
+    // 有地形碰撞器时只计算候选位置并提交地面探测，位置在 onGroundProbeResolved 中落定
     // @param dt 帧间隔时间
     void applyMovement(float dt);
+
+    // pos 处的脚下地面高度：位置未变时取最近一次被接受的探测结果，否则立即探测一次
+    // 移动被拒绝时敌人留在原地，只能用原地的地面落地
+    // @param outY 输出：地面高度
+    // @return bool 是否有地面
+    bool findSupportHeight(const Vec3& pos, float& outY);
     
     // 检查是否低生命值
     // @return bool 是否低生命值
@@ -253,8 +365,41 @@ protected:
   std::string _modelFile;            // 例如 "enemy1.c3b" 或 "boss.c3b"
 
   // 物理与碰撞
-  TerrainCollider* _terrainCollider = nullptr; // 地形碰撞器
+  TerrainQuery* _terrainCollider = nullptr; // 地形碰撞器
+  GroundProbeBatch* _groundProbes = nullptr;   // 场景级地面探测批处理
   CharacterCollider _collider;       // 角色碰撞器
+  TerrainQuery::GroundCache _groundCache; // 贴地查询缓存
+
+  // 避障
+  CrowdAvoidance* _crowd = nullptr;   // 场景级避障求解器
+  bool _crowdSteered = true;          // 是否由避障控制水平移动
+  Vec3 _preferredVelocity = Vec3::ZERO; // 状态给出的期望水平速度
+  Vec3 _crowdVelocity = Vec3::ZERO;   // 上一次避障求解的水平速度
+  bool _crowdSolvedMoving = false;    // 上一次提交求解的期望速度是否非零
+  Vec3 _crowdLastPos = Vec3::ZERO;    // 上一帧位置（不受避障控制时估计速度）
+
+  // 包围
+  ActorSpatialHash* _actors = nullptr;       // 场景级角色空间哈希
+  CombatantRegistry* _combatants = nullptr;  // 场景级战斗参与者登记表
+  CombatantRegistry::Handle _combatantHandle = CombatantRegistry::kInvalidHandle; // 登记表句柄
+  InfluenceMap* _influence = nullptr; // 场景级战术影响图
+  int _surroundSlot = -1;             // 持有的包围位
+
+  // 寻路
+  NavPathQueue* _navPaths = nullptr;  // 场景级寻路队列
+  NavPathQueue::Handle _navRequest = NavPathQueue::kInvalidHandle; // 尚未取回的寻路请求
+  const FlowField* _flowField = nullptr; // 场景共享的追击流场
+  std::vector<Vec3> _navPath;         // 当前路径（父节点坐标）
+  size_t _navPathIndex = 0;           // 下一个路径点
+  bool _navPathComplete = false;      // 当前路径是否通往目标
+  Vec3 _navGoal = Vec3::ZERO;         // 最近一次请求的目标
+  bool _hasNavGoal = false;           // 是否已请求过路径
+  float _navRepathTimer = 0.0f;       // 距下次重新寻路的时间
+  Vec3 _pendingOldPos = Vec3::ZERO;  // 等待地面探测结果的起始位置
+  Vec3 _pendingNewPos = Vec3::ZERO;  // 等待地面探测结果的候选位置
+  float _pendingDt = 0.0f;           // 等待地面探测结果的帧间隔
+  bool _hasSupport = false;          // _supportPos 是否有效
+  Vec3 _supportPos = Vec3::ZERO;     // 最近一次被接受的地面探测位置（y 为地面高度）
   Vec3 _velocity = Vec3::ZERO;       // 速度向量
   bool _onGround = true;             // 是否在地面上
   const float _gravity = 980.0f;     // 重力加速度
@@ -104,13 +104,10 @@ void EnemyIdleState::onUpdate(Enemy* enemy, float deltaTime) {
         enemy->getStateMachine()->changeState("Patrol");
     }
     
-    // 感知玩家：在视野范围内 -> 追击
-    if (HasTarget(enemy)) {
-        float d = EnemyWorldPos(enemy).distance(PlayerWorldPos(enemy));
-        if (d <= enemy->getViewRange()) {
-            enemy->getStateMachine()->changeState("Chase");
-            return;
-        }
+    // 感知玩家：在视野范围内且视线未被遮挡 -> 追击
+    if (enemy->canSeeTarget()) {
+        enemy->getStateMachine()->changeState("Chase");
+        return;
     }
 }
 
@@ -182,13 +179,10 @@ void EnemyPatrolState::onUpdate(Enemy* enemy, float deltaTime) {
     // 更新巡逻计时器
     _patrolTimer += deltaTime;
     
-    // 感知玩家：在视野范围内 -> 追击
-    if (HasTarget(enemy)) {
-        float d = EnemyWorldPos(enemy).distance(PlayerWorldPos(enemy));
-        if (d <= enemy->getViewRange()) {
-            enemy->getStateMachine()->changeState("Chase");
-            return;
-        }
+    // 感知玩家：在视野范围内且视线未被遮挡 -> 追击
+    if (enemy->canSeeTarget()) {
+        enemy->getStateMachine()->changeState("Chase");
+        return;
     }
 
     // 移动向巡逻目标点
@@ -206,9 +200,9 @@ void EnemyPatrolState::onUpdate(Enemy* enemy, float deltaTime) {
                 enemy->getSprite()->setRotation3D(Vec3(0, angle, 0));
             }
             
-            // 计算新位置并移动
-            Vec3 newPos = currentPos + direction * enemy->getMoveSpeed() * deltaTime;
-            enemy->setPosition3D(newPos);
+            // 给出期望速度，实际移动在 Enemy::update 中经过避障与地形碰撞后落定
+            direction.y = 0.0f;
+            enemy->setPreferredVelocity(direction * enemy->getMoveSpeed());
         } else {
             // 到达目标点，切换到待机状态
             enemy->getStateMachine()->changeState("Idle");
@@ -250,6 +244,9 @@ void EnemyChaseState::onEnter(Enemy* enemy) {
     
     // 追逐动画（如果有）
     enemy->playAnim("chase", false);
+
+    // 丢弃其他状态留下的路径
+    enemy->clearNavPath();
 }
 
 // 追逐状态每一帧执行的操作
@@ -314,8 +311,7 @@ void EnemyChaseState::onUpdate(Enemy* enemy, float deltaTime) {
         return;
     }
 
-    const Vec3 playerWorld = PlayerWorldPos(enemy);
-    float distanceToPlayer = enemyWorld.distance(playerWorld);
+    float distanceToPlayer = enemy->getTargetDistance();
 
     // 超出视野 -> Return
     if (distanceToPlayer > enemy->getViewRange()) {
@@ -323,24 +319,40 @@ void EnemyChaseState::onUpdate(Enemy* enemy, float deltaTime) {
         return;
     }
 
-    // 追上了再攻击（给一个简单攻击距离，增加到 80，配合攻击判定的膨胀）
+    // 接近玩家后领取包围位，各自绕到玩家周围不同的位置，而不是在玩家正前方排队
+    const float kSurroundRange = 200.0f;
+    const float kSlotArriveDist = 25.0f;
+    Vec3 slotPos;
+    const bool hasSlot = distanceToPlayer <= kSurroundRange && enemy->claimSurroundSlot(slotPos);
+    if (!hasSlot && enemy->hasSurroundSlot()) {
+        enemy->releaseSurroundSlot();
+    }
+    Vec3 toSlot = hasSlot ? slotPos - enemy->getPosition3D() : Vec3::ZERO;
+    toSlot.y = 0.0f;
+
+    // 追上了再攻击（给一个简单攻击距离，增加到 80，配合攻击判定的膨胀）；持有包围位时到位后再攻击
     const float kAttackRange = 80.0f;
-    if (distanceToPlayer <= kAttackRange && enemy->canAttack()) {
+    const bool inPosition = !hasSlot || toSlot.length() <= kSlotArriveDist;
+    if (distanceToPlayer <= kAttackRange && inPosition && enemy->canAttack()) {
         enemy->getStateMachine()->changeState("Attack");
         return;
     }
 
-    // 继续追击移动
+    // 继续追击移动：有包围位时直接走向包围位；否则优先采样共享流场，
+    // 流场不可用时沿单独的导航路径，都没有时直线追击
     if (enemy->canMove()) {
-        Vec3 dir = playerWorld - enemyWorld;
+        Vec3 dir = toSlot;
+        if (!hasSlot && !enemy->sampleFlowField(dir)) {
+            Vec3 waypoint = enemy->steerTowards(WorldToParentSpace(enemy, PlayerWorldPos(enemy)), deltaTime);
+            dir = waypoint - enemy->getPosition3D();
+        }
         dir.y = 0;
 
         if (dir.lengthSquared() > 1e-6f) {
             dir.normalize();
 
-            // 先在 world 空间算新位置，再转回父节点空间 setPosition3D（关键）
-            Vec3 newWorld = enemyWorld + dir * enemy->getMoveSpeed() * deltaTime;
-            enemy->setPosition3D(WorldToParentSpace(enemy, newWorld));
+            // 期望速度（父节点空间），与其他敌人的避障在场景中统一求解
+            enemy->setPreferredVelocity(dir * enemy->getMoveSpeed());
 
             // 朝向（沿用你 Patrol 的方式）
             if (enemy->getSprite()) {
@@ -355,6 +367,8 @@ void EnemyChaseState::onUpdate(Enemy* enemy, float deltaTime) {
 // @param enemy 敌人指针
 void EnemyChaseState::onExit(Enemy* enemy) {
     CCLOG("Enemy exited chase state");
+    enemy->clearNavPath();
+    enemy->releaseSurroundSlot();
 }
 
 // 获取状态名称
@@ -407,10 +421,11 @@ void EnemyAttackState::onUpdate(Enemy* enemy, float deltaTime) {
         auto combat = enemy->getCombat();
         auto target = enemy->getTarget();
         CCLOG("EnemyAttackState: Attempting attack. Combat: %p, Target: %p", combat, target);
-        if (combat && target) {
-            // 将目标（悟空）放入列表
-            std::vector<cocos2d::Node*> targets = { static_cast<cocos2d::Node*>(target) };
-            int hits = combat->executeMeleeAttack(enemy->getCollider(), targets);
+        auto registry = enemy->getCombatantRegistry();
+        if (combat && target && registry) {
+            // 目标（悟空）按登记表句柄直接取包围盒与组件；未登记（已离场）的句柄不会命中
+            const CombatantRegistry::Handle targetHandle = target->getCombatantHandle();
+            int hits = combat->executeMeleeAttack(enemy->getCollider(), *registry, &targetHandle, 1);
             if (hits > 0) {
                 CCLOG("Enemy hit player! Damage dealt. Hits: %d", hits);
             } else {
@@ -426,7 +441,7 @@ void EnemyAttackState::onUpdate(Enemy* enemy, float deltaTime) {
             enemy->getStateMachine()->changeState("Return");
             return;
         }
-        float distance = EnemyWorldPos(enemy).distance(PlayerWorldPos(enemy));
+        float distance = enemy->getTargetDistance();
 
 
         if (distance <= enemy->getViewRange()) {
@@ -504,7 +519,7 @@ void EnemyHitState::onUpdate(Enemy* enemy, float deltaTime) {
             enemy->getStateMachine()->changeState("Return");
             return;
         }
-        float distance = EnemyWorldPos(enemy).distance(PlayerWorldPos(enemy));
+        float distance = enemy->getTargetDistance();
 
         if (distance <= 80.0f) { // 使用与 ChaseState 一致的攻击距离
             if (enemy->canAttack()) {
@@ -613,6 +628,8 @@ void ReturnState::onEnter(Enemy* enemy) {
     _returnTarget = enemy->getBirthPosition();
     // 播放巡逻动画（作为返回时的移动动画）
     enemy->playAnim("patrol", true);
+
+    enemy->clearNavPath();
 }
 
 // 返回状态每一帧执行的操作
@@ -625,12 +642,8 @@ void ReturnState::onUpdate(Enemy* enemy, float dt) {
         return;
     }
 
-    // 玩家回到感知范围 -> Chase（保持你原逻辑）
-    float distanceToPlayer = FLT_MAX;
-    if (HasTarget(enemy)) {
-        distanceToPlayer = EnemyWorldPos(enemy).distance(PlayerWorldPos(enemy));
-    }
-    if (distanceToPlayer <= enemy->getViewRange()) {
+    // 玩家回到感知范围且能被看到 -> Chase
+    if (enemy->canSeeTarget()) {
         enemy->getStateMachine()->changeState("Chase");
         return;
     }
@@ -638,17 +651,22 @@ void ReturnState::onUpdate(Enemy* enemy, float dt) {
     if (!enemy->canMove()) return;
 
     Vec3 pos = enemy->getPosition3D();     // 父节点坐标
-    Vec3 dir = _returnTarget - pos;
+    Vec3 toTarget = _returnTarget - pos;
+    toTarget.y = 0.0f;
+
+    float dist = toTarget.length();
+
+    // 沿导航路径回家；出生点不可达时走到最近点即视为返回完成
+    Vec3 dir = enemy->steerTowards(_returnTarget, dt) - pos;
     dir.y = 0.0f;
 
-    float dist = dir.length();
-    if (dist > 10.0f) {
+    if (dist > 10.0f && dir.lengthSquared() > 1e-6f) {
         dir.normalize();
 
-        float step = enemy->getMoveSpeed() * dt;
-        if (step > dist) step = dist;      // 防止 overshoot 抖动/跳
+        float speed = enemy->getMoveSpeed();
+        if (speed * dt > dist) speed = dist / dt; // 防止 overshoot 抖动/跳
 
-        enemy->setPosition3D(pos + dir * step);
+        enemy->setPreferredVelocity(dir * speed);
 
         if (enemy->getSprite()) {
             float angle = atan2f(dir.x, dir.z) * 180.0f / M_PI;
@@ -657,9 +675,11 @@ void ReturnState::onUpdate(Enemy* enemy, float dt) {
     }
     else {
         // 锁死到出生点，再切 Patrol，避免“阈值边缘卡住”
-        pos.x = _returnTarget.x;
-        pos.z = _returnTarget.z;
-        enemy->setPosition3D(pos);
+        if (dist <= 10.0f) {
+            pos.x = _returnTarget.x;
+            pos.z = _returnTarget.z;
+            enemy->setPosition3D(pos);
+        }
 
         enemy->getStateMachine()->changeState("Patrol");
     }
@@ -670,6 +690,7 @@ void ReturnState::onUpdate(Enemy* enemy, float dt) {
 // @param enemy 敌人指针
 void ReturnState::onExit(Enemy* enemy) {
     CCLOG("Enemy exited return state");
+    enemy->clearNavPath();
 }
 
 // 获取状态名称
@@ -4,6 +4,7 @@
 #include "enemy/Enemy.h"
 #include "../combat/HealthComponent.h"
 #include "../combat/CombatComponent.h"
+#include "../combat/CapsuleSweep.h"
 
 Character::Character()
     : _visualRoot(nullptr),
@@ -24,6 +25,32 @@ Character::~Character() {
     // _ownedStates 会自动释放状态对象
 }
 
+void Character::onEnter() {
+    cocos2d::Node::onEnter();
+    if (_combatants && _combatantHandle == CombatantRegistry::kInvalidHandle) {
+        _combatantHandle = _combatants->add(this, _health, _combat, _collider.worldAABB);
+    }
+}
+
+void Character::onExit() {
+    if (_combatants) {
+        _combatants->remove(_combatantHandle);
+    }
+    _combatantHandle = CombatantRegistry::kInvalidHandle;
+    cocos2d::Node::onExit();
+}
+
+void Character::setCombatantRegistry(CombatantRegistry* registry) {
+    if (_combatants) {
+        _combatants->remove(_combatantHandle);
+    }
+    _combatantHandle = CombatantRegistry::kInvalidHandle;
+    _combatants = registry;
+    if (_combatants && isRunning()) {
+        _combatantHandle = _combatants->add(this, _health, _combat, _collider.worldAABB);
+    }
+}
+
 bool Character::init() {
     if (!cocos2d::Node::init()) {
         return false;
@@ -82,10 +109,7 @@ void Character::update(float dt) {
     }
 
     applyGravity(dt);
-    applyMovement(dt);
-
-    // 更新 AABB 碰撞盒到世界空间
-    _collider.update(this);
+    applyMovement(dt); // 位置落定后会同步更新 AABB 碰撞盒
 }
 
 void Character::setMoveIntent(const MoveIntent& intent) {
@@ -228,8 +252,41 @@ void Character::applyMovement(float dt) {
     cocos2d::Vec3 oldPos = this->getPosition3D();
     cocos2d::Vec3 newPos = oldPos + _velocity * dt;
 
-    // 1. 与敌人的 AABB 碰撞检测
     if (_enemies && !_enemies->empty()) {
+        // 1. 水平位移先对敌人做包围盒扫掠，碰到后沿接触面滑动：翻滚或帧间隔较大时不会一步穿过敌人
+        const AABB& fromAABB = _collider.worldAABB;
+        auto sweepEnemies = [&](const Vec3& at, const Vec3&, const Vec3& delta, float& outToi, Vec3& outNormal) {
+            AABB box = fromAABB;
+            box._min += at - oldPos;
+            box._max += at - oldPos;
+
+            if (_actors) {
+                ActorSpatialHash::SweepHit hit;
+                if (!_actors->sweepAABB(box, delta, ActorSpatialHash::kLayerEnemy, hit, this)) return false;
+                outToi = hit.toi;
+                outNormal = hit.normal;
+                return true;
+            }
+
+            bool found = false;
+            for (auto enemy : *_enemies) {
+                if (!enemy || enemy->isDead()) continue;
+                float toi;
+                Vec3 normal;
+                if (CharacterCollider::sweepAABB(box, delta, enemy->getCollider().worldAABB, toi, normal) &&
+                    (!found || toi < outToi)) {
+                    found = true;
+                    outToi = toi;
+                    outNormal = normal;
+                }
+            }
+            return found;
+        };
+        const Vec3 swept = CapsuleSweep::slide(oldPos, Vec3::ZERO, Vec3::ZERO, newPos - oldPos, 2, sweepEnemies);
+        newPos.x = swept.x;
+        newPos.z = swept.z;
+
+        // 2. 与敌人的 AABB 碰撞检测：推出起始时已经重叠（或扫掠后被敌人移动挤入）的部分
         // 先临时计算新位置下的世界 AABB
         // 获取当前变换并替换位置部分
         Mat4 nextTransform = this->getNodeToWorldTransform();
@@ -240,11 +297,7 @@ void Character::applyMovement(float dt) {
         AABB nextWorldAABB = _collider.aabb;
         nextWorldAABB.transform(nextTransform);
 
-        for (auto enemy : *_enemies) {
-            if (!enemy || enemy->isDead()) continue;
-
-            const AABB& enemyAABB = enemy->getCollider().worldAABB;
-            
+        auto pushOut = [&](const AABB& enemyAABB) {
             if (nextWorldAABB.intersects(enemyAABB)) {
                 // 计算碰撞偏移并修正 newPos
                 Vec3 offset = _collider.getCollisionOffset(enemyAABB, &nextWorldAABB);
@@ -257,50 +310,55 @@ void Character::applyMovement(float dt) {
                     nextWorldAABB._max += offset;
                 }
             }
+        };
+
+        if (_actors && _combatants) {
+            // 空间哈希中是上一帧的包围盒，只用来筛出附近的敌人；存活状态与当前包围盒从登记表读取
+            const Vec3 margin(ActorSpatialHash::kQueryMargin, ActorSpatialHash::kQueryMargin, ActorSpatialHash::kQueryMargin);
+            AABB queryBox = nextWorldAABB;
+            queryBox._min -= margin;
+            queryBox._max += margin;
+            _nearbyCombatants.clear();
+            _actors->queryCombatants(queryBox, ActorSpatialHash::kLayerEnemy, _nearbyCombatants, this);
+            for (CombatantRegistry::Handle handle : _nearbyCombatants) {
+                if (!_combatants->isValid(handle)) continue;
+                HealthComponent* health = _combatants->getHealth(handle);
+                if (!health || health->isDead()) continue;
+                pushOut(_combatants->getBounds(handle));
+            }
+        } else {
+            for (auto enemy : *_enemies) {
+                if (enemy && !enemy->isDead()) pushOut(enemy->getCollider().worldAABB);
+            }
         }
     }
 
     if (_terrainCollider) {
-        // 2. 射线检测新位置地面（从上方 500 个单位向下发射，覆盖更广的高度差）
-        CustomRay ray(newPos + cocos2d::Vec3(0, 500, 0), cocos2d::Vec3(0, -1, 0));
-        float hitDist;
-
-        if (_terrainCollider->rayIntersects(ray, hitDist)) {
-            float groundY = ray.origin.y - hitDist;
-            const float MAX_STEP_HEIGHT = 40.0f; // 稍微增大跨越高度
-
-            // 2. 坡度 / 台阶判断
-            // 如果新位置的地面高度与当前位置高度差在允许范围内，或者正在下坡
-            if (groundY - oldPos.y < MAX_STEP_HEIGHT) {
-                newPos.y = groundY;
-                this->setPosition3D(newPos);
-                
-                // 落地判定
-                if (!_onGround && _velocity.y <= 0) {
-                    _onGround = true;
-                    _velocity.y = 0;
-                }
-            } else {
-                // 坡度太陡（墙壁）
-                // 限制水平位移，保持原位置，但允许垂直重力/跳跃
-                cocos2d::Vec3 finalPos = oldPos;
-                finalPos.y += _velocity.y * dt; 
-                
-                if (finalPos.y <= groundY) {
-                    finalPos.y = groundY;
-                    _onGround = true;
-                    _velocity.y = 0;
-                }
-                this->setPosition3D(finalPos);
-            }
-        } else {
-            // 3. 没检测到地面（可能出界）
-            // 维持重力下降，但 _onGround 设为 false
-            this->setPosition3D(newPos);
-            _onGround = false;
+        // 3. 水平位移再与地形做胶囊体扫掠，碰到墙面时沿墙滑动，而不是整帧退回原位
+        cocos2d::Vec3 axisBottom, axisTop;
+        float radius;
+        _collider.getCapsule(TerrainQuery::kMaxStepHeight, axisBottom, axisTop, radius);
+        cocos2d::Vec3 slid = _terrainCollider->slideCapsule(oldPos, axisBottom, axisTop, radius, newPos - oldPos);
+        newPos.x = slid.x;
+        newPos.z = slid.z;
+
+        // 4. 地面检测：交给场景批处理，或在没有批处理时立即检测
+        _pendingMove.oldPos = oldPos;
+        _pendingMove.newPos = newPos;
+        _pendingMove.dt = dt;
+
+        if (_groundProbes) {
+            _groundProbes->submit(this, this, newPos);
+            return;
         }
+
+        // 从上方 500 个单位向下发射，覆盖更广的高度差
+        CustomRay ray(newPos + cocos2d::Vec3(0, GroundProbeBatch::kProbeHeight, 0), cocos2d::Vec3(0, -1, 0));
+        TerrainQuery::RayHit groundHit;
+        bool hit = _terrainCollider->probeGround(ray.origin, _groundCache, groundHit);
+        onGroundProbeResolved(hit, hit ? ray.origin.y - groundHit.distance : 0.0f, groundHit.normal);
     } else {
-        // 4. 无碰撞器，维持原有的简单 y=0 判定
+        // 5. 无碰撞器，维持原有的简单 y=0 判定
         this->setPosition3D(newPos);
         if (newPos.y <= 0.0f) {
             cocos2d::Vec3 pos = this->getPosition3D();
@@ -309,5 +367,75 @@ void Character::applyMovement(float dt) {
             _velocity.y = 0.0f;
             _onGround = true;
         }
+        _collider.update(this);
+        if (_combatants) _combatants->setBounds(_combatantHandle, _collider.worldAABB);
+    }
+}
+
+void Character::onGroundProbeResolved(bool hit, float groundY, const cocos2d::Vec3& groundNormal) {
+    const cocos2d::Vec3& oldPos = _pendingMove.oldPos;
+    cocos2d::Vec3 newPos = _pendingMove.newPos;
+    const float dt = _pendingMove.dt;
+
+    if (hit) {
+        // 2. 坡度 / 台阶判断
+        // 新位置的地面高度差在台阶范围内且坡面不陡，或者正在下坡
+        if (TerrainQuery::canStepOnto(groundY - oldPos.y, groundNormal)) {
+            newPos.y = groundY;
+            this->setPosition3D(newPos);
+            _groundSupport.valid = true;
+            _groundSupport.x = newPos.x;
+            _groundSupport.z = newPos.z;
+            _groundSupport.y = groundY;
+            
+            // 落地判定
+            if (!_onGround && _velocity.y <= 0) {
+                _onGround = true;
+                _velocity.y = 0;
+            }
+        } else {
+            // 坡度太陡（墙壁）：扫掠之后仍可能走到台阶高度之内、但法线超出坡度限制的陡坡上
+            // 限制水平位移，保持原位置，但允许垂直重力/跳跃；
+            // groundY 属于被拒绝的位置，落地只看原地的地面，否则每帧都会被抬上陡坡一个台阶高度
+            cocos2d::Vec3 finalPos = oldPos;
+            finalPos.y += _velocity.y * dt; 
+            
+            float supportY;
+            if (findSupportHeight(oldPos, supportY) && finalPos.y <= supportY) {
+                finalPos.y = supportY;
+                _onGround = true;
+                _velocity.y = 0;
+            }
+            this->setPosition3D(finalPos);
+        }
+    } else {
+        // 3. 没检测到地面（可能出界）
+        // 维持重力下降，但 _onGround 设为 false
+        this->setPosition3D(newPos);
+        _onGround = false;
+        _groundSupport.valid = false;
     }
+
+    // 更新 AABB 碰撞盒到世界空间，同步到战斗参与者登记表
+    _collider.update(this);
+    if (_combatants) _combatants->setBounds(_combatantHandle, _collider.worldAABB);
+}
+
+bool Character::findSupportHeight(const cocos2d::Vec3& pos, float& outY) {
+    if (_groundSupport.valid && _groundSupport.x == pos.x && _groundSupport.z == pos.z) {
+        outY = _groundSupport.y;
+        return true;
+    }
+    if (!_terrainCollider) return false;
+
+    // 被推挤、击退或直接设置过位置：在原地补测一次（很少发生，不走批处理）
+    CustomRay ray(pos + cocos2d::Vec3(0, GroundProbeBatch::kProbeHeight, 0), cocos2d::Vec3(0, -1, 0));
+    TerrainQuery::RayHit groundHit;
+    if (!_terrainCollider->probeGround(ray.origin, _groundCache, groundHit)) return false;
+    outY = ray.origin.y - groundHit.distance;
+    _groundSupport.valid = true;
+    _groundSupport.x = pos.x;
+    _groundSupport.z = pos.z;
+    _groundSupport.y = outY;
+    return true;
 }
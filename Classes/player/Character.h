@@ -3,8 +3,11 @@
 
 #include "StateMachine.h"
 #include "cocos2d.h"
+#include "../combat/ActorSpatialHash.h"
 #include "../combat/Collider.h"
 #include "../combat/CharacterCollider.h"
+#include "../combat/CombatantRegistry.h"
+#include "../combat/GroundProbeBatch.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -17,7 +20,7 @@ class CombatComponent;
  * @class Character
  * @brief 角色基类（继承 cocos2d::Node），提供移动、跳跃、翻滚、普攻连招、受击、死亡等通用接口
  */
-class Character : public cocos2d::Node {
+class Character : public cocos2d::Node, public GroundProbeClient {
 public:
     /**
      * @brief 移动意图（由输入或 AI 生成）
@@ -58,6 +61,16 @@ public:
      */
     virtual void update(float dt) override;
 
+    /**
+     * @brief 进入场景时登记到战斗参与者登记表
+     */
+    virtual void onEnter() override;
+
+    /**
+     * @brief 离开场景时从登记表注销
+     */
+    virtual void onExit() override;
+
     // ======================= 对外动作接口（外部系统只调用这些） =======================
 
     /**
@@ -75,7 +88,23 @@ public:
     /**
      * @brief 设置地形碰撞器
      */
-    void setTerrainCollider(TerrainCollider* collider) { _terrainCollider = collider; }
+    void setTerrainCollider(TerrainQuery* collider) { _terrainCollider = collider; }
+    TerrainQuery* getTerrainCollider() const { return _terrainCollider; }
+
+    /**
+     * @brief 设置场景级地面探测批处理（为空时每帧立即单独检测）
+     */
+    void setGroundProbeBatch(GroundProbeBatch* batch) { _groundProbes = batch; }
+
+    /**
+     * @brief 地面探测结果回调：按台阶高度与地面坡度完成贴地、挡墙与落地判定
+     */
+    void onGroundProbeResolved(bool hit, float groundY, const cocos2d::Vec3& groundNormal) override;
+
+    /**
+     * @brief 贴地缓存：每帧位移很小，地面探测大多只需检测上一帧的三角形
+     */
+    TerrainQuery::GroundCache* getGroundCache() override { return &_groundCache; }
 
     /**
      * @brief 设置敌人列表（用于碰撞检测）
@@ -87,6 +116,23 @@ public:
      */
     const std::vector<Enemy*>* getEnemies() const { return _enemies; }
 
+    /**
+     * @brief 设置场景级角色空间哈希（为空时推挤与近战遍历整个敌人列表）
+     */
+    void setActorHash(ActorSpatialHash* actors) { _actors = actors; }
+    ActorSpatialHash* getActorHash() const { return _actors; }
+
+    /**
+     * @brief 设置场景级战斗参与者登记表（在场景中时立即登记）
+     */
+    void setCombatantRegistry(CombatantRegistry* registry);
+    CombatantRegistry* getCombatantRegistry() const { return _combatants; }
+
+    /**
+     * @brief 在登记表中的句柄，未登记时为 CombatantRegistry::kInvalidHandle
+     */
+    CombatantRegistry::Handle getCombatantHandle() const { return _combatantHandle; }
+
     /**
      * @brief 获取碰撞组件
      */
@@ -213,6 +259,7 @@ protected:
 
     /**
      * @brief 应用位移（pos += velocity * dt）
+     * 有地形碰撞器时只计算候选位置并提交地面探测，位置在 onGroundProbeResolved 中落定
      * @param dt 帧间隔时间（秒）
      */
     void applyMovement(float dt);
@@ -235,9 +282,39 @@ protected:
     HealthComponent* _health = nullptr;  ///< 健康组件
     CombatComponent* _combat = nullptr;  ///< 战斗组件
 
-    TerrainCollider* _terrainCollider = nullptr; ///< 地形碰撞器
+    TerrainQuery* _terrainCollider = nullptr;    ///< 地形碰撞器
+    GroundProbeBatch* _groundProbes = nullptr;   ///< 场景级地面探测批处理
     CharacterCollider _collider;                 ///< 角色碰撞器
+    TerrainQuery::GroundCache _groundCache;      ///< 贴地查询缓存
+
+    /**
+     * @brief 等待地面探测结果的位移
+     */
+    struct PendingMove {
+        cocos2d::Vec3 oldPos;
+        cocos2d::Vec3 newPos;
+        float dt = 0.0f;
+    } _pendingMove;
+
+    /**
+     * @brief 最近一次被接受的地面探测：脚下地面高度与测量时的 XZ 位置
+     */
+    struct GroundSupport {
+        bool valid = false;
+        float x = 0.0f, z = 0.0f;
+        float y = 0.0f;
+    } _groundSupport;
+
+    /**
+     * @brief pos 处的脚下地面高度：位置未变时取 _groundSupport，否则立即探测一次
+     * 移动被拒绝时角色留在原地，只能用原地的地面落地，不能用被拒绝位置的地面高度
+     */
+    bool findSupportHeight(const cocos2d::Vec3& pos, float& outY);
     const std::vector<Enemy*>* _enemies = nullptr; ///< 敌人列表引用
+    ActorSpatialHash* _actors = nullptr;           ///< 场景级角色空间哈希
+    std::vector<CombatantRegistry::Handle> _nearbyCombatants; ///< 空间哈希查询结果（复用内存）
+    CombatantRegistry* _combatants = nullptr;      ///< 场景级战斗参与者登记表
+    CombatantRegistry::Handle _combatantHandle = CombatantRegistry::kInvalidHandle; ///< 登记表句柄
 };
 
 #endif // CHARACTER_H
@@ -1,6 +1,7 @@
 #include "InputController.h"
 #include"Wukong.h"
 #include"cocos2d.h"
+#include <algorithm>
 #include <cmath>
 #include <new>
 
@@ -27,7 +28,8 @@ bool PlayerController::init(Wukong* target) {
     bindKeyboard();
     bindMouse();
 
-    this->scheduleUpdate();
+    // ڳͳһ̽⣨ȼ 1֮£ͷ汾֡䶨Ľɫλ
+    this->scheduleUpdateWithPriority(2);
     return true;
 }
 void PlayerController::setCamera(cocos2d::Camera* cam) {
@@ -87,6 +89,17 @@ void PlayerController::updateThirdPersonCamera(float dt) {
     float t = 1.0f - std::exp(-_camFollowPosK * dt);
     cocos2d::Vec3 newPos = cur + (desiredPos - cur) * t;
 
+    // ڵעӵͷλ߶μ⣬סʱѾͷǰ⴩ɽ
+    if (TerrainQuery* terrain = _target->getTerrainCollider()) {
+        float fraction;
+        if (terrain->segmentIntersects(lookAtPos, newPos, fraction)) {
+            cocos2d::Vec3 toCam = newPos - lookAtPos;
+            float len = toCam.length();
+            float dist = std::max(len * fraction - _camCollisionPadding, 0.0f);
+            newPos = lookAtPos + toCam * (len > 1e-4f ? dist / len : 0.0f);
+        }
+    }
+
     _cam->setPosition3D(newPos);
     _cam->lookAt(lookAtPos, cocos2d::Vec3::UNIT_Y);
 }
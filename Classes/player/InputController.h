@@ -87,6 +87,7 @@ private:
     float _maxDist = 120.0f;
 
     float _lookAtHeight = 12.0f;      // ͷɫؿڡ߶
+    float _camCollisionPadding = 4.0f; // ڵʱͷͣڽǰľ
 };
 
 #endif // PLAYERCONTROLLER_H
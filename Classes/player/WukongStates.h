@@ -6,6 +6,7 @@
 #include "Character.h"
 #include "Wukong.h"
 #include "enemy/Enemy.h"
+#include "../combat/AttackShape.h"
 #include "../combat/CombatComponent.h"
 #include "../scene_ui/UIManager.h"
 #include <string>
@@ -299,6 +300,28 @@ public:
         return "Attack3";
     }
 
+    /**
+     * @brief 每段攻击的判定数据：判定时机（占动画时长的比例）、判定窗口与攻击形状
+     */
+    struct AttackStep {
+        float hitTimeRatio;
+        float hitWindow;
+        AttackShape shape;
+    };
+
+    static const AttackStep& getAttackStep(int step) {
+        static const AttackStep kSteps[] = {
+            // 第一段：快速横扫，前方 120 度扇形，较短的检测窗口
+            { 0.35f, 0.08f, AttackShape::sector(90.0f, 60.0f) },
+            // 第二段：蓄力回身扫，范围更大的扇形，中等检测窗口
+            { 0.45f, 0.12f, AttackShape::sector(100.0f, 80.0f) },
+            // 第三段：终结突刺，沿朝向的长条胶囊，较长的检测窗口（确保命中）
+            { 0.40f, 0.15f, AttackShape::capsule(130.0f, 30.0f) },
+        };
+        static const AttackStep kDefault = { 0.40f, 0.1f, AttackShape::sector(90.0f, 60.0f) };
+        return (step >= 1 && step <= 3) ? kSteps[step - 1] : kDefault;
+    }
+
 private:
     /**
      * @brief 执行攻击伤害检测
@@ -308,64 +331,36 @@ private:
         if (!entity || _damageDealt) return;
 
         // 根据攻击段数设置不同的伤害检测时机和范围
-        float hitTimeRatio = 0.0f;
-        float hitWindow = 0.1f; // 伤害检测窗口宽度（秒）
-        
-        switch (_step) {
-        case 1: 
-            hitTimeRatio = 0.35f; // 第一段攻击早期检测（快速出手）
-            hitWindow = 0.08f;    // 较短的检测窗口
-            break;
-        case 2: 
-            hitTimeRatio = 0.45f; // 第二段攻击中期检测（蓄力攻击）
-            hitWindow = 0.12f;    // 中等检测窗口
-            break;
-        case 3: 
-            hitTimeRatio = 0.40f; // 第三段攻击早期检测（终结技）
-            hitWindow = 0.15f;    // 较长的检测窗口（确保命中）
-            break;
-        default: 
-            hitTimeRatio = 0.40f; 
-            hitWindow = 0.1f; 
-            break;
-        }
+        const AttackStep& step = getAttackStep(_step);
+        const float hitTimeRatio = step.hitTimeRatio;
+        const float hitWindow = step.hitWindow;
 
         float hitTime = hitTimeRatio * _dur;
 
         // 在合适的时机执行一次伤害检测
         if (_t >= hitTime && _t <= hitTime + hitWindow) {
             auto* combat = entity->getCombat();
-            if (combat) {
-                // 获取敌人列表
-                auto* enemies = entity->getEnemies();
-                if (enemies && !enemies->empty()) {
-                    // 将 Enemy* 转换为 Node* 以匹配函数参数类型
-                    // 同时只保留存活的敌人
-                    std::vector<Node*> nodeTargets;
-                    nodeTargets.reserve(enemies->size());
-                    for (auto* enemy : *enemies) {
-                        // 只对存活的敌人进行攻击检测
-                        if (enemy && !enemy->isDead()) {
-                            nodeTargets.push_back(dynamic_cast<Node*>(enemy));
-                        }
-                    }
-                    
-                    // 执行近战攻击
-                    if (!nodeTargets.empty()) {
-                        int hitCount = combat->executeMeleeAttack(
-                            entity->getCollider(), 
-                            nodeTargets
-                        );
-
-                        if (hitCount > 0) {
-                            CCLOG("AttackState: %s hit %d enemies!", getStateName().c_str(), hitCount);
-                            
-                            // 可以在这里添加攻击命中特效或音效
-                            // TODO: 添加攻击命中反馈
-                        }
-                    } else {
-                        CCLOG("AttackState: %s - no alive enemies to attack", getStateName().c_str());
-                    }
+            // 目标由场景级空间哈希筛选、从登记表读取（BaseScene 在创建角色时安装两者）
+            auto* actors = entity->getActorHash();
+            auto* registry = entity->getCombatantRegistry();
+            if (combat && actors && registry) {
+                // 攻击形状按角色当前的世界位置与朝向（角色本地 -Z）摆放
+                const cocos2d::Mat4 toWorld = entity->getNodeToWorldTransform();
+                cocos2d::Vec3 origin;
+                toWorld.transformPoint(cocos2d::Vec3::ZERO, &origin);
+                const cocos2d::Vec3 forward = AttackShape::getActorForward(toWorld);
+
+                int hitCount = combat->executeShapeAttack(
+                    step.shape,
+                    origin,
+                    forward,
+                    *actors,
+                    *registry,
+                    ActorSpatialHash::kLayerEnemy
+                );
+
+                if (hitCount > 0) {
+                    CCLOG("AttackState: %s hit %d enemies!", getStateName().c_str(), hitCount);
                 }
             }
             _damageDealt = true; // 标记已经执行过伤害检测，避免重复伤害
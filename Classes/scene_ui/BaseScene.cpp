@@ -10,6 +10,7 @@
 
 #include "3d/CCSprite3D.h"
 #include "3d/CCTerrain.h"
+#include "AttackShape.h"
 #include "AudioManager.h"
 #include "Boss.h"
 #include "BossAI.h"
@@ -31,8 +32,18 @@ static float s_aspect = 1.0f;
 static float s_nearPlane = 1.0f;
 static float s_farPlane = 2000.0f;
 
+// ײļݲ絥λ scene/camp.scene е simplify һ¡
+static const float kTerrainSimplifyTolerance = 2.0f;
+
 Scene* BaseScene::createScene() { return BaseScene::create(); }
 
+BaseScene::~BaseScene() {
+  CC_SAFE_RELEASE(_terrainStreamer);
+  CC_SAFE_RELEASE(_terrainCollider);
+  CC_SAFE_RELEASE(_bakedWorld);
+  CC_SAFE_RELEASE(_staticWorld);
+}
+
 bool BaseScene::init() {
   if (!Scene::init()) return false;
 
@@ -64,7 +75,11 @@ bool BaseScene::init() {
   // ű֡
   AudioManager::getInstance()->playBGM("Audio/game_bgm1.mp3");
 
-  this->scheduleUpdate();
+  // ȼ 1нɫȼ 0²ύ֮̽С
+  this->scheduleUpdateWithPriority(1);
+
+  // ˱ͨɫռϣھӡ
+  _crowd.setActorHash(&_actors);
 
   //  HUD ͣť
   auto vs = Director::getInstance()->getVisibleSize();
@@ -203,13 +218,46 @@ void BaseScene::initLights() {
 
 void BaseScene::initInput() {
   // ʼ߼/
-  // Ŀǰʹ scheduleUpdate ѯ롣
-  scheduleUpdate();
+  // Ŀǰʹ scheduleUpdate ѯ루ȼ init
+  scheduleUpdateWithPriority(1);
 }
 
 /* ====================  ==================== */
 
 void BaseScene::update(float dt) {
+  // λõȷֿأ֡ɵķֿĵ̽⡣
+  if (_terrainStreamer && _player) {
+    _terrainStreamer->update(dt, _player->getPosition3D());
+  }
+
+  // ͳһⱾ֡нɫύĵ̽⣬ɫλڴ䶨
+  _groundProbes.flush();
+
+  // 㱾֡ȫ˺ / ״̬лнɫ֮ͳһУ
+  // ֡ĵ˲ٽؽĿռϣ
+  _damage.flush();
+
+  // ɫλѶؽɫռϣһ֡Ƽս֪ѯʹá
+  rebuildActorHash();
+
+  // Ȿ֡еύıٶȣһ֡ƶʱЧ
+  _crowd.solve(dt);
+
+  // ÿ֡ڵԤִеύѰ·󣬳Ԥһ֡
+  _navPaths.update();
+
+  // Ӱͼ֡˵ռøΧλ֣˥ң빥״ͬ
+  if (_player) {
+    _influence.update(_player->getPosition3D(),
+                      AttackShape::getActorForward(_player->getNodeToWorldTransform()));
+  }
+
+  // ҿʱؽ׷ɢ̯֡
+  if (_player && _chaseField.hasGrid()) {
+    _chaseField.setGoal(_player->getPosition3D());
+    _chaseField.update();
+  }
+
   //  HUD Ϸ״̬
   if (_player) {
     // Ƿ硣
@@ -236,6 +284,26 @@ static float moveTowardAngleDeg(float cur, float target, float maxDeltaDeg) {
   return cur + delta;
 }
 
+// ĵ˵ǼǵռϣΪ㣬ҰΧڵľؽʱһ
+void BaseScene::rebuildActorHash() {
+  _actors.clear();
+
+  float focusRange = 0.0f;
+  for (auto enemy : _enemies) {
+    if (!enemy || enemy->isDead()) continue;
+    _actors.add(enemy, enemy->getCollider(), enemy->getWorldPosition3D(), ActorSpatialHash::kLayerEnemy,
+                enemy->getCombatantHandle());
+    focusRange = std::max(focusRange, enemy->getViewRange());
+  }
+  if (_player && !_player->isDead()) {
+    _actors.add(_player, _player->getCollider(), _player->getWorldPosition3D(), ActorSpatialHash::kLayerPlayer,
+                _player->getCombatantHandle());
+  }
+
+  _actors.setFocus(_player, focusRange, ActorSpatialHash::kLayerEnemy);
+  _actors.build();
+}
+
 void BaseScene::updateCamera(float dt) {
   if (!_mainCamera || !_player) return;
 
@@ -279,13 +347,7 @@ void BaseScene::updateCamera(float dt) {
 void BaseScene::teleportPlayerToCenter() {
   if (_player) {
     cocos2d::Vec3 teleportPos(0, 0, -960);
-    if (_terrainCollider) {
-        CustomRay ray(teleportPos + cocos2d::Vec3(0, 500, 0), cocos2d::Vec3(0, -1, 0));
-        float hitDist;
-        if (_terrainCollider->rayIntersects(ray, hitDist)) {
-            teleportPos.y = ray.origin.y - hitDist;
-        }
-    }
+    snapToGround(&teleportPos, 1);
     _player->setPosition3D(teleportPos);  // ص͵ 2
     _player->respawn();
   }
@@ -300,6 +362,44 @@ void BaseScene::teleportPlayerToCenter() {
   CCLOG("BaseScene: еá");
 }
 
+int BaseScene::snapToGround(cocos2d::Vec3* positions, int count) {
+  if (!_terrainQuery || count <= 0) return 0;
+
+  if (_terrainStreamer) {
+    for (int i = 0; i < count; ++i) _terrainStreamer->preload(positions[i], 0.0f);
+  }
+
+  // 決ĸ߶λ߼⡣
+  int hits = 0;
+  std::vector<int> pending;
+  std::vector<CustomRay> rays;
+  rays.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    float y;
+    if (_bakedWorld && _bakedWorld->findSpawnHeight(positions[i].x, positions[i].z, y)) {
+      positions[i].y = y;
+      ++hits;
+      continue;
+    }
+    pending.push_back(i);
+    rays.push_back(CustomRay(positions[i] + cocos2d::Vec3(0, GroundProbeBatch::kProbeHeight, 0),
+                             cocos2d::Vec3(0, -1, 0)));
+  }
+  if (rays.empty()) return hits;
+
+  std::vector<float> hitDist(rays.size());
+  hits += _terrainQuery->rayIntersectsBatch(rays.data(), (int)rays.size(), hitDist.data());
+  for (size_t k = 0; k < rays.size(); ++k) {
+    cocos2d::Vec3& pos = positions[pending[k]];
+    if (hitDist[k] != TerrainQuery::kNoHit) {
+      pos.y = rays[k].origin.y - hitDist[k];
+    } else {
+      CCLOG("Warning: terrain raycast failed at (%f, %f)", pos.x, pos.z);
+    }
+  }
+  return hits;
+}
+
 /* ====================  ==================== */
 
 Scene* CampScene::createScene() { return CampScene::create(); }
@@ -307,33 +407,112 @@ Scene* CampScene::createScene() { return CampScene::create(); }
 bool CampScene::init() {
   if (!BaseScene::init()) return false;
 
-  // صģ͡
-  auto terrain = Sprite3D::create("scene/terrain.obj");
-  if (terrain) {
-    terrain->setPosition3D(Vec3(0, 0, 0));
-    terrain->setScale(100.0f);
-    terrain->setCameraMask((unsigned short)CameraFlag::USER1);
-    addChild(terrain);
-
-    // ʼײ
-    _terrainCollider = TerrainCollider::create(terrain, "scene/terrain.obj");
-    if (_terrainCollider) {
-      _terrainCollider->retain();
-      if (_player) {
-        _player->setTerrainCollider(_terrainCollider);
+  const std::string sceneDesc = "scene/camp.scene";
+
+  // ȼطֿΣ嵥ʱλʽأΡ
+  // ֿ嵥 world_bake tiles scene/camp.scene scene/tiles/ Resources/ ɡ
+  const std::string tileManifest = "scene/tiles/manifest.txt";
+  if (FileUtils::getInstance()->isFileExist(tileManifest)) {
+    _terrainStreamer = TerrainStreamer::create(tileManifest, this);
+  }
+
+  if (_terrainStreamer) {
+    _terrainStreamer->retain();
+    // 㸽ķֿͬأ֡غȾ
+    _terrainStreamer->preload(Vec3(0, 0, -960), _terrainStreamer->getStreamRadius());
+    _terrainQuery = _terrainStreamer;
+    // ֻεĵײɣֿûеݣõ
+    // ׷ؼʱ˻ֱƶ
+    CCLOG("CampScene: streamed terrain has no navmesh, enemies steer in straight lines");
+  } else {
+    // صģ͡
+    auto terrain = Sprite3D::create("scene/terrain.obj");
+    if (terrain) {
+      terrain->setPosition3D(Vec3(0, 0, 0));
+      terrain->setScale(100.0f);
+      terrain->setCameraMask((unsigned short)CameraFlag::USER1);
+      addChild(terrain);
+
+      // ʼײӳߺ決ļworld_bake ɣȱʧʱ .obj
+      _bakedWorld = BakedWorld::create(sceneDesc, "scene/camp.wkworld", terrain);
+      if (_bakedWorld) {
+        _bakedWorld->retain();
+        _terrainCollider = _bakedWorld->getCollider();
+      } else {
+        _terrainCollider = TerrainCollider::create(terrain, "scene/terrain.obj",
+                                                   TerrainCollider::AccelType::BVH,
+                                                   kTerrainSimplifyTolerance);
       }
-      for (auto enemy : _enemies) {
-        enemy->setTerrainCollider(_terrainCollider);
+      if (_terrainCollider) {
+        _terrainCollider->retain();
+        _terrainQuery = _terrainCollider;
+
+        // ȡ決ļеģײɣ׷ؼʱ·ƿºͶ¡
+        NavMesh* navMesh = _bakedWorld ? _bakedWorld->getNavMesh() : nullptr;
+        _navPaths.setNavMesh(navMesh ? navMesh : NavMesh::create(_terrainCollider));
+        _influence.setNavMesh(_navPaths.getNavMesh());
       }
+    }
+  }
 
-      // ʼϷҡˡBoss
-      initGameObjects();
+  if (_terrainQuery) {
+    initStaticProps(sceneDesc);
+
+    // ĸͨ԰Ĳѯ⣬ƿʯ
+    if (_navPaths.getNavMesh()) {
+      _chaseField.buildGrid(_navPaths.getNavMesh(), _terrainQuery);
     }
+    _groundProbes.setTerrainCollider(_terrainQuery);
+
+    // ʼϷҡˡBoss
+    initGameObjects();
   }
 
   return true;
 }
 
+void CampScene::initStaticProps(const std::string& sceneDescPath) {
+  WorldBake::SceneDesc desc;
+  if (_bakedWorld) {
+    desc = _bakedWorld->getSceneDesc();
+  } else {
+    const std::string text = FileUtils::getInstance()->getStringFromFile(sceneDescPath);
+    if (text.empty() || !WorldBake::parseSceneDesc(text, desc)) return;
+  }
+  if (desc.props.empty()) return;
+
+  // ڵαϣʱ _terrainQuery ֻǵΣֿ»ȼڵķֿ顣
+  std::vector<Vec3> positions;
+  for (const auto& prop : desc.props) positions.push_back(Vec3(prop.x, 0.0f, prop.z));
+  snapToGround(positions.data(), (int)positions.size());
+
+  _staticWorld = StaticCollisionWorld::create();
+  _staticWorld->retain();
+  _staticWorld->setTerrain(_terrainQuery);
+  for (size_t i = 0; i < desc.props.size(); ++i) {
+    const WorldBake::Prop& prop = desc.props[i];
+    const int mesh = _staticWorld->addMesh(prop.obj);
+    if (mesh < 0) continue;
+
+    const Quaternion rotation(Vec3::UNIT_Y, CC_DEGREES_TO_RADIANS(prop.yaw));
+    _staticWorld->addInstance(mesh, positions[i], rotation, prop.scale);
+
+    auto model = Sprite3D::create(prop.obj);
+    if (model) {
+      model->setPosition3D(positions[i]);
+      model->setRotationQuat(rotation);
+      model->setScale(prop.scale);
+      model->setCameraMask((unsigned short)CameraFlag::USER1);
+      addChild(model);
+    }
+  }
+  _staticWorld->build();
+
+  // ֮ɫءƶ߼ⶼͬʱڵκ
+  _terrainQuery = _staticWorld;
+  CCLOG("CampScene: %d static props over the terrain", _staticWorld->getInstanceCount());
+}
+
 /* ----------  ---------- */
 
 void BaseScene::initPlayer() {
@@ -345,21 +524,20 @@ void BaseScene::initPlayer() {
 
   // ڴ͵ 2 ҡ
   cocos2d::Vec3 playerSpawnPos(0.0f, 0.0f, -960.0f);
-  if (_terrainCollider) {
-      CustomRay ray(playerSpawnPos + cocos2d::Vec3(0, 500, 0), cocos2d::Vec3(0, -1, 0));
-      float hitDist;
-      if (_terrainCollider->rayIntersects(ray, hitDist)) {
-          playerSpawnPos.y = ray.origin.y - hitDist;
-          CCLOG("Player spawned at ground Y: %f (hitDist: %f)", playerSpawnPos.y, hitDist);
-      } else {
-          CCLOG("Warning: Player terrain raycast failed!");
-      }
+  if (snapToGround(&playerSpawnPos, 1) > 0) {
+    CCLOG("Player spawned at ground Y: %f", playerSpawnPos.y);
   }
   _player->setPosition3D(playerSpawnPos);
   _player->setRotation3D(cocos2d::Vec3::ZERO);
 
-  if (_terrainCollider) {
-    _player->setTerrainCollider(_terrainCollider);
+  if (_terrainQuery) {
+    _player->setTerrainCollider(_terrainQuery);
+    _player->setGroundProbeBatch(&_groundProbes);
+  }
+  _player->setActorHash(&_actors);
+  _player->setCombatantRegistry(&_combatants);
+  if (_player->getHealth()) {
+    _player->getHealth()->setDamageQueue(&_damage);
   }
 
   addChild(_player, 10);
@@ -385,30 +563,35 @@ void BaseScene::initEnemy() {
       {"Enemy/enemy3", "enemy3.c3b", cocos2d::Vec3(380, 0, -450)},
   };
 
-  for (auto& s : spawns) {
+  // гһء
+  const int spawnCount = (int)(sizeof(spawns) / sizeof(spawns[0]));
+  cocos2d::Vec3 spawnPos[spawnCount];
+  for (int i = 0; i < spawnCount; ++i) spawnPos[i] = spawns[i].pos;
+  snapToGround(spawnPos, spawnCount);
+
+  for (int i = 0; i < spawnCount; ++i) {
+    const Spawn& s = spawns[i];
     auto e = Enemy::createWithResRoot(s.root, s.model);
     if (!e) continue;
 
-    cocos2d::Vec3 spawnPos = s.pos;
-    if (_terrainCollider) {
-        CustomRay ray(spawnPos + cocos2d::Vec3(0, 500, 0), cocos2d::Vec3(0, -1, 0));
-        float hitDist;
-        if (_terrainCollider->rayIntersects(ray, hitDist)) {
-            spawnPos.y = ray.origin.y - hitDist;
-            CCLOG("Enemy spawned at ground Y: %f (hitDist: %f)", spawnPos.y, hitDist);
-        } else {
-            CCLOG("Warning: Enemy terrain raycast failed!");
-        }
-    }
-
-    e->setPosition3D(spawnPos);
+    e->setPosition3D(spawnPos[i]);
     e->setBirthPosition(e->getPosition3D());
     e->setTarget(_player);
-    e->setTerrainCollider(_terrainCollider);
-
-    // СѪΪ 10
+    e->setTerrainCollider(_terrainQuery);
+    if (_terrainQuery) {
+      e->setGroundProbeBatch(&_groundProbes);
+    }
+    e->setNavPathQueue(&_navPaths);
+    e->setFlowField(&_chaseField);
+    e->setCrowdAvoidance(&_crowd);
+    e->setInfluenceMap(&_influence);
+    e->setActorHash(&_actors);
+    e->setCombatantRegistry(&_combatants);
+
+    // СѪΪ 10˺ͳһ㡣
     if (e->getHealth()) {
       e->getHealth()->setMaxHealth(10.0f);
+      e->getHealth()->setDamageQueue(&_damage);
     }
 
     this->addChild(e);
@@ -465,8 +648,18 @@ void BaseScene::initBoss() {
   boss->setBirthPosition(boss->getPosition3D());
   boss->setTarget(_player);
 
-  if (_terrainCollider) {
-    boss->setTerrainCollider(_terrainCollider);
+  if (_terrainQuery) {
+    boss->setTerrainCollider(_terrainQuery);
+    boss->setGroundProbeBatch(&_groundProbes);
+  }
+  boss->setNavPathQueue(&_navPaths);
+  boss->setFlowField(&_chaseField);
+  boss->setCrowdAvoidance(&_crowd);
+  boss->setInfluenceMap(&_influence);
+  boss->setActorHash(&_actors);
+  boss->setCombatantRegistry(&_combatants);
+  if (boss->getHealth()) {
+    boss->getHealth()->setDamageQueue(&_damage);
   }
 
   //  Boss AI
@@ -482,17 +675,11 @@ void BaseScene::initBoss() {
   }
 
   // Ըݵζʼ߶
-  if (_terrainCollider) {
-      CustomRay ray(cocos2d::Vec3(-200, 500, 600), cocos2d::Vec3(0, -1, 0));
-      float hitDist;
-      if (_terrainCollider->rayIntersects(ray, hitDist)) {
-          float groundY = ray.origin.y - hitDist;
-          boss->setPosition3D(cocos2d::Vec3(-200, groundY, 600));
-          boss->setBirthPosition(boss->getPosition3D());
-          CCLOG("Boss spawned at ground Y: %f (hitDist: %f)", groundY, hitDist);
-      } else {
-          CCLOG("Warning: Boss terrain raycast failed!");
-      }
+  cocos2d::Vec3 bossSpawnPos(-200, 0, 600);
+  if (snapToGround(&bossSpawnPos, 1) > 0) {
+    boss->setPosition3D(bossSpawnPos);
+    boss->setBirthPosition(boss->getPosition3D());
+    CCLOG("Boss spawned at ground Y: %f", bossSpawnPos.y);
   }
 
   this->addChild(boss);
@@ -9,7 +9,18 @@
 #include <string>
 #include <vector>
 
+#include "../combat/ActorSpatialHash.h"
 #include "../combat/Collider.h"
+#include "../combat/CombatantRegistry.h"
+#include "../combat/CrowdAvoidance.h"
+#include "../combat/DamageQueue.h"
+#include "../combat/FlowField.h"
+#include "../combat/GroundProbeBatch.h"
+#include "../combat/InfluenceMap.h"
+#include "../combat/NavPathQuery.h"
+#include "../combat/StaticCollisionWorld.h"
+#include "../combat/TerrainStreamer.h"
+#include "../combat/WorldBake.h"
 #include "Enemy.h"
 #include "Wukong.h"
 #include "cocos2d.h"
@@ -23,6 +34,7 @@ class BaseScene : public cocos2d::Scene {
  public:
   static cocos2d::Scene* createScene();
   virtual bool init() override;
+  virtual ~BaseScene();
 
   // 将玩家传送到重生点并重置敌人。
   void teleportPlayerToCenter();
@@ -43,6 +55,7 @@ class BaseScene : public cocos2d::Scene {
   // 更新循环。
   virtual void update(float dt) override;
   void updateCamera(float dt);
+  void rebuildActorHash();  // 按本帧最终位置重建角色空间哈希。
 
   // 天空盒辅助方法。
   bool chooseSkyboxFaces(std::array<std::string, 6>& outFaces);
@@ -51,6 +64,10 @@ class BaseScene : public cocos2d::Scene {
   // 敌人管理。
   void removeDeadEnemy(Enemy* deadEnemy);
 
+  // 将一组位置批量贴合到地形表面，返回成功贴地的数量（未命中的位置保持不变）。
+  // 分块地形下会先同步加载这些位置所在的分块；与烘焙出生点重合的位置直接使用烘焙高度。
+  int snapToGround(cocos2d::Vec3* positions, int count);
+
  protected:
   // 摄像机相关成员。
   cocos2d::Camera* _mainCamera = nullptr;
@@ -92,7 +109,19 @@ class BaseScene : public cocos2d::Scene {
 
   // 游戏对象。
   Wukong* _player = nullptr;
-  TerrainCollider* _terrainCollider = nullptr;
+  TerrainCollider* _terrainCollider = nullptr;  // 整块地形（没有分块清单时使用）。
+  TerrainStreamer* _terrainStreamer = nullptr;  // 分块流式地形。
+  BakedWorld* _bakedWorld = nullptr;            // 离线烘焙的整块地形数据（可能为空）。
+  StaticCollisionWorld* _staticWorld = nullptr; // 叠加在地形之上的静态物件（场景描述中没有物件时为空）。
+  TerrainQuery* _terrainQuery = nullptr;        // 角色使用的地形查询：有物件时为 _staticWorld，否则为两种地形之一。
+  GroundProbeBatch _groundProbes;  // 每帧收集角色的贴地射线，在 update 中统一求解。
+  NavPathQueue _navPaths;          // 敌人的寻路请求，在 update 中按节点预算执行。
+  FlowField _chaseField;           // 通往玩家的共享流场，玩家跨过格子时在 update 中分帧重建。
+  CrowdAvoidance _crowd;           // 敌人之间的局部避障，在 update 中统一求解。
+  InfluenceMap _influence;         // 玩家周围的战术影响图，敌人从中领取包围位。
+  CombatantRegistry _combatants;   // 战斗参与者登记表，角色进出场景时登记 / 注销。
+  ActorSpatialHash _actors;        // 玩家与敌人的动态宽相，在 update 中每帧重建一次。
+  DamageQueue _damage;             // 本帧的伤害事件，在 update 中统一结算受伤与死亡。
   std::vector<Enemy*> _enemies;
 };
 
@@ -102,6 +131,10 @@ class CampScene : public BaseScene {
   static cocos2d::Scene* createScene();
   virtual bool init() override;
   CREATE_FUNC(CampScene);
+
+ private:
+  // 按场景描述中的 prop 行放置静态物件，并把物件叠加到 _terrainQuery 之上。
+  void initStaticProps(const std::string& sceneDescPath);
 };
 
 #endif  // __BASE_SCENE_H__
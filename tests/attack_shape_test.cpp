@@ -0,0 +1,172 @@
+/**
+ * attack_shape_test：攻击判定形状的单元测试
+ *
+ * - 各形状的基本命中 / 未命中情形；
+ * - 批量判定（AttackTargets::test）与单个判定（AttackShape::test）在随机包围盒上结果一致，
+ *   目标数不是通道数的整数倍，覆盖末尾的填充通道；
+ * - 连招各段的形状按角色朝向摆放：正前方的目标命中，正后方的不命中。
+ *
+ * 用法：attack_shape_test，全部通过时返回 0
+ */
+#include "cocos2d.h"
+#include "AttackShape.h"
+#include "WukongStates.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+USING_NS_CC;
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const char* what) {
+    if (condition) return;
+    ++g_failures;
+    printf("FAILED: %s\n", what);
+}
+
+AABB boxAt(const Vec3& center, float halfSize) {
+    const Vec3 half(halfSize, halfSize, halfSize);
+    return AABB(center - half, center + half);
+}
+
+void testBasicShapes() {
+    const Vec3 origin(0.0f, 0.0f, 0.0f);
+    const Vec3 forward(0.0f, 0.0f, -1.0f);
+
+    // 扇形：半径 100，半角 45 度
+    const AttackShape sector = AttackShape::sector(100.0f, 45.0f);
+    check(sector.test(origin, forward, boxAt(Vec3(0, 50, -60), 5)), "sector hits a target in front");
+    check(!sector.test(origin, forward, boxAt(Vec3(0, 50, 60), 5)), "sector misses a target behind");
+    check(!sector.test(origin, forward, boxAt(Vec3(80, 50, -20), 5)), "sector misses a target outside the angle");
+    check(!sector.test(origin, forward, boxAt(Vec3(0, 50, -130), 5)), "sector misses a target out of range");
+    check(!sector.test(origin, forward, boxAt(Vec3(0, 400, -60), 5)), "sector misses a target above maxY");
+
+    // 胶囊：从前方 20 处延伸 100，半径 15
+    const AttackShape capsule = AttackShape::capsule(100.0f, 15.0f, 20.0f);
+    check(capsule.test(origin, forward, boxAt(Vec3(0, 50, -70), 5)), "capsule hits a target on its axis");
+    check(capsule.test(origin, forward, boxAt(Vec3(0, 50, -130), 5)), "capsule hits a target at its end cap");
+    check(!capsule.test(origin, forward, boxAt(Vec3(40, 50, -70), 5)), "capsule misses a target beside it");
+    check(!capsule.test(origin, forward, boxAt(Vec3(0, 50, 40), 5)), "capsule misses a target behind");
+
+    // 矩形：从前方 10 处延伸 80，半宽 20
+    const AttackShape box = AttackShape::orientedBox(80.0f, 20.0f, 10.0f);
+    check(box.test(origin, forward, boxAt(Vec3(15, 50, -50), 5)), "box hits a target inside");
+    check(!box.test(origin, forward, boxAt(Vec3(40, 50, -50), 5)), "box misses a target beside it");
+    check(!box.test(origin, forward, boxAt(Vec3(0, 50, -110), 5)), "box misses a target past its end");
+    check(!box.test(origin, forward, boxAt(Vec3(0, 50, 30), 5)), "box misses a target behind");
+    check(box.test(Vec3::ZERO, Vec3(1, 0, 0), boxAt(Vec3(50, 50, 0), 5)), "box follows the forward direction");
+
+    // 圆环：内半径 50，外半径 100，圆心在原点
+    const AttackShape ring = AttackShape::ring(50.0f, 100.0f);
+    check(ring.test(origin, forward, boxAt(Vec3(0, 50, 75), 5)), "ring hits a target inside the band");
+    check(!ring.test(origin, forward, boxAt(Vec3(10, 50, 10), 5)), "ring misses a target inside the hole");
+    check(!ring.test(origin, forward, boxAt(Vec3(0, 50, 130), 5)), "ring misses a target outside");
+    check(AttackShape::ring(0.0f, 100.0f).test(origin, forward, boxAt(Vec3::ZERO, 5)), "disc hits its centre");
+}
+
+AttackShape randomShape(std::mt19937& rng) {
+    std::uniform_real_distribution<float> size(10.0f, 150.0f);
+    std::uniform_real_distribution<float> angle(5.0f, 185.0f);
+    std::uniform_real_distribution<float> offset(-30.0f, 60.0f);
+    switch (rng() % 4) {
+    case 0:
+        return AttackShape::sector(size(rng), angle(rng));
+    case 1:
+        return AttackShape::capsule(size(rng), size(rng) * 0.3f, offset(rng));
+    case 2:
+        return AttackShape::orientedBox(size(rng), size(rng) * 0.5f, offset(rng));
+    default: {
+        const float outer = size(rng);
+        return AttackShape::ring(outer * std::uniform_real_distribution<float>(0.0f, 0.9f)(rng), outer, offset(rng));
+    }
+    }
+}
+
+void testBatchMatchesScalar() {
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> pos(-250.0f, 250.0f);
+    std::uniform_real_distribution<float> height(-100.0f, 300.0f);
+    std::uniform_real_distribution<float> extent(1.0f, 60.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    AttackTargets targets;
+    std::vector<AABB> boxes;
+    std::vector<uint32_t> mask;
+    int mismatches = 0;
+    for (int round = 0; round < 500; ++round) {
+        const AttackShape shape = randomShape(rng);
+        const Vec3 origin(pos(rng) * 0.2f, height(rng) * 0.2f, pos(rng) * 0.2f);
+        const Vec3 forward(unit(rng), 0.0f, unit(rng));
+
+        // 目标数从 0 到数个通道宽度之外，覆盖不足一组通道与末尾的填充通道
+        const int count = round % (AttackTargets::kLaneCount * 4 + 3);
+        targets.clear();
+        boxes.clear();
+        for (int i = 0; i < count; ++i) {
+            const Vec3 center(pos(rng), height(rng), pos(rng));
+            const Vec3 half(extent(rng), extent(rng), extent(rng));
+            boxes.push_back(AABB(center - half, center + half));
+            targets.add(boxes.back());
+        }
+
+        const int hits = targets.test(shape, origin, forward, mask);
+        int expected = 0;
+        for (int i = 0; i < count; ++i) {
+            const bool scalar = shape.test(origin, forward, boxes[i]);
+            expected += scalar ? 1 : 0;
+            if (scalar != AttackTargets::isHit(mask, i)) ++mismatches;
+        }
+        if (hits != expected) ++mismatches;
+        // 填充通道永远不会命中
+        for (int i = count; i < (int)mask.size() * 32; ++i) {
+            if (AttackTargets::isHit(mask, i)) ++mismatches;
+        }
+    }
+    check(mismatches == 0, "batch test matches the scalar test on random boxes");
+}
+
+void testComboFacing() {
+    for (int step = 1; step <= 3; ++step) {
+        const AttackShape& shape = AttackState::getAttackStep(step).shape;
+        for (float yaw = 0.0f; yaw < 360.0f; yaw += 45.0f) {
+            // 与角色节点相同的变换：先平移再绕 Y 轴旋转 yaw
+            Mat4 translation, rotation;
+            Mat4::createTranslation(Vec3(300.0f, 20.0f, -150.0f), &translation);
+            Mat4::createRotationY(CC_DEGREES_TO_RADIANS(yaw), &rotation);
+            const Mat4 toWorld = translation * rotation;
+
+            Vec3 origin;
+            toWorld.transformPoint(Vec3::ZERO, &origin);
+            const Vec3 forward = AttackShape::getActorForward(toWorld);
+
+            // 角色正面是节点本地 -Z
+            Vec3 front, back;
+            toWorld.transformPoint(Vec3(0.0f, 50.0f, -60.0f), &front);
+            toWorld.transformPoint(Vec3(0.0f, 50.0f, 60.0f), &back);
+
+            char what[96];
+            snprintf(what, sizeof(what), "combo step %d at yaw %.0f hits the target in front", step, yaw);
+            check(shape.test(origin, forward, boxAt(front, 10.0f)), what);
+            snprintf(what, sizeof(what), "combo step %d at yaw %.0f misses the target behind", step, yaw);
+            check(!shape.test(origin, forward, boxAt(back, 10.0f)), what);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    testBasicShapes();
+    testBatchMatchesScalar();
+    testComboFacing();
+
+    if (g_failures > 0) {
+        printf("attack_shape_test: %d failures\n", g_failures);
+        return 1;
+    }
+    printf("attack_shape_test: all passed\n");
+    return 0;
+}
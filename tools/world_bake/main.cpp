@@ -0,0 +1,65 @@
+/**
+ * world_bake：离线烘焙场景的碰撞、出生点与导航数据，或把地形切分为流式加载的分块
+ *
+ * 用法：world_bake <场景描述> <输出文件> [资源目录]
+ *     场景描述与其中引用的 .obj 均相对资源目录解析（默认为 Resources/）
+ *
+ *       world_bake tiles <场景描述> <分块目录> [资源目录] [分块边长]
+ *     分块目录相对资源目录，写出 manifest.txt 与每个分块的渲染 / 碰撞 .obj（分块边长默认 500）；
+ *     CampScene 发现 scene/tiles/manifest.txt 时改用分块流式地形
+ *
+ * 例：world_bake scene/camp.scene Resources/scene/camp.wkworld Resources/
+ *     world_bake tiles scene/camp.scene scene/tiles/ Resources/ 500
+ */
+#include "cocos2d.h"
+#include "WorldBake.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+USING_NS_CC;
+
+namespace {
+
+int bakeTiles(int argc, char** argv) {
+    if (argc < 4) {
+        printf("usage: %s tiles <scene desc> <tile dir> [resource dir] [tile size]\n", argv[0]);
+        return 1;
+    }
+
+    std::string resourceDir = (argc > 4) ? argv[4] : "Resources/";
+    if (resourceDir.back() != '/' && resourceDir.back() != '\\') resourceDir += '/';
+    std::string tileDir = argv[3];
+    if (tileDir.back() != '/' && tileDir.back() != '\\') tileDir += '/';
+    const float tileSize = (argc > 5) ? (float)std::atof(argv[5]) : 500.0f;
+    FileUtils::getInstance()->addSearchPath(resourceDir, true);
+
+    if (!WorldBake::bakeTiles(argv[2], tileDir, resourceDir + tileDir, tileSize)) {
+        printf("world_bake: failed to split %s into tiles\n", argv[2]);
+        return 1;
+    }
+    printf("world_bake: %s -> %s%smanifest.txt\n", argv[2], resourceDir.c_str(), tileDir.c_str());
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "tiles") == 0) return bakeTiles(argc, argv);
+
+    if (argc < 3) {
+        printf("usage: %s <scene desc> <output> [resource dir]\n", argv[0]);
+        printf("       %s tiles <scene desc> <tile dir> [resource dir] [tile size]\n", argv[0]);
+        return 1;
+    }
+
+    const std::string resourceDir = (argc > 3) ? argv[3] : "Resources/";
+    FileUtils::getInstance()->addSearchPath(resourceDir, true);
+
+    if (!WorldBake::bake(argv[1], argv[2])) {
+        printf("world_bake: failed to bake %s\n", argv[1]);
+        return 1;
+    }
+    printf("world_bake: %s -> %s\n", argv[1], argv[2]);
+    return 0;
+}